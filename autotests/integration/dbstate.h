@@ -29,6 +29,9 @@
 #include "documentdatadb.h"
 #include "positiondb.h"
 #include "documenttimedb.h"
+#include "ordinaldb.h"
+
+#include <algorithm>
 
 namespace Baloo {
 
@@ -78,6 +81,7 @@ DBState DBState::fromTransaction(Baloo::Transaction* tr)
     DocumentIdDB failedIdDb(dbis.failedIdDbi, txn);
     MTimeDB mtimeDB(dbis.mtimeDbi, txn);
     DocumentUrlDB docUrlDB(dbis.idTreeDbi, dbis.idFilenameDbi, txn);
+    OrdinalDB ordinalDB(dbis.idOrdinalDbi, dbis.ordinalIdDbi, dbis.freeOrdinalDbi, txn);
 
     DBState state;
     state.postingDb = postingDB.toTestMap();
@@ -91,6 +95,23 @@ DBState DBState::fromTransaction(Baloo::Transaction* tr)
     state.contentIndexingDb = contentIndexingDB.toTestVector();
     state.failedIdDb = failedIdDb.toTestVector();
 
+    // The documents are stored by ordinal, the tests are written with ids
+    for (PostingList& list : state.postingDb) {
+        for (quint64& id : list) {
+            id = ordinalDB.id(id);
+        }
+        std::sort(list.begin(), list.end());
+    }
+    for (QVector<PositionInfo>& list : state.positionDb) {
+        for (PositionInfo& info : list) {
+            info.docId = ordinalDB.id(info.docId);
+        }
+        std::sort(list.begin(), list.end());
+    }
+    for (quint64& id : state.mtimeDb) {
+        id = ordinalDB.id(id);
+    }
+
     // FIXME: What about DocumentUrlDB?
     // state.docUrlDb = docUrlDB.toTestMap();
 
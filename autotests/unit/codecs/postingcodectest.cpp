@@ -41,6 +41,18 @@ private Q_SLOTS:
         QCOMPARE(vec2, vec);
     }
 
+    void testDeltas() {
+        PostingCodec codec;
+
+        // Small gaps take a byte each, whatever the size of the ordinals
+        QVector<quint64> vec = {100000, 100001, 100003, 0xffffffff};
+        QByteArray arr = codec.encode(vec);
+        QCOMPARE(arr.size(), 1 + 3 + 1 + 1 + 5);
+        QCOMPARE(codec.decode(arr), vec);
+
+        QCOMPARE(codec.decode(codec.encode(QVector<quint64>())), QVector<quint64>());
+    }
+
 };
 
 QTEST_MAIN(PostingCodecTest)
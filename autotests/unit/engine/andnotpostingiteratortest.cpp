@@ -0,0 +1,83 @@
+/*
+   This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "andnotpostingiterator.h"
+#include "orpostingiterator.h"
+#include "vectorpostingiterator.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class AndNotPostingIteratorTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+    void testNullExcluded();
+    void testSkipTo();
+};
+
+void AndNotPostingIteratorTest::test()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7, 9, 11};
+    QVector<quint64> l2 = {2, 3, 4, 9, 10};
+
+    AndNotPostingIterator it(new VectorPostingIterator(l1), new VectorPostingIterator(l2));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+
+    QVector<quint64> result = {1, 5, 7, 11};
+    for (quint64 val : result) {
+        QCOMPARE(it.next(), static_cast<quint64>(val));
+        QCOMPARE(it.docId(), static_cast<quint64>(val));
+    }
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
+
+void AndNotPostingIteratorTest::testNullExcluded()
+{
+    QVector<quint64> l1 = {1, 3, 5};
+
+    AndNotPostingIterator it(new VectorPostingIterator(l1), nullptr);
+    QCOMPARE(it.next(), static_cast<quint64>(1));
+    QCOMPARE(it.next(), static_cast<quint64>(3));
+    QCOMPARE(it.next(), static_cast<quint64>(5));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+}
+
+void AndNotPostingIteratorTest::testSkipTo()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7, 9, 11};
+    QVector<quint64> l2 = {5, 6};
+    QVector<quint64> l3 = {7};
+
+    QVector<PostingIterator*> excluded = {new VectorPostingIterator(l2), new VectorPostingIterator(l3)};
+    AndNotPostingIterator it(new VectorPostingIterator(l1), new OrPostingIterator(excluded));
+    QCOMPARE(it.estimatedSize(), static_cast<uint>(6));
+
+    QCOMPARE(it.skipTo(4), static_cast<quint64>(9));
+    QCOMPARE(it.skipTo(9), static_cast<quint64>(9));
+    QCOMPARE(it.next(), static_cast<quint64>(11));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+}
+
+QTEST_MAIN(AndNotPostingIteratorTest)
+
+#include "andnotpostingiteratortest.moc"
@@ -31,6 +31,8 @@ class AndPostingIteratorTest : public QObject
 private Q_SLOTS:
     void test();
     void testNullIterators();
+    void testSkipTo();
+    void testEstimatedSize();
 };
 
 void AndPostingIteratorTest::test()
@@ -72,6 +74,37 @@ void AndPostingIteratorTest::testNullIterators()
     QCOMPARE(it.docId(), static_cast<quint64>(0));
 }
 
+void AndPostingIteratorTest::testSkipTo()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7, 9, 11, 13};
+    QVector<quint64> l2 = {2, 3, 5, 9, 13, 15};
+
+    QVector<PostingIterator*> vec = {new VectorPostingIterator(l1), new VectorPostingIterator(l2)};
+    AndPostingIterator it(vec);
+
+    QCOMPARE(it.skipTo(4), static_cast<quint64>(5));
+    QCOMPARE(it.docId(), static_cast<quint64>(5));
+    QCOMPARE(it.skipTo(5), static_cast<quint64>(5));
+    QCOMPARE(it.skipTo(10), static_cast<quint64>(13));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+    QCOMPARE(it.skipTo(20), static_cast<quint64>(0));
+}
+
+void AndPostingIteratorTest::testEstimatedSize()
+{
+    QVector<quint64> l1 = {1, 2, 3, 4, 5, 6, 7, 8};
+    QVector<quint64> l2 = {2, 6};
+    QVector<quint64> l3 = {1, 2, 4, 6};
+
+    QVector<PostingIterator*> vec = {new VectorPostingIterator(l1), new VectorPostingIterator(l2),
+                                     new VectorPostingIterator(l3)};
+    AndPostingIterator it(vec);
+    QCOMPARE(it.estimatedSize(), static_cast<uint>(2));
+
+    QCOMPARE(it.next(), static_cast<quint64>(2));
+    QCOMPARE(it.next(), static_cast<quint64>(6));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+}
 
 QTEST_MAIN(AndPostingIteratorTest)
 
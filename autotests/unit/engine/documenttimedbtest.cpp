@@ -29,6 +29,7 @@ class DocumentTimeDBTest : public SingleDBTest
 private Q_SLOTS:
     void test();
     void testAllowZeroTime();
+    void testIdRange();
 };
 
 void DocumentTimeDBTest::test()
@@ -62,6 +63,26 @@ void DocumentTimeDBTest::testAllowZeroTime()
     QCOMPARE(db.get(1), DocumentTimeDB::TimeInfo());
 }
 
+void DocumentTimeDBTest::testIdRange()
+{
+    DocumentTimeDB db(DocumentTimeDB::create(m_txn), m_txn);
+
+    quint64 firstId = 0;
+    quint64 lastId = 0;
+    QVERIFY(!db.idRange(&firstId, &lastId));
+
+    db.put(7, DocumentTimeDB::TimeInfo(1, 1));
+    QVERIFY(db.idRange(&firstId, &lastId));
+    QCOMPARE(firstId, static_cast<quint64>(7));
+    QCOMPARE(lastId, static_cast<quint64>(7));
+
+    db.put(3, DocumentTimeDB::TimeInfo(1, 1));
+    db.put(0x100000002, DocumentTimeDB::TimeInfo(1, 1));
+    QVERIFY(db.idRange(&firstId, &lastId));
+    QCOMPARE(firstId, static_cast<quint64>(3));
+    QCOMPARE(lastId, static_cast<quint64>(0x100000002));
+}
+
 QTEST_MAIN(DocumentTimeDBTest)
 
 #include "documenttimedbtest.moc"
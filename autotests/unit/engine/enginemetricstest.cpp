@@ -0,0 +1,100 @@
+/*
+   This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "enginemetrics.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class EngineMetricsTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+    void testLatencyBuckets();
+};
+
+void EngineMetricsTest::test()
+{
+    EngineMetrics metrics;
+
+    EngineMetrics::CommitStats stats;
+    stats.usecs = 1500;
+    stats.terms = 10;
+    stats.operations = 40;
+    stats.bytes = 1024;
+    stats.pages = 2;
+    metrics.recordCommit(stats);
+
+    stats.usecs = 500;
+    stats.terms = 5;
+    stats.operations = 20;
+    stats.bytes = 512;
+    stats.pages = 0;
+    metrics.recordCommit(stats);
+
+    QVariantMap map = metrics.snapshot();
+    QCOMPARE(map.value("commits").toULongLong(), 2ULL);
+    QCOMPARE(map.value("commitTimeUsecs").toULongLong(), 2000ULL);
+    QCOMPARE(map.value("termsTouched").toULongLong(), 15ULL);
+    QCOMPARE(map.value("pendingOperations").toULongLong(), 60ULL);
+    QCOMPARE(map.value("maxPendingOperations").toULongLong(), 40ULL);
+    QCOMPARE(map.value("bytesWritten").toULongLong(), 1536ULL);
+    QCOMPARE(map.value("pagesGrown").toULongLong(), 2ULL);
+
+    QVariantMap last = map.value("lastCommit").toMap();
+    QCOMPARE(last.value("usecs").toULongLong(), 500ULL);
+    QCOMPARE(last.value("termsTouched").toULongLong(), 5ULL);
+    QCOMPARE(last.value("pendingOperations").toULongLong(), 20ULL);
+
+    QCOMPARE(metrics.lastCommit().bytes, 512ULL);
+}
+
+void EngineMetricsTest::testLatencyBuckets()
+{
+    EngineMetrics metrics;
+
+    EngineMetrics::CommitStats stats;
+    for (quint64 usecs : {0, 1000, 1001, 4000, 3000000}) {
+        stats.usecs = usecs;
+        metrics.recordCommit(stats);
+    }
+
+    QVariantMap map = metrics.snapshot();
+    QVariantList bounds = map.value("commitLatencyBoundsMsecs").toList();
+    QVariantList histogram = map.value("commitLatencyHistogram").toList();
+    QCOMPARE(histogram.size(), bounds.size() + 1);
+
+    // up to 1ms, up to 2ms, up to 5ms and slower than 2s
+    QCOMPARE(histogram[0].toULongLong(), 2ULL);
+    QCOMPARE(histogram[1].toULongLong(), 1ULL);
+    QCOMPARE(histogram[2].toULongLong(), 1ULL);
+    QCOMPARE(histogram.last().toULongLong(), 1ULL);
+
+    quint64 total = 0;
+    for (const QVariant& count : histogram) {
+        total += count.toULongLong();
+    }
+    QCOMPARE(total, 5ULL);
+}
+
+QTEST_MAIN(EngineMetricsTest)
+
+#include "enginemetricstest.moc"
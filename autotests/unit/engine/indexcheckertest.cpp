@@ -0,0 +1,204 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "indexchecker.h"
+#include "database.h"
+#include "transaction.h"
+#include "document.h"
+#include "enginequery.h"
+#include "idutils.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+
+using namespace Baloo;
+
+class IndexCheckerTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testConsistent();
+    void testRepair();
+    void testMissingPostingList();
+    void testManyProblems();
+
+private:
+    QVector<IndexChecker::Problem> check(IndexChecker* checker);
+
+    QTemporaryDir* m_dir;
+    Database* m_db;
+    QVector<quint64> m_ids;
+};
+
+void IndexCheckerTest::init()
+{
+    m_dir = new QTemporaryDir();
+    m_db = new Database(m_dir->path());
+    QVERIFY(m_db->open(Database::CreateDatabase));
+
+    Transaction tr(m_db, Transaction::ReadWrite);
+    m_ids.clear();
+    for (int i = 0; i < 10; i++) {
+        const QByteArray url = QFile::encodeName(m_dir->path()) + "/file" + QByteArray::number(i);
+        QFile file(QFile::decodeName(url));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.close();
+
+        Document doc;
+        doc.setId(filePathToId(url));
+        doc.setUrl(url);
+        doc.addTerm("fire");
+        doc.addTerm("term" + QByteArray::number(i));
+        doc.addFileNameTerm("file" + QByteArray::number(i));
+        doc.addXattrTerm("TAG-" + QByteArray::number(i % 2));
+        doc.setMTime(1);
+        tr.addDocument(doc);
+
+        m_ids << doc.id();
+    }
+    tr.commit();
+}
+
+void IndexCheckerTest::cleanup()
+{
+    delete m_db;
+    delete m_dir;
+}
+
+QVector<IndexChecker::Problem> IndexCheckerTest::check(IndexChecker* checker)
+{
+    QVector<IndexChecker::Problem> problems;
+    bool checked = checker->check([&problems](const IndexChecker::Problem& problem) {
+        problems << problem;
+    });
+    Q_ASSERT(checked);
+    Q_UNUSED(checked);
+    return problems;
+}
+
+void IndexCheckerTest::testConsistent()
+{
+    IndexChecker checker(m_db);
+    QVERIFY(check(&checker).isEmpty());
+    QCOMPARE(checker.documentCount(), 10ULL);
+    QCOMPARE(checker.postingCount(), 40ULL);
+
+    // Every document in its own chunk, and the terms spread over threads
+    checker.setChunkSize(1);
+    checker.setThreadCount(3);
+    QVERIFY(check(&checker).isEmpty());
+    QCOMPARE(checker.documentCount(), 10ULL);
+    QCOMPARE(checker.postingCount(), 40ULL);
+}
+
+void IndexCheckerTest::testRepair()
+{
+    // Break the posting lists in both directions
+    {
+        Transaction tr(m_db, Transaction::ReadWrite);
+        IndexChecker::repair(&tr, {IndexChecker::Problem::UnknownPosting, m_ids[3], "fire"});
+        IndexChecker::repair(&tr, {IndexChecker::Problem::MissingPosting, m_ids[5], "term1"});
+        tr.commit();
+    }
+
+    IndexChecker checker(m_db);
+    checker.setChunkSize(2);
+    checker.setThreadCount(2);
+
+    QVector<IndexChecker::Problem> problems = check(&checker);
+    QCOMPARE(problems.size(), 2);
+    for (const IndexChecker::Problem& problem : problems) {
+        if (problem.type == IndexChecker::Problem::MissingPosting) {
+            QCOMPARE(problem.id, m_ids[3]);
+            QCOMPARE(problem.term, QByteArray("fire"));
+        } else {
+            QCOMPARE(problem.type, IndexChecker::Problem::UnknownPosting);
+            QCOMPARE(problem.id, m_ids[5]);
+            QCOMPARE(problem.term, QByteArray("term1"));
+        }
+    }
+
+    {
+        Transaction tr(m_db, Transaction::ReadWrite);
+        for (const IndexChecker::Problem& problem : problems) {
+            IndexChecker::repair(&tr, problem);
+        }
+        tr.commit();
+    }
+    QVERIFY(check(&checker).isEmpty());
+
+    Transaction tr(m_db, Transaction::ReadOnly);
+    QCOMPARE(tr.exec(EngineQuery("fire")).size(), 10);
+    QCOMPARE(tr.exec(EngineQuery("term1")).size(), 1);
+}
+
+void IndexCheckerTest::testMissingPostingList()
+{
+    // The only posting of the term, so its posting list is gone
+    {
+        Transaction tr(m_db, Transaction::ReadWrite);
+        IndexChecker::repair(&tr, {IndexChecker::Problem::UnknownPosting, m_ids[7], "term7"});
+        tr.commit();
+    }
+
+    IndexChecker checker(m_db);
+    checker.setChunkSize(1);
+    checker.setThreadCount(3);
+
+    const QVector<IndexChecker::Problem> problems = check(&checker);
+    QCOMPARE(problems.size(), 1);
+    QCOMPARE(problems.first().type, IndexChecker::Problem::MissingPosting);
+    QCOMPARE(problems.first().id, m_ids[7]);
+    QCOMPARE(problems.first().term, QByteArray("term7"));
+    QCOMPARE(checker.postingCount(), 39ULL);
+}
+
+void IndexCheckerTest::testManyProblems()
+{
+    // More problems than the scanners may queue up
+    {
+        Transaction tr(m_db, Transaction::ReadWrite);
+        for (int i = 0; i < 3000; i++) {
+            const QByteArray term = "extra" + QByteArray::number(i);
+            IndexChecker::repair(&tr, {IndexChecker::Problem::MissingPosting, m_ids[i % 10], term});
+        }
+        tr.commit();
+    }
+
+    IndexChecker checker(m_db);
+    checker.setThreadCount(3);
+
+    int count = 0;
+    QVERIFY(checker.check([this, &count](const IndexChecker::Problem& problem) {
+        QCOMPARE(problem.type, IndexChecker::Problem::UnknownPosting);
+        QCOMPARE(problem.id, m_ids[problem.term.mid(5).toInt() % 10]);
+        count++;
+    }));
+    QCOMPARE(count, 3000);
+    QCOMPARE(checker.postingCount(), 3040ULL);
+}
+
+QTEST_MAIN(IndexCheckerTest)
+
+#include "indexcheckertest.moc"
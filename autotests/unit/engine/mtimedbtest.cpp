@@ -22,6 +22,10 @@
 #include "postingiterator.h"
 #include "singledbtest.h"
 
+#include <QDateTime>
+
+#include <limits>
+
 using namespace Baloo;
 
 class MTimeDBTest : public SingleDBTest
@@ -96,6 +100,9 @@ private Q_SLOTS:
             QCOMPARE(it->next(), static_cast<quint64>(val));
             QCOMPARE(it->docId(), static_cast<quint64>(val));
         }
+
+        QVERIFY(!db.iterRange(10, 12));
+        QVERIFY(!db.iterRange(3, 4));
     }
 
     void testSortedAndUnique()
@@ -132,6 +139,47 @@ private Q_SLOTS:
             }
         }
     }
+
+    void testHistogram()
+    {
+        MTimeDB db(MTimeDB::create(m_txn), m_txn);
+
+        auto time = [](int year, int month, int day, int hour) {
+            return QDateTime(QDate(year, month, day), QTime(hour, 0)).toTime_t();
+        };
+
+        db.put(time(2015, 6, 1, 10), 1);
+        db.put(time(2015, 6, 1, 23), 2);
+        db.put(time(2015, 6, 1, 23), 3);
+        db.put(time(2015, 6, 3, 8), 4);
+        db.put(time(2015, 7, 1, 0), 5);
+        db.put(time(2016, 1, 1, 12), 6);
+
+        QMap<QDate, uint> days;
+        days.insert(QDate(2015, 6, 1), 3);
+        days.insert(QDate(2015, 6, 3), 1);
+        days.insert(QDate(2015, 7, 1), 1);
+        days.insert(QDate(2016, 1, 1), 1);
+        QCOMPARE(db.histogram(0, std::numeric_limits<quint32>::max(), MTimeDB::Day), days);
+
+        QMap<QDate, uint> months;
+        months.insert(QDate(2015, 6, 1), 4);
+        months.insert(QDate(2015, 7, 1), 1);
+        QCOMPARE(db.histogram(time(2015, 1, 1, 0), time(2015, 12, 31, 23), MTimeDB::Month), months);
+
+        QMap<QDate, uint> years;
+        years.insert(QDate(2015, 1, 1), 5);
+        years.insert(QDate(2016, 1, 1), 1);
+        QCOMPARE(db.histogram(0, std::numeric_limits<quint32>::max(), MTimeDB::Year), years);
+
+        const QVector<quint64> ids = {2, 4, 6};
+        years.clear();
+        years.insert(QDate(2015, 1, 1), 2);
+        years.insert(QDate(2016, 1, 1), 1);
+        QCOMPARE(db.histogram(0, std::numeric_limits<quint32>::max(), MTimeDB::Year, &ids), years);
+
+        QVERIFY(db.histogram(time(2017, 1, 1, 0), time(2017, 12, 31, 23), MTimeDB::Day).isEmpty());
+    }
 };
 
 QTEST_MAIN(MTimeDBTest)
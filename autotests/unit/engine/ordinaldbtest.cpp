@@ -0,0 +1,144 @@
+/*
+   This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+ */
+
+#include "ordinaldb.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class OrdinalDBTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+    void testFreeList();
+    void testHint();
+    void testReset();
+};
+
+static OrdinalDB createOrdinalDB(MDB_txn* txn)
+{
+    return OrdinalDB(OrdinalDB::create("idordinaldb", txn),
+                     OrdinalDB::create("ordinaliddb", txn),
+                     OrdinalDB::create("freeordinaldb", txn), txn);
+}
+
+void OrdinalDBTest::test()
+{
+    OrdinalDB db = createOrdinalDB(m_txn);
+
+    quint32 first = 0;
+    quint32 last = 0;
+    QVERIFY(!db.range(&first, &last));
+    QCOMPARE(db.ordinal(0x500000001), 0U);
+
+    QCOMPARE(db.assign(0x500000001), 1U);
+    QCOMPARE(db.assign(0x100000007), 2U);
+    QCOMPARE(db.assign(0x500000001), 1U);
+
+    QCOMPARE(db.ordinal(0x100000007), 2U);
+    QCOMPARE(db.id(1), 0x500000001ULL);
+    QCOMPARE(db.id(3), 0ULL);
+
+    QVERIFY(db.range(&first, &last));
+    QCOMPARE(first, 1U);
+    QCOMPARE(last, 2U);
+
+    QMap<quint64, quint32> map;
+    map.insert(0x500000001, 1);
+    map.insert(0x100000007, 2);
+    QCOMPARE(db.toTestMap(), map);
+}
+
+void OrdinalDBTest::testFreeList()
+{
+    OrdinalDB db = createOrdinalDB(m_txn);
+
+    for (quint64 id = 1; id <= 4; id++) {
+        db.assign(id);
+    }
+
+    QCOMPARE(db.del(3), 3U);
+    QCOMPARE(db.del(2), 2U);
+    QCOMPARE(db.del(2), 0U);
+    QCOMPARE(db.ordinal(3), 0U);
+    QCOMPARE(db.id(3), 0ULL);
+    QCOMPARE(db.freeOrdinals(), QVector<quint32>() << 2 << 3);
+
+    // The lowest free ordinal is reused first
+    QCOMPARE(db.assign(7), 2U);
+    QCOMPARE(db.assign(8), 3U);
+    QCOMPARE(db.assign(9), 5U);
+    QVERIFY(db.freeOrdinals().isEmpty());
+
+    QCOMPARE(db.del(9), 5U);
+    quint32 first = 0;
+    quint32 last = 0;
+    QVERIFY(db.range(&first, &last));
+    QCOMPARE(first, 1U);
+    QCOMPARE(last, 4U);
+}
+
+void OrdinalDBTest::testHint()
+{
+    OrdinalDB db = createOrdinalDB(m_txn);
+
+    for (quint64 id = 1; id <= 6; id++) {
+        db.assign(id);
+    }
+    db.del(2);
+    db.del(5);
+
+    // The next free ordinal and the document in front of it
+    quint64 previousId = 0;
+    QCOMPARE(db.nextFree(3, &previousId), 5U);
+    QCOMPARE(previousId, 4ULL);
+    QCOMPARE(db.nextFree(1, &previousId), 2U);
+    QCOMPARE(previousId, 1ULL);
+    QCOMPARE(db.nextFree(5, &previousId), 0U);
+
+    // The hint if it is free, else the lowest free ordinal
+    QCOMPARE(db.assign(10, 5), 5U);
+    QCOMPARE(db.assign(11, 4), 2U);
+    QCOMPARE(db.assign(12, 2), 7U);
+}
+
+void OrdinalDBTest::testReset()
+{
+    OrdinalDB db = createOrdinalDB(m_txn);
+
+    for (quint64 id = 1; id <= 3; id++) {
+        db.assign(id);
+    }
+    db.del(2);
+    QCOMPARE(db.idsByOrdinal(), QVector<quint64>({0, 1, 0, 3}));
+
+    db.reset({3, 0, 1});
+    QCOMPARE(db.ordinal(3), 1U);
+    QCOMPARE(db.ordinal(1), 3U);
+    QCOMPARE(db.id(2), 0ULL);
+    QCOMPARE(db.freeOrdinals(), QVector<quint32>() << 2);
+    QCOMPARE(db.idsByOrdinal(), QVector<quint64>({0, 3, 0, 1}));
+}
+
+QTEST_MAIN(OrdinalDBTest)
+
+#include "ordinaldbtest.moc"
@@ -31,6 +31,7 @@ class OrPostingIteratorTest : public QObject
 private Q_SLOTS:
     void test();
     void testNullIterators();
+    void testSkipTo();
 };
 
 void OrPostingIteratorTest::test()
@@ -80,6 +81,22 @@ void OrPostingIteratorTest::testNullIterators()
 }
 
 
+void OrPostingIteratorTest::testSkipTo()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7};
+    QVector<quint64> l2 = {3, 4, 5, 7, 9, 11};
+
+    QVector<PostingIterator*> vec = {new VectorPostingIterator(l1), new VectorPostingIterator(l2)};
+    OrPostingIterator it(vec);
+    QCOMPARE(it.estimatedSize(), static_cast<uint>(10));
+
+    QCOMPARE(it.skipTo(4), static_cast<quint64>(4));
+    QCOMPARE(it.next(), static_cast<quint64>(5));
+    QCOMPARE(it.skipTo(8), static_cast<quint64>(9));
+    QCOMPARE(it.next(), static_cast<quint64>(11));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+}
+
 QTEST_MAIN(OrPostingIteratorTest)
 
 #include "orpostingiteratortest.moc"
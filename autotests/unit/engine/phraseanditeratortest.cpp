@@ -32,6 +32,8 @@ class PhraseAndIteratorTest : public QObject
 private Q_SLOTS:
     void test();
     void testNullIterators();
+    void testThreeTerms();
+    void testSkipTo();
 };
 
 void PhraseAndIteratorTest::test()
@@ -109,6 +111,37 @@ void PhraseAndIteratorTest::testNullIterators()
     QCOMPARE(it.docId(), static_cast<quint64>(0));
 }
 
+void PhraseAndIteratorTest::testThreeTerms()
+{
+    // "a b c" appears at 40 in document 1, but not in document 3
+    QVector<PositionInfo> vec1 = {PositionInfo(1, {1, 5, 9, 20, 40, 77}), PositionInfo(3, {1, 10})};
+    QVector<PositionInfo> vec2 = {PositionInfo(1, {2, 41}), PositionInfo(3, {2, 11})};
+    QVector<PositionInfo> vec3 = {PositionInfo(1, {4, 8, 12, 30, 42, 50, 60, 70, 80}), PositionInfo(3, {13, 20})};
+
+    QVector<PostingIterator*> vec = {new VectorPositionInfoIterator(vec1),
+                                     new VectorPositionInfoIterator(vec2),
+                                     new VectorPositionInfoIterator(vec3)};
+    PhraseAndIterator it(vec);
+
+    QCOMPARE(it.next(), static_cast<quint64>(1));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
+
+void PhraseAndIteratorTest::testSkipTo()
+{
+    QVector<PositionInfo> vec1 = {PositionInfo(1, {1}), PositionInfo(4, {1}), PositionInfo(6, {5}), PositionInfo(9, {3})};
+    QVector<PositionInfo> vec2 = {PositionInfo(1, {2}), PositionInfo(5, {2}), PositionInfo(6, {6}), PositionInfo(9, {4})};
+
+    QVector<PostingIterator*> vec = {new VectorPositionInfoIterator(vec1), new VectorPositionInfoIterator(vec2)};
+    PhraseAndIterator it(vec);
+
+    QCOMPARE(it.skipTo(2), static_cast<quint64>(6));
+    QCOMPARE(it.skipTo(6), static_cast<quint64>(6));
+    QCOMPARE(it.next(), static_cast<quint64>(9));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+}
+
 QTEST_MAIN(PhraseAndIteratorTest)
 
 #include "phraseanditeratortest.moc"
@@ -0,0 +1,162 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "postingcache.h"
+#include "postingdb.h"
+#include "queryprofile.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class PostingCacheTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testSnapshots();
+    void testBudget();
+    void testRemove();
+    void testPostingDB();
+};
+
+void PostingCacheTest::testSnapshots()
+{
+    PostingCache cache;
+    PostingList list;
+
+    cache.put(m_env, 5, "fire", {1, 3, 5});
+    QVERIFY(cache.get(m_env, 5, "fire", &list));
+    QCOMPARE(list, PostingList({1, 3, 5}));
+    QVERIFY(!cache.get(m_env, 6, "fire", &list));
+    QVERIFY(!cache.get(m_env, 5, "water", &list));
+    QCOMPARE(cache.hits(), 1ULL);
+    QCOMPARE(cache.misses(), 2ULL);
+
+    // A newer snapshot drops the lists of the older ones
+    cache.put(m_env, 6, "water", {2});
+    QVERIFY(!cache.get(m_env, 5, "fire", &list));
+    QVERIFY(cache.get(m_env, 6, "water", &list));
+
+    // Older snapshots are not cached anymore
+    cache.put(m_env, 5, "fire", {1, 3, 5});
+    QVERIFY(!cache.get(m_env, 5, "fire", &list));
+}
+
+void PostingCacheTest::testBudget()
+{
+    PostingCache cache;
+    cache.setMaxBytes(1024);
+    QCOMPARE(cache.maxBytes(), 1024);
+
+    const PostingList list(32, 1);
+    cache.put(m_env, 1, "a", list);
+    cache.put(m_env, 1, "b", list);
+    QVERIFY(cache.bytes() > 0);
+
+    PostingList result;
+    QVERIFY(cache.get(m_env, 1, "a", &result));
+
+    // "b" is the least recently used one
+    cache.put(m_env, 1, "c", list);
+    QVERIFY(cache.bytes() <= 1024);
+    QVERIFY(cache.get(m_env, 1, "a", &result));
+    QVERIFY(!cache.get(m_env, 1, "b", &result));
+    QVERIFY(cache.get(m_env, 1, "c", &result));
+
+    // Lists larger than the budget are not cached at all
+    cache.put(m_env, 1, "d", PostingList(1024, 1));
+    QVERIFY(!cache.get(m_env, 1, "d", &result));
+    QVERIFY(cache.get(m_env, 1, "a", &result));
+}
+
+void PostingCacheTest::testRemove()
+{
+    int otherEnv;
+    MDB_env* other = reinterpret_cast<MDB_env*>(&otherEnv);
+
+    PostingCache cache;
+    cache.put(m_env, 3, "fire", {1});
+    cache.put(other, 7, "fire", {2});
+
+    cache.remove(m_env);
+
+    PostingList list;
+    QVERIFY(!cache.get(m_env, 3, "fire", &list));
+    QVERIFY(cache.get(other, 7, "fire", &list));
+    QCOMPARE(list, PostingList({2}));
+
+    // The transaction ids start over for a new environment
+    cache.put(m_env, 1, "fire", {3});
+    QVERIFY(cache.get(m_env, 1, "fire", &list));
+}
+
+void PostingCacheTest::testPostingDB()
+{
+    MDB_dbi dbi = PostingDB::create(m_txn);
+    {
+        PostingDB db(dbi, m_txn);
+        db.put("fir", {1, 3, 5});
+        db.put("fire", {1, 8, 9});
+    }
+    QCOMPARE(mdb_txn_commit(m_txn), 0);
+    QCOMPARE(mdb_txn_begin(m_env, nullptr, MDB_RDONLY, &m_txn), 0);
+
+    PostingCache cache;
+    DBCounters counters;
+
+    PostingDB db(dbi, m_txn);
+    db.setCache(&cache);
+    db.setCounters(&counters);
+
+    for (int i = 0; i < 2; i++) {
+        QScopedPointer<PostingIterator> it(db.iter("fire"));
+        QVERIFY(it);
+        QCOMPARE(it->next(), 1ULL);
+        QCOMPARE(it->next(), 8ULL);
+        QCOMPARE(it->next(), 9ULL);
+        QCOMPARE(it->next(), 0ULL);
+    }
+    QCOMPARE(counters.terms, 2u);
+    QCOMPARE(counters.cached, 1u);
+    QCOMPARE(counters.gets, 1ULL);
+
+    // The prefix iterator neither uses the cache nor fills it
+    QScopedPointer<PostingIterator> it(db.prefixIter("fir"));
+    QVERIFY(it);
+    QCOMPARE(counters.terms, 4u);
+    QCOMPARE(counters.cached, 1u);
+    QCOMPARE(cache.hits(), 1ULL);
+    QCOMPARE(cache.misses(), 1ULL);
+
+    QScopedPointer<PostingIterator> firIt(db.iter("fir"));
+    QVERIFY(firIt);
+    QCOMPARE(counters.cached, 1u);
+    QCOMPARE(cache.misses(), 2ULL);
+
+    QVector<quint64> ids;
+    while (it->next()) {
+        ids << it->docId();
+    }
+    QCOMPARE(ids, QVector<quint64>({1, 3, 5, 8, 9}));
+}
+
+QTEST_MAIN(PostingCacheTest)
+
+#include "postingcachetest.moc"
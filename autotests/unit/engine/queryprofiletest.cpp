@@ -0,0 +1,85 @@
+/*
+   This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "queryprofile.h"
+#include "andpostingiterator.h"
+#include "vectorpostingiterator.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class QueryProfileTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+    void testNullIterator();
+};
+
+void QueryProfileTest::test()
+{
+    QueryProfile profile;
+
+    profile.dbCounters()->terms = 1;
+    profile.dbCounters()->gets = 2;
+    PostingIterator* it1 = profile.wrap(new VectorPostingIterator({1, 3, 5, 7}), "a");
+    PostingIterator* it2 = profile.wrap(new VectorPostingIterator({3, 7}), "b");
+
+    QScopedPointer<PostingIterator> it(profile.create<AndPostingIterator>("AND", {it1, it2}));
+    QCOMPARE(it->next(), static_cast<quint64>(3));
+    QCOMPARE(it->next(), static_cast<quint64>(7));
+    QCOMPARE(it->next(), static_cast<quint64>(0));
+    it.reset();
+
+    const QVector<QueryProfile::Node> nodes = profile.nodes();
+    QCOMPARE(nodes.size(), 3);
+
+    QCOMPARE(nodes[0].name, QByteArray("a"));
+    QCOMPARE(nodes[0].db.terms, 1u);
+    QCOMPARE(nodes[0].db.gets, static_cast<quint64>(2));
+    QCOMPARE(nodes[1].db.gets, static_cast<quint64>(0));
+
+    // "b" is the smaller list and drives the intersection
+    QCOMPARE(nodes[1].nextCalls, static_cast<quint64>(3));
+    QCOMPARE(nodes[1].ids, static_cast<quint64>(2));
+    QCOMPARE(nodes[0].nextCalls, static_cast<quint64>(0));
+    QCOMPARE(nodes[0].skipToCalls, static_cast<quint64>(2));
+
+    QCOMPARE(nodes[2].name, QByteArray("AND"));
+    QCOMPARE(nodes[2].children, QVector<int>({0, 1}));
+    QCOMPARE(nodes[2].nextCalls, static_cast<quint64>(3));
+    QCOMPARE(nodes[2].ids, static_cast<quint64>(2));
+
+    QVERIFY(nodes[0].hasParent);
+    QVERIFY(!nodes[2].hasParent);
+    QVERIFY(profile.toString().startsWith(QStringLiteral("AND")));
+}
+
+void QueryProfileTest::testNullIterator()
+{
+    QueryProfile profile;
+    QCOMPARE(profile.wrap(nullptr, "a"), static_cast<PostingIterator*>(nullptr));
+    QCOMPARE(profile.nodes().size(), 1);
+    QVERIFY(profile.toString().startsWith(QStringLiteral("a (no match)")));
+}
+
+QTEST_MAIN(QueryProfileTest)
+
+#include "queryprofiletest.moc"
@@ -0,0 +1,163 @@
+/*
+   This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "residentidsets.h"
+#include "idfilenamedb.h"
+#include "documentiddb.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class ResidentIdSetsTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testBuild();
+    void testUpdate();
+    void testSaveAndLoad();
+};
+
+static IdFilenameDB::FilePath filePath(const QByteArray& name)
+{
+    IdFilenameDB::FilePath path;
+    path.name = name;
+    return path;
+}
+
+void ResidentIdSetsTest::testBuild()
+{
+    DatabaseDbis dbis;
+    dbis.idFilenameDbi = IdFilenameDB::create(m_txn);
+    dbis.contentIndexingDbi = DocumentIdDB::create("indexingleveldb", m_txn);
+    dbis.failedIdDbi = DocumentIdDB::create("failediddb", m_txn);
+
+    IdFilenameDB idFilenameDB(dbis.idFilenameDbi, m_txn);
+    idFilenameDB.put(7, filePath("b"));
+    idFilenameDB.put(3, filePath("a"));
+    DocumentIdDB(dbis.contentIndexingDbi, m_txn).put(7);
+
+    ResidentIdSets sets(m_tempDir->path() + QStringLiteral("/index-ids"), m_tempDir->path() + QStringLiteral("/data.mdb"));
+    const quint64 txnId = mdb_txn_id(m_txn);
+
+    bool contains = false;
+    QVERIFY(!sets.lookup(ResidentIdSets::Documents, 3, txnId, &contains));
+
+    sets.build(m_txn, dbis);
+    QCOMPARE(sets.txnId(), txnId);
+    QCOMPARE(sets.toTestVector(ResidentIdSets::Documents), QVector<quint64>({3, 7}));
+    QCOMPARE(sets.toTestVector(ResidentIdSets::PhaseOne), QVector<quint64>({7}));
+    QVERIFY(sets.toTestVector(ResidentIdSets::Failed).isEmpty());
+
+    QVERIFY(sets.lookup(ResidentIdSets::Documents, 3, txnId, &contains));
+    QVERIFY(contains);
+    QVERIFY(sets.lookup(ResidentIdSets::PhaseOne, 3, txnId, &contains));
+    QVERIFY(!contains);
+
+    // Other snapshots are not answered
+    QVERIFY(!sets.lookup(ResidentIdSets::Documents, 3, txnId + 1, &contains));
+}
+
+void ResidentIdSetsTest::testUpdate()
+{
+    DatabaseDbis dbis;
+    dbis.idFilenameDbi = IdFilenameDB::create(m_txn);
+    dbis.contentIndexingDbi = DocumentIdDB::create("indexingleveldb", m_txn);
+    dbis.failedIdDbi = DocumentIdDB::create("failediddb", m_txn);
+    IdFilenameDB(dbis.idFilenameDbi, m_txn).put(5, filePath("a"));
+
+    ResidentIdSets sets(m_tempDir->path() + QStringLiteral("/index-ids"), m_tempDir->path() + QStringLiteral("/data.mdb"));
+    sets.build(m_txn, dbis);
+    const quint64 txnId = sets.txnId();
+
+    ResidentIdSets::Changes changes;
+    changes.insert(5, 1u << ResidentIdSets::Failed);
+    changes.insert(2, (1u << ResidentIdSets::Documents) | (1u << ResidentIdSets::PhaseOne));
+
+    // Only the next snapshot can be reached
+    sets.update(txnId + 2, changes);
+    QCOMPARE(sets.txnId(), txnId);
+
+    sets.update(txnId + 1, changes);
+    QCOMPARE(sets.txnId(), txnId + 1);
+    QCOMPARE(sets.toTestVector(ResidentIdSets::Documents), QVector<quint64>({2}));
+    QCOMPARE(sets.toTestVector(ResidentIdSets::PhaseOne), QVector<quint64>({2}));
+    QCOMPARE(sets.toTestVector(ResidentIdSets::Failed), QVector<quint64>({5}));
+
+    sets.update(txnId + 2, ResidentIdSets::Changes());
+    QCOMPARE(sets.txnId(), txnId + 2);
+    QCOMPARE(sets.toTestVector(ResidentIdSets::Documents), QVector<quint64>({2}));
+}
+
+void ResidentIdSetsTest::testSaveAndLoad()
+{
+    const QString idsPath = m_tempDir->path() + QStringLiteral("/index-ids");
+    const QString indexPath = m_tempDir->path() + QStringLiteral("/data.mdb");
+
+    DatabaseDbis dbis;
+    dbis.idFilenameDbi = IdFilenameDB::create(m_txn);
+    dbis.contentIndexingDbi = DocumentIdDB::create("indexingleveldb", m_txn);
+    dbis.failedIdDbi = DocumentIdDB::create("failediddb", m_txn);
+    IdFilenameDB(dbis.idFilenameDbi, m_txn).put(1, filePath("a"));
+    IdFilenameDB(dbis.idFilenameDbi, m_txn).put(9, filePath("b"));
+    DocumentIdDB(dbis.failedIdDbi, m_txn).put(9);
+
+    quint64 txnId;
+    {
+        ResidentIdSets sets(idsPath, indexPath);
+        QVERIFY(!sets.save());
+
+        sets.build(m_txn, dbis);
+        txnId = sets.txnId();
+        QVERIFY(sets.save());
+    }
+
+    // Saved for another data file, such as the one replaced by compacting
+    {
+        const QString otherPath = m_tempDir->path() + QStringLiteral("/other.mdb");
+        QVERIFY(QFile::copy(indexPath, otherPath));
+
+        ResidentIdSets sets(idsPath, otherPath);
+        QVERIFY(!sets.load(txnId));
+        QCOMPARE(sets.txnId(), 0ULL);
+    }
+
+    ResidentIdSets sets(idsPath, indexPath);
+    QVERIFY(!sets.load(txnId + 1));
+    QCOMPARE(sets.txnId(), 0ULL);
+
+    QVERIFY(sets.load(txnId));
+    QCOMPARE(sets.txnId(), txnId);
+    QCOMPARE(sets.toTestVector(ResidentIdSets::Documents), QVector<quint64>({1, 9}));
+    QCOMPARE(sets.toTestVector(ResidentIdSets::Failed), QVector<quint64>({9}));
+
+    // The mapped sets are copied once they change
+    ResidentIdSets::Changes changes;
+    changes.insert(4, 1u << ResidentIdSets::Documents);
+    sets.update(txnId + 1, changes);
+    QCOMPARE(sets.toTestVector(ResidentIdSets::Documents), QVector<quint64>({1, 4, 9}));
+    QCOMPARE(sets.toTestVector(ResidentIdSets::Failed), QVector<quint64>({9}));
+
+    sets.clear();
+    QCOMPARE(sets.txnId(), 0ULL);
+    QVERIFY(!QFile::exists(idsPath));
+}
+
+QTEST_MAIN(ResidentIdSetsTest)
+
+#include "residentidsetstest.moc"
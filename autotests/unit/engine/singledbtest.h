@@ -35,7 +35,7 @@ private Q_SLOTS:
         m_tempDir = new QTemporaryDir();
 
         mdb_env_create(&m_env);
-        mdb_env_set_maxdbs(m_env, 1);
+        mdb_env_set_maxdbs(m_env, 3);
 
         // The directory needs to be created before opening the environment
         QByteArray path = QFile::encodeName(m_tempDir->path());
@@ -0,0 +1,132 @@
+/*
+   This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "tagdb.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class TagDBTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+    void testHierarchy();
+    void testUnsplitTags();
+};
+
+static TagDB::TagInfo tagInfo(quint32 documentCount, quint32 childCount)
+{
+    TagDB::TagInfo info;
+    info.documentCount = documentCount;
+    info.childCount = childCount;
+    return info;
+}
+
+void TagDBTest::test()
+{
+    TagDB db(TagDB::create(m_txn), m_txn);
+
+    QCOMPARE(db.get("fire"), TagDB::TagInfo());
+
+    db.setDocumentCount("fire", 2);
+    db.setDocumentCount("water", 1);
+    QCOMPARE(db.get("fire"), tagInfo(2, 0));
+    QCOMPARE(db.get("water"), tagInfo(1, 0));
+
+    QMap<QByteArray, TagDB::TagInfo> children;
+    children.insert("fire", tagInfo(2, 0));
+    children.insert("water", tagInfo(1, 0));
+    QCOMPARE(db.children(QByteArray()), children);
+
+    db.setDocumentCount("fire", 0);
+    QCOMPARE(db.get("fire"), TagDB::TagInfo());
+    children.remove("fire");
+    QCOMPARE(db.children(QByteArray()), children);
+}
+
+void TagDBTest::testHierarchy()
+{
+    TagDB db(TagDB::create(m_txn), m_txn);
+
+    db.setDocumentCount("a/b/c", 3);
+    db.setDocumentCount("a/d", 1);
+    db.setDocumentCount("ab", 2);
+
+    QMap<QByteArray, TagDB::TagInfo> map;
+    map.insert("a", tagInfo(0, 2));
+    map.insert("a/b", tagInfo(0, 1));
+    map.insert("a/b/c", tagInfo(3, 0));
+    map.insert("a/d", tagInfo(1, 0));
+    map.insert("ab", tagInfo(2, 0));
+    QCOMPARE(db.toTestMap(), map);
+
+    QMap<QByteArray, TagDB::TagInfo> children;
+    children.insert("a", tagInfo(0, 2));
+    children.insert("ab", tagInfo(2, 0));
+    QCOMPARE(db.children(QByteArray()), children);
+
+    children.clear();
+    children.insert("b", tagInfo(0, 1));
+    children.insert("d", tagInfo(1, 0));
+    QCOMPARE(db.children("a"), children);
+    QVERIFY(db.children("a/d").isEmpty());
+
+    // Tagging an intermediate tag keeps its children
+    db.setDocumentCount("a/b", 1);
+    QCOMPARE(db.get("a/b"), tagInfo(1, 1));
+    QCOMPARE(db.get("a"), tagInfo(0, 2));
+
+    // Parents go away with their last child
+    db.setDocumentCount("a/b/c", 0);
+    QCOMPARE(db.get("a/b"), tagInfo(1, 0));
+    db.setDocumentCount("a/b", 0);
+    db.setDocumentCount("a/d", 0);
+
+    map.clear();
+    map.insert("ab", tagInfo(2, 0));
+    QCOMPARE(db.toTestMap(), map);
+}
+
+void TagDBTest::testUnsplitTags()
+{
+    TagDB db(TagDB::create(m_txn), m_txn);
+
+    db.setDocumentCount("a", 1);
+    db.setDocumentCount("/a", 2);
+    db.setDocumentCount("a/", 3);
+    db.setDocumentCount("a//b", 4);
+
+    QCOMPARE(TagDB::parentTag("a//b"), QByteArray("a/"));
+    QCOMPARE(TagDB::parentTag("/a"), QByteArray());
+
+    QMap<QByteArray, TagDB::TagInfo> children;
+    children.insert("a", tagInfo(1, 0));
+    children.insert("/a", tagInfo(2, 0));
+    children.insert("a/", tagInfo(3, 1));
+    QCOMPARE(db.children(QByteArray()), children);
+
+    children.clear();
+    children.insert("b", tagInfo(4, 0));
+    QCOMPARE(db.children("a/"), children);
+}
+
+QTEST_MAIN(TagDBTest)
+
+#include "tagdbtest.moc"
@@ -0,0 +1,54 @@
+/*
+   This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "termstatsdb.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class TermStatsDBTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+};
+
+void TermStatsDBTest::test()
+{
+    TermStatsDB db(TermStatsDB::create(m_txn), m_txn);
+
+    QCOMPARE(db.get("fire"), TermStatsDB::TermStats());
+
+    TermStatsDB::TermStats stats;
+    stats.documentCount = 2;
+    stats.minId = 5;
+    stats.maxId = 9;
+    stats.positionCount = 4;
+
+    db.put("fire", stats);
+    QCOMPARE(db.get("fire"), stats);
+    QCOMPARE(db.get("fir"), TermStatsDB::TermStats());
+
+    db.del("fire");
+    QCOMPARE(db.get("fire"), TermStatsDB::TermStats());
+}
+
+QTEST_MAIN(TermStatsDBTest)
+
+#include "termstatsdbtest.moc"
@@ -21,9 +21,23 @@
 #include "transaction.h"
 #include "database.h"
 #include "idutils.h"
+#include "databasesize.h"
+#include "storagereport.h"
+#include "enginequery.h"
 
 #include <QTest>
 #include <QTemporaryDir>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QDateTime>
+#include <QDir>
+
+#include <algorithm>
+#include <limits>
+
+#include <sys/file.h>
+
+#include <lmdb.h>
 
 using namespace Baloo;
 
@@ -43,6 +57,19 @@ private Q_SLOTS:
     }
 
     void testTimeInfo();
+    void testStatistics();
+    void testTags();
+    void testMTimeHistogram();
+    void testDbSize();
+    void testStorageReport();
+    void testDeferredSync();
+    void testCompact();
+    void testReorderDocuments();
+    void testSpareOrdinals();
+    void testReadTransactionPool();
+    void testSharded();
+    void testShardedDevices();
+    void testUnconvertedIndex();
 private:
     QTemporaryDir* dir;
     Database* db;
@@ -87,6 +114,866 @@ void TransactionTest::testTimeInfo()
     QCOMPARE(tr2.documentTimeInfo(id), timeInfo);
 }
 
+void TransactionTest::testStatistics()
+{
+    const QByteArray url1(dir->path().toUtf8() + "/file1");
+    const QByteArray url2(dir->path().toUtf8() + "/file2");
+    const quint64 id1 = touchFile(url1);
+    const quint64 id2 = touchFile(url2);
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+
+        Document doc;
+        doc.setId(id1);
+        doc.setUrl(url1);
+        doc.addPositionTerm("fire", 1);
+        doc.addPositionTerm("fire", 5);
+        doc.addTerm("water");
+        doc.setMTime(1);
+        doc.setContentIndexing(true);
+        tr.addDocument(doc);
+
+        Document doc2;
+        doc2.setId(id2);
+        doc2.setUrl(url2);
+        doc2.addPositionTerm("fire", 2);
+        doc2.setMTime(1);
+        tr.addDocument(doc2);
+
+        tr.commit();
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        QCOMPARE(tr.size(), 2u);
+        QCOMPARE(tr.phaseOneSize(), 1u);
+
+        // The documents are numbered in the order they were added
+        QCOMPARE(tr.idToOrdinal(id1), 1ULL);
+        QCOMPARE(tr.idToOrdinal(id2), 2ULL);
+        QCOMPARE(tr.ordinalToId(2), id2);
+
+        TermStatsDB::TermStats stats = tr.termStats("fire");
+        QCOMPARE(stats.documentCount, 2u);
+        QCOMPARE(stats.minId, 1ULL);
+        QCOMPARE(stats.maxId, 2ULL);
+        QCOMPARE(stats.positionCount, static_cast<quint64>(3));
+
+        QCOMPARE(tr.termStats("water").documentCount, 1u);
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.removeDocument(id1);
+        tr.commit();
+    }
+
+    Transaction tr(db, Transaction::ReadOnly);
+    QCOMPARE(tr.size(), 1u);
+    QCOMPARE(tr.phaseOneSize(), 0u);
+    QCOMPARE(tr.termStats("fire").documentCount, 1u);
+    QCOMPARE(tr.termStats("fire").positionCount, static_cast<quint64>(1));
+    QCOMPARE(tr.termStats("water"), TermStatsDB::TermStats());
+}
+
+void TransactionTest::testTags()
+{
+    const QByteArray url1(dir->path().toUtf8() + "/file1");
+    const QByteArray url2(dir->path().toUtf8() + "/file2");
+    const quint64 id1 = touchFile(url1);
+    const quint64 id2 = touchFile(url2);
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+
+        Document doc;
+        doc.setId(id1);
+        doc.setUrl(url1);
+        doc.addTerm("fire");
+        doc.addXattrBoolTerm("TAG-holiday/beach");
+        doc.addXattrBoolTerm("TAG-family");
+        doc.setMTime(1);
+        tr.addDocument(doc);
+
+        Document doc2;
+        doc2.setId(id2);
+        doc2.setUrl(url2);
+        doc2.addTerm("fire");
+        doc2.addXattrBoolTerm("TAG-holiday/beach");
+        doc2.setMTime(1);
+        tr.addDocument(doc2);
+
+        tr.commit();
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+
+        const QMap<QByteArray, TagDB::TagInfo> topLevel = tr.tagChildren(QByteArray());
+        QCOMPARE(topLevel.keys(), QList<QByteArray>({"family", "holiday"}));
+        QCOMPARE(topLevel.value("family").documentCount, 1u);
+        QCOMPARE(topLevel.value("holiday").documentCount, 0u);
+        QCOMPARE(topLevel.value("holiday").childCount, 1u);
+
+        const QMap<QByteArray, TagDB::TagInfo> holiday = tr.tagChildren("holiday");
+        QCOMPARE(holiday.keys(), QList<QByteArray>({"beach"}));
+        QCOMPARE(holiday.value("beach").documentCount, 2u);
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.removeDocument(id1);
+        tr.commit();
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        QCOMPARE(tr.tagChildren(QByteArray()).keys(), QList<QByteArray>({"holiday"}));
+        QCOMPARE(tr.tagChildren("holiday").value("beach").documentCount, 1u);
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.removeDocument(id2);
+        tr.commit();
+    }
+
+    Transaction tr(db, Transaction::ReadOnly);
+    QVERIFY(tr.tagChildren(QByteArray()).isEmpty());
+}
+
+void TransactionTest::testMTimeHistogram()
+{
+    const QByteArray url(dir->path().toUtf8() + "/file");
+    const quint64 id = touchFile(url);
+
+    const quint32 june = QDateTime(QDate(2015, 6, 1)).toTime_t();
+    const quint32 july = QDateTime(QDate(2015, 7, 1)).toTime_t();
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        doc.addTerm("fire");
+        doc.setMTime(june);
+        tr.addDocument(doc);
+        tr.commit();
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+
+        Document doc;
+        doc.setId(id);
+        doc.setMTime(july);
+        tr.replaceDocument(doc, DocumentTime);
+        tr.commit();
+    }
+
+    // The previous mtime is not counted anymore
+    Transaction tr(db, Transaction::ReadOnly);
+    QMap<QDate, uint> months;
+    months.insert(QDate(2015, 7, 1), 1);
+    QCOMPARE(tr.mTimeHistogram(0, std::numeric_limits<quint32>::max(), MTimeDB::Month), months);
+}
+
+class ReaderRunnable : public QRunnable
+{
+public:
+    ReaderRunnable(Database* db, quint64 id, QAtomicInt* found)
+        : m_db(db), m_id(id), m_found(found) {}
+
+    void run() Q_DECL_OVERRIDE {
+        for (int i = 0; i < 100; i++) {
+            Transaction tr(m_db, Transaction::ReadOnly);
+            if (tr.hasDocument(m_id)) {
+                m_found->ref();
+            }
+        }
+    }
+
+private:
+    Database* m_db;
+    quint64 m_id;
+    QAtomicInt* m_found;
+};
+
+void TransactionTest::testDbSize()
+{
+    const QByteArray url(dir->path().toUtf8() + "/file");
+    const quint64 id = touchFile(url);
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        doc.addPositionTerm("fire", 1);
+        doc.setMTime(1);
+        tr.addDocument(doc);
+        tr.commit();
+    }
+
+    Transaction tr(db, Transaction::ReadOnly);
+    const DatabaseSize size = tr.dbSize();
+    QVERIFY(size.postingDb > 0);
+    QVERIFY(size.positionDb > 0);
+    QVERIFY(size.termStatsDb > 0);
+    QCOMPARE(size.expectedSize, size.postingDb + size.positionDb + size.docTerms + size.docFilenameTerms
+                              + size.docXattrTerms + size.idTree + size.idFilename + size.docTime
+                              + size.docData + size.contentIndexingIds + size.failedIds + size.mtimeDb
+                              + size.ordinalDb + size.termStatsDb + size.metaDataDb + size.tagDb);
+    QVERIFY(size.actualSize >= size.expectedSize);
+}
+
+void TransactionTest::testStorageReport()
+{
+    const QByteArray url1(dir->path().toUtf8() + "/file1");
+    const QByteArray url2(dir->path().toUtf8() + "/file2");
+    const quint64 id1 = touchFile(url1);
+    const quint64 id2 = touchFile(url2);
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+
+        Document doc;
+        doc.setId(id1);
+        doc.setUrl(url1);
+        doc.addTerm("fire");
+        doc.addTerm("water");
+        doc.setMTime(1);
+        tr.addDocument(doc);
+
+        Document doc2;
+        doc2.setId(id2);
+        doc2.setUrl(url2);
+        doc2.addTerm("fire");
+        doc2.setMTime(1);
+        tr.addDocument(doc2);
+
+        tr.commit();
+    }
+
+    Transaction tr(db, Transaction::ReadOnly);
+    const StorageReport report = tr.storageReport(1);
+    QVERIFY(report.pageSize > 0);
+    QVERIFY(report.usedPages > 0);
+
+    StorageReport::Dbi postingDb;
+    for (const StorageReport::Dbi& dbi : report.dbis) {
+        if (dbi.name == "postingdb") {
+            postingDb = dbi;
+        }
+    }
+    QCOMPARE(postingDb.name, QByteArray("postingdb"));
+    QCOMPARE(postingDb.depth, size_t(1));
+    QCOMPARE(postingDb.overflowValues, size_t(0));
+
+    QCOMPARE(postingDb.entries, size_t(2));
+    QCOMPARE(postingDb.largestValues.size(), 1);
+    QCOMPARE(postingDb.largestValues.first().key, QByteArray("fire"));
+    QCOMPARE(postingDb.largestValues.first().overflowPages, size_t(0));
+}
+
+void TransactionTest::testDeferredSync()
+{
+    delete db;
+    db = new Database(dir->path());
+    db->setDurability(Database::DeferredSync);
+    QVERIFY(db->open(Database::CreateDatabase));
+
+    // A new database has no checkpoint
+    QVERIFY(!db->hasCheckpoint());
+    QVERIFY(db->sync());
+
+    quint32 checkpointTime = 0;
+    QVERIFY(db->hasCheckpoint(&checkpointTime));
+    QVERIFY(checkpointTime > 0);
+
+    const QByteArray url(dir->path().toUtf8() + "/file");
+    const quint64 id = touchFile(url);
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        doc.addTerm("fire");
+        doc.setMTime(1);
+        tr.addDocument(doc);
+        tr.commit();
+    }
+    QVERIFY(db->sync());
+    QVERIFY(db->hasCheckpoint());
+
+    // A clean shutdown removes the checkpoint
+    QVERIFY(db->sync(true));
+    QVERIFY(!db->hasCheckpoint());
+
+    // So does writing the index synchronously again
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.setPhaseOne(id);
+        tr.commit();
+    }
+    QVERIFY(db->sync());
+    QVERIFY(db->hasCheckpoint());
+
+    delete db;
+    db = new Database(dir->path());
+    QVERIFY(db->open(Database::CreateDatabase));
+    QVERIFY(db->hasCheckpoint());
+    QVERIFY(db->sync());
+    QVERIFY(!db->hasCheckpoint());
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        QVERIFY(tr.hasDocument(id));
+    }
+
+    // A held checkpoint stays, even on shutdown, until it is let go
+    db->holdCheckpoint(checkpointTime);
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.removePhaseOne(id);
+        tr.commit();
+    }
+    QVERIFY(db->sync());
+    quint32 heldTime = 0;
+    QVERIFY(db->hasCheckpoint(&heldTime));
+    QCOMPARE(heldTime, checkpointTime);
+    QVERIFY(db->sync(true));
+    QVERIFY(db->hasCheckpoint(&heldTime));
+    QCOMPARE(heldTime, checkpointTime);
+
+    db->holdCheckpoint(0);
+    QVERIFY(db->sync(true));
+    QVERIFY(!db->hasCheckpoint());
+}
+
+void TransactionTest::testCompact()
+{
+    const QByteArray url(dir->path().toUtf8() + "/file");
+    const quint64 id = touchFile(url);
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        for (int i = 1; i <= 2000; i++) {
+            Document doc;
+            doc.setId(id + i);
+            doc.setUrl(url + QByteArray::number(i));
+            doc.addTerm("fire" + QByteArray::number(i));
+            doc.addPositionTerm("water" + QByteArray::number(i), 1);
+            doc.setMTime(i);
+            tr.addDocument(doc);
+        }
+
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        doc.addTerm("fire");
+        doc.setMTime(1);
+        tr.addDocument(doc);
+        tr.commit();
+    }
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        for (int i = 1; i <= 2000; i++) {
+            tr.removeDocument(id + i);
+        }
+        tr.commit();
+    }
+
+    size_t freePages;
+    size_t usedPages;
+    quint64 snapshotId;
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        freePages = tr.freePageCount(&usedPages);
+        snapshotId = tr.snapshotId();
+    }
+    QVERIFY(freePages > 0);
+
+    // Another process using the index would keep using the replaced file
+    {
+        QFile users(dir->path() + QStringLiteral("/index-users"));
+        QVERIFY(users.open(QIODevice::ReadOnly));
+        QCOMPARE(flock(users.handle(), LOCK_SH), 0);
+        QVERIFY(!db->compact());
+    }
+
+    QVERIFY(db->compact());
+    QVERIFY(!QFile::exists(dir->path() + QStringLiteral("/index-compact")));
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        QVERIFY(tr.snapshotId() > snapshotId);
+
+        size_t compactedUsedPages;
+        QVERIFY(tr.freePageCount(&compactedUsedPages) < freePages);
+        QVERIFY(compactedUsedPages < usedPages);
+
+        QVERIFY(tr.hasDocument(id));
+        QVERIFY(!tr.hasDocument(id + 1));
+        QCOMPARE(tr.documentUrl(id), url);
+    }
+
+    // Writes keep working on the compacted index
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.removeDocument(id);
+        tr.commit();
+    }
+    Transaction tr(db, Transaction::ReadOnly);
+    QVERIFY(!tr.hasDocument(id));
+}
+
+void TransactionTest::testReorderDocuments()
+{
+    QVERIFY(QDir(dir->path()).mkdir(QStringLiteral("f")));
+    const QByteArray folderUrl(dir->path().toUtf8() + "/f");
+    const quint64 folderId = filePathToId(folderUrl);
+
+    const QByteArray urlA(dir->path().toUtf8() + "/a");
+    const QByteArray urlB(dir->path().toUtf8() + "/b");
+    const QByteArray urlG(dir->path().toUtf8() + "/g");
+    const QByteArray urlX(folderUrl + "/x");
+    const QByteArray urlY(folderUrl + "/y");
+    const quint64 idA = touchFile(urlA);
+    const quint64 idB = touchFile(urlB);
+    const quint64 idG = touchFile(urlG);
+    const quint64 idX = touchFile(urlX);
+    const quint64 idY = touchFile(urlY);
+
+    auto addDocument = [](Transaction* tr, quint64 id, const QByteArray& url, const QByteArray& term) {
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        doc.addPositionTerm(term, 1);
+        doc.setMTime(1);
+        tr->addDocument(doc);
+    };
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        addDocument(&tr, idB, urlB, "water");
+        addDocument(&tr, idX, urlX, "fire");
+        addDocument(&tr, idA, urlA, "fire");
+        addDocument(&tr, folderId, folderUrl, "folder");
+        addDocument(&tr, idG, urlG, "water");
+        tr.commit();
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        QVERIFY(tr.reorderDocuments());
+        tr.commit();
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        QVERIFY(!tr.reorderDocuments());
+        tr.abort();
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+
+        // The folder keeps a free ordinal after its documents
+        QCOMPARE(tr.idToOrdinal(idA), 1ULL);
+        QCOMPARE(tr.idToOrdinal(idB), 2ULL);
+        QCOMPARE(tr.idToOrdinal(folderId), 3ULL);
+        QCOMPARE(tr.idToOrdinal(idX), 4ULL);
+        QCOMPARE(tr.idToOrdinal(idG), 6ULL);
+
+        QVector<quint64> ids = {idA, idX};
+        std::sort(ids.begin(), ids.end());
+        QCOMPARE(tr.exec(EngineQuery("fire")), ids);
+        QCOMPARE(tr.termStats("fire").minId, 1ULL);
+        QCOMPARE(tr.termStats("fire").maxId, 4ULL);
+        QCOMPARE(tr.exec(EngineQuery("folder")), QVector<quint64>({folderId}));
+
+        const QMap<QDate, uint> histogram = tr.mTimeHistogram(0, 2, MTimeDB::Month);
+        QCOMPARE(histogram.size(), 1);
+        QCOMPARE(histogram.first(), 5u);
+    }
+
+    // Which goes to the next document added to the folder
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        addDocument(&tr, idY, urlY, "fire");
+        tr.commit();
+    }
+
+    Transaction tr(db, Transaction::ReadOnly);
+    QCOMPARE(tr.idToOrdinal(idY), 5ULL);
+    QCOMPARE(tr.exec(EngineQuery("fire")).size(), 3);
+}
+
+void TransactionTest::testSpareOrdinals()
+{
+    QVERIFY(QDir(dir->path()).mkdir(QStringLiteral("f")));
+    QVERIFY(QDir(dir->path()).mkdir(QStringLiteral("h")));
+    const QByteArray folderF(dir->path().toUtf8() + "/f");
+    const QByteArray folderH(dir->path().toUtf8() + "/h");
+
+    const QByteArray urlA(dir->path().toUtf8() + "/a");
+    const QByteArray urlI(dir->path().toUtf8() + "/i");
+    const QByteArray urlX(folderF + "/x");
+    const QByteArray urlY(folderF + "/y");
+    const QByteArray urlZ(folderF + "/z");
+    const QByteArray urlW(folderH + "/w");
+    const quint64 idA = touchFile(urlA);
+    const quint64 idI = touchFile(urlI);
+    const quint64 idX = touchFile(urlX);
+    const quint64 idY = touchFile(urlY);
+    const quint64 idZ = touchFile(urlZ);
+    const quint64 idW = touchFile(urlW);
+
+    auto addDocument = [](Transaction* tr, quint64 id, const QByteArray& url) {
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        doc.addTerm("fire");
+        doc.setMTime(1);
+        tr->addDocument(doc);
+    };
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        addDocument(&tr, idA, urlA);
+        addDocument(&tr, filePathToId(folderF), folderF);
+        addDocument(&tr, idX, urlX);
+        addDocument(&tr, filePathToId(folderH), folderH);
+        addDocument(&tr, idW, urlW);
+        addDocument(&tr, idI, urlI);
+        QVERIFY(tr.reorderDocuments());
+        tr.commit();
+    }
+
+    // a, f, x, (free), h, w, (free), i
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        QCOMPARE(tr.idToOrdinal(idX), 3ULL);
+        QCOMPARE(tr.idToOrdinal(idW), 6ULL);
+        QCOMPARE(tr.idToOrdinal(idI), 8ULL);
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        addDocument(&tr, idY, urlY);
+        tr.removeDocument(idA);
+
+        // f has used up its free ordinal, the one after h is not taken
+        addDocument(&tr, idZ, urlZ);
+        tr.commit();
+    }
+
+    Transaction tr(db, Transaction::ReadOnly);
+    QCOMPARE(tr.idToOrdinal(idY), 4ULL);
+    QCOMPARE(tr.idToOrdinal(idZ), 1ULL);
+}
+
+void TransactionTest::testReadTransactionPool()
+{
+    db->setReadTransactionPoolSize(2);
+
+    const QByteArray url(dir->path().toUtf8() + "/file");
+    const quint64 id = touchFile(url);
+
+    quint64 snapshotId;
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        QVERIFY(!tr.hasDocument(id));
+        snapshotId = tr.snapshotId();
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        doc.addTerm("a");
+        doc.setMTime(1);
+        tr.addDocument(doc);
+        tr.commit();
+    }
+
+    {
+        // A pooled transaction has to see the latest data once renewed
+        Transaction tr(db, Transaction::ReadOnly);
+        QVERIFY(tr.snapshotId() > snapshotId);
+        QVERIFY(tr.hasDocument(id));
+    }
+
+    QAtomicInt found;
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    for (int i = 0; i < 8; i++) {
+        pool.start(new ReaderRunnable(db, id, &found));
+    }
+    pool.waitForDone();
+
+    QCOMPARE(found.load(), 800);
+}
+
+void TransactionTest::testSharded()
+{
+    const QString path = dir->path() + QStringLiteral("/sharded");
+    Database shardedDb(path);
+    shardedDb.setSharded(true);
+    QVERIFY(shardedDb.open(Database::CreateDatabase));
+    QVERIFY(shardedDb.isSharded());
+    QVERIFY(!QFile::exists(path + QStringLiteral("/index")));
+
+    QDir(dir->path()).mkdir(QStringLiteral("folder"));
+    const QByteArray folderUrl(dir->path().toUtf8() + "/folder");
+    const QByteArray url1(folderUrl + "/file1");
+    const QByteArray url2(folderUrl + "/file2");
+    const quint64 folderId = filePathToId(folderUrl);
+    const quint64 id1 = touchFile(url1);
+    const quint64 id2 = touchFile(url2);
+    const quint32 deviceId = idToDeviceId(id1);
+
+    // The result cache relies on later snapshots having larger ids
+    quint64 snapshotId;
+    {
+        Transaction tr(shardedDb, Transaction::ReadOnly);
+        QCOMPARE(tr.size(), 0u);
+        QVERIFY(!tr.hasDocument(id1));
+        QCOMPARE(tr.exec(EngineQuery("fire")), QVector<quint64>());
+        snapshotId = tr.snapshotId();
+    }
+
+    {
+        Transaction tr(shardedDb, Transaction::ReadWrite);
+
+        Document doc;
+        doc.setId(id1);
+        doc.setUrl(url1);
+        doc.addTerm("fire");
+        doc.setMTime(1);
+        tr.addDocument(doc);
+
+        Document doc2;
+        doc2.setId(id2);
+        doc2.setUrl(url2);
+        doc2.addTerm("fire");
+        doc2.addTerm("water");
+        doc2.setMTime(2);
+        tr.addDocument(doc2);
+        tr.commit();
+    }
+
+    // The documents went to the shard of their device
+    QCOMPARE(shardedDb.shardDevices(), QVector<quint32>({deviceId}));
+    QVERIFY(QFile::exists(path + QStringLiteral("/shards/") + QString::number(deviceId) + QStringLiteral("/index")));
+    QVERIFY(shardedDb.fileSize() > 0);
+    {
+        Transaction tr(shardedDb.shard(deviceId), Transaction::ReadOnly);
+        QCOMPARE(tr.size(), 2u);
+    }
+
+    QVector<quint64> ids = {id1, id2};
+    std::sort(ids.begin(), ids.end());
+    {
+        Transaction tr(shardedDb, Transaction::ReadOnly);
+        QCOMPARE(tr.size(), 2u);
+        QCOMPARE(tr.documentUrl(id1), url1);
+        QCOMPARE(tr.documentId(url2), id2);
+        QCOMPARE(tr.documentChildren(folderId), ids);
+        QCOMPARE(tr.exec(EngineQuery("fire")), ids);
+        QCOMPARE(tr.exec(EngineQuery("water")), QVector<quint64>({id2}));
+        QCOMPARE(tr.termStats("fire").documentCount, 2u);
+        QCOMPARE(tr.documentTimeInfo(id2).mTime, 2u);
+
+        quint64 firstId;
+        quint64 lastId;
+        QVERIFY(tr.documentIdRange(&firstId, &lastId));
+        QCOMPARE(firstId, ids.first());
+        QCOMPARE(lastId, ids.last());
+
+        QVERIFY(tr.snapshotId() > snapshotId);
+        snapshotId = tr.snapshotId();
+    }
+
+    {
+        Transaction tr(shardedDb, Transaction::ReadWrite);
+        tr.removeDocument(id1);
+        tr.commit();
+    }
+    {
+        Transaction tr(shardedDb, Transaction::ReadOnly);
+        QCOMPARE(tr.exec(EngineQuery("fire")), QVector<quint64>({id2}));
+        QVERIFY(tr.snapshotId() > snapshotId);
+        snapshotId = tr.snapshotId();
+    }
+
+    // Dropping the shard drops its documents
+    QVERIFY(shardedDb.removeShard(deviceId));
+    QVERIFY(shardedDb.shardDevices().isEmpty());
+    QVERIFY(!QFile::exists(path + QStringLiteral("/shards/") + QString::number(deviceId)));
+    {
+        Transaction tr(shardedDb, Transaction::ReadOnly);
+        QCOMPARE(tr.size(), 0u);
+        QVERIFY(!tr.hasDocument(id2));
+        QVERIFY(tr.snapshotId() > snapshotId);
+    }
+
+    // The index of the fixture was created without shards
+    QVERIFY(!db->isSharded());
+}
+
+void TransactionTest::testShardedDevices()
+{
+    // Needs a second file system, which /dev/shm usually is
+    QTemporaryDir otherDir(QStringLiteral("/dev/shm/baloo-XXXXXX"));
+    const QByteArray url1(dir->path().toUtf8() + "/file1");
+    const QByteArray url2(otherDir.path().toUtf8() + "/file2");
+    const quint64 id1 = touchFile(url1);
+    const quint64 id2 = otherDir.isValid() ? touchFile(url2) : 0;
+    if (!id2 || idToDeviceId(id1) == idToDeviceId(id2)) {
+        QSKIP("No second file system for the temporary files");
+    }
+    const quint32 deviceId1 = idToDeviceId(id1);
+    const quint32 deviceId2 = idToDeviceId(id2);
+
+    Database shardedDb(dir->path() + QStringLiteral("/sharded"));
+    shardedDb.setSharded(true);
+    QVERIFY(shardedDb.open(Database::CreateDatabase));
+
+    // Written in the order of the shards, then in the reverse one
+    const QVector<QVector<QByteArray>> orders = {{url1, url2}, {url2, url1}};
+    for (const QVector<QByteArray>& urls : orders) {
+        Transaction tr(shardedDb, Transaction::ReadWrite);
+        for (const QByteArray& url : urls) {
+            Document doc;
+            doc.setId(filePathToId(url));
+            doc.setUrl(url);
+            doc.addTerm("fire");
+            doc.setMTime(1);
+            tr.addDocument(doc);
+        }
+        tr.commit();
+    }
+
+    QVector<quint32> devices = {deviceId1, deviceId2};
+    std::sort(devices.begin(), devices.end());
+    QCOMPARE(shardedDb.shardDevices(), devices);
+
+    QVector<quint64> ids = {id1, id2};
+    std::sort(ids.begin(), ids.end());
+    {
+        // Looking things up does not lock the shards for writing, or the
+        // second transaction would wait for the first one
+        Transaction lookup(shardedDb, Transaction::ReadWrite);
+        QCOMPARE(lookup.documentUrl(id1), url1);
+        QCOMPARE(lookup.documentUrl(id2), url2);
+        QCOMPARE(lookup.exec(EngineQuery("fire")), ids);
+
+        Transaction tr(shardedDb, Transaction::ReadWrite);
+        Document doc;
+        doc.setId(id2);
+        doc.setUrl(url2);
+        doc.addTerm("water");
+        doc.setMTime(2);
+        tr.replaceDocument(doc, DocumentTerms | DocumentTime);
+        tr.commit();
+
+        lookup.abort();
+    }
+
+    quint64 snapshotId;
+    {
+        Transaction tr(shardedDb, Transaction::ReadOnly);
+        QCOMPARE(tr.size(), 2u);
+        QCOMPARE(tr.exec(EngineQuery("fire")), QVector<quint64>({id1}));
+        QCOMPARE(tr.exec(EngineQuery("water")), QVector<quint64>({id2}));
+        snapshotId = tr.snapshotId();
+    }
+
+    // Dropping the shard of a device leaves those of the others alone
+    QVERIFY(shardedDb.removeShard(deviceId2));
+    QCOMPARE(shardedDb.shardDevices(), QVector<quint32>({deviceId1}));
+    {
+        Transaction tr(shardedDb, Transaction::ReadOnly);
+        QCOMPARE(tr.size(), 1u);
+        QVERIFY(tr.hasDocument(id1));
+        QVERIFY(!tr.hasDocument(id2));
+        QCOMPARE(tr.exec(EngineQuery("water")), QVector<quint64>());
+        QCOMPARE(tr.documentUrl(id1), url1);
+        QVERIFY(tr.snapshotId() > snapshotId);
+    }
+
+    {
+        Transaction tr(shardedDb, Transaction::ReadWrite);
+        tr.removeDocument(id1);
+        tr.commit();
+    }
+    Transaction tr(shardedDb, Transaction::ReadOnly);
+    QCOMPARE(tr.size(), 0u);
+}
+
+void TransactionTest::testUnconvertedIndex()
+{
+    const QByteArray url(dir->path().toUtf8() + "/file");
+    const quint64 id = touchFile(url);
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        doc.addTerm("fire");
+        doc.setMTime(1);
+        tr.addDocument(doc);
+        tr.commit();
+    }
+    delete db;
+    db = nullptr;
+
+    // Index of a version without ordinals
+    MDB_env* env;
+    QCOMPARE(mdb_env_create(&env), 0);
+    mdb_env_set_maxdbs(env, 18);
+    const QByteArray path = QFile::encodeName(dir->path() + QStringLiteral("/index"));
+    QCOMPARE(mdb_env_open(env, path.constData(), MDB_NOSUBDIR, 0664), 0);
+    MDB_txn* txn;
+    QCOMPARE(mdb_txn_begin(env, nullptr, 0, &txn), 0);
+    for (const char* name : {"idordinaldb", "ordinaliddb", "freeordinaldb"}) {
+        MDB_dbi dbi;
+        QCOMPARE(mdb_dbi_open(txn, name, 0, &dbi), 0);
+        QCOMPARE(mdb_drop(txn, dbi, 1), 0);
+    }
+    QCOMPARE(mdb_txn_commit(txn), 0);
+    mdb_env_close(env);
+
+    // Readers have to wait for the conversion
+    db = new Database(dir->path());
+    QVERIFY(!db->open(Database::ReadOnlyDatabase));
+    QVERIFY(db->needsConversion());
+    QVERIFY(!db->isOpen());
+    delete db;
+
+    db = new Database(dir->path());
+    QVERIFY(db->open(Database::CreateDatabase));
+    QVERIFY(!db->needsConversion());
+    delete db;
+
+    db = new Database(dir->path());
+    QVERIFY(db->open(Database::ReadOnlyDatabase));
+    QVERIFY(!db->needsConversion());
+
+    Transaction tr(db, Transaction::ReadOnly);
+    QVERIFY(tr.hasDocument(id));
+    QCOMPARE(tr.documentUrl(id), url);
+    QCOMPARE(tr.exec(EngineQuery("fire")), QVector<quint64>{id});
+}
 
 QTEST_MAIN(TransactionTest)
 
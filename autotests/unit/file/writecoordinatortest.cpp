@@ -0,0 +1,189 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "writecoordinator.h"
+#include "metadatamover.h"
+
+#include "database.h"
+#include "transaction.h"
+#include "document.h"
+#include "basicindexingjob.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+#include <QFile>
+
+using namespace Baloo;
+
+class WriteCoordinatorTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init() {
+        m_dir = new QTemporaryDir();
+        m_db = new Database(m_dir->path());
+        m_db->open(Database::CreateDatabase);
+    }
+
+    void cleanup() {
+        delete m_db;
+        delete m_dir;
+    }
+
+    void testGroupCommit();
+    void testMaximumLatency();
+    void testMaximumBatchSize();
+    void testEnqueueAlone();
+    void testMetadataMover();
+
+private:
+    QTemporaryDir* m_dir;
+    Database* m_db;
+};
+
+static WriteCoordinator::Mutation addDocument(quint64 id)
+{
+    return [id](Transaction* tr) {
+        Document doc;
+        doc.setId(id);
+        doc.setUrl("/tmp/" + QByteArray::number(id));
+        doc.addTerm("fire");
+        tr->addDocument(doc);
+    };
+}
+
+void WriteCoordinatorTest::testGroupCommit()
+{
+    WriteCoordinator coordinator(m_db);
+    coordinator.setMaximumLatency(60 * 1000);
+
+    for (quint64 id = 1; id <= 100; id++) {
+        coordinator.enqueue(addDocument(id));
+    }
+    coordinator.flush();
+
+    QCOMPARE(coordinator.commitCount(), 1ULL);
+
+    Transaction tr(m_db, Transaction::ReadOnly);
+    QVERIFY(tr.hasDocument(1));
+    QVERIFY(tr.hasDocument(100));
+
+    // Nothing is queued, so there is nothing to wait for
+    coordinator.flush();
+    QCOMPARE(coordinator.commitCount(), 1ULL);
+}
+
+void WriteCoordinatorTest::testMaximumLatency()
+{
+    WriteCoordinator coordinator(m_db);
+    coordinator.setMaximumLatency(10);
+
+    coordinator.enqueue(addDocument(1));
+    QTRY_COMPARE(coordinator.commitCount(), 1ULL);
+
+    Transaction tr(m_db, Transaction::ReadOnly);
+    QVERIFY(tr.hasDocument(1));
+}
+
+void WriteCoordinatorTest::testMaximumBatchSize()
+{
+    WriteCoordinator coordinator(m_db);
+    coordinator.setMaximumLatency(60 * 1000);
+    coordinator.setMaximumBatchSize(5);
+
+    for (quint64 id = 1; id <= 5; id++) {
+        coordinator.enqueue(addDocument(id));
+    }
+    QTRY_COMPARE(coordinator.commitCount(), 1ULL);
+}
+
+void WriteCoordinatorTest::testEnqueueAlone()
+{
+    WriteCoordinator coordinator(m_db);
+    coordinator.setMaximumLatency(60 * 1000);
+
+    coordinator.enqueue(addDocument(1));
+    coordinator.enqueue(addDocument(2));
+    coordinator.enqueueAlone(addDocument(3));
+    coordinator.enqueue(addDocument(4));
+    coordinator.flush();
+
+    // The windows before and after it are committed on their own
+    QCOMPARE(coordinator.commitCount(), 3ULL);
+
+    Transaction tr(m_db, Transaction::ReadOnly);
+    QCOMPARE(tr.size(), 4u);
+}
+
+static quint64 insertFile(Database* db, const QString& url)
+{
+    QFile file(url);
+    file.open(QIODevice::WriteOnly);
+    file.write("data");
+    file.close();
+
+    BasicIndexingJob job(url, QStringLiteral("text/plain"));
+    job.index();
+
+    Transaction tr(db, Transaction::ReadWrite);
+    tr.addDocument(job.document());
+    tr.commit();
+    return job.document().id();
+}
+
+void WriteCoordinatorTest::testMetadataMover()
+{
+    QTemporaryDir dir;
+    const QString url1 = dir.path() + QStringLiteral("/file1");
+    const QString url2 = dir.path() + QStringLiteral("/file2");
+    const quint64 id1 = insertFile(m_db, url1);
+    const quint64 id2 = insertFile(m_db, url2);
+
+    WriteCoordinator coordinator(m_db);
+    coordinator.setMaximumLatency(60 * 1000);
+
+    MetadataMover mover(m_db, &coordinator);
+
+    const QString newUrl1 = dir.path() + QStringLiteral("/moved");
+    QVERIFY(QFile::rename(url1, newUrl1));
+    mover.moveFileMetadata(url1, newUrl1);
+
+    QVERIFY(QFile::remove(url2));
+    mover.removeFileMetadata(url2);
+
+    // Nothing is written until the window is committed
+    {
+        Transaction tr(m_db, Transaction::ReadOnly);
+        QCOMPARE(tr.documentUrl(id1), QFile::encodeName(url1));
+        QVERIFY(tr.hasDocument(id2));
+    }
+
+    coordinator.flush();
+    QCOMPARE(coordinator.commitCount(), 1ULL);
+
+    Transaction tr(m_db, Transaction::ReadOnly);
+    QCOMPARE(tr.documentUrl(id1), QFile::encodeName(newUrl1));
+    QVERIFY(!tr.hasDocument(id2));
+}
+
+QTEST_GUILESS_MAIN(WriteCoordinatorTest)
+
+#include "writecoordinatortest.moc"
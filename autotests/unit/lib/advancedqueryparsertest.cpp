@@ -37,6 +37,7 @@ private Q_SLOTS:
     void testDateTime();
     void testOperators();
     void testBinaryOperatorMissingFirstArg();
+    void testNegation();
 };
 
 void AdvancedQueryParserTest::testSimpleProperty()
@@ -200,6 +201,40 @@ void AdvancedQueryParserTest::testBinaryOperatorMissingFirstArg()
 }
 
 
+void AdvancedQueryParserTest::testNegation()
+{
+    AdvancedQueryParser parser;
+
+    Term term = parser.parse(QStringLiteral("reports -old"));
+    Term expectedTerm = Term(QString(), QStringLiteral("reports")) && !Term(QString(), QStringLiteral("old"));
+    QCOMPARE(term, expectedTerm);
+
+    term = parser.parse(QStringLiteral("reports NOT old"));
+    QCOMPARE(term, expectedTerm);
+
+    term = parser.parse(QStringLiteral("images -tag:holiday"));
+    expectedTerm = Term(QString(), QStringLiteral("images")) && !Term(QStringLiteral("tag"), QStringLiteral("holiday"), Term::Contains);
+    QCOMPARE(term, expectedTerm);
+
+    term = parser.parse(QStringLiteral("a NOT (b OR c)"));
+    expectedTerm = Term(QString(), QStringLiteral("a"))
+        && !(Term(QString(), QStringLiteral("b")) || Term(QString(), QStringLiteral("c")));
+    QCOMPARE(term, expectedTerm);
+
+    term = parser.parse(QStringLiteral("a -(b OR c)"));
+    QCOMPARE(term, expectedTerm);
+
+    term = parser.parse(QStringLiteral("-(b OR c)"));
+    QCOMPARE(term, !(Term(QString(), QStringLiteral("b")) || Term(QString(), QStringLiteral("c"))));
+
+    // The negation survives serialization
+    QCOMPARE(Term::fromVariantMap(expectedTerm.toVariantMap()), expectedTerm);
+
+    // Negative numbers are not negations
+    term = parser.parse(QStringLiteral("-5"));
+    QCOMPARE(term, Term(QString(), QStringLiteral("-5")));
+}
+
 QTEST_MAIN(AdvancedQueryParserTest)
 
 #include "advancedqueryparsertest.moc"
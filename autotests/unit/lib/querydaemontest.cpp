@@ -0,0 +1,183 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "../../../src/querydaemon/querydaemon.h"
+#include "queryclient.h"
+#include "query.h"
+#include "document.h"
+#include "database.h"
+#include "transaction.h"
+#include "idutils.h"
+#include "global.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QCoreApplication>
+
+#include <atomic>
+#include <thread>
+
+using namespace Baloo;
+
+class QueryDaemonTest : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir dir;
+    QTemporaryDir runtimeDir;
+    QStringList filePaths;
+
+    QStringList execInDaemon(Query query, bool* ok);
+
+private Q_SLOTS:
+    void initTestCase();
+    void testFrame();
+    void testSerializeResults();
+    void testExec();
+    void testExecAfterClose();
+    void testNoDaemon();
+};
+
+void QueryDaemonTest::initTestCase()
+{
+    setenv("BALOO_DB_PATH", dir.path().toStdString().c_str(), 1);
+    setenv("XDG_RUNTIME_DIR", runtimeDir.path().toStdString().c_str(), 1);
+
+    Database db(fileIndexDbPath());
+    QVERIFY(db.open(Database::CreateDatabase));
+
+    Transaction tr(db, Transaction::ReadWrite);
+    for (int i = 0; i < 50; i++) {
+        const QString filePath = dir.path() + QStringLiteral("/file%1").arg(i);
+        QFile file(filePath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.close();
+
+        Document doc;
+        doc.setUrl(QFile::encodeName(filePath));
+        doc.setId(filePathToId(doc.url()));
+        doc.addTerm("testterm");
+        doc.setMTime(i + 1);
+        doc.setCTime(i + 1);
+        tr.addDocument(doc);
+
+        filePaths << filePath;
+    }
+    tr.commit();
+    filePaths.sort();
+}
+
+QStringList QueryDaemonTest::execInDaemon(Query query, bool* ok)
+{
+    const QByteArray json = query.toJSON();
+    QStringList results;
+    std::atomic<bool> done(false);
+
+    // The daemon answers from this thread's event loop
+    std::thread client([&]() {
+        *ok = QueryClient::exec(json, &results);
+        done = true;
+    });
+    while (!done) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    client.join();
+
+    results.sort();
+    return results;
+}
+
+void QueryDaemonTest::testFrame()
+{
+    QByteArray buffer = QueryClient::frame("first") + QueryClient::frame(QByteArray()) + QueryClient::frame("third");
+    QByteArray payload;
+
+    // Incomplete frames are left alone
+    QByteArray partial = buffer.left(2);
+    QVERIFY(!QueryClient::takeFrame(&partial, &payload));
+    QCOMPARE(partial.size(), 2);
+    partial = buffer.left(6);
+    QVERIFY(!QueryClient::takeFrame(&partial, &payload));
+    QCOMPARE(partial.size(), 6);
+
+    QVERIFY(QueryClient::takeFrame(&buffer, &payload));
+    QCOMPARE(payload, QByteArray("first"));
+    QVERIFY(QueryClient::takeFrame(&buffer, &payload));
+    QVERIFY(payload.isEmpty());
+    QVERIFY(QueryClient::takeFrame(&buffer, &payload));
+    QCOMPARE(payload, QByteArray("third"));
+    QVERIFY(buffer.isEmpty());
+    QVERIFY(!QueryClient::takeFrame(&buffer, &payload));
+}
+
+void QueryDaemonTest::testSerializeResults()
+{
+    const QStringList results = {QStringLiteral("/home/user/a"), QStringLiteral("/home/user/ü b")};
+    QCOMPARE(QueryClient::deserializeResults(QueryClient::serializeResults(results)), results);
+    QVERIFY(QueryClient::deserializeResults(QueryClient::serializeResults(QStringList())).isEmpty());
+}
+
+void QueryDaemonTest::testExec()
+{
+    QueryDaemon daemon;
+    QVERIFY(daemon.start());
+
+    Query query;
+    query.setSearchString(QStringLiteral("testterm"));
+
+    bool ok = false;
+    const QStringList results = execInDaemon(query, &ok);
+    QVERIFY(ok);
+    QCOMPARE(results, filePaths);
+
+    query.setSearchString(QStringLiteral("nonexistent"));
+    QVERIFY(execInDaemon(query, &ok).isEmpty());
+    QVERIFY(ok);
+}
+
+void QueryDaemonTest::testExecAfterClose()
+{
+    QueryDaemon daemon;
+    QVERIFY(daemon.start());
+
+    // What the daemon does once it has been idle
+    globalDatabaseInstance()->close();
+
+    Query query;
+    query.setSearchString(QStringLiteral("testterm"));
+
+    bool ok = false;
+    const QStringList results = execInDaemon(query, &ok);
+    QVERIFY(ok);
+    QCOMPARE(results, filePaths);
+}
+
+void QueryDaemonTest::testNoDaemon()
+{
+    QStringList results;
+    QVERIFY(!QueryClient::exec(Query().toJSON(), &results));
+    QVERIFY(results.isEmpty());
+}
+
+QTEST_MAIN(QueryDaemonTest)
+
+#include "querydaemontest.moc"
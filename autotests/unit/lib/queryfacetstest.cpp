@@ -0,0 +1,153 @@
+/*
+   This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "query.h"
+#include "document.h"
+#include "database.h"
+#include "transaction.h"
+#include "idutils.h"
+#include "global.h"
+#include "basicindexingjob.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QDateTime>
+#include <QFile>
+
+#include <KFileMetaData/TypeInfo>
+
+#include <utime.h>
+
+using namespace Baloo;
+
+class QueryFacetsTest : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir dir;
+
+private Q_SLOTS:
+    void initTestCase();
+    void test();
+    void testNoResults();
+};
+
+/**
+ * Indexes \p filePath like baloo_file does, with \p mTime as modification time
+ */
+static Document indexFile(const QString& filePath, const QString& mimeType, quint32 mTime)
+{
+    QFile file(filePath);
+    file.open(QIODevice::WriteOnly);
+    file.close();
+
+    struct utimbuf times;
+    times.actime = mTime;
+    times.modtime = mTime;
+    utime(QFile::encodeName(filePath).constData(), &times);
+
+    BasicIndexingJob job(filePath, mimeType, BasicIndexingJob::NoLevel);
+    job.index();
+    return job.document();
+}
+
+void QueryFacetsTest::initTestCase()
+{
+    setenv("BALOO_DB_PATH", dir.path().toStdString().c_str(), 1);
+
+    Database db(fileIndexDbPath());
+    QVERIFY(db.open(Database::CreateDatabase));
+
+    const quint32 may2016 = QDateTime(QDate(2016, 5, 10)).toTime_t();
+    const quint32 june2017 = QDateTime(QDate(2017, 6, 10)).toTime_t();
+
+    Transaction tr(db, Transaction::ReadWrite);
+    for (int i = 0; i < 6; i++) {
+        const QString filePath = dir.path() + QStringLiteral("/file%1").arg(i);
+        const QString mimeType = i < 4 ? QStringLiteral("image/png") : QStringLiteral("application/pdf");
+
+        Document doc = indexFile(filePath, mimeType, i < 3 ? may2016 : june2017);
+        QVERIFY(doc.id());
+        doc.addTerm("holiday");
+        if (i % 2) {
+            doc.addTerm("TAG-beach");
+            doc.addTerm("TAbeach");
+        }
+        tr.addDocument(doc);
+    }
+
+    // Does not match the query, so is never counted
+    Document doc = indexFile(dir.path() + QStringLiteral("/other"), QStringLiteral("image/png"), may2016);
+    QVERIFY(doc.id());
+    doc.addTerm("work");
+    doc.addTerm("TAG-beach");
+    tr.addDocument(doc);
+
+    tr.commit();
+}
+
+void QueryFacetsTest::test()
+{
+    Query query;
+    query.setSearchString(QStringLiteral("holiday"));
+
+    const QStringList properties = {QStringLiteral("type"), QStringLiteral("mimetype"),
+                                    QStringLiteral("tag"), QStringLiteral("year"), QStringLiteral("month")};
+    const QMap<QString, QMap<QString, int>> facets = query.facets(properties);
+    QCOMPARE(facets.keys(), QStringList({QStringLiteral("mimetype"), QStringLiteral("month"), QStringLiteral("tag"),
+                                         QStringLiteral("type"), QStringLiteral("year")}));
+
+    QMap<QString, int> types;
+    types.insert(KFileMetaData::TypeInfo(KFileMetaData::Type::Image).name(), 4);
+    types.insert(KFileMetaData::TypeInfo(KFileMetaData::Type::Document).name(), 2);
+    QCOMPARE(facets.value(QStringLiteral("type")), types);
+
+    QMap<QString, int> mimeTypes;
+    mimeTypes.insert(QStringLiteral("image/png"), 4);
+    mimeTypes.insert(QStringLiteral("application/pdf"), 2);
+    QCOMPARE(facets.value(QStringLiteral("mimetype")), mimeTypes);
+
+    QMap<QString, int> tags;
+    tags.insert(QStringLiteral("beach"), 3);
+    QCOMPARE(facets.value(QStringLiteral("tag")), tags);
+
+    QMap<QString, int> years;
+    years.insert(QStringLiteral("2016"), 3);
+    years.insert(QStringLiteral("2017"), 3);
+    QCOMPARE(facets.value(QStringLiteral("year")), years);
+
+    QMap<QString, int> months;
+    months.insert(QStringLiteral("2016-05"), 3);
+    months.insert(QStringLiteral("2017-06"), 3);
+    QCOMPARE(facets.value(QStringLiteral("month")), months);
+}
+
+void QueryFacetsTest::testNoResults()
+{
+    Query query;
+    query.setSearchString(QStringLiteral("nothingmatches"));
+
+    const QMap<QString, QMap<QString, int>> facets = query.facets({QStringLiteral("type")});
+    QCOMPARE(facets.size(), 1);
+    QVERIFY(facets.value(QStringLiteral("type")).isEmpty());
+}
+
+QTEST_MAIN(QueryFacetsTest)
+
+#include "queryfacetstest.moc"
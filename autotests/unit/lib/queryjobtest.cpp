@@ -0,0 +1,130 @@
+/*
+   This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "queryjob.h"
+#include "query.h"
+#include "document.h"
+#include "database.h"
+#include "transaction.h"
+#include "idutils.h"
+#include "global.h"
+
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+
+using namespace Baloo;
+
+class QueryJobTest : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir dir;
+    QStringList filePaths;
+
+private Q_SLOTS:
+    void initTestCase();
+    void test();
+    void testKill();
+};
+
+void QueryJobTest::initTestCase()
+{
+    setenv("BALOO_DB_PATH", dir.path().toStdString().c_str(), 1);
+
+    Database db(fileIndexDbPath());
+    QVERIFY(db.open(Database::CreateDatabase));
+
+    Transaction tr(db, Transaction::ReadWrite);
+    for (int i = 0; i < 500; i++) {
+        const QString filePath = dir.path() + QStringLiteral("/file%1").arg(i);
+        QFile file(filePath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.close();
+
+        Document doc;
+        doc.setUrl(QFile::encodeName(filePath));
+        doc.setId(filePathToId(doc.url()));
+        doc.addTerm("testterm");
+        doc.setMTime(i + 1);
+        doc.setCTime(i + 1);
+        tr.addDocument(doc);
+
+        filePaths << filePath;
+    }
+    tr.commit();
+}
+
+void QueryJobTest::test()
+{
+    Query query;
+    query.setSearchString(QStringLiteral("testterm"));
+
+    QueryJob* job = query.execAsync();
+    QVERIFY(job);
+
+    QStringList results;
+    int batches = 0;
+    connect(job, &QueryJob::resultsReady, this, [&](QueryJob*, const QStringList& batch) {
+        QVERIFY(!batch.isEmpty());
+        results << batch;
+        batches++;
+    });
+
+    QSignalSpy spy(job, &KJob::result);
+    job->start();
+    QVERIFY(spy.wait());
+
+    QCOMPARE(job->error(), 0);
+    QVERIFY(batches > 1);
+    QCOMPARE(job->totalAmount(KJob::Files), static_cast<qulonglong>(500));
+    QCOMPARE(job->processedAmount(KJob::Files), static_cast<qulonglong>(500));
+
+    results.sort();
+    QStringList expected = filePaths;
+    expected.sort();
+    QCOMPARE(results, expected);
+}
+
+void QueryJobTest::testKill()
+{
+    Query query;
+    query.setSearchString(QStringLiteral("testterm"));
+
+    QueryJob* job = query.execAsync();
+    job->setMaxPendingBatches(1);
+
+    int batches = 0;
+    connect(job, &QueryJob::resultsReady, this, [&](QueryJob* killedJob, const QStringList&) {
+        batches++;
+        killedJob->kill();
+    });
+
+    QSignalSpy spy(job, &KJob::result);
+    job->start();
+    QTest::qWait(500);
+
+    QCOMPARE(batches, 1);
+    QCOMPARE(spy.count(), 0);
+}
+
+QTEST_MAIN(QueryJobTest)
+
+#include "queryjobtest.moc"
@@ -0,0 +1,107 @@
+/*
+ * This file is part of the KDE Baloo Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "queryresultcache.h"
+#include "term.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class QueryResultCacheTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testLookup();
+    void testNewerSnapshot();
+    void testOlderSnapshot();
+    void testKeyNormalization();
+    void testKeyParameters();
+};
+
+void QueryResultCacheTest::testLookup()
+{
+    QueryResultCache cache;
+    const QByteArray key = QueryResultCache::key(Term(QStringLiteral("tag"), QStringLiteral("foo")), 0, -1, true);
+
+    QVector<quint64> ids;
+    QVERIFY(!cache.lookup(key, 5, &ids));
+
+    const QVector<quint64> expected = {1, 2, 3};
+    cache.insert(key, 5, expected);
+
+    QVERIFY(cache.lookup(key, 5, &ids));
+    QCOMPARE(ids, expected);
+}
+
+void QueryResultCacheTest::testNewerSnapshot()
+{
+    QueryResultCache cache;
+    const QByteArray key = QueryResultCache::key(Term(QStringLiteral("tag"), QStringLiteral("foo")), 0, -1, true);
+
+    cache.insert(key, 5, {1, 2, 3});
+
+    QVector<quint64> ids;
+    QVERIFY(!cache.lookup(key, 6, &ids));
+    // The entry has been dropped for good
+    QVERIFY(!cache.lookup(key, 5, &ids));
+}
+
+void QueryResultCacheTest::testOlderSnapshot()
+{
+    QueryResultCache cache;
+    const QByteArray key = QueryResultCache::key(Term(QStringLiteral("tag"), QStringLiteral("foo")), 0, -1, true);
+
+    cache.insert(key, 6, {1, 2, 3});
+    cache.insert(key, 5, {4});
+
+    QVector<quint64> ids;
+    QVERIFY(!cache.lookup(key, 5, &ids));
+    QVERIFY(cache.lookup(key, 6, &ids));
+    QCOMPARE(ids, QVector<quint64>({1, 2, 3}));
+}
+
+void QueryResultCacheTest::testKeyNormalization()
+{
+    Term t1(QStringLiteral("tag"), QStringLiteral("foo"));
+    Term t2(QStringLiteral("rating"), 5, Term::Equal);
+
+    QCOMPARE(QueryResultCache::key(t1 && t2, 0, -1, true), QueryResultCache::key(t2 && t1, 0, -1, true));
+    QVERIFY(QueryResultCache::key(t1 && t2, 0, -1, true) != QueryResultCache::key(t1 || t2, 0, -1, true));
+    QVERIFY(QueryResultCache::key(t1, 0, -1, true) != QueryResultCache::key(!t1, 0, -1, true));
+
+    // Values of different types must not collide
+    Term intTerm(QStringLiteral("rating"), 5, Term::Equal);
+    Term stringTerm(QStringLiteral("rating"), QStringLiteral("5"), Term::Equal);
+    QVERIFY(QueryResultCache::key(intTerm, 0, -1, true) != QueryResultCache::key(stringTerm, 0, -1, true));
+}
+
+void QueryResultCacheTest::testKeyParameters()
+{
+    Term term(QStringLiteral("tag"), QStringLiteral("foo"));
+    const QByteArray key = QueryResultCache::key(term, 0, -1, true);
+
+    QVERIFY(key != QueryResultCache::key(term, 1, -1, true));
+    QVERIFY(key != QueryResultCache::key(term, 0, 10, true));
+    QVERIFY(key != QueryResultCache::key(term, 0, -1, false));
+}
+
+QTEST_MAIN(QueryResultCacheTest)
+
+#include "queryresultcachetest.moc"
@@ -21,6 +21,7 @@
 #include "query.h"
 #include "term.h"
 
+#include <QJsonObject>
 #include <QTest>
 
 using namespace Baloo;
@@ -35,6 +36,7 @@ private Q_SLOTS:
     void testAndTerm();
     void testDateTerm();
     void testDateTimeTerm();
+    void testByteArrayTerm();
 
     void testCustomOptions();
 };
@@ -105,6 +107,21 @@ void QuerySerializationTest::testDateTimeTerm()
     QCOMPARE(q, query);
 }
 
+void QuerySerializationTest::testByteArrayTerm()
+{
+    const Term term = Term(QStringLiteral("modified"), QByteArray("20150501"), Term::Equal)
+                   && Term(QStringLiteral("tag"), QByteArray("a\xff"), Term::Contains);
+
+    // Through JSON, like Query::toJSON()
+    const QVariantMap map = QJsonObject::fromVariantMap(term.toVariantMap()).toVariantMap();
+    const Term t = Term::fromVariantMap(map);
+
+    QCOMPARE(t, term);
+    for (const Term& subTerm : t.subTerms()) {
+        QCOMPARE(subTerm.value().type(), QVariant::ByteArray);
+    }
+    QCOMPARE(t.subTerms().last().value().toByteArray(), QByteArray("a\xff"));
+}
 
 void QuerySerializationTest::testCustomOptions()
 {
@@ -0,0 +1,132 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "taglistjob.h"
+#include "document.h"
+#include "database.h"
+#include "transaction.h"
+#include "idutils.h"
+#include "global.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QFile>
+
+using namespace Baloo;
+
+class TagListJobTest : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir dir;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testAllTags();
+    void testTopLevel();
+    void testParentTagCase();
+    void testUnknownParentTag();
+};
+
+void TagListJobTest::initTestCase()
+{
+    setenv("BALOO_DB_PATH", dir.path().toStdString().c_str(), 1);
+
+    Database db(fileIndexDbPath());
+    QVERIFY(db.open(Database::CreateDatabase));
+
+    const QList<QByteArray> tags = {"Holiday/Beach", "holiday/sea", "holiday/Sea", "work"};
+
+    Transaction tr(db, Transaction::ReadWrite);
+    for (int i = 0; i < tags.size(); i++) {
+        const QString filePath = dir.path() + QStringLiteral("/file%1").arg(i);
+        QFile file(filePath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.close();
+
+        Document doc;
+        doc.setUrl(QFile::encodeName(filePath));
+        doc.setId(filePathToId(doc.url()));
+        doc.addTerm("TAG-" + tags[i]);
+        doc.setMTime(1);
+        doc.setCTime(1);
+        tr.addDocument(doc);
+    }
+    tr.commit();
+}
+
+void TagListJobTest::testAllTags()
+{
+    TagListJob* job = new TagListJob();
+    QVERIFY(job->exec());
+
+    QStringList tags = job->tags();
+    tags.sort();
+    QCOMPARE(tags, QStringList({QStringLiteral("Holiday/Beach"), QStringLiteral("holiday/Sea"),
+                                QStringLiteral("holiday/sea"), QStringLiteral("work")}));
+}
+
+void TagListJobTest::testTopLevel()
+{
+    TagListJob* job = new TagListJob();
+    job->setParentTag(QString());
+    QVERIFY(job->exec());
+
+    // "Holiday" and "holiday" are listed once
+    QCOMPARE(job->tags(), QStringList({QStringLiteral("Holiday"), QStringLiteral("work")}));
+    QVERIFY(job->hasChildTags(QStringLiteral("Holiday")));
+    QCOMPARE(job->fileCount(QStringLiteral("Holiday")), 0u);
+    QVERIFY(!job->hasChildTags(QStringLiteral("work")));
+    QCOMPARE(job->fileCount(QStringLiteral("work")), 1u);
+}
+
+void TagListJobTest::testParentTagCase()
+{
+    TagListJob* job = new TagListJob();
+    job->setParentTag(QStringLiteral("HOLIDAY"));
+    QVERIFY(job->exec());
+
+    QCOMPARE(job->parentTags(), QStringList({QStringLiteral("Holiday"), QStringLiteral("holiday")}));
+    QCOMPARE(job->tags(), QStringList({QStringLiteral("Beach"), QStringLiteral("Sea")}));
+    QCOMPARE(job->fileCount(QStringLiteral("Beach")), 1u);
+    QCOMPARE(job->fileCount(QStringLiteral("Sea")), 2u);
+
+    job = new TagListJob();
+    job->setParentTag(QStringLiteral("holiday/SEA"));
+    QVERIFY(job->exec());
+
+    QCOMPARE(job->parentTags(), QStringList({QStringLiteral("holiday/Sea"), QStringLiteral("holiday/sea")}));
+    QVERIFY(job->tags().isEmpty());
+}
+
+void TagListJobTest::testUnknownParentTag()
+{
+    TagListJob* job = new TagListJob();
+    job->setParentTag(QStringLiteral("nothing"));
+    QVERIFY(job->exec());
+
+    QVERIFY(job->parentTags().isEmpty());
+    QVERIFY(job->tags().isEmpty());
+}
+
+QTEST_MAIN(TagListJobTest)
+
+#include "taglistjobtest.moc"
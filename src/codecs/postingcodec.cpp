@@ -19,6 +19,7 @@
  */
 
 #include "postingcodec.h"
+#include "coding.h"
 
 using namespace Baloo;
 
@@ -28,17 +29,45 @@ PostingCodec::PostingCodec()
 
 QByteArray PostingCodec::encode(const QVector<quint64>& list)
 {
-    uint size = list.size() * sizeof(quint64);
-    char* ptr = reinterpret_cast<char*>(const_cast<quint64*>(list.constData()));
+    QVector<quint32> ordinals;
+    ordinals.reserve(list.size());
+    for (quint64 ordinal : list) {
+        Q_ASSERT_X(ordinal <= 0xffffffff, "PostingCodec::encode", "Posting lists hold 32 bit ordinals");
+        ordinals << static_cast<quint32>(ordinal);
+    }
 
-    return QByteArray(ptr, size);
+    QByteArray data;
+    QByteArray temporaryStorage;
+    putDifferentialVarInt32(temporaryStorage, &data, ordinals);
+
+    return data;
 }
 
 QVector<quint64> PostingCodec::decode(const QByteArray& arr)
 {
+    char* data = const_cast<char*>(arr.data());
+    char* end = data + arr.size();
+
     QVector<quint64> vec;
-    vec.resize(arr.size() / sizeof(quint64));
+    quint32 size = 0;
+    if (data < end) {
+        data = getVarint32Ptr(data, end, &size);
+    }
+    vec.reserve(size);
+
+    // Decoded straight into the result instead of going through getDifferentialVarInt32()
+    quint32 ordinal = 0;
+    while (data && data < end && size) {
+        quint32 delta;
+        data = getVarint32Ptr(data, end, &delta);
+        if (!data) {
+            break;
+        }
+
+        ordinal += delta;
+        vec.append(ordinal);
+        size--;
+    }
 
-    memcpy(vec.data(), arr.data(), arr.size());
     return vec;
 }
@@ -26,6 +26,10 @@
 
 namespace Baloo {
 
+/**
+ * Encodes a sorted list of document ordinals as the number of ordinals
+ * followed by the varint encoded differences between them
+ */
 class PostingCodec
 {
 public:
@@ -0,0 +1,88 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "andnotpostingiterator.h"
+
+using namespace Baloo;
+
+AndNotPostingIterator::AndNotPostingIterator(PostingIterator* it, PostingIterator* excluded)
+    : m_it(it)
+    , m_excluded(excluded)
+    , m_excludedDone(!excluded)
+    , m_docId(0)
+{
+    Q_ASSERT(m_it);
+}
+
+AndNotPostingIterator::~AndNotPostingIterator()
+{
+    delete m_it;
+    delete m_excluded;
+}
+
+quint64 AndNotPostingIterator::docId() const
+{
+    return m_docId;
+}
+
+quint64 AndNotPostingIterator::next()
+{
+    m_docId = findMatch(m_it->next());
+    return m_docId;
+}
+
+quint64 AndNotPostingIterator::skipTo(quint64 id)
+{
+    if (m_docId && m_docId >= id) {
+        return m_docId;
+    }
+
+    m_docId = findMatch(m_it->skipTo(id));
+    return m_docId;
+}
+
+quint64 AndNotPostingIterator::findMatch(quint64 id)
+{
+    while (id && !m_excludedDone) {
+        const quint64 excludedId = m_excluded->skipTo(id);
+        if (!excludedId) {
+            // Nothing left to exclude
+            m_excludedDone = true;
+            break;
+        }
+        if (excludedId != id) {
+            break;
+        }
+        id = m_it->next();
+    }
+
+    return id;
+}
+
+uint AndNotPostingIterator::estimatedSize() const
+{
+    return m_it->estimatedSize();
+}
+
+QVector<uint> AndNotPostingIterator::positions()
+{
+    return m_it->positions();
+}
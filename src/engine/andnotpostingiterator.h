@@ -0,0 +1,60 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_ANDNOTPOSTINGITERATOR_H
+#define BALOO_ANDNOTPOSTINGITERATOR_H
+
+#include "postingiterator.h"
+
+namespace Baloo {
+
+/**
+ * Yields the ids of \p it which are not yielded by \p excluded. The excluded
+ * side is only ever advanced with skipTo to the current candidate, so the
+ * cost is close to the size of \p it no matter how large \p excluded is.
+ *
+ * Takes ownership of both iterators. \p excluded may be null, in which case
+ * nothing is excluded.
+ */
+class BALOO_ENGINE_EXPORT AndNotPostingIterator : public PostingIterator
+{
+public:
+    AndNotPostingIterator(PostingIterator* it, PostingIterator* excluded);
+    ~AndNotPostingIterator();
+
+    quint64 next() Q_DECL_OVERRIDE;
+    quint64 docId() const Q_DECL_OVERRIDE;
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE;
+    uint estimatedSize() const Q_DECL_OVERRIDE;
+    QVector<uint> positions() Q_DECL_OVERRIDE;
+
+private:
+    quint64 findMatch(quint64 id);
+
+    PostingIterator* m_it;
+    PostingIterator* m_excluded;
+    bool m_excludedDone;
+    quint64 m_docId;
+};
+
+}
+
+#endif // BALOO_ANDNOTPOSTINGITERATOR_H
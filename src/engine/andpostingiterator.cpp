@@ -20,6 +20,8 @@
 
 #include "andpostingiterator.h"
 
+#include <algorithm>
+
 using namespace Baloo;
 
 AndPostingIterator::AndPostingIterator(const QVector<PostingIterator*>& iterators)
@@ -30,6 +32,10 @@ AndPostingIterator::AndPostingIterator(const QVector<PostingIterator*>& iterator
         qDeleteAll(m_iterators);
         m_iterators.clear();
     }
+
+    std::stable_sort(m_iterators.begin(), m_iterators.end(), [](PostingIterator* lhs, PostingIterator* rhs) {
+        return lhs->estimatedSize() < rhs->estimatedSize();
+    });
 }
 
 AndPostingIterator::~AndPostingIterator()
@@ -42,6 +48,14 @@ quint64 AndPostingIterator::docId() const
     return m_docId;
 }
 
+uint AndPostingIterator::estimatedSize() const
+{
+    if (m_iterators.isEmpty()) {
+        return 0;
+    }
+    return m_iterators.first()->estimatedSize();
+}
+
 quint64 AndPostingIterator::next()
 {
     if (m_iterators.isEmpty()) {
@@ -49,26 +63,48 @@ quint64 AndPostingIterator::next()
         return 0;
     }
 
-    if (m_iterators[0]->next() == 0) {
+    m_docId = m_iterators[0]->next();
+    return findMatch();
+}
+
+quint64 AndPostingIterator::skipTo(quint64 id)
+{
+    if (m_iterators.isEmpty()) {
         m_docId = 0;
         return 0;
     }
+    if (m_docId && m_docId >= id) {
+        return m_docId;
+    }
 
-    m_docId = m_iterators[0]->docId();
+    m_docId = m_iterators[0]->skipTo(id);
+    return findMatch();
+}
 
-    for (int i = 1; i < m_iterators.size(); i++) {
-        PostingIterator* iter = m_iterators[i];
-        if (iter->docId() == 0 && iter->next() == 0) {
-            m_docId = 0;
-            return 0;
-        }
+quint64 AndPostingIterator::findMatch()
+{
+    // Leapfrog: whenever a child overshoots the candidate, the driving
+    // iterator jumps ahead to the child's id
+    while (m_docId) {
+        bool match = true;
+        for (int i = 1; i < m_iterators.size(); i++) {
+            const quint64 id = m_iterators[i]->skipTo(m_docId);
+            if (id == 0) {
+                m_docId = 0;
+                return 0;
+            }
 
-        iter->skipTo(m_docId);
+            if (id != m_docId) {
+                m_docId = m_iterators[0]->skipTo(id);
+                match = false;
+                break;
+            }
+        }
 
-        if (m_docId != iter->docId()) {
-            return next();
+        if (match) {
+            return m_docId;
         }
     }
 
-    return m_docId;
+    return 0;
 }
@@ -26,6 +26,12 @@
 
 namespace Baloo {
 
+/**
+ * Iterates over the intersection of its child iterators.
+ *
+ * The children are ordered by their estimated size, so that the rarest one
+ * drives the intersection and the others are only asked to skip ahead.
+ */
 class BALOO_ENGINE_EXPORT AndPostingIterator : public PostingIterator
 {
 public:
@@ -34,8 +40,12 @@ public:
 
     quint64 next() Q_DECL_OVERRIDE;
     quint64 docId() const Q_DECL_OVERRIDE;
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE;
+    uint estimatedSize() const Q_DECL_OVERRIDE;
 
 private:
+    quint64 findMatch();
+
     QVector<PostingIterator*> m_iterators;
     quint64 m_docId;
 };
@@ -22,6 +22,7 @@
 #include "database.h"
 #include "transaction.h"
 #include "postingdb.h"
+#include "postingcache.h"
 #include "documentdb.h"
 #include "documenturldb.h"
 #include "documentiddb.h"
@@ -29,6 +30,14 @@
 #include "documenttimedb.h"
 #include "documentdatadb.h"
 #include "mtimedb.h"
+#include "termstatsdb.h"
+#include "metadatadb.h"
+#include "tagdb.h"
+#include "ordinaldb.h"
+#include "residentidsets.h"
+#include "positioninfo.h"
+#include "postingcodec.h"
+#include "positioncodec.h"
 
 #include "document.h"
 #include "enginequery.h"
@@ -45,32 +54,360 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QMutexLocker>
+#include <QDateTime>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
 
 using namespace Baloo;
 
+// How long compact() waits for the transactions of this process to end
+static const int s_compactLockTimeout = 1000;
+
 Database::Database(const QString& path)
     : m_path(path)
     , m_env(nullptr)
+    , m_maxReaders(126)
+    , m_durability(SyncEveryCommit)
+    , m_readOnly(true)
+    , m_checkpointTxnId(0)
+    , m_heldCheckpoint(0)
+    , m_envLock(QReadWriteLock::Recursive)
+    , m_usersFd(-1)
+    , m_snapshotBase(0)
+    , m_readTxnPoolSize(8)
+    , m_idSets(nullptr)
+    , m_sharded(false)
+    , m_shardsOpen(false)
+    , m_needsConversion(false)
 {
 }
 
 Database::~Database()
 {
+    qDeleteAll(m_shards);
+    qDeleteAll(m_removedShards);
+
+    // Nothing must be lost on a clean exit
+    if (m_env && !m_readOnly && m_durability == DeferredSync) {
+        sync();
+    }
+
+    closeEnvironment();
+    delete m_idSets;
+
+    if (m_usersFd >= 0) {
+        ::close(m_usersFd);
+    }
+}
+
+void Database::close()
+{
+    if (m_env && !m_readOnly && m_durability == DeferredSync) {
+        sync();
+    }
+
+    QWriteLocker envLocker(&m_envLock);
+    {
+        // No transaction can use them anymore, they are opened anew by the next one
+        QMutexLocker locker(&m_shardMutex);
+        for (Database* shard : m_shards) {
+            retireShard(shard);
+        }
+        qDeleteAll(m_removedShards);
+        m_shards.clear();
+        m_removedShards.clear();
+        m_shardsModified = QDateTime();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    closeEnvironment();
+    m_shardsOpen = false;
+}
+
+void Database::closeEnvironment()
+{
+    for (MDB_txn* txn : m_readTxnPool) {
+        mdb_txn_abort(txn);
+    }
+    m_readTxnPool.clear();
+
+    // The next process may only use the sets if everything they cover is
+    // on disk, commits of other processes with DeferredSync included
+    if (m_env && m_idSets && !m_readOnly && mdb_env_sync(m_env, 1) == 0) {
+        MDB_envinfo info;
+        mdb_env_info(m_env, &info);
+        if (m_idSets->txnId() == info.me_last_txnid) {
+            m_idSets->save();
+        }
+    }
+
     // try only to close if we did open the DB successfully
     if (m_env) {
+        // Others may compact the index until it is opened again
+        MDB_envinfo envInfo;
+        mdb_env_info(m_env, &envInfo);
+        m_snapshotBase.fetchAndAddOrdered(envInfo.me_last_txnid + 1);
+
+        PostingCache::instance()->remove(m_env);
         mdb_env_close(m_env);
         m_env = nullptr;
     }
+
+    if (m_usersFd >= 0) {
+        lockUsers(LOCK_UN);
+    }
+}
+
+/**
+ * Fills the TermStatsDB and the MetaDataDB from the contents of the other
+ * databases. From then on they are maintained by the WriteTransaction.
+ */
+static void buildStatistics(MDB_txn* txn, const DatabaseDbis& dbis)
+{
+    TermStatsDB termStatsDb(dbis.termStatsDbi, txn);
+    MetaDataDB metaDataDb(dbis.metaDataDbi, txn);
+
+    MDB_cursor* cursor;
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    mdb_cursor_open(txn, dbis.postingDbi, &cursor);
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        const QByteArray term(static_cast<char*>(key.mv_data), key.mv_size);
+        const QVector<quint64> list = PostingCodec().decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+        if (list.isEmpty()) {
+            continue;
+        }
+
+        TermStatsDB::TermStats stats;
+        stats.documentCount = list.size();
+        stats.minId = list.first();
+        stats.maxId = list.last();
+        termStatsDb.put(term, stats);
+    }
+    mdb_cursor_close(cursor);
+
+    key = {0, nullptr};
+    mdb_cursor_open(txn, dbis.positionDBi, &cursor);
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        const QByteArray term(static_cast<char*>(key.mv_data), key.mv_size);
+        const QVector<PositionInfo> list = PositionCodec().decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+
+        TermStatsDB::TermStats stats = termStatsDb.get(term);
+        if (!stats.documentCount) {
+            continue;
+        }
+        for (const PositionInfo& info : list) {
+            stats.positionCount += info.positions.size();
+        }
+        termStatsDb.put(term, stats);
+    }
+    mdb_cursor_close(cursor);
+
+    auto entries = [txn](MDB_dbi dbi) {
+        MDB_stat stat;
+        int rc = mdb_stat(txn, dbi, &stat);
+        Q_ASSERT_X(rc == 0, "Database::buildStatistics", mdb_strerror(rc));
+        return rc == 0 ? static_cast<quint64>(stat.ms_entries) : 0;
+    };
+
+    metaDataDb.putCount(documentCountName, entries(dbis.docTimeDbi));
+    metaDataDb.putCount(phaseOneCountName, entries(dbis.contentIndexingDbi));
+    metaDataDb.putCount(failedCountName, entries(dbis.failedIdDbi));
+}
+
+/**
+ * Fills the TagDB from the tag terms in the PostingDB. From then on it is
+ * maintained by the WriteTransaction.
+ */
+static void buildTags(MDB_txn* txn, const DatabaseDbis& dbis)
+{
+    TagDB tagDb(dbis.tagDbi, txn);
+
+    const QByteArray prefix = QByteArrayLiteral("TAG-");
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(txn, dbis.postingDbi, &cursor);
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+
+    MDB_val val;
+    int rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+    while (rc == 0) {
+        const QByteArray term(static_cast<char*>(key.mv_data), key.mv_size);
+        if (!term.startsWith(prefix)) {
+            break;
+        }
+
+        const QVector<quint64> list = PostingCodec().decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+        if (!list.isEmpty() && term.size() > prefix.size()) {
+            tagDb.setDocumentCount(term.mid(prefix.size()), list.size());
+        }
+
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+    }
+    mdb_cursor_close(cursor);
+}
+
+/**
+ * Moves the posting, position and mtime dbs of databases created by older
+ * versions from document ids to ordinals. The ordinals are handed out in id
+ * order, so the converted lists stay sorted. Ids which do not belong to any
+ * document are dropped on the way.
+ */
+static void convertToOrdinals(MDB_txn* txn, const DatabaseDbis& dbis)
+{
+    OrdinalDB ordinalDb(dbis.idOrdinalDbi, dbis.ordinalIdDbi, dbis.freeOrdinalDbi, txn);
+
+    MDB_cursor* cursor;
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    // Every document has a time, it is written along with its terms
+    QVector<quint64> ids;
+    mdb_cursor_open(txn, dbis.docTimeDbi, &cursor);
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        const quint64 id = *static_cast<quint64*>(key.mv_data);
+        ids << id;
+        ordinalDb.assign(id);
+    }
+    mdb_cursor_close(cursor);
+
+    auto toOrdinal = [&ids](quint64 id) -> quint32 {
+        auto it = std::lower_bound(ids.constBegin(), ids.constEnd(), id);
+        return (it != ids.constEnd() && *it == id) ? (it - ids.constBegin()) + 1 : 0;
+    };
+
+    // The values change size, so the keys are copied out of the pages first
+    auto rewrite = [](MDB_cursor* cursor, const MDB_val& key, const QByteArray& data) {
+        QByteArray term(static_cast<char*>(key.mv_data), key.mv_size);
+        MDB_val termKey = {static_cast<size_t>(term.size()), term.data()};
+        int rc;
+        if (data.isEmpty()) {
+            rc = mdb_cursor_del(cursor, 0);
+        } else {
+            MDB_val newVal = {static_cast<size_t>(data.size()), const_cast<char*>(data.constData())};
+            rc = mdb_cursor_put(cursor, &termKey, &newVal, MDB_CURRENT);
+        }
+        Q_ASSERT_X(rc == 0, "Database::convertToOrdinals", mdb_strerror(rc));
+        Q_UNUSED(rc);
+    };
+
+    // The posting lists were the plain 64 bit ids
+    key = {0, nullptr};
+    mdb_cursor_open(txn, dbis.postingDbi, &cursor);
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        QVector<quint64> list(val.mv_size / sizeof(quint64));
+        memcpy(list.data(), val.mv_data, list.size() * sizeof(quint64));
+
+        QVector<quint64> ordinals;
+        ordinals.reserve(list.size());
+        for (quint64 id : list) {
+            if (const quint32 ordinal = toOrdinal(id)) {
+                ordinals << ordinal;
+            }
+        }
+        rewrite(cursor, key, ordinals.isEmpty() ? QByteArray() : PostingCodec().encode(ordinals));
+    }
+    mdb_cursor_close(cursor);
+
+    key = {0, nullptr};
+    mdb_cursor_open(txn, dbis.positionDBi, &cursor);
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        const QVector<PositionInfo> list = PositionCodec().decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+
+        QVector<PositionInfo> converted;
+        converted.reserve(list.size());
+        for (const PositionInfo& info : list) {
+            if (const quint32 ordinal = toOrdinal(info.docId)) {
+                converted << info;
+                converted.last().docId = ordinal;
+            }
+        }
+        rewrite(cursor, key, converted.isEmpty() ? QByteArray() : PositionCodec().encode(converted));
+    }
+    mdb_cursor_close(cursor);
+
+    // The mtime db holds fixed size duplicates, which have to be written anew
+    QVector<QPair<quint32, quint32>> times;
+    key = {0, nullptr};
+    mdb_cursor_open(txn, dbis.mtimeDbi, &cursor);
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        quint64 id;
+        memcpy(&id, val.mv_data, sizeof(id));
+        if (const quint32 ordinal = toOrdinal(id)) {
+            times << qMakePair(*static_cast<quint32*>(key.mv_data), ordinal);
+        }
+    }
+    mdb_cursor_close(cursor);
+
+    int rc = mdb_drop(txn, dbis.mtimeDbi, 0);
+    Q_ASSERT_X(rc == 0, "Database::convertToOrdinals", mdb_strerror(rc));
+    Q_UNUSED(rc);
+
+    MTimeDB mtimeDb(dbis.mtimeDbi, txn);
+    for (const auto& time : times) {
+        mtimeDb.put(time.first, time.second);
+    }
+}
+
+bool Database::lockUsers(int operation)
+{
+    if (m_usersFd < 0) {
+        const QByteArray path = QFile::encodeName(m_path + QStringLiteral("/index-users"));
+        m_usersFd = ::open(path.constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0664);
+        if (m_usersFd < 0) {
+            // Read only indexes cannot be compacted anyway
+            m_usersFd = ::open(path.constData(), O_RDONLY | O_CLOEXEC);
+        }
+        if (m_usersFd < 0) {
+            return false;
+        }
+    }
+
+    int rc;
+    do {
+        rc = flock(m_usersFd, operation);
+    } while (rc != 0 && errno == EINTR);
+    return rc == 0;
 }
 
 bool Database::open(OpenMode mode)
 {
     QMutexLocker locker(&m_mutex);
+    if (openEnvironment(mode)) {
+        return true;
+    }
+
+    // Must not keep compact() of other processes from running
+    if (m_usersFd >= 0) {
+        lockUsers(LOCK_UN);
+    }
+    return false;
+}
+
+bool Database::needsConversion() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_needsConversion;
+}
 
+bool Database::openEnvironment(OpenMode mode)
+{
     // nop if already open!
-    if (m_env) {
+    if (m_env || m_shardsOpen) {
         return true;
     }
+    m_needsConversion = false;
 
     QDir dir(m_path);
     if (!dir.exists()) {
@@ -78,8 +415,9 @@ bool Database::open(OpenMode mode)
         dir.refresh();
     }
     QFileInfo indexInfo(dir, QStringLiteral("index"));
+    const QFileInfo shardsInfo(dir, QStringLiteral("shards"));
 
-    if ((mode != CreateDatabase) && !indexInfo.exists()) {
+    if ((mode != CreateDatabase) && !indexInfo.exists() && !shardsInfo.exists()) {
         return false;
     }
 
@@ -96,6 +434,17 @@ bool Database::open(OpenMode mode)
         }
     }
 
+    // The shards are opened by the first transaction using them
+    if (!indexInfo.exists() && (shardsInfo.exists() || (m_sharded && mode == CreateDatabase))) {
+        if (!shardsInfo.exists() && !dir.mkdir(QStringLiteral("shards"))) {
+            return false;
+        }
+
+        m_shardsOpen = true;
+        m_readOnly = (mode == ReadOnlyDatabase);
+        return true;
+    }
+
     int rc = mdb_env_create(&m_env);
     if (rc) {
         m_env = nullptr;
@@ -106,7 +455,9 @@ bool Database::open(OpenMode mode)
      * maximal number of allowed named databases, must match number of databases we create below
      * each additional one leads to overhead
      */
-    mdb_env_set_maxdbs(m_env, 12);
+    mdb_env_set_maxdbs(m_env, 18);
+
+    mdb_env_set_maxreaders(m_env, m_maxReaders);
 
     /**
      * size limit for database == size limit of mmap
@@ -117,7 +468,18 @@ bool Database::open(OpenMode mode)
 
     // The directory needs to be created before opening the environment
     QByteArray arr = QFile::encodeName(indexInfo.absoluteFilePath());
-    rc = mdb_env_open(m_env, arr.constData(), MDB_NOSUBDIR | MDB_NOMEMINIT | ((mode == ReadOnlyDatabase) ? MDB_RDONLY : 0), 0664);
+    // MDB_NOTLS: read transactions are pooled and may be handed between threads
+    uint flags = MDB_NOSUBDIR | MDB_NOMEMINIT | MDB_NOTLS | ((mode == ReadOnlyDatabase) ? MDB_RDONLY : 0);
+    if (m_durability == DeferredSync) {
+        // Integrity is kept as long as the file system does not reorder writes, which is
+        // good enough for an index that can always be rebuilt from the files
+        flags |= MDB_NOSYNC;
+    }
+
+    // Waits while another process swaps in a compacted index
+    lockUsers(LOCK_SH);
+
+    rc = mdb_env_open(m_env, arr.constData(), flags, 0664);
     if (rc) {
         mdb_env_close(m_env);
         m_env = nullptr;
@@ -136,6 +498,10 @@ bool Database::open(OpenMode mode)
     // Individual Databases
     //
     MDB_txn* txn;
+
+    // The saved id sets may be those of the snapshot the databases are opened in
+    quint64 idSetsTxnId = 0;
+    quint64 openTxnId = 0;
     if (mode != CreateDatabase) {
         int rc = mdb_txn_begin(m_env, nullptr, MDB_RDONLY, &txn);
         Q_ASSERT_X(rc == 0, "Database::transaction ro begin", mdb_strerror(rc));
@@ -144,6 +510,7 @@ bool Database::open(OpenMode mode)
             m_env = nullptr;
             return false;
         }
+        idSetsTxnId = mdb_txn_id(txn);
 
         m_dbis.postingDbi = PostingDB::open(txn);
         m_dbis.positionDBi = PositionDB::open(txn);
@@ -163,6 +530,25 @@ bool Database::open(OpenMode mode)
 
         m_dbis.mtimeDbi = MTimeDB::open(txn);
 
+        // Missing in databases created by older versions, which are converted
+        // the first time they are opened with CreateDatabase
+        m_dbis.idOrdinalDbi = OrdinalDB::open("idordinaldb", txn);
+        m_dbis.ordinalIdDbi = OrdinalDB::open("ordinaliddb", txn);
+        m_dbis.freeOrdinalDbi = OrdinalDB::open("freeordinaldb", txn);
+        if (!m_dbis.idOrdinalDbi) {
+            qWarning() << "The index" << m_path << "was created by an older version and has to be converted by baloo_file first";
+            m_needsConversion = true;
+            m_dbis = DatabaseDbis();
+            mdb_txn_abort(txn);
+            mdb_env_close(m_env);
+            m_env = nullptr;
+            return false;
+        }
+
+        m_dbis.termStatsDbi = TermStatsDB::open(txn);
+        m_dbis.metaDataDbi = MetaDataDB::open(txn);
+        m_dbis.tagDbi = TagDB::open(txn);
+
         Q_ASSERT(m_dbis.isValid());
         if (!m_dbis.isValid()) {
             mdb_txn_abort(txn);
@@ -186,6 +572,8 @@ bool Database::open(OpenMode mode)
             m_env = nullptr;
             return false;
         }
+        openTxnId = mdb_txn_id(txn);
+        idSetsTxnId = openTxnId - 1;
 
         m_dbis.postingDbi = PostingDB::create(txn);
         m_dbis.positionDBi = PositionDB::create(txn);
@@ -205,6 +593,32 @@ bool Database::open(OpenMode mode)
 
         m_dbis.mtimeDbi = MTimeDB::create(txn);
 
+        const bool hasOrdinals = OrdinalDB::open("idordinaldb", txn) != 0;
+        m_dbis.idOrdinalDbi = OrdinalDB::create("idordinaldb", txn);
+        m_dbis.ordinalIdDbi = OrdinalDB::create("ordinaliddb", txn);
+        m_dbis.freeOrdinalDbi = OrdinalDB::create("freeordinaldb", txn);
+        if (!hasOrdinals) {
+            convertToOrdinals(txn, m_dbis);
+        }
+
+        // Databases created by older versions do not have any statistics yet,
+        // and the id ranges of converted ones are ordinal ranges now
+        const bool hasStatistics = MetaDataDB::open(txn) != 0;
+        m_dbis.termStatsDbi = TermStatsDB::create(txn);
+        m_dbis.metaDataDbi = MetaDataDB::create(txn);
+        if (hasStatistics && !hasOrdinals) {
+            mdb_drop(txn, m_dbis.termStatsDbi, 0);
+        }
+        if (!hasStatistics || !hasOrdinals) {
+            buildStatistics(txn, m_dbis);
+        }
+
+        const bool hasTags = TagDB::open(txn) != 0;
+        m_dbis.tagDbi = TagDB::create(txn);
+        if (!hasTags) {
+            buildTags(txn, m_dbis);
+        }
+
         Q_ASSERT(m_dbis.isValid());
         if (!m_dbis.isValid()) {
             mdb_txn_abort(txn);
@@ -222,14 +636,566 @@ bool Database::open(OpenMode mode)
         }
     }
 
+    // Creating and converting the databases does not change the sets
+    if (!m_idSets) {
+        m_idSets = new ResidentIdSets(m_path + QStringLiteral("/index-ids"), m_path + QStringLiteral("/index"));
+    }
+    if (m_idSets->load(idSetsTxnId) && openTxnId) {
+        MDB_envinfo info;
+        mdb_env_info(m_env, &info);
+        if (info.me_last_txnid >= openTxnId) {
+            m_idSets->update(openTxnId, ResidentIdSets::Changes());
+        }
+    }
+
     Q_ASSERT(m_env);
+    m_readOnly = (mode == ReadOnlyDatabase);
     return true;
 }
 
+void Database::setMaxReaders(uint count)
+{
+    QMutexLocker locker(&m_mutex);
+    Q_ASSERT_X(!m_env, "Database::setMaxReaders", "The database is already open");
+    Q_ASSERT(count > 0);
+
+    m_maxReaders = count;
+}
+
+void Database::setDurability(Durability durability)
+{
+    QMutexLocker locker(&m_mutex);
+    Q_ASSERT_X(!m_env, "Database::setDurability", "The database is already open");
+
+    m_durability = durability;
+}
+
+Database::Durability Database::durability() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_durability;
+}
+
+bool Database::sync(bool shutdown)
+{
+    if (isSharded()) {
+        bool ok = !m_readOnly;
+        for (Database* shard : openShards()) {
+            shard->m_heldCheckpoint.store(m_heldCheckpoint.load());
+            ok = shard->sync(shutdown) && ok;
+        }
+        return ok;
+    }
+
+    QReadLocker envLocker(&m_envLock);
+    QMutexLocker locker(&m_syncMutex);
+    if (!m_env || m_readOnly || !m_dbis.metaDataDbi) {
+        return false;
+    }
+
+    MDB_envinfo info;
+    mdb_env_info(m_env, &info);
+    if (!shutdown && info.me_last_txnid == m_checkpointTxnId) {
+        return true;
+    }
+
+    // The checkpoint must not reach the disk before the commits it covers
+    int rc;
+    if (m_durability == DeferredSync) {
+        rc = mdb_env_sync(m_env, 1);
+        Q_ASSERT_X(rc == 0, "Database::sync", mdb_strerror(rc));
+        if (rc) {
+            return false;
+        }
+    }
+
+    MDB_txn* txn;
+    rc = mdb_txn_begin(m_env, nullptr, 0, &txn);
+    Q_ASSERT_X(rc == 0, "Database::sync begin", mdb_strerror(rc));
+    if (rc) {
+        return false;
+    }
+
+    // We hold the write lock now, so this commit will be the next one
+    mdb_env_info(m_env, &info);
+    quint64 txnId = info.me_last_txnid + 1;
+
+    MetaDataDB metaDataDb(m_dbis.metaDataDbi, txn);
+    if (const quint32 heldTime = m_heldCheckpoint.load()) {
+        metaDataDb.putCount(checkpointTimeName, heldTime);
+    } else if (m_durability == DeferredSync && !shutdown) {
+        metaDataDb.putCount(checkpointTimeName, QDateTime::currentDateTime().toTime_t());
+    } else if (!metaDataDb.get(checkpointTimeName).isEmpty()) {
+        metaDataDb.del(checkpointTimeName);
+    } else {
+        mdb_txn_abort(txn);
+        txn = nullptr;
+        txnId = info.me_last_txnid;
+    }
+
+    if (txn) {
+        rc = mdb_txn_commit(txn);
+        Q_ASSERT_X(rc == 0, "Database::sync commit", mdb_strerror(rc));
+        if (rc) {
+            return false;
+        }
+
+        // The checkpoint leaves the sets as they are
+        if (m_idSets) {
+            m_idSets->update(txnId, ResidentIdSets::Changes());
+        }
+
+        if (m_durability == DeferredSync) {
+            rc = mdb_env_sync(m_env, 1);
+            Q_ASSERT_X(rc == 0, "Database::sync", mdb_strerror(rc));
+            if (rc) {
+                return false;
+            }
+        }
+    }
+
+    m_checkpointTxnId = txnId;
+    return true;
+}
+
+bool Database::hasCheckpoint(quint32* checkpointTime) const
+{
+    if (isSharded()) {
+        // Everything since the oldest checkpoint has to be checked
+        bool exists = false;
+        for (Database* shard : openShards()) {
+            quint32 time = 0;
+            if (shard->hasCheckpoint(&time)) {
+                if (checkpointTime && (!exists || time < *checkpointTime)) {
+                    *checkpointTime = time;
+                }
+                exists = true;
+            }
+        }
+        return exists;
+    }
+
+    QReadLocker envLocker(&m_envLock);
+    if (!m_env || !m_dbis.metaDataDbi) {
+        return false;
+    }
+
+    MDB_txn* txn = acquireReadTransaction();
+    if (!txn) {
+        return false;
+    }
+
+    MetaDataDB metaDataDb(m_dbis.metaDataDbi, txn);
+    const bool exists = !metaDataDb.get(checkpointTimeName).isEmpty();
+    if (checkpointTime) {
+        *checkpointTime = metaDataDb.count(checkpointTimeName);
+    }
+    releaseReadTransaction(txn);
+
+    return exists;
+}
+
+void Database::holdCheckpoint(quint32 checkpointTime)
+{
+    m_heldCheckpoint.store(checkpointTime);
+}
+
+bool Database::compact(int attempts)
+{
+    if (isSharded()) {
+        bool ok = !m_readOnly;
+        for (Database* shard : openShards()) {
+            ok = shard->compact(attempts) && ok;
+        }
+        return ok;
+    }
+
+    if (!m_env || m_readOnly) {
+        return false;
+    }
+
+    // Other processes would keep using the replaced file, and whatever they
+    // commit to it would be lost. Checked again before swapping in the copy.
+    if (!otherUsersGone()) {
+        return false;
+    }
+
+    const QByteArray indexPath = QFile::encodeName(m_path + QStringLiteral("/index"));
+    const QByteArray copyPath = QFile::encodeName(m_path + QStringLiteral("/index-compact"));
+
+    for (int attempt = 0; attempt < attempts; attempt++) {
+        // LMDB refuses to overwrite a copy left behind by a crash
+        QFile::remove(QFile::decodeName(copyPath));
+
+        quint64 txnId;
+        {
+            QReadLocker envLocker(&m_envLock);
+
+            MDB_envinfo info;
+            mdb_env_info(m_env, &info);
+            txnId = info.me_last_txnid;
+
+            int rc = mdb_env_copy2(m_env, copyPath.constData(), MDB_CP_COMPACT);
+            Q_ASSERT_X(rc == 0, "Database::compact copy", mdb_strerror(rc));
+            if (rc) {
+                QFile::remove(QFile::decodeName(copyPath));
+                return false;
+            }
+        }
+
+        // Threads of this process may wait for each other while holding a
+        // transaction, such as the parallel queries of SearchStore, so
+        // waiting for all of them to end could deadlock
+        if (!m_envLock.tryLockForWrite(s_compactLockTimeout)) {
+            QFile::remove(QFile::decodeName(copyPath));
+            return false;
+        }
+
+        // Processes opening the index wait in open() until the swap is done
+        if (!lockUsers(LOCK_EX | LOCK_NB)) {
+            lockUsers(LOCK_SH);
+            m_envLock.unlock();
+            QFile::remove(QFile::decodeName(copyPath));
+            return false;
+        }
+
+        MDB_envinfo info;
+        mdb_env_info(m_env, &info);
+        if (info.me_last_txnid != txnId) {
+            lockUsers(LOCK_SH);
+            m_envLock.unlock();
+            continue;
+        }
+
+        if (std::rename(copyPath.constData(), indexPath.constData()) != 0) {
+            lockUsers(LOCK_SH);
+            m_envLock.unlock();
+            QFile::remove(QFile::decodeName(copyPath));
+            return false;
+        }
+
+        for (MDB_txn* txn : m_readTxnPool) {
+            mdb_txn_abort(txn);
+        }
+        m_readTxnPool.clear();
+
+        // They are labeled with transaction ids, which start over in the copy
+        if (m_idSets) {
+            m_idSets->clear();
+        }
+        m_snapshotBase.fetchAndAddOrdered(txnId);
+
+        {
+            QMutexLocker locker(&m_mutex);
+            PostingCache::instance()->remove(m_env);
+            mdb_env_close(m_env);
+            m_env = nullptr;
+        }
+        m_checkpointTxnId = 0;
+
+        // No other process has the lock file open, so LMDB sets its reader
+        // table up anew for the copy. open() shares the users lock again.
+        const bool ok = open(ReadWriteDatabase);
+        m_envLock.unlock();
+        return ok;
+    }
+
+    QFile::remove(QFile::decodeName(copyPath));
+    return false;
+}
+
+bool Database::otherUsersGone()
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Converting the lock is not atomic, it has to be taken again if it fails
+    const bool gone = lockUsers(LOCK_EX | LOCK_NB);
+    lockUsers(LOCK_SH);
+    return gone;
+}
+
+void Database::setReadTransactionPoolSize(uint size)
+{
+    {
+        QMutexLocker locker(&m_shardMutex);
+        for (Database* shard : m_shards) {
+            shard->setReadTransactionPoolSize(size);
+        }
+    }
+
+    QMutexLocker locker(&m_poolMutex);
+    m_readTxnPoolSize = size;
+
+    while (static_cast<uint>(m_readTxnPool.size()) > m_readTxnPoolSize) {
+        mdb_txn_abort(m_readTxnPool.takeLast());
+    }
+}
+
+MDB_txn* Database::acquireReadTransaction() const
+{
+    MDB_txn* txn = nullptr;
+    {
+        QMutexLocker locker(&m_poolMutex);
+        if (!m_readTxnPool.isEmpty()) {
+            txn = m_readTxnPool.takeLast();
+        }
+    }
+
+    if (txn) {
+        int rc = mdb_txn_renew(txn);
+        if (rc == 0) {
+            return txn;
+        }
+        mdb_txn_abort(txn);
+    }
+
+    int rc = mdb_txn_begin(m_env, nullptr, MDB_RDONLY, &txn);
+    Q_ASSERT_X(rc == 0, "Database::acquireReadTransaction", mdb_strerror(rc));
+    if (rc) {
+        return nullptr;
+    }
+
+    return txn;
+}
+
+void Database::buildResidentIdSets() const
+{
+    MDB_txn* txn = acquireReadTransaction();
+    if (!txn) {
+        return;
+    }
+
+    m_idSets->build(txn, m_dbis);
+    releaseReadTransaction(txn);
+}
+
+void Database::releaseReadTransaction(MDB_txn* txn) const
+{
+    Q_ASSERT(txn);
+
+    // Releases the snapshot, so that old pages can be reused, but keeps the reader slot
+    mdb_txn_reset(txn);
+
+    QMutexLocker locker(&m_poolMutex);
+    if (static_cast<uint>(m_readTxnPool.size()) < m_readTxnPoolSize) {
+        m_readTxnPool << txn;
+    } else {
+        mdb_txn_abort(txn);
+    }
+}
+
+void Database::setSharded(bool sharded)
+{
+    QMutexLocker locker(&m_mutex);
+    Q_ASSERT_X(!m_env && !m_shardsOpen, "Database::setSharded", "The database is already open");
+
+    m_sharded = sharded;
+}
+
+bool Database::isSharded() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_shardsOpen;
+}
+
+QString Database::shardPath(quint32 deviceId) const
+{
+    return m_path + QStringLiteral("/shards/") + QString::number(deviceId);
+}
+
+Database* Database::addShard(quint32 deviceId, OpenMode mode) const
+{
+    Database* shard = new Database(shardPath(deviceId));
+    shard->m_maxReaders = m_maxReaders;
+    shard->m_durability = m_durability;
+    shard->m_readTxnPoolSize = m_readTxnPoolSize;
+
+    if (!shard->open(mode)) {
+        delete shard;
+        return nullptr;
+    }
+
+    m_shards.insert(deviceId, shard);
+    return shard;
+}
+
+void Database::scanShards() const
+{
+    const QString shardsPath = m_path + QStringLiteral("/shards");
+
+    // The time has a resolution of a second on some file systems, so a shard
+    // created right after the last scan might not have changed it
+    const QDateTime modified = QFileInfo(shardsPath).lastModified();
+    if (modified == m_shardsModified && modified.secsTo(QDateTime::currentDateTime()) > 1) {
+        return;
+    }
+    m_shardsModified = modified;
+
+    QVector<quint32> devices;
+    const QStringList names = QDir(shardsPath).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& name : names) {
+        bool ok = false;
+        const quint32 deviceId = name.toUInt(&ok);
+        if (ok) {
+            devices << deviceId;
+        }
+    }
+
+    for (auto it = m_shards.begin(); it != m_shards.end();) {
+        if (devices.contains(it.key())) {
+            ++it;
+        } else {
+            retireShard(it.value());
+            it = m_shards.erase(it);
+        }
+    }
+
+    for (quint32 deviceId : devices) {
+        // A shard another process is still creating fails to open, try again next time
+        if (!m_shards.contains(deviceId) && !addShard(deviceId, m_readOnly ? ReadOnlyDatabase : ReadWriteDatabase)) {
+            m_shardsModified = QDateTime();
+        }
+    }
+}
+
+void Database::retireShard(Database* shard) const
+{
+    // The snapshot ids of the remaining shards have to make up for its own
+    m_snapshotBase.fetchAndAddOrdered(shard->lastSnapshotId() + 1);
+    m_removedShards << shard;
+}
+
+QMap<quint32, Database*> Database::openShards(quint64* snapshotBase) const
+{
+    QMutexLocker locker(&m_shardMutex);
+    scanShards();
+    if (snapshotBase) {
+        *snapshotBase = m_snapshotBase.load();
+    }
+    return m_shards;
+}
+
+int Database::lockWriters() const
+{
+    // A descriptor per transaction, so that the threads of this process
+    // exclude each other as well
+    const QByteArray path = QFile::encodeName(m_path + QStringLiteral("/index-writers"));
+    const int fd = ::open(path.constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0664);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int rc;
+    do {
+        rc = flock(fd, LOCK_EX);
+    } while (rc != 0 && errno == EINTR);
+    Q_ASSERT_X(rc == 0, "Database::lockWriters", strerror(errno));
+
+    return fd;
+}
+
+void Database::unlockWriters(int fd)
+{
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+quint64 Database::lastSnapshotId() const
+{
+    if (!m_env) {
+        return m_snapshotBase.load();
+    }
+
+    MDB_envinfo info;
+    mdb_env_info(m_env, &info);
+    return m_snapshotBase.load() + info.me_last_txnid;
+}
+
+Database* Database::openShard(quint32 deviceId, bool create) const
+{
+    QMutexLocker locker(&m_shardMutex);
+    if (Database* shard = m_shards.value(deviceId)) {
+        return shard;
+    }
+
+    scanShards();
+    if (Database* shard = m_shards.value(deviceId)) {
+        return shard;
+    }
+
+    if (!create || m_readOnly) {
+        return nullptr;
+    }
+    return addShard(deviceId, CreateDatabase);
+}
+
+QVector<quint32> Database::shardDevices() const
+{
+    if (!isSharded()) {
+        return QVector<quint32>();
+    }
+    return openShards().keys().toVector();
+}
+
+Database* Database::shard(quint32 deviceId) const
+{
+    if (!isSharded()) {
+        return nullptr;
+    }
+    return openShard(deviceId, false);
+}
+
+bool Database::removeShard(quint32 deviceId)
+{
+    if (!isSharded() || m_readOnly) {
+        return false;
+    }
+
+    Database* shard;
+    {
+        QMutexLocker locker(&m_shardMutex);
+        shard = m_shards.take(deviceId);
+        if (!shard) {
+            return false;
+        }
+        retireShard(shard);
+    }
+
+    {
+        QWriteLocker envLocker(&shard->m_envLock);
+
+        for (MDB_txn* txn : shard->m_readTxnPool) {
+            mdb_txn_abort(txn);
+        }
+        shard->m_readTxnPool.clear();
+
+        QMutexLocker locker(&shard->m_mutex);
+        PostingCache::instance()->remove(shard->m_env);
+        mdb_env_close(shard->m_env);
+        shard->m_env = nullptr;
+    }
+
+    return QDir(shardPath(deviceId)).removeRecursively();
+}
+
+qint64 Database::fileSize() const
+{
+    if (!isSharded()) {
+        return QFileInfo(m_path + QStringLiteral("/index")).size();
+    }
+
+    qint64 size = 0;
+    for (Database* shard : openShards()) {
+        size += shard->fileSize();
+    }
+    return size;
+}
+
 bool Database::isOpen() const
 {
     QMutexLocker locker(&m_mutex);
-    return m_env != nullptr;
+    return m_env != nullptr || m_shardsOpen;
 }
 
 QString Database::path() const
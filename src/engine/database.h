@@ -22,7 +22,12 @@
 #ifndef BALOO_DATABASE_H
 #define BALOO_DATABASE_H
 
+#include <QAtomicInteger>
+#include <QDateTime>
+#include <QMap>
 #include <QMutex>
+#include <QReadWriteLock>
+#include <QVector>
 
 #include "document.h"
 #include "databasedbis.h"
@@ -30,7 +35,30 @@
 namespace Baloo {
 
 class DatabaseTest;
+class ResidentIdSets;
 
+/**
+ * The Database owns the LMDB environment of the index.
+ *
+ * Thread safety: a Database may be shared between threads. open(), isOpen()
+ * and path() may be called concurrently, and so may the constructors of
+ * Transaction. A Transaction itself must only be used by one thread at a
+ * time, but since the environment is opened with MDB_NOTLS a read only
+ * Transaction is not bound to the thread which created it.
+ *
+ * Read only transactions are pooled: when they end they are reset instead of
+ * aborted and the next one renews them, which saves acquiring a reader slot
+ * for every query. Write transactions are serialized by LMDB, a second one
+ * blocks until the first has been committed or aborted.
+ *
+ * A sharded database keeps one LMDB environment per device below
+ * \c shards/<device id>, each with its own map size. The documents of a
+ * device, along with the folders leading to them, are stored in its shard,
+ * and Transaction routes every call to the shards involved. Dropping a
+ * device only has to delete its shard. Writers still take turns: a
+ * Transaction writing to any shard holds the lock on \c index-writers, so
+ * that two of them never wait for each other's shards.
+ */
 class BALOO_ENGINE_EXPORT Database
 {
 public:
@@ -68,12 +96,147 @@ public:
     /**
      * Open database in given mode.
      * Nop after open was done (even if mode differs).
-     * There is no close as this would invalidate the database for all threads using it.
      * @param mode create or open only?
      * @return success?
      */
     bool open(OpenMode mode);
 
+    /**
+     * Whether the last open() failed because the index was created by an
+     * older version. Only CreateDatabase converts it, which baloo_file does
+     * when it starts, until then the index cannot be read.
+     */
+    bool needsConversion() const;
+
+    /**
+     * Closes the index until open() is called again, so that long running
+     * processes can let compact() of other processes run while they are
+     * idle. Waits for the transactions of this process, so the calling
+     * thread must not have one.
+     */
+    void close();
+
+    /**
+     * Sets the maximum number of read transactions, of all processes using
+     * the index, which may be active at the same time. Has to be called before
+     * open(). Defaults to 126.
+     */
+    void setMaxReaders(uint count);
+
+    /**
+     * Sets the number of finished read transactions which are kept around for
+     * reuse. Every pooled transaction keeps its reader slot, so this should be
+     * well below the maximum number of readers. Defaults to 8.
+     */
+    void setReadTransactionPoolSize(uint size);
+
+    /**
+     * How commits reach the disk
+     */
+    enum Durability {
+        /**
+         * Every commit is flushed to disk before it returns
+         */
+        SyncEveryCommit,
+
+        /**
+         * Commits are only flushed to disk by sync(), or by a later commit of
+         * a process using SyncEveryCommit. A crash may lose the commits made
+         * since the last sync.
+         */
+        DeferredSync
+    };
+
+    /**
+     * Has to be called before open(). Defaults to SyncEveryCommit.
+     */
+    void setDurability(Durability durability);
+    Durability durability() const;
+
+    /**
+     * Flushes all commits to disk and records the time of the flush as the
+     * checkpoint. Does nothing if nothing has been committed since the last
+     * checkpoint.
+     *
+     * The checkpoint is removed instead with SyncEveryCommit, as nothing
+     * can be lost, or when \p shutdown is set by the last process writing
+     * to the index before it exits.
+     *
+     * Blocks while another write transaction is active.
+     * @return false if the database is read only or the flush failed
+     */
+    bool sync(bool shutdown = false);
+
+    /**
+     * Returns true if the index has a checkpoint, i.e. it is being written
+     * with DeferredSync or its writer did not shut down cleanly. The commits
+     * after the checkpoint may have been lost in the latter case, so
+     * everything which changed since \p checkpointTime, set to the time of
+     * the checkpoint, has to be checked again.
+     */
+    bool hasCheckpoint(quint32* checkpointTime = nullptr) const;
+
+    /**
+     * Makes sync() keep the checkpoint at \p checkpointTime, also when
+     * \p shutdown is set, until called with 0. For as long as the changes
+     * lost since that checkpoint are being repaired, so that a crash in the
+     * meantime does not leave them unchecked.
+     */
+    void holdCheckpoint(quint32 checkpointTime);
+
+    /**
+     * Rewrites the index without its free pages, as LMDB never shrinks the
+     * file on its own. The copy is made while reads and writes go on, and
+     * swapped in for the index if no commit happened in the meantime,
+     * otherwise it is made again, up to \p attempts times. Transactions
+     * of this Database wait while the copy is swapped in.
+     *
+     * Processes which have the index open would keep using the replaced
+     * file, so nothing is done while another process has it open, and
+     * processes opening it wait until the copy has been swapped in.
+     *
+     * @return false if the database is read only, another process has it
+     * open, or the copy could not be swapped in
+     */
+    bool compact(int attempts = 3);
+
+    /**
+     * Has to be called before open(). Creates a sharded index if none
+     * exists yet, an existing index is opened as it is. Defaults to false.
+     */
+    void setSharded(bool sharded);
+
+    /**
+     * After open(), returns whether the index is sharded
+     */
+    bool isSharded() const;
+
+    /**
+     * The devices which have a shard, also those created by other
+     * processes since the last call
+     */
+    QVector<quint32> shardDevices() const;
+
+    /**
+     * The database of the shard of \p deviceId, or nullptr if there is none
+     */
+    Database* shard(quint32 deviceId) const;
+
+    /**
+     * Deletes the shard of \p deviceId along with all of its documents.
+     * Waits for the transactions of this process using the shard, so the
+     * calling thread must not have one. Other processes stop seeing the
+     * shard once they start a new transaction.
+     *
+     * @return false if the database is read only or has no such shard
+     */
+    bool removeShard(quint32 deviceId);
+
+    /**
+     * The size of the index on disk, of all shards if sharded
+     */
+    qint64 fileSize() const;
+
     /**
      * Is database open?
      * @return database open?
@@ -100,6 +263,103 @@ private:
     MDB_env* m_env;
     DatabaseDbis m_dbis;
 
+    uint m_maxReaders;
+
+    Durability m_durability;
+    bool m_readOnly;
+
+    /**
+     * serializes sync(), m_checkpointTxnId is the commit of the last checkpoint
+     */
+    QMutex m_syncMutex;
+    quint64 m_checkpointTxnId;
+    QAtomicInteger<quint32> m_heldCheckpoint;
+
+    /**
+     * Held for reading by every Transaction, and for writing while
+     * compact() replaces m_env
+     */
+    mutable QReadWriteLock m_envLock;
+
+    /**
+     * A shared lock on \c index-users is held while the environment is
+     * open. compact() only swaps in its copy while it can take the lock
+     * exclusively, and openers wait for the swap.
+     */
+    int m_usersFd;
+    bool lockUsers(int operation);
+    bool otherUsersGone();
+
+    bool openEnvironment(OpenMode mode);
+    bool m_needsConversion;
+    void closeEnvironment();
+
+    /**
+     * Added to the transaction ids of the snapshot ids, so that those keep
+     * growing when compact() starts the transaction ids over, or when the
+     * index was compacted by another process while it was closed. Sharded
+     * databases add it to the sum of the snapshot ids of their shards, and
+     * add the last snapshot id of every shard they drop.
+     */
+    mutable QAtomicInteger<quint64> m_snapshotBase;
+    quint64 lastSnapshotId() const;
+
+    /**
+     * Returns a read only transaction, renewed from the pool if possible
+     */
+    MDB_txn* acquireReadTransaction() const;
+    void releaseReadTransaction(MDB_txn* txn) const;
+
+    /**
+     * The ids of the documents, of those in phase one and of the failed
+     * ones, kept in memory for the snapshot they were built from and saved
+     * to \c index-ids when the database is closed
+     */
+    ResidentIdSets* m_idSets;
+    void buildResidentIdSets() const;
+
+    mutable QMutex m_poolMutex;
+    mutable QVector<MDB_txn*> m_readTxnPool;
+    uint m_readTxnPoolSize;
+
+    /**
+     * m_sharded is what setSharded() asked for, m_shardsOpen whether the
+     * database has been opened as a sharded one
+     */
+    bool m_sharded;
+    bool m_shardsOpen;
+
+    /**
+     * Returns the open shards after picking up those created or removed
+     * by other processes, and the m_snapshotBase that goes with them in
+     * \p snapshotBase. openShard() opens or, if \p create is set, creates
+     * a single shard.
+     */
+    QMap<quint32, Database*> openShards(quint64* snapshotBase = nullptr) const;
+    Database* openShard(quint32 deviceId, bool create) const;
+    void scanShards() const;
+    void retireShard(Database* shard) const;
+    Database* addShard(quint32 deviceId, OpenMode mode) const;
+    QString shardPath(quint32 deviceId) const;
+
+    /**
+     * Waits for the lock on \c index-writers, which a Transaction holds
+     * from its first write to a shard until it ends. Returns the file
+     * descriptor to hand to unlockWriters(), or -1 if the lock file cannot
+     * be opened.
+     */
+    int lockWriters() const;
+    static void unlockWriters(int fd);
+
+    /**
+     * guards the shards, removed ones are kept until destruction as
+     * transactions of other threads may still use them
+     */
+    mutable QMutex m_shardMutex;
+    mutable QMap<quint32, Database*> m_shards;
+    mutable QVector<Database*> m_removedShards;
+    mutable QDateTime m_shardsModified;
+
     friend class Transaction;
     friend class DatabaseTest;
 
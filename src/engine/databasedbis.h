@@ -44,6 +44,16 @@ public:
     MDB_dbi mtimeDbi;
     MDB_dbi failedIdDbi;
 
+    MDB_dbi idOrdinalDbi;
+    MDB_dbi ordinalIdDbi;
+    MDB_dbi freeOrdinalDbi;
+
+    // Statistics, these may be missing in databases created by older versions
+    // which have only been opened read only since
+    MDB_dbi termStatsDbi;
+    MDB_dbi metaDataDbi;
+    MDB_dbi tagDbi;
+
     DatabaseDbis()
         : postingDbi(0)
         , positionDBi(0)
@@ -57,12 +67,22 @@ public:
         , contentIndexingDbi(0)
         , mtimeDbi(0)
         , failedIdDbi(0)
+        , idOrdinalDbi(0)
+        , ordinalIdDbi(0)
+        , freeOrdinalDbi(0)
+        , termStatsDbi(0)
+        , metaDataDbi(0)
+        , tagDbi(0)
     {}
 
     bool isValid() {
         return postingDbi && positionDBi && docTermsDbi && docFilenameTermsDbi && docXattrTermsDbi &&
                idTreeDbi && idFilenameDbi && docTimeDbi && docDataDbi && contentIndexingDbi && mtimeDbi
-               && failedIdDbi;
+               && failedIdDbi && idOrdinalDbi && ordinalIdDbi && freeOrdinalDbi;
+    }
+
+    bool hasStatistics() const {
+        return termStatsDbi && metaDataDbi;
     }
 };
 
@@ -55,6 +55,14 @@ public:
     size_t failedIds;
 
     size_t mtimeDb;
+
+    // The id to ordinal maps in both directions and the free ordinals
+    size_t ordinalDb;
+
+    // These are 0 for databases which have no statistics yet
+    size_t termStatsDb;
+    size_t metaDataDb;
+    size_t tagDb;
 };
 
 }
@@ -57,7 +57,7 @@ MDB_dbi DocumentIdDB::open(const char* name, MDB_txn* txn)
     return dbi;
 }
 
-void DocumentIdDB::put(quint64 docId)
+bool DocumentIdDB::put(quint64 docId)
 {
     Q_ASSERT(docId > 0);
 
@@ -69,8 +69,13 @@ void DocumentIdDB::put(quint64 docId)
     val.mv_size = 0;
     val.mv_data = nullptr;
 
-    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, MDB_NOOVERWRITE);
+    if (rc == MDB_KEYEXIST) {
+        return false;
+    }
     Q_ASSERT_X(rc == 0, "DocumentIdDB::put", mdb_strerror(rc));
+
+    return rc == 0;
 }
 
 bool DocumentIdDB::contains(quint64 docId)
@@ -91,7 +96,7 @@ bool DocumentIdDB::contains(quint64 docId)
     return true;
 }
 
-void DocumentIdDB::del(quint64 docId)
+bool DocumentIdDB::del(quint64 docId)
 {
     Q_ASSERT(docId > 0);
 
@@ -101,9 +106,11 @@ void DocumentIdDB::del(quint64 docId)
 
     int rc = mdb_del(m_txn, m_dbi, &key, nullptr);
     if (rc == MDB_NOTFOUND) {
-        return;
+        return false;
     }
     Q_ASSERT_X(rc == 0, "DocumentIdDB::del", mdb_strerror(rc));
+
+    return rc == 0;
 }
 
 QVector<quint64> DocumentIdDB::fetchItems(int size)
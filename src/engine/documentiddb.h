@@ -37,9 +37,16 @@ public:
     static MDB_dbi create(const char* name, MDB_txn* txn);
     static MDB_dbi open(const char* name, MDB_txn* txn);
 
-    void put(quint64 docId);
+    /**
+     * Returns true if \p docId was not in the database before
+     */
+    bool put(quint64 docId);
     bool contains(quint64 docId);
-    void del(quint64 docID);
+
+    /**
+     * Returns true if \p docId was in the database
+     */
+    bool del(quint64 docID);
 
     QVector<quint64> fetchItems(int size);
     uint size();
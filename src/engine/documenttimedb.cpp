@@ -122,6 +122,33 @@ bool DocumentTimeDB::contains(quint64 docId)
     return true;
 }
 
+bool DocumentTimeDB::idRange(quint64* firstId, quint64* lastId)
+{
+    Q_ASSERT(firstId);
+    Q_ASSERT(lastId);
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    int rc = mdb_cursor_get(cursor, &key, &val, MDB_FIRST);
+    if (rc == MDB_NOTFOUND) {
+        mdb_cursor_close(cursor);
+        return false;
+    }
+    Q_ASSERT_X(rc == 0, "DocumentTimeDB::idRange", mdb_strerror(rc));
+    *firstId = *(static_cast<quint64*>(key.mv_data));
+
+    rc = mdb_cursor_get(cursor, &key, &val, MDB_LAST);
+    Q_ASSERT_X(rc == 0, "DocumentTimeDB::idRange", mdb_strerror(rc));
+    *lastId = *(static_cast<quint64*>(key.mv_data));
+
+    mdb_cursor_close(cursor);
+    return true;
+}
+
 QMap<quint64, DocumentTimeDB::TimeInfo> DocumentTimeDB::toTestMap() const
 {
     MDB_cursor* cursor;
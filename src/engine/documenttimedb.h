@@ -55,6 +55,12 @@ public:
     void del(quint64 docId);
     bool contains(quint64 docId);
 
+    /**
+     * Returns the smallest and the largest document id in \p firstId and
+     * \p lastId, or false if the database is empty
+     */
+    bool idRange(quint64* firstId, quint64* lastId);
+
     QMap<quint64, TimeInfo> toTestMap() const;
 private:
     MDB_txn* m_txn;
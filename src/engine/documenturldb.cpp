@@ -32,6 +32,7 @@ DocumentUrlDB::DocumentUrlDB(MDB_dbi idTreeDb, MDB_dbi idFilenameDb, MDB_txn* tx
     : m_txn(txn)
     , m_idFilenameDbi(idFilenameDb)
     , m_idTreeDbi(idTreeDb)
+    , m_changeLog(nullptr)
 {
 }
 
@@ -123,6 +124,9 @@ void DocumentUrlDB::add(quint64 id, quint64 parentId, const QByteArray& name)
     path.name = name;
 
     idFilenameDb.put(id, path);
+    if (m_changeLog) {
+        m_changeLog->insert(id);
+    }
 }
 
 QByteArray DocumentUrlDB::get(quint64 docId) const
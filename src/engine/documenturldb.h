@@ -26,6 +26,7 @@
 
 #include <QDebug>
 #include <QFile>
+#include <QSet>
 
 namespace Baloo {
 
@@ -64,6 +65,14 @@ public:
 
     void rename(quint64 docId, const QByteArray& newFileName);
 
+    /**
+     * Collects the ids of the entries added or removed from now on in \p ids,
+     * including the folders added or removed along with a document
+     */
+    void setChangeLog(QSet<quint64>* ids) {
+        m_changeLog = ids;
+    }
+
     quint64 getId(quint64 docId, const QByteArray& fileName) const;
 
     PostingIterator* iter(quint64 docId) {
@@ -79,6 +88,7 @@ private:
     MDB_txn* m_txn;
     MDB_dbi m_idFilenameDbi;
     MDB_dbi m_idTreeDbi;
+    QSet<quint64>* m_changeLog;
 
     friend class UrlTest;
 };
@@ -97,6 +107,9 @@ void DocumentUrlDB::replace(quint64 docId, const QByteArray& url, Functor should
         return;
     }
     idFilenameDb.del(docId);
+    if (m_changeLog) {
+        m_changeLog->insert(docId);
+    }
 
     QVector<quint64> subDocs = idTreeDb.get(path.parentId);
     subDocs.removeOne(docId);
@@ -118,6 +131,9 @@ void DocumentUrlDB::replace(quint64 docId, const QByteArray& url, Functor should
             if (subDocs.size() == 1 && shouldDeleteFolder(id)) {
                 idTreeDb.del(path.parentId);
                 idFilenameDb.del(id);
+                if (m_changeLog) {
+                    m_changeLog->insert(id);
+                }
             } else {
                 break;
             }
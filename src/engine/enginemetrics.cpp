@@ -0,0 +1,110 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "enginemetrics.h"
+
+#include <QMutexLocker>
+
+using namespace Baloo;
+
+Q_GLOBAL_STATIC(EngineMetrics, s_engineMetrics)
+
+// Upper bounds of the commit latency buckets in milliseconds, the last bucket is unbounded
+static const quint64 s_latencyBounds[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000};
+
+EngineMetrics::EngineMetrics()
+{
+    Q_STATIC_ASSERT(sizeof(s_latencyBounds) / sizeof(s_latencyBounds[0]) == LatencyBucketCount - 1);
+}
+
+EngineMetrics* EngineMetrics::instance()
+{
+    return s_engineMetrics();
+}
+
+void EngineMetrics::recordCommit(const CommitStats& stats)
+{
+    m_commits.fetchAndAddRelaxed(1);
+    m_commitUsecs.fetchAndAddRelaxed(stats.usecs);
+    m_terms.fetchAndAddRelaxed(stats.terms);
+    m_operations.fetchAndAddRelaxed(stats.operations);
+    m_bytes.fetchAndAddRelaxed(stats.bytes);
+    m_pages.fetchAndAddRelaxed(stats.pages);
+
+    quint64 max = m_maxOperations.load();
+    while (stats.operations > max && !m_maxOperations.testAndSetRelaxed(max, stats.operations)) {
+        max = m_maxOperations.load();
+    }
+
+    int bucket = 0;
+    while (bucket < LatencyBucketCount - 1 && stats.usecs > s_latencyBounds[bucket] * 1000) {
+        bucket++;
+    }
+    m_latency[bucket].fetchAndAddRelaxed(1);
+
+    QMutexLocker locker(&m_lastCommitMutex);
+    m_lastCommit = stats;
+}
+
+EngineMetrics::CommitStats EngineMetrics::lastCommit() const
+{
+    QMutexLocker locker(&m_lastCommitMutex);
+    return m_lastCommit;
+}
+
+QVariantList EngineMetrics::latencyBucketBounds()
+{
+    QVariantList bounds;
+    for (quint64 bound : s_latencyBounds) {
+        bounds << bound;
+    }
+    return bounds;
+}
+
+QVariantMap EngineMetrics::snapshot() const
+{
+    QVariantMap map;
+    map.insert(QStringLiteral("commits"), m_commits.load());
+    map.insert(QStringLiteral("commitTimeUsecs"), m_commitUsecs.load());
+    map.insert(QStringLiteral("termsTouched"), m_terms.load());
+    map.insert(QStringLiteral("pendingOperations"), m_operations.load());
+    map.insert(QStringLiteral("maxPendingOperations"), m_maxOperations.load());
+    map.insert(QStringLiteral("bytesWritten"), m_bytes.load());
+    map.insert(QStringLiteral("pagesGrown"), m_pages.load());
+
+    QVariantList latency;
+    for (const QAtomicInteger<quint64>& count : m_latency) {
+        latency << count.load();
+    }
+    map.insert(QStringLiteral("commitLatencyHistogram"), latency);
+    map.insert(QStringLiteral("commitLatencyBoundsMsecs"), latencyBucketBounds());
+
+    const CommitStats last = lastCommit();
+    QVariantMap lastMap;
+    lastMap.insert(QStringLiteral("usecs"), last.usecs);
+    lastMap.insert(QStringLiteral("termsTouched"), last.terms);
+    lastMap.insert(QStringLiteral("pendingOperations"), last.operations);
+    lastMap.insert(QStringLiteral("bytesWritten"), last.bytes);
+    lastMap.insert(QStringLiteral("pagesGrown"), last.pages);
+    map.insert(QStringLiteral("lastCommit"), lastMap);
+
+    return map;
+}
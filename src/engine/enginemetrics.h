@@ -0,0 +1,105 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_ENGINEMETRICS_H
+#define BALOO_ENGINEMETRICS_H
+
+#include "engine_export.h"
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QVariantMap>
+
+namespace Baloo {
+
+/**
+ * Process wide counters of the write path. They are cheap enough to be
+ * always on: recording only takes relaxed atomic additions, and a snapshot
+ * need not be consistent between the individual counters.
+ *
+ * Write transactions are serialized by LMDB, so there is no contention which
+ * would make per thread counters worthwhile.
+ */
+class BALOO_ENGINE_EXPORT EngineMetrics
+{
+public:
+    EngineMetrics();
+
+    /**
+     * The metrics which the Transaction records to
+     */
+    static EngineMetrics* instance();
+
+    struct CommitStats {
+        /// The time taken by the commit, including writing the posting lists
+        quint64 usecs;
+        /// The number of terms whose posting lists were rewritten
+        quint64 terms;
+        /// The number of queued posting list operations
+        quint64 operations;
+        /// The size of the posting and position lists which were written
+        quint64 bytes;
+        /// The number of pages by which the database file grew
+        quint64 pages;
+
+        CommitStats() : usecs(0), terms(0), operations(0), bytes(0), pages(0) {}
+    };
+
+    /**
+     * Adds a commit of this or, when forwarded, another process
+     */
+    void recordCommit(const CommitStats& stats);
+
+    /**
+     * Returns the last commit recorded in this process
+     */
+    CommitStats lastCommit() const;
+
+    /**
+     * Returns all counters. The commit latency histogram is a list of counts
+     * for the buckets with the upper bounds in milliseconds of
+     * latencyBucketBounds(), followed by the count of slower commits.
+     */
+    QVariantMap snapshot() const;
+
+    static QVariantList latencyBucketBounds();
+
+private:
+    enum {
+        LatencyBucketCount = 12
+    };
+
+    QAtomicInteger<quint64> m_commits;
+    QAtomicInteger<quint64> m_commitUsecs;
+    QAtomicInteger<quint64> m_terms;
+    QAtomicInteger<quint64> m_operations;
+    QAtomicInteger<quint64> m_maxOperations;
+    QAtomicInteger<quint64> m_bytes;
+    QAtomicInteger<quint64> m_pages;
+    QAtomicInteger<quint64> m_latency[LatencyBucketCount];
+
+    mutable QMutex m_lastCommitMutex;
+    CommitStats m_lastCommit;
+};
+
+}
+
+#endif // BALOO_ENGINEMETRICS_H
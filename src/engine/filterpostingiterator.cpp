@@ -0,0 +1,76 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filterpostingiterator.h"
+
+using namespace Baloo;
+
+FilterPostingIterator::FilterPostingIterator(PostingIterator* it, const Filter& filter)
+    : m_it(it)
+    , m_filter(filter)
+    , m_docId(0)
+{
+    Q_ASSERT(m_it);
+}
+
+FilterPostingIterator::~FilterPostingIterator()
+{
+    delete m_it;
+}
+
+quint64 FilterPostingIterator::docId() const
+{
+    return m_docId;
+}
+
+quint64 FilterPostingIterator::next()
+{
+    m_docId = findMatch(m_it->next());
+    return m_docId;
+}
+
+quint64 FilterPostingIterator::skipTo(quint64 id)
+{
+    if (m_docId && m_docId >= id) {
+        return m_docId;
+    }
+
+    m_docId = findMatch(m_it->skipTo(id));
+    return m_docId;
+}
+
+quint64 FilterPostingIterator::findMatch(quint64 id)
+{
+    while (id && !m_filter(id)) {
+        id = m_it->next();
+    }
+    return id;
+}
+
+uint FilterPostingIterator::estimatedSize() const
+{
+    return m_it->estimatedSize();
+}
+
+QVector<uint> FilterPostingIterator::positions()
+{
+    return m_it->positions();
+}
@@ -0,0 +1,63 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_FILTERPOSTINGITERATOR_H
+#define BALOO_FILTERPOSTINGITERATOR_H
+
+#include "postingiterator.h"
+
+#include <functional>
+
+namespace Baloo {
+
+/**
+ * Yields the ids of another iterator which pass the \p filter. This is used
+ * for query constraints which are cheaper to check per document than to
+ * enumerate, such as a parent folder or an mtime range, when the rest of
+ * the query is selective.
+ *
+ * Takes ownership of the wrapped iterator.
+ */
+class BALOO_ENGINE_EXPORT FilterPostingIterator : public PostingIterator
+{
+public:
+    typedef std::function<bool (quint64)> Filter;
+
+    FilterPostingIterator(PostingIterator* it, const Filter& filter);
+    ~FilterPostingIterator();
+
+    quint64 next() Q_DECL_OVERRIDE;
+    quint64 docId() const Q_DECL_OVERRIDE;
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE;
+    uint estimatedSize() const Q_DECL_OVERRIDE;
+    QVector<uint> positions() Q_DECL_OVERRIDE;
+
+private:
+    quint64 findMatch(quint64 id);
+
+    PostingIterator* m_it;
+    Filter m_filter;
+    quint64 m_docId;
+};
+
+}
+
+#endif // BALOO_FILTERPOSTINGITERATOR_H
@@ -0,0 +1,667 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "indexchecker.h"
+#include "database.h"
+#include "transaction.h"
+#include "writetransaction.h"
+#include "postingcodec.h"
+#include "documentdb.h"
+#include "idfilenamedb.h"
+#include "idutils.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QTemporaryFile>
+#include <QPair>
+#include <QDebug>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace Baloo;
+
+/**
+ * The terms of the documents with ordinals from \c first to \c last
+ */
+struct IndexChecker::Chunk {
+    quint64 first;
+    quint64 last;
+
+    QVector<quint64> ordinals;
+
+    // The sorted terms of ordinals[i] are terms[offsets[i]] to terms[offsets[i + 1]]
+    QVector<int> offsets;
+    QVector<QByteArray> terms;
+};
+
+namespace {
+
+// Read ahead for every run a scanner merges
+static const int s_runBufferSize = 16 * 1024;
+
+// Problems the scanners may find before the calling thread reports them
+static const int s_problemQueueSize = 1024;
+
+/**
+ * A term of a document, runs are sorted by term and then by ordinal
+ */
+struct RunEntry {
+    QByteArray term;
+    quint64 ordinal;
+
+    bool operator < (const RunEntry& rhs) const {
+        return term < rhs.term || (term == rhs.term && ordinal < rhs.ordinal);
+    }
+};
+
+/**
+ * Reads the entries of a run from \c begin up to \c end of the runs file.
+ * An entry is the size of the term, the term and the ordinal.
+ */
+class RunReader
+{
+public:
+    RunReader(int fd, qint64 begin, qint64 end)
+        : m_fd(fd)
+        , m_filePos(begin)
+        , m_end(end)
+        , m_bufferPos(0)
+        , m_valid(false)
+    {
+        next();
+    }
+
+    bool atEnd() const { return !m_valid; }
+    const RunEntry& entry() const { return m_entry; }
+
+    void next()
+    {
+        quint32 size = 0;
+        m_valid = read(&size, sizeof(size));
+        if (m_valid) {
+            m_entry.term.resize(size);
+            m_valid = read(m_entry.term.data(), size) && read(&m_entry.ordinal, sizeof(quint64));
+        }
+    }
+
+private:
+    bool read(void* data, int size)
+    {
+        char* out = static_cast<char*>(data);
+        while (size > 0) {
+            if (m_bufferPos == m_buffer.size()) {
+                const qint64 count = qMin<qint64>(s_runBufferSize, m_end - m_filePos);
+                if (count <= 0) {
+                    return false;
+                }
+
+                m_buffer.resize(count);
+                ssize_t rc;
+                do {
+                    rc = ::pread(m_fd, m_buffer.data(), count, m_filePos);
+                } while (rc < 0 && errno == EINTR);
+                if (rc <= 0) {
+                    return false;
+                }
+                m_buffer.resize(rc);
+                m_filePos += rc;
+                m_bufferPos = 0;
+            }
+
+            const int count = qMin(size, m_buffer.size() - m_bufferPos);
+            memcpy(out, m_buffer.constData() + m_bufferPos, count);
+            m_bufferPos += count;
+            out += count;
+            size -= count;
+        }
+        return true;
+    }
+
+    int m_fd;
+    qint64 m_filePos;
+    qint64 m_end;
+    QByteArray m_buffer;
+    int m_bufferPos;
+
+    RunEntry m_entry;
+    bool m_valid;
+};
+
+/**
+ * Hands the problems found by the scanners to the calling thread. A full
+ * queue blocks the scanners until the calling thread has caught up.
+ */
+class ProblemQueue
+{
+public:
+    explicit ProblemQueue(int producers)
+        : m_producers(producers)
+    {
+    }
+
+    void push(const IndexChecker::Problem& problem)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_problems.size() >= s_problemQueueSize) {
+            m_notFull.wait(&m_mutex);
+        }
+        m_problems.enqueue(problem);
+        m_notEmpty.wakeOne();
+    }
+
+    /**
+     * Called by every scanner once it is done
+     */
+    void finish()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_producers--;
+        m_notEmpty.wakeOne();
+    }
+
+    /**
+     * Waits for the next problem. Returns false once all scanners are done
+     * and every problem has been taken.
+     */
+    bool pop(IndexChecker::Problem* problem)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_problems.isEmpty() && m_producers > 0) {
+            m_notEmpty.wait(&m_mutex);
+        }
+        if (m_problems.isEmpty()) {
+            return false;
+        }
+        *problem = m_problems.dequeue();
+        m_notFull.wakeAll();
+        return true;
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QQueue<IndexChecker::Problem> m_problems;
+    int m_producers;
+};
+
+/**
+ * Merges the posting lists of the terms from \c lo up to \c hi, an empty
+ * \c hi being the end of the posting db, against the same term range of
+ * every run
+ */
+class PostingScanner : public QThread
+{
+public:
+    PostingScanner(MDB_txn* txn, MDB_dbi dbi, int runsFd, const QVector<QPair<qint64, qint64>>& runRanges,
+                   const QByteArray& lo, const QByteArray& hi, ProblemQueue* queue)
+        : m_txn(txn)
+        , m_dbi(dbi)
+        , m_runsFd(runsFd)
+        , m_runRanges(runRanges)
+        , m_lo(lo)
+        , m_hi(hi)
+        , m_queue(queue)
+        , m_postingCount(0)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        scan();
+        m_queue->finish();
+    }
+
+    quint64 postingCount() const { return m_postingCount; }
+
+private:
+    void scan();
+
+    void addProblem(IndexChecker::Problem::Type type, const QByteArray& term, quint64 ordinal)
+    {
+        // The ids are filled in by the calling thread
+        m_queue->push({type, 0, QByteArray(term.constData(), term.size()), ordinal});
+    }
+
+    MDB_txn* m_txn;
+    MDB_dbi m_dbi;
+
+    int m_runsFd;
+    QVector<QPair<qint64, qint64>> m_runRanges;
+
+    QByteArray m_lo;
+    QByteArray m_hi;
+    ProblemQueue* m_queue;
+    quint64 m_postingCount;
+};
+
+void PostingScanner::scan()
+{
+    // The smallest entry of all runs is on top
+    QVector<RunReader*> readers;
+    for (const auto& range : m_runRanges) {
+        readers << new RunReader(m_runsFd, range.first, range.second);
+    }
+    auto greater = [](const RunReader* lhs, const RunReader* rhs) {
+        return rhs->entry() < lhs->entry();
+    };
+    std::priority_queue<RunReader*, std::vector<RunReader*>, decltype(greater)> heap(greater);
+    for (RunReader* reader : readers) {
+        if (!reader->atEnd()) {
+            heap.push(reader);
+        }
+    }
+    auto advance = [&heap]() {
+        RunReader* reader = heap.top();
+        heap.pop();
+        reader->next();
+        if (!reader->atEnd()) {
+            heap.push(reader);
+        }
+    };
+
+    MDB_cursor* cursor;
+    int rc = mdb_cursor_open(m_txn, m_dbi, &cursor);
+    Q_ASSERT_X(rc == 0, "IndexChecker::PostingScanner", mdb_strerror(rc));
+    if (rc) {
+        qDeleteAll(readers);
+        return;
+    }
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+    if (m_lo.isEmpty()) {
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_FIRST);
+    } else {
+        key.mv_size = m_lo.size();
+        key.mv_data = static_cast<void*>(m_lo.data());
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+    }
+
+    PostingCodec codec;
+    QVector<quint64> ordinals;
+    while (rc == 0) {
+        const QByteArray term = QByteArray::fromRawData(static_cast<char*>(key.mv_data), key.mv_size);
+        if (!m_hi.isEmpty() && term >= m_hi) {
+            break;
+        }
+
+        // Terms of documents which have no posting list at all
+        while (!heap.empty() && heap.top()->entry().term < term) {
+            addProblem(IndexChecker::Problem::MissingPosting, heap.top()->entry().term, heap.top()->entry().ordinal);
+            advance();
+        }
+
+        // The documents with this term, in the order of their ordinals
+        ordinals.clear();
+        while (!heap.empty() && heap.top()->entry().term == term) {
+            ordinals << heap.top()->entry().ordinal;
+            advance();
+        }
+
+        const QVector<quint64> list = codec.decode(QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size));
+        m_postingCount += list.size();
+
+        auto it = list.constBegin();
+        auto ordinalIt = ordinals.constBegin();
+        while (it != list.constEnd() || ordinalIt != ordinals.constEnd()) {
+            if (ordinalIt == ordinals.constEnd() || (it != list.constEnd() && *it < *ordinalIt)) {
+                addProblem(IndexChecker::Problem::UnknownPosting, term, *it++);
+            } else if (it == list.constEnd() || *ordinalIt < *it) {
+                addProblem(IndexChecker::Problem::MissingPosting, term, *ordinalIt++);
+            } else {
+                ++it;
+                ++ordinalIt;
+            }
+        }
+
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+    }
+    Q_ASSERT_X(rc == 0 || rc == MDB_NOTFOUND, "IndexChecker::PostingScanner", mdb_strerror(rc));
+    mdb_cursor_close(cursor);
+
+    // Terms after the last posting list of the range
+    while (!heap.empty()) {
+        addProblem(IndexChecker::Problem::MissingPosting, heap.top()->entry().term, heap.top()->entry().ordinal);
+        advance();
+    }
+
+    qDeleteAll(readers);
+}
+
+}
+
+IndexChecker::IndexChecker(Database* db)
+    : m_db(db)
+    , m_threadCount(qMax(1, QThread::idealThreadCount()))
+    , m_chunkSize(1 << 19)
+    , m_documentCount(0)
+    , m_postingCount(0)
+{
+    Q_ASSERT(db);
+}
+
+void IndexChecker::setThreadCount(int count)
+{
+    Q_ASSERT(count > 0);
+    m_threadCount = count;
+}
+
+void IndexChecker::setChunkSize(int terms)
+{
+    Q_ASSERT(terms > 0);
+    m_chunkSize = terms;
+}
+
+QVector<QByteArray> IndexChecker::termRanges(Transaction* tr) const
+{
+    QVector<QByteArray> bounds;
+    if (m_threadCount == 1) {
+        return bounds;
+    }
+
+    MDB_stat stat;
+    int rc = mdb_stat(tr->m_txn, tr->m_dbis.postingDbi, &stat);
+    Q_ASSERT_X(rc == 0, "IndexChecker::termRanges", mdb_strerror(rc));
+    if (rc) {
+        return bounds;
+    }
+    const size_t step = stat.ms_entries / m_threadCount + 1;
+
+    MDB_cursor* cursor;
+    rc = mdb_cursor_open(tr->m_txn, tr->m_dbis.postingDbi, &cursor);
+    Q_ASSERT_X(rc == 0, "IndexChecker::termRanges", mdb_strerror(rc));
+    if (rc) {
+        return bounds;
+    }
+
+    // Only the keys are read, the posting lists are not touched
+    MDB_val key;
+    MDB_val val;
+    size_t count = 0;
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        if (count && count % step == 0) {
+            bounds << QByteArray(static_cast<char*>(key.mv_data), key.mv_size);
+        }
+        count++;
+    }
+    mdb_cursor_close(cursor);
+
+    return bounds;
+}
+
+void IndexChecker::fillChunk(Transaction* tr, quint64 first, Chunk* chunk, const Reporter& report) const
+{
+    chunk->first = first;
+    chunk->ordinals.clear();
+    chunk->offsets.clear();
+    chunk->terms.clear();
+
+    const DatabaseDbis& dbis = tr->m_dbis;
+    DocumentDB documentTermsDB(dbis.docTermsDbi, tr->m_txn);
+    DocumentDB documentFileNameTermsDB(dbis.docFilenameTermsDbi, tr->m_txn);
+    DocumentDB documentXattrTermsDB(dbis.docXattrTermsDbi, tr->m_txn);
+    IdFilenameDB idFilenameDB(dbis.idFilenameDbi, tr->m_txn);
+    DocumentDB* const termDbs[] = { &documentTermsDB, &documentFileNameTermsDB, &documentXattrTermsDB };
+
+    MDB_cursor* cursor = nullptr;
+    int rc = mdb_cursor_open(tr->m_txn, dbis.ordinalIdDbi, &cursor);
+    Q_ASSERT_X(rc == 0, "IndexChecker::fillChunk", mdb_strerror(rc));
+
+    // The documents are walked in the order of their ordinals, which is the
+    // order of the posting lists
+    quint32 firstOrdinal = qMin<quint64>(first, std::numeric_limits<quint32>::max());
+    MDB_val key;
+    key.mv_size = sizeof(quint32);
+    key.mv_data = static_cast<void*>(&firstOrdinal);
+    MDB_val val;
+    rc = rc ? rc : mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+
+    chunk->last = std::numeric_limits<quint64>::max();
+    while (rc == 0) {
+        const quint32 ordinal = *static_cast<quint32*>(key.mv_data);
+        const quint64 id = *static_cast<quint64*>(val.mv_data);
+        if (chunk->terms.size() >= m_chunkSize) {
+            chunk->last = ordinal - 1;
+            break;
+        }
+
+        // A term may be in more than one of them
+        const int start = chunk->terms.size();
+        for (DocumentDB* db : termDbs) {
+            chunk->terms += db->get(id);
+        }
+        std::sort(chunk->terms.begin() + start, chunk->terms.end());
+        chunk->terms.erase(std::unique(chunk->terms.begin() + start, chunk->terms.end()), chunk->terms.end());
+
+        chunk->ordinals << ordinal;
+        chunk->offsets << start;
+
+        if (chunk->terms.size() > start && !idFilenameDB.contains(id)) {
+            report({Problem::MissingUrl, id, QByteArray(), ordinal});
+        }
+
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+    }
+    Q_ASSERT_X(rc == 0 || rc == MDB_NOTFOUND, "IndexChecker::fillChunk", mdb_strerror(rc));
+    if (cursor) {
+        mdb_cursor_close(cursor);
+    }
+
+    chunk->offsets << chunk->terms.size();
+}
+
+QVector<qint64> IndexChecker::writeRun(QFile* file, const Chunk& chunk, const QVector<QByteArray>& bounds)
+{
+    QVector<RunEntry> entries;
+    entries.reserve(chunk.terms.size());
+    for (int i = 0; i < chunk.ordinals.size(); i++) {
+        for (int t = chunk.offsets[i]; t < chunk.offsets[i + 1]; t++) {
+            entries.append({chunk.terms[t], chunk.ordinals[i]});
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+
+    // Where each of the term ranges starts, and where the run ends
+    QVector<qint64> offsets;
+    offsets.reserve(bounds.size() + 2);
+    offsets << file->pos();
+
+    QByteArray buffer;
+    for (const RunEntry& entry : entries) {
+        while (offsets.size() <= bounds.size() && entry.term >= bounds[offsets.size() - 1]) {
+            file->write(buffer);
+            buffer.clear();
+            offsets << file->pos();
+        }
+
+        const quint32 size = entry.term.size();
+        buffer.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        buffer.append(entry.term);
+        buffer.append(reinterpret_cast<const char*>(&entry.ordinal), sizeof(quint64));
+        if (buffer.size() >= s_runBufferSize) {
+            file->write(buffer);
+            buffer.clear();
+        }
+    }
+    file->write(buffer);
+
+    while (offsets.size() < bounds.size() + 2) {
+        offsets << file->pos();
+    }
+    return offsets;
+}
+
+bool IndexChecker::check(const Reporter& report)
+{
+    m_documentCount = 0;
+    m_postingCount = 0;
+
+    // Every shard is an index of its own
+    if (m_db->isSharded()) {
+        for (quint32 deviceId : m_db->shardDevices()) {
+            Database* shard = m_db->shard(deviceId);
+            if (!shard) {
+                continue;
+            }
+
+            IndexChecker checker(shard);
+            checker.setThreadCount(m_threadCount);
+            checker.setChunkSize(m_chunkSize);
+            const quint64 deviceBase = quint64(deviceId) << 32;
+            const bool ok = checker.check([&report, deviceBase](const Problem& problem) {
+                Problem shardProblem = problem;
+                shardProblem.ordinal |= deviceBase;
+                report(shardProblem);
+            });
+
+            m_documentCount += checker.documentCount();
+            m_postingCount += checker.postingCount();
+            if (!ok) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    for (int attempt = 0; attempt < 3; attempt++) {
+        Transaction tr(m_db, Transaction::ReadOnly);
+        const QVector<QByteArray> bounds = termRanges(&tr);
+
+        // Every scanner has to see the snapshot the documents are read from
+        const size_t txnId = mdb_txn_id(tr.m_txn);
+        bool sameSnapshot = true;
+        QVector<Transaction*> transactions;
+        for (int i = 0; i <= bounds.size(); i++) {
+            Transaction* scannerTr = new Transaction(m_db, Transaction::ReadOnly);
+            sameSnapshot = sameSnapshot && mdb_txn_id(scannerTr->m_txn) == txnId;
+            transactions << scannerTr;
+        }
+        if (!sameSnapshot) {
+            qDeleteAll(transactions);
+            continue;
+        }
+
+        QTemporaryFile runsFile;
+        if (!runsFile.open()) {
+            qWarning() << "Could not create a temporary file" << runsFile.errorString();
+            qDeleteAll(transactions);
+            return false;
+        }
+
+        // The terms of the documents are sorted by term one chunk at a time
+        // and written to the runs file, so the posting db is read only once
+        QVector<QVector<qint64>> runOffsets;
+        Chunk chunk;
+        quint64 first = 1;
+        while (true) {
+            fillChunk(&tr, first, &chunk, report);
+            runOffsets << writeRun(&runsFile, chunk, bounds);
+            m_documentCount += chunk.ordinals.size();
+
+            if (chunk.last == std::numeric_limits<quint64>::max()) {
+                break;
+            }
+            first = chunk.last + 1;
+        }
+        chunk = Chunk();
+        runsFile.flush();
+
+        ProblemQueue queue(bounds.size() + 1);
+        QVector<PostingScanner*> scanners;
+        for (int i = 0; i <= bounds.size(); i++) {
+            QVector<QPair<qint64, qint64>> runRanges;
+            runRanges.reserve(runOffsets.size());
+            for (const QVector<qint64>& offsets : runOffsets) {
+                runRanges.append(qMakePair(offsets[i], offsets[i + 1]));
+            }
+
+            scanners << new PostingScanner(transactions[i]->m_txn, tr.m_dbis.postingDbi, runsFile.handle(), runRanges,
+                                           i ? bounds[i - 1] : QByteArray(),
+                                           i < bounds.size() ? bounds[i] : QByteArray(), &queue);
+        }
+
+        for (PostingScanner* scanner : scanners) {
+            scanner->start();
+        }
+
+        // The problems are reported while the scanners go on
+        Problem problem;
+        while (queue.pop(&problem)) {
+            problem.id = tr.ordinalToId(problem.ordinal);
+            report(problem);
+        }
+
+        for (PostingScanner* scanner : scanners) {
+            scanner->wait();
+            m_postingCount += scanner->postingCount();
+        }
+        qDeleteAll(scanners);
+        qDeleteAll(transactions);
+        return true;
+    }
+
+    return false;
+}
+
+void IndexChecker::repair(Transaction* tr, const Problem& problem)
+{
+    quint64 ordinal = problem.ordinal;
+    if (tr->m_sharded) {
+        // The ordinal of a posting without a document only carries its device
+        Transaction* shardTr = tr->writeShard(problem.id ? idToDeviceId(problem.id) : ordinal >> 32);
+        if (!shardTr) {
+            return;
+        }
+        tr = shardTr;
+    }
+    Q_ASSERT(tr->m_writeTrans);
+
+    if (!ordinal) {
+        ordinal = tr->idToOrdinal(problem.id);
+    }
+    ordinal &= 0xffffffff;
+
+    switch (problem.type) {
+    case Problem::UnknownPosting:
+        if (ordinal) {
+            tr->m_writeTrans->repairPosting(problem.term, ordinal, WriteTransaction::RemoveId);
+        }
+        break;
+    case Problem::MissingPosting:
+        if (ordinal) {
+            tr->m_writeTrans->repairPosting(problem.term, ordinal, WriteTransaction::AddId);
+        }
+        break;
+    case Problem::MissingUrl:
+        tr->removeDocument(problem.id);
+        break;
+    }
+}
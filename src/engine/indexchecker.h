@@ -0,0 +1,140 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_INDEXCHECKER_H
+#define BALOO_INDEXCHECKER_H
+
+#include "engine_export.h"
+
+#include <QByteArray>
+#include <QVector>
+
+#include <functional>
+
+class QFile;
+
+namespace Baloo {
+
+class Database;
+class Transaction;
+
+/**
+ * Checks that the posting lists agree with the terms stored for every
+ * document, and that every document with terms has a file name.
+ *
+ * The documents are read in chunks of consecutive ordinals, whose terms are
+ * sorted and written to a temporary file, so the memory used is bounded
+ * by the chunk size and not by the size of the index. The posting db is
+ * then read once and merged against all of those runs. It is split into
+ * term ranges which are scanned by parallel threads.
+ *
+ * All threads read the same snapshot, the check starts over if a commit
+ * happened while their transactions were begun.
+ */
+class BALOO_ENGINE_EXPORT IndexChecker
+{
+public:
+    struct Problem {
+        enum Type {
+            /**
+             * The posting list of \c term contains \c ordinal, but none of
+             * the terms of the document do. \c id is 0 if no document has
+             * that ordinal
+             */
+            UnknownPosting,
+
+            /**
+             * \c term is one of the terms of the document \c id, but its
+             * posting list does not contain \c id
+             */
+            MissingPosting,
+
+            /**
+             * The document \c id has terms but no file name
+             */
+            MissingUrl
+        };
+
+        Type type;
+        quint64 id;
+        QByteArray term;
+
+        /**
+         * The ordinal of the document in the posting lists, as returned by
+         * Transaction::idToOrdinal. 0 to look it up from \c id
+         */
+        quint64 ordinal;
+    };
+    typedef std::function<void(const Problem&)> Reporter;
+
+    explicit IndexChecker(Database* db);
+
+    /**
+     * The number of threads scanning the posting db. Defaults to
+     * QThread::idealThreadCount()
+     */
+    void setThreadCount(int count);
+
+    /**
+     * The number of document terms held in memory at once. Defaults to 2^19
+     */
+    void setChunkSize(int terms);
+
+    /**
+     * Calls \p report for every problem as soon as it is found, always from
+     * the calling thread. The scanners wait while \p report is busy, so the
+     * problems are never all held in memory. Returns false if the index could not be read, or kept changing
+     */
+    bool check(const Reporter& report);
+
+    quint64 documentCount() const { return m_documentCount; }
+    quint64 postingCount() const { return m_postingCount; }
+
+    /**
+     * Fixes \p problem in the write transaction \p tr. Postings are added
+     * without positions, documents without a file name are removed.
+     */
+    static void repair(Transaction* tr, const Problem& problem);
+
+private:
+    struct Chunk;
+    void fillChunk(Transaction* tr, quint64 first, Chunk* chunk, const Reporter& report) const;
+
+    /**
+     * Appends the terms of \p chunk to \p file, sorted by term, and returns
+     * where each of the term ranges of \p bounds starts followed by the end
+     */
+    static QVector<qint64> writeRun(QFile* file, const Chunk& chunk, const QVector<QByteArray>& bounds);
+    QVector<QByteArray> termRanges(Transaction* tr) const;
+
+    Database* m_db;
+    int m_threadCount;
+    int m_chunkSize;
+
+    quint64 m_documentCount;
+    quint64 m_postingCount;
+};
+
+}
+
+Q_DECLARE_TYPEINFO(Baloo::IndexChecker::Problem, Q_MOVABLE_TYPE);
+
+#endif // BALOO_INDEXCHECKER_H
@@ -0,0 +1,150 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "metadatadb.h"
+
+#include <cstring>
+
+using namespace Baloo;
+
+MetaDataDB::MetaDataDB(MDB_dbi dbi, MDB_txn* txn)
+    : m_txn(txn)
+    , m_dbi(dbi)
+{
+    Q_ASSERT(txn != nullptr);
+    Q_ASSERT(dbi != 0);
+}
+
+MetaDataDB::~MetaDataDB()
+{
+}
+
+MDB_dbi MetaDataDB::create(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "metadatadb", MDB_CREATE, &dbi);
+    Q_ASSERT_X(rc == 0, "MetaDataDB::create", mdb_strerror(rc));
+
+    return dbi;
+}
+
+MDB_dbi MetaDataDB::open(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "metadatadb", 0, &dbi);
+    if (rc == MDB_NOTFOUND) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "MetaDataDB::open", mdb_strerror(rc));
+
+    return dbi;
+}
+
+void MetaDataDB::put(const QByteArray& name, const QByteArray& value)
+{
+    Q_ASSERT(!name.isEmpty());
+
+    MDB_val key;
+    key.mv_size = name.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(name.constData()));
+
+    MDB_val val;
+    val.mv_size = value.size();
+    val.mv_data = static_cast<void*>(const_cast<char*>(value.constData()));
+
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    Q_ASSERT_X(rc == 0, "MetaDataDB::put", mdb_strerror(rc));
+}
+
+QByteArray MetaDataDB::get(const QByteArray& name)
+{
+    Q_ASSERT(!name.isEmpty());
+
+    MDB_val key;
+    key.mv_size = name.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(name.constData()));
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND) {
+        return QByteArray();
+    }
+    Q_ASSERT_X(rc == 0, "MetaDataDB::get", mdb_strerror(rc));
+
+    return QByteArray(static_cast<char*>(val.mv_data), val.mv_size);
+}
+
+void MetaDataDB::del(const QByteArray& name)
+{
+    Q_ASSERT(!name.isEmpty());
+
+    MDB_val key;
+    key.mv_size = name.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(name.constData()));
+
+    int rc = mdb_del(m_txn, m_dbi, &key, nullptr);
+    if (rc == MDB_NOTFOUND) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "MetaDataDB::del", mdb_strerror(rc));
+}
+
+void MetaDataDB::putCount(const QByteArray& name, quint64 count)
+{
+    put(name, QByteArray(reinterpret_cast<const char*>(&count), sizeof(quint64)));
+}
+
+quint64 MetaDataDB::count(const QByteArray& name)
+{
+    const QByteArray value = get(name);
+    if (value.size() != sizeof(quint64)) {
+        return 0;
+    }
+
+    quint64 count;
+    memcpy(&count, value.constData(), sizeof(quint64));
+    return count;
+}
+
+QMap<QByteArray, QByteArray> MetaDataDB::toTestMap() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    QMap<QByteArray, QByteArray> map;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc == MDB_NOTFOUND) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "MetaDataDB::toTestMap", mdb_strerror(rc));
+
+        const QByteArray name(static_cast<char*>(key.mv_data), key.mv_size);
+        const QByteArray value(static_cast<char*>(val.mv_data), val.mv_size);
+        map.insert(name, value);
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
@@ -0,0 +1,75 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_METADATADB_H
+#define BALOO_METADATADB_H
+
+#include "engine_export.h"
+
+#include <QByteArray>
+#include <QMap>
+#include <lmdb.h>
+
+namespace Baloo {
+
+// Index wide counters, kept up to date by the WriteTransaction
+static const char documentCountName[] = "documentcount";
+static const char phaseOneCountName[] = "phaseonecount";
+static const char failedCountName[] = "failedcount";
+
+// When the index was last flushed by Database::sync, only while it uses DeferredSync
+static const char checkpointTimeName[] = "checkpointtime";
+
+/**
+ * Holds index wide records, such as the number of documents, which would
+ * otherwise have to be computed by scanning the other databases.
+ *
+ * name -> value
+ */
+class BALOO_ENGINE_EXPORT MetaDataDB
+{
+public:
+    MetaDataDB(MDB_dbi dbi, MDB_txn* txn);
+    ~MetaDataDB();
+
+    static MDB_dbi create(MDB_txn* txn);
+    static MDB_dbi open(MDB_txn* txn);
+
+    void put(const QByteArray& name, const QByteArray& value);
+    QByteArray get(const QByteArray& name);
+    void del(const QByteArray& name);
+
+    /**
+     * Convenience methods for records holding a single integer. Returns 0
+     * if the record does not exist.
+     */
+    void putCount(const QByteArray& name, quint64 count);
+    quint64 count(const QByteArray& name);
+
+    QMap<QByteArray, QByteArray> toTestMap() const;
+private:
+    MDB_txn* m_txn;
+    MDB_dbi m_dbi;
+};
+
+}
+
+#endif // BALOO_METADATADB_H
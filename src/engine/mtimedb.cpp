@@ -20,6 +20,9 @@
 
 #include "mtimedb.h"
 #include "vectorpostingiterator.h"
+
+#include <QDateTime>
+
 #include <algorithm>
 
 using namespace Baloo;
@@ -57,18 +60,18 @@ MDB_dbi MTimeDB::open(MDB_txn* txn)
     return dbi;
 }
 
-void MTimeDB::put(quint32 mtime, quint64 docId)
+void MTimeDB::put(quint32 mtime, quint32 ordinal)
 {
     Q_ASSERT(mtime > 0);
-    Q_ASSERT(docId > 0);
+    Q_ASSERT(ordinal > 0);
 
     MDB_val key;
     key.mv_size = sizeof(quint32);
     key.mv_data = static_cast<void*>(&mtime);
 
     MDB_val val;
-    val.mv_size = sizeof(quint64);
-    val.mv_data = static_cast<void*>(&docId);
+    val.mv_size = sizeof(quint32);
+    val.mv_data = static_cast<void*>(&ordinal);
 
     int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
     Q_ASSERT_X(rc == 0, "MTimeDB::put", mdb_strerror(rc));
@@ -95,7 +98,7 @@ QVector<quint64> MTimeDB::get(quint32 mtime)
     }
     Q_ASSERT_X(rc == 0, "MTimeDB::get", mdb_strerror(rc));
 
-    values << *static_cast<quint64*>(val.mv_data);
+    values << *static_cast<quint32*>(val.mv_data);
 
     while (1) {
         rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT_DUP);
@@ -104,7 +107,7 @@ QVector<quint64> MTimeDB::get(quint32 mtime)
         }
         Q_ASSERT_X(rc == 0, "MTimeDB::get while", mdb_strerror(rc));
 
-        values << *static_cast<quint64*>(val.mv_data);
+        values << *static_cast<quint32*>(val.mv_data);
     }
 
     mdb_cursor_close(cursor);
@@ -113,18 +116,18 @@ QVector<quint64> MTimeDB::get(quint32 mtime)
     return values;
 }
 
-void MTimeDB::del(quint32 mtime, quint64 docId)
+void MTimeDB::del(quint32 mtime, quint32 ordinal)
 {
     Q_ASSERT(mtime > 0);
-    Q_ASSERT(docId > 0);
+    Q_ASSERT(ordinal > 0);
 
     MDB_val key;
     key.mv_size = sizeof(quint32);
     key.mv_data = static_cast<void*>(&mtime);
 
     MDB_val val;
-    val.mv_size = sizeof(quint64);
-    val.mv_data = static_cast<void*>(&docId);
+    val.mv_size = sizeof(quint32);
+    val.mv_data = static_cast<void*>(&ordinal);
 
     int rc = mdb_del(m_txn, m_dbi, &key, &val);
     if (rc == MDB_NOTFOUND) {
@@ -159,7 +162,7 @@ PostingIterator* MTimeDB::iter(quint32 mtime, MTimeDB::Comparator com)
     Q_ASSERT_X(rc == 0, "MTimeDB::iter", mdb_strerror(rc));
 
     QVector<quint64> results;
-    results << *static_cast<quint64*>(val.mv_data);
+    results << *static_cast<quint32*>(val.mv_data);
 
     if (com == GreaterEqual) {
         while (1) {
@@ -169,7 +172,7 @@ PostingIterator* MTimeDB::iter(quint32 mtime, MTimeDB::Comparator com)
             }
             Q_ASSERT_X(rc == 0, "MTimeDB::iter >=", mdb_strerror(rc));
 
-            results << *static_cast<quint64*>(val.mv_data);
+            results << *static_cast<quint32*>(val.mv_data);
         }
     }
     else {
@@ -180,7 +183,7 @@ PostingIterator* MTimeDB::iter(quint32 mtime, MTimeDB::Comparator com)
             }
             Q_ASSERT_X(rc == 0, "MTimeDB::iter >=", mdb_strerror(rc));
 
-            quint64 id = *static_cast<quint64*>(val.mv_data);
+            quint64 id = *static_cast<quint32*>(val.mv_data);
             results.push_front(id);
         }
     }
@@ -211,8 +214,14 @@ PostingIterator* MTimeDB::iterRange(quint32 beginTime, quint32 endTime)
     }
     Q_ASSERT_X(rc == 0, "MTimeDB::iterRange", mdb_strerror(rc));
 
+    // The first entry is only guaranteed to be >= beginTime
+    if (*static_cast<quint32*>(key.mv_data) > endTime) {
+        mdb_cursor_close(cursor);
+        return nullptr;
+    }
+
     QVector<quint64> results;
-    results << *static_cast<quint64*>(val.mv_data);
+    results << *static_cast<quint32*>(val.mv_data);
 
     while (1) {
         rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
@@ -225,7 +234,7 @@ PostingIterator* MTimeDB::iterRange(quint32 beginTime, quint32 endTime)
         if (time > endTime) {
             break;
         }
-        results << *static_cast<quint64*>(val.mv_data);
+        results << *static_cast<quint32*>(val.mv_data);
     }
 
     mdb_cursor_close(cursor);
@@ -234,6 +243,91 @@ PostingIterator* MTimeDB::iterRange(quint32 beginTime, quint32 endTime)
     return new VectorPostingIterator(results);
 }
 
+static QDate periodStart(const QDate& date, MTimeDB::Granularity granularity)
+{
+    switch (granularity) {
+    case MTimeDB::Day:
+        return date;
+    case MTimeDB::Month:
+        return QDate(date.year(), date.month(), 1);
+    case MTimeDB::Year:
+        return QDate(date.year(), 1, 1);
+    }
+    return date;
+}
+
+static QDate nextPeriod(const QDate& start, MTimeDB::Granularity granularity)
+{
+    switch (granularity) {
+    case MTimeDB::Day:
+        return start.addDays(1);
+    case MTimeDB::Month:
+        return start.addMonths(1);
+    case MTimeDB::Year:
+        return start.addYears(1);
+    }
+    return start.addDays(1);
+}
+
+QMap<QDate, uint> MTimeDB::histogram(quint32 beginTime, quint32 endTime, Granularity granularity,
+                                     const QVector<quint64>* ids)
+{
+    QMap<QDate, uint> counts;
+
+    MDB_val key;
+    key.mv_size = sizeof(quint32);
+    key.mv_data = &beginTime;
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    // The period is only recomputed once the times, which are sorted, leave it
+    QDate period;
+    uint periodEnd = 0;
+
+    MDB_val val;
+    int rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+    while (rc == 0) {
+        const quint32 time = *static_cast<quint32*>(key.mv_data);
+        if (time > endTime) {
+            break;
+        }
+
+        if (time >= periodEnd) {
+            period = periodStart(QDateTime::fromTime_t(time).date(), granularity);
+            periodEnd = QDateTime(nextPeriod(period, granularity)).toTime_t();
+        }
+
+        uint count = 0;
+        if (ids) {
+            int dupRc = 0;
+            while (dupRc == 0) {
+                const quint64 id = *static_cast<quint32*>(val.mv_data);
+                if (std::binary_search(ids->constBegin(), ids->constEnd(), id)) {
+                    count++;
+                }
+                dupRc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT_DUP);
+            }
+            Q_ASSERT_X(dupRc == MDB_NOTFOUND, "MTimeDB::histogram", mdb_strerror(dupRc));
+        } else {
+            size_t dupCount = 0;
+            int dupRc = mdb_cursor_count(cursor, &dupCount);
+            Q_ASSERT_X(dupRc == 0, "MTimeDB::histogram", mdb_strerror(dupRc));
+            count = dupCount;
+        }
+
+        if (count) {
+            counts[period] += count;
+        }
+
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT_NODUP);
+    }
+    Q_ASSERT_X(rc == 0 || rc == MDB_NOTFOUND, "MTimeDB::histogram", mdb_strerror(rc));
+
+    mdb_cursor_close(cursor);
+    return counts;
+}
+
 QMap<quint32, quint64> MTimeDB::toTestMap() const
 {
     MDB_cursor* cursor;
@@ -251,7 +345,7 @@ QMap<quint32, quint64> MTimeDB::toTestMap() const
         Q_ASSERT_X(rc == 0, "MTimeDB::toTestMap", mdb_strerror(rc));
 
         const quint32 time = *(static_cast<quint32*>(key.mv_data));
-        const quint64 id = *(static_cast<quint64*>(val.mv_data));
+        const quint64 id = *(static_cast<quint32*>(val.mv_data));
         map.insert(time, id);
     }
 
@@ -25,14 +25,15 @@
 #include <lmdb.h>
 #include <QVector>
 #include <QMap>
+#include <QDate>
 
 namespace Baloo {
 
 class PostingIterator;
 
 /**
- * The MTime DB maps the file mtime to its id. This allows us to do
- * fast searches of files between a certain time range.
+ * The MTime DB maps the file mtime to the ordinal of its document. This
+ * allows us to do fast searches of files between a certain time range.
  */
 class BALOO_ENGINE_EXPORT MTimeDB
 {
@@ -43,10 +44,10 @@ public:
     static MDB_dbi create(MDB_txn* txn);
     static MDB_dbi open(MDB_txn* txn);
 
-    void put(quint32 mtime, quint64 docId);
+    void put(quint32 mtime, quint32 ordinal);
     QVector<quint64> get(quint32 mtime);
 
-    void del(quint32 mtime, quint64 docId);
+    void del(quint32 mtime, quint32 ordinal);
 
     enum Comparator {
         Equal,
@@ -56,6 +57,22 @@ public:
     PostingIterator* iter(quint32 mtime, Comparator com);
     PostingIterator* iterRange(quint32 beginTime, quint32 endTime);
 
+    enum Granularity {
+        Day,
+        Month,
+        Year
+    };
+
+    /**
+     * Counts the documents modified within [\p beginTime, \p endTime] per day,
+     * month or year in local time, keyed by the first day of each. Only periods
+     * with documents are returned. The database is read in a single pass and,
+     * unless \p ids is given, the ordinals themselves are not read. Otherwise
+     * only the documents within the sorted ordinals \p ids are counted.
+     */
+    QMap<QDate, uint> histogram(quint32 beginTime, quint32 endTime, Granularity granularity,
+                                const QVector<quint64>* ids = nullptr);
+
     QMap<quint32, quint64> toTestMap() const;
 private:
     MDB_txn* m_txn;
@@ -0,0 +1,360 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ordinaldb.h"
+
+using namespace Baloo;
+
+OrdinalDB::OrdinalDB(MDB_dbi idOrdinalDbi, MDB_dbi ordinalIdDbi, MDB_dbi freeOrdinalDbi, MDB_txn* txn)
+    : m_txn(txn)
+    , m_idOrdinalDbi(idOrdinalDbi)
+    , m_ordinalIdDbi(ordinalIdDbi)
+    , m_freeOrdinalDbi(freeOrdinalDbi)
+{
+    Q_ASSERT(txn != nullptr);
+    Q_ASSERT(idOrdinalDbi != 0);
+    Q_ASSERT(ordinalIdDbi != 0);
+    Q_ASSERT(freeOrdinalDbi != 0);
+}
+
+OrdinalDB::~OrdinalDB()
+{
+}
+
+MDB_dbi OrdinalDB::create(const char* name, MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, name, MDB_CREATE | MDB_INTEGERKEY, &dbi);
+    Q_ASSERT_X(rc == 0, "OrdinalDB::create", mdb_strerror(rc));
+
+    return dbi;
+}
+
+MDB_dbi OrdinalDB::open(const char* name, MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, name, MDB_INTEGERKEY, &dbi);
+    if (rc == MDB_NOTFOUND) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "OrdinalDB::open", mdb_strerror(rc));
+
+    return dbi;
+}
+
+quint32 OrdinalDB::ordinal(quint64 id) const
+{
+    Q_ASSERT(id > 0);
+
+    MDB_val key;
+    key.mv_size = sizeof(quint64);
+    key.mv_data = static_cast<void*>(&id);
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_idOrdinalDbi, &key, &val);
+    if (rc == MDB_NOTFOUND) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "OrdinalDB::ordinal", mdb_strerror(rc));
+
+    return rc == 0 ? *static_cast<quint32*>(val.mv_data) : 0;
+}
+
+quint64 OrdinalDB::id(quint32 ordinal) const
+{
+    Q_ASSERT(ordinal > 0);
+
+    MDB_val key;
+    key.mv_size = sizeof(quint32);
+    key.mv_data = static_cast<void*>(&ordinal);
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_ordinalIdDbi, &key, &val);
+    if (rc == MDB_NOTFOUND) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "OrdinalDB::id", mdb_strerror(rc));
+
+    return rc == 0 ? *static_cast<quint64*>(val.mv_data) : 0;
+}
+
+quint32 OrdinalDB::assign(quint64 id, quint32 hint)
+{
+    Q_ASSERT(id > 0);
+
+    if (const quint32 existing = ordinal(id)) {
+        return existing;
+    }
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_freeOrdinalDbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+    quint32 ordinal = 0;
+    int rc = MDB_NOTFOUND;
+    if (hint) {
+        key.mv_size = sizeof(quint32);
+        key.mv_data = static_cast<void*>(&hint);
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_KEY);
+    }
+    if (rc == MDB_NOTFOUND) {
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_FIRST);
+    }
+    if (rc == 0) {
+        ordinal = *static_cast<quint32*>(key.mv_data);
+        rc = mdb_cursor_del(cursor, 0);
+        Q_ASSERT_X(rc == 0, "OrdinalDB::assign", mdb_strerror(rc));
+    } else {
+        Q_ASSERT_X(rc == MDB_NOTFOUND, "OrdinalDB::assign", mdb_strerror(rc));
+    }
+    mdb_cursor_close(cursor);
+
+    if (!ordinal) {
+        quint32 first = 0;
+        quint32 last = 0;
+        range(&first, &last);
+        Q_ASSERT_X(last < 0xffffffff, "OrdinalDB::assign", "Out of ordinals");
+        ordinal = last + 1;
+    }
+
+    key.mv_size = sizeof(quint64);
+    key.mv_data = static_cast<void*>(&id);
+    val.mv_size = sizeof(quint32);
+    val.mv_data = static_cast<void*>(&ordinal);
+    rc = mdb_put(m_txn, m_idOrdinalDbi, &key, &val, 0);
+    Q_ASSERT_X(rc == 0, "OrdinalDB::assign", mdb_strerror(rc));
+
+    key.mv_size = sizeof(quint32);
+    key.mv_data = static_cast<void*>(&ordinal);
+    val.mv_size = sizeof(quint64);
+    val.mv_data = static_cast<void*>(&id);
+    rc = mdb_put(m_txn, m_ordinalIdDbi, &key, &val, 0);
+    Q_ASSERT_X(rc == 0, "OrdinalDB::assign", mdb_strerror(rc));
+
+    return ordinal;
+}
+
+quint32 OrdinalDB::nextFree(quint32 ordinal, quint64* previousId) const
+{
+    Q_ASSERT(previousId);
+    *previousId = 0;
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_freeOrdinalDbi, &cursor);
+
+    quint32 next = ordinal + 1;
+    MDB_val key;
+    key.mv_size = sizeof(quint32);
+    key.mv_data = static_cast<void*>(&next);
+    MDB_val val;
+    int rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+    mdb_cursor_close(cursor);
+    if (rc == MDB_NOTFOUND) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "OrdinalDB::nextFree", mdb_strerror(rc));
+    const quint32 free = *static_cast<quint32*>(key.mv_data);
+
+    // The free ordinal itself is not in use, so the search lands after it
+    mdb_cursor_open(m_txn, m_ordinalIdDbi, &cursor);
+    quint32 from = free;
+    key.mv_size = sizeof(quint32);
+    key.mv_data = static_cast<void*>(&from);
+    rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+    rc = mdb_cursor_get(cursor, &key, &val, rc == MDB_NOTFOUND ? MDB_LAST : MDB_PREV);
+    if (rc == 0 && *static_cast<quint32*>(key.mv_data) < free) {
+        *previousId = *static_cast<quint64*>(val.mv_data);
+    }
+    mdb_cursor_close(cursor);
+
+    return free;
+}
+
+quint32 OrdinalDB::del(quint64 id)
+{
+    quint32 ordinal = this->ordinal(id);
+    if (!ordinal) {
+        return 0;
+    }
+
+    MDB_val key;
+    key.mv_size = sizeof(quint64);
+    key.mv_data = static_cast<void*>(&id);
+    int rc = mdb_del(m_txn, m_idOrdinalDbi, &key, nullptr);
+    Q_ASSERT_X(rc == 0, "OrdinalDB::del", mdb_strerror(rc));
+
+    key.mv_size = sizeof(quint32);
+    key.mv_data = static_cast<void*>(&ordinal);
+    rc = mdb_del(m_txn, m_ordinalIdDbi, &key, nullptr);
+    Q_ASSERT_X(rc == 0 || rc == MDB_NOTFOUND, "OrdinalDB::del", mdb_strerror(rc));
+
+    MDB_val val;
+    val.mv_size = 0;
+    val.mv_data = nullptr;
+    rc = mdb_put(m_txn, m_freeOrdinalDbi, &key, &val, 0);
+    Q_ASSERT_X(rc == 0, "OrdinalDB::del", mdb_strerror(rc));
+
+    return ordinal;
+}
+
+bool OrdinalDB::range(quint32* first, quint32* last) const
+{
+    Q_ASSERT(first);
+    Q_ASSERT(last);
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_ordinalIdDbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    int rc = mdb_cursor_get(cursor, &key, &val, MDB_FIRST);
+    if (rc == MDB_NOTFOUND) {
+        mdb_cursor_close(cursor);
+        return false;
+    }
+    Q_ASSERT_X(rc == 0, "OrdinalDB::range", mdb_strerror(rc));
+    *first = *static_cast<quint32*>(key.mv_data);
+
+    rc = mdb_cursor_get(cursor, &key, &val, MDB_LAST);
+    Q_ASSERT_X(rc == 0, "OrdinalDB::range", mdb_strerror(rc));
+    *last = *static_cast<quint32*>(key.mv_data);
+
+    mdb_cursor_close(cursor);
+    return true;
+}
+
+QVector<quint64> OrdinalDB::idsByOrdinal() const
+{
+    QVector<quint64> ids;
+
+    quint32 first = 0;
+    quint32 last = 0;
+    if (!range(&first, &last)) {
+        return ids;
+    }
+    ids.fill(0, last + 1);
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_ordinalIdDbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc == MDB_NOTFOUND) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "OrdinalDB::idsByOrdinal", mdb_strerror(rc));
+
+        ids[*static_cast<quint32*>(key.mv_data)] = *static_cast<quint64*>(val.mv_data);
+    }
+
+    mdb_cursor_close(cursor);
+    return ids;
+}
+
+void OrdinalDB::reset(const QVector<quint64>& ids)
+{
+    Q_ASSERT(quint64(ids.size()) < 0xffffffff);
+
+    for (MDB_dbi dbi : {m_idOrdinalDbi, m_ordinalIdDbi, m_freeOrdinalDbi}) {
+        int rc = mdb_drop(m_txn, dbi, 0);
+        Q_ASSERT_X(rc == 0, "OrdinalDB::reset", mdb_strerror(rc));
+        Q_UNUSED(rc);
+    }
+
+    // Appending in key order fills the pages completely
+    for (int i = 0; i < ids.size(); i++) {
+        quint64 id = ids[i];
+        quint32 ordinal = i + 1;
+
+        MDB_val ordinalKey;
+        ordinalKey.mv_size = sizeof(quint32);
+        ordinalKey.mv_data = static_cast<void*>(&ordinal);
+
+        int rc;
+        if (!id) {
+            MDB_val val = {0, nullptr};
+            rc = mdb_put(m_txn, m_freeOrdinalDbi, &ordinalKey, &val, MDB_APPEND);
+            Q_ASSERT_X(rc == 0, "OrdinalDB::reset", mdb_strerror(rc));
+            continue;
+        }
+
+        MDB_val idVal;
+        idVal.mv_size = sizeof(quint64);
+        idVal.mv_data = static_cast<void*>(&id);
+        rc = mdb_put(m_txn, m_ordinalIdDbi, &ordinalKey, &idVal, MDB_APPEND);
+        Q_ASSERT_X(rc == 0, "OrdinalDB::reset", mdb_strerror(rc));
+
+        rc = mdb_put(m_txn, m_idOrdinalDbi, &idVal, &ordinalKey, 0);
+        Q_ASSERT_X(rc == 0, "OrdinalDB::reset", mdb_strerror(rc));
+        Q_UNUSED(rc);
+    }
+}
+
+QMap<quint64, quint32> OrdinalDB::toTestMap() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_idOrdinalDbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    QMap<quint64, quint32> map;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc == MDB_NOTFOUND) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "OrdinalDB::toTestMap", mdb_strerror(rc));
+
+        const quint64 id = *static_cast<quint64*>(key.mv_data);
+        map.insert(id, *static_cast<quint32*>(val.mv_data));
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
+
+QVector<quint32> OrdinalDB::freeOrdinals() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_freeOrdinalDbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    QVector<quint32> vec;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc == MDB_NOTFOUND) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "OrdinalDB::freeOrdinals", mdb_strerror(rc));
+
+        vec << *static_cast<quint32*>(key.mv_data);
+    }
+
+    mdb_cursor_close(cursor);
+    return vec;
+}
@@ -0,0 +1,118 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_ORDINALDB_H
+#define BALOO_ORDINALDB_H
+
+#include "engine_export.h"
+
+#include <QMap>
+#include <QVector>
+#include <lmdb.h>
+
+namespace Baloo {
+
+/**
+ * Maps the document ids, which are made of the device id and the inode, to
+ * dense ordinals and back. The posting, position and mtime dbs store the
+ * ordinals instead of the ids, which keeps their values small enough to be
+ * delta encoded.
+ *
+ * Ordinals start at 1. Those of removed documents go to a free list and are
+ * handed out again before the range is grown. WriteTransaction::reorderDocuments
+ * renumbers the documents in path order and leaves some free ordinals after
+ * every folder, which are preferred for new documents in that folder.
+ *
+ * id -> ordinal
+ * ordinal -> id
+ * free ordinal -> (empty)
+ */
+class BALOO_ENGINE_EXPORT OrdinalDB
+{
+public:
+    OrdinalDB(MDB_dbi idOrdinalDbi, MDB_dbi ordinalIdDbi, MDB_dbi freeOrdinalDbi, MDB_txn* txn);
+    ~OrdinalDB();
+
+    static MDB_dbi create(const char* name, MDB_txn* txn);
+    static MDB_dbi open(const char* name, MDB_txn* txn);
+
+    /**
+     * Returns the ordinal of \p id, or 0 if it has none
+     */
+    quint32 ordinal(quint64 id) const;
+
+    /**
+     * Returns the id with the ordinal \p ordinal, or 0 if it is not in use
+     */
+    quint64 id(quint32 ordinal) const;
+
+    /**
+     * Returns the ordinal of \p id, giving it one if it has none yet. A new
+     * ordinal is \p hint if that one is free, or else the lowest free one.
+     */
+    quint32 assign(quint64 id, quint32 hint = 0);
+
+    /**
+     * Returns the first free ordinal after \p ordinal, or 0 if there is
+     * none, and sets \p previousId to the id with the closest ordinal
+     * below it.
+     */
+    quint32 nextFree(quint32 ordinal, quint64* previousId) const;
+
+    /**
+     * Removes the ordinal of \p id, puts it on the free list and returns it,
+     * or 0 if it had none. It may be handed out again within the same
+     * transaction, which is fine as the changes to the posting lists are
+     * applied in the order they were made.
+     */
+    quint32 del(quint64 id);
+
+    /**
+     * Returns the smallest and the largest ordinal in use, or false if there
+     * are none
+     */
+    bool range(quint32* first, quint32* last) const;
+
+    /**
+     * Returns the ids indexed by their ordinal, with 0 for the free ordinals
+     * and for the unused first entry
+     */
+    QVector<quint64> idsByOrdinal() const;
+
+    /**
+     * Replaces all ordinals, \p ids[i] gets the ordinal i + 1. The ordinals
+     * of the entries which are 0 go to the free list.
+     */
+    void reset(const QVector<quint64>& ids);
+
+    QMap<quint64, quint32> toTestMap() const;
+    QVector<quint32> freeOrdinals() const;
+
+private:
+    MDB_txn* m_txn;
+    MDB_dbi m_idOrdinalDbi;
+    MDB_dbi m_ordinalIdDbi;
+    MDB_dbi m_freeOrdinalDbi;
+};
+
+}
+
+#endif // BALOO_ORDINALDB_H
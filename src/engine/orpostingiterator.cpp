@@ -72,3 +72,34 @@ quint64 OrPostingIterator::next()
 
     return m_docId;
 }
+
+quint64 OrPostingIterator::skipTo(quint64 id)
+{
+    if (m_docId && m_docId >= id) {
+        return m_docId;
+    }
+
+    // The children are always positioned past m_docId, move the ones
+    // which are behind and let next() pick the smallest id
+    for (auto it = m_iterators.begin(), end = m_iterators.end(); it != end; it++) {
+        PostingIterator* iter = *it;
+        if (iter && iter->docId() < id && iter->skipTo(id) == 0) {
+            delete iter;
+            *it = nullptr;
+        }
+    }
+
+    return next();
+}
+
+uint OrPostingIterator::estimatedSize() const
+{
+    quint64 size = 0;
+    for (PostingIterator* iter : m_iterators) {
+        if (iter) {
+            size += iter->estimatedSize();
+        }
+    }
+
+    return qMin<quint64>(size, UnknownSize);
+}
@@ -34,6 +34,8 @@ public:
 
     quint64 next() Q_DECL_OVERRIDE;
     quint64 docId() const Q_DECL_OVERRIDE;
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE;
+    uint estimatedSize() const Q_DECL_OVERRIDE;
 
 private:
     QVector<PostingIterator*> m_iterators;
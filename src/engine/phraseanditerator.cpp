@@ -22,6 +22,8 @@
 
 #include <QDebug>
 
+#include <algorithm>
+
 using namespace Baloo;
 
 PhraseAndIterator::PhraseAndIterator(const QVector<PostingIterator*>& iterators)
@@ -32,6 +34,9 @@ PhraseAndIterator::PhraseAndIterator(const QVector<PostingIterator*>& iterators)
         qDeleteAll(m_iterators);
         m_iterators.clear();
     }
+
+    m_positions.resize(m_iterators.size());
+    m_cursors.resize(m_iterators.size());
 }
 
 PhraseAndIterator::~PhraseAndIterator()
@@ -44,46 +49,82 @@ quint64 PhraseAndIterator::docId() const
     return m_docId;
 }
 
+uint PhraseAndIterator::estimatedSize() const
+{
+    uint size = m_iterators.isEmpty() ? 0 : UnknownSize;
+    for (PostingIterator* iter : m_iterators) {
+        size = qMin(size, iter->estimatedSize());
+    }
+    return size;
+}
+
+/**
+ * Returns the index of the first element of \p vec, at or after \p from,
+ * which is not less than \p value. The distance is probed in growing steps
+ * before searching binary, which is fast when \p value is close.
+ */
+static int gallop(const QVector<uint>& vec, int from, uint value)
+{
+    const uint* data = vec.constData();
+    const int size = vec.size();
+
+    int step = 1;
+    int hi = from;
+    while (hi < size && data[hi] < value) {
+        from = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+
+    return std::lower_bound(data + from, data + qMin(hi, size), value) - data;
+}
+
 bool PhraseAndIterator::checkIfPositionsMatch()
 {
-    QVector< QVector<uint> > positionList;
-    // All the iterators should have the same value
+    int rarest = 0;
     for (int i = 0; i < m_iterators.size(); i++) {
         PostingIterator* iter = m_iterators[i];
         Q_ASSERT(iter->docId() == m_docId);
 
-        QVector<uint> pi = iter->positions();
-        for (int j = 0; j < pi.size(); j++) {
-            pi[j] -= i;
+        m_positions[i] = iter->positions();
+        m_cursors[i] = 0;
+        if (m_positions[i].size() < m_positions[rarest].size()) {
+            rarest = i;
         }
-
-        positionList << pi;
     }
 
-    // Intersect all these positions
-    QVector<uint> vec = positionList[0];
-    for (int l = 1; l < positionList.size(); l++) {
-        QVector<uint> newVec = positionList[l];
-
-        int i = 0;
-        int j = 0;
-        QVector<uint> finalVec;
-        while (i < vec.size() && j < newVec.size()) {
-            if (vec[i] == newVec[j]) {
-                finalVec << vec[i];
-                i++;
-                j++;
-            } else if (vec[i] < newVec[j]) {
-                i++;
-            } else {
-                j++;
+    // The n-th term of the phrase has to be at start + n. Only const access
+    // is used, as the lists are shared with the children.
+    const QVector<uint>& driver = m_positions[rarest];
+    for (uint pos : driver) {
+        if (pos < static_cast<uint>(rarest)) {
+            continue;
+        }
+        const uint start = pos - rarest;
+
+        bool match = true;
+        for (int i = 0; i < m_positions.size() && match; i++) {
+            if (i == rarest) {
+                continue;
+            }
+
+            const QVector<uint>& vec = m_positions[i];
+            const int cursor = gallop(vec, m_cursors[i], start + i);
+            if (cursor == vec.size()) {
+                // Later starts cannot match either
+                return false;
             }
+
+            m_cursors[i] = cursor;
+            match = vec[cursor] == start + i;
         }
 
-        vec = finalVec;
+        if (match) {
+            return true;
+        }
     }
 
-    return !vec.isEmpty();
+    return false;
 }
 
 quint64 PhraseAndIterator::next()
@@ -93,30 +134,44 @@ quint64 PhraseAndIterator::next()
         return 0;
     }
 
-    if (m_iterators[0]->next() == 0) {
+    return findMatch(m_iterators[0]->next());
+}
+
+quint64 PhraseAndIterator::skipTo(quint64 id)
+{
+    if (m_iterators.isEmpty()) {
         m_docId = 0;
         return 0;
     }
+    if (m_docId && m_docId >= id) {
+        return m_docId;
+    }
 
-    m_docId = m_iterators[0]->docId();
+    return findMatch(m_iterators[0]->skipTo(id));
+}
 
-    for (int i = 1; i < m_iterators.size(); i++) {
-        PostingIterator* iter = m_iterators[i];
-        if (iter->docId() == 0 && iter->next() == 0) {
-            m_docId = 0;
-            return 0;
+quint64 PhraseAndIterator::findMatch(quint64 id)
+{
+    while (id) {
+        bool aligned = true;
+        for (int i = 1; i < m_iterators.size(); i++) {
+            const quint64 otherId = m_iterators[i]->skipTo(id);
+            if (otherId != id) {
+                id = otherId ? m_iterators[0]->skipTo(otherId) : 0;
+                aligned = false;
+                break;
+            }
         }
 
-        iter->skipTo(m_docId);
-
-        if (m_docId != iter->docId()) {
-            return next();
+        if (aligned) {
+            m_docId = id;
+            if (checkIfPositionsMatch()) {
+                return m_docId;
+            }
+            id = m_iterators[0]->next();
         }
     }
 
-    if (checkIfPositionsMatch())
-        return m_docId;
-    else
-        return next();
+    m_docId = 0;
+    return 0;
 }
-
@@ -27,6 +27,15 @@
 
 namespace Baloo {
 
+/**
+ * Yields the documents in which the terms of its children appear next to
+ * each other, in order. The children have to provide positions.
+ *
+ * Matching the positions of a candidate allocates nothing: the position
+ * lists are shared with the children, the rarest term drives the match and
+ * the other lists are searched by galloping from where the previous
+ * candidate position left off.
+ */
 class BALOO_ENGINE_EXPORT PhraseAndIterator : public PostingIterator
 {
 public:
@@ -35,11 +44,18 @@ public:
 
     quint64 next() Q_DECL_OVERRIDE;
     quint64 docId() const Q_DECL_OVERRIDE;
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE;
+    uint estimatedSize() const Q_DECL_OVERRIDE;
 
 private:
     QVector<PostingIterator*> m_iterators;
     quint64 m_docId;
 
+    // Reused for every candidate document
+    QVector<QVector<uint>> m_positions;
+    QVector<int> m_cursors;
+
+    quint64 findMatch(quint64 id);
     bool checkIfPositionsMatch();
 };
 }
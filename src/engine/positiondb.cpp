@@ -22,14 +22,18 @@
 #include "positioncodec.h"
 #include "positioninfo.h"
 #include "postingiterator.h"
+#include "queryprofile.h"
 
 #include <QDebug>
 
+#include <algorithm>
+
 using namespace Baloo;
 
 PositionDB::PositionDB(MDB_dbi dbi, MDB_txn* txn)
     : m_txn(txn)
     , m_dbi(dbi)
+    , m_counters(nullptr)
 {
     Q_ASSERT(txn != nullptr);
     Q_ASSERT(dbi != 0);
@@ -60,7 +64,7 @@ MDB_dbi PositionDB::open(MDB_txn* txn)
     return dbi;
 }
 
-void PositionDB::put(const QByteArray& term, const QVector<PositionInfo>& list)
+uint PositionDB::put(const QByteArray& term, const QVector<PositionInfo>& list)
 {
     Q_ASSERT(!term.isEmpty());
     Q_ASSERT(!list.isEmpty());
@@ -78,6 +82,8 @@ void PositionDB::put(const QByteArray& term, const QVector<PositionInfo>& list)
 
     int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
     Q_ASSERT_X(rc == 0, "PositionDB::put", mdb_strerror(rc));
+
+    return val.mv_size;
 }
 
 QVector<PositionInfo> PositionDB::get(const QByteArray& term)
@@ -145,6 +151,24 @@ public:
         return m_vec[m_pos].docId;
     }
 
+    quint64 skipTo(quint64 id) Q_DECL_OVERRIDE {
+        if (m_pos >= m_vec.size()) {
+            return 0;
+        }
+        if (m_pos >= 0 && m_vec[m_pos].docId >= id) {
+            return m_vec[m_pos].docId;
+        }
+
+        auto it = std::lower_bound(m_vec.constBegin() + qMax(m_pos, 0), m_vec.constEnd(), id,
+                                   [](const PositionInfo& info, quint64 docId) { return info.docId < docId; });
+        m_pos = it - m_vec.constBegin();
+        return docId();
+    }
+
+    uint estimatedSize() const Q_DECL_OVERRIDE {
+        return m_vec.size();
+    }
+
     QVector<uint> positions() Q_DECL_OVERRIDE {
         if (m_pos < 0 || m_pos >= m_vec.size()) {
             return QVector<uint>();
@@ -167,11 +191,18 @@ PostingIterator* PositionDB::iter(const QByteArray& term)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (m_counters) {
+        m_counters->gets++;
+    }
     if (rc == MDB_NOTFOUND) {
         return nullptr;
     }
     Q_ASSERT_X(rc == 0, "PositionDB::iter", mdb_strerror(rc));
 
+    if (m_counters) {
+        m_counters->terms++;
+        m_counters->bytesDecoded += val.mv_size;
+    }
     return new DBPositionIterator(static_cast<char*>(val.mv_data), val.mv_size);
 }
 
@@ -32,6 +32,7 @@ namespace Baloo {
 
 class PositionInfo;
 class PostingIterator;
+struct DBCounters;
 
 class BALOO_ENGINE_EXPORT PositionDB
 {
@@ -42,16 +43,28 @@ public:
     static MDB_dbi create(MDB_txn* txn);
     static MDB_dbi open(MDB_txn* txn);
 
-    void put(const QByteArray& term, const QVector<PositionInfo>& list);
+    /**
+     * Returns the number of bytes stored for \p list
+     */
+    uint put(const QByteArray& term, const QVector<PositionInfo>& list);
     QVector<PositionInfo> get(const QByteArray& term);
     void del(const QByteArray& term);
 
     PostingIterator* iter(const QByteArray& term);
 
     QMap<QByteArray, QVector<PositionInfo>> toTestMap() const;
+
+    /**
+     * \sa PostingDB::setCounters
+     */
+    void setCounters(DBCounters* counters) {
+        m_counters = counters;
+    }
+
 private:
     MDB_txn* m_txn;
     MDB_dbi m_dbi;
+    DBCounters* m_counters;
 };
 
 }
@@ -0,0 +1,148 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "postingcache.h"
+
+#include <QMutexLocker>
+
+using namespace Baloo;
+
+Q_GLOBAL_STATIC(PostingCache, s_postingCache)
+
+// Enough for the type and mimetype lists of a large index
+static const int s_defaultMaxBytes = 16 * 1024 * 1024;
+
+// What a list costs besides its ids, roughly the hash node and the headers
+static const int s_entryOverhead = 96;
+
+namespace Baloo {
+uint qHash(const PostingCache::Key& key, uint seed)
+{
+    return qHash(key.term, seed) ^ qHash(key.txnId, seed) ^ qHash(quintptr(key.env), seed);
+}
+}
+
+PostingCache::PostingCache()
+    : m_cache(s_defaultMaxBytes)
+    , m_hits(0)
+    , m_misses(0)
+{
+}
+
+PostingCache* PostingCache::instance()
+{
+    return s_postingCache();
+}
+
+bool PostingCache::get(MDB_env* env, quint64 txnId, const QByteArray& term, PostingList* list)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const PostingList* cached = m_cache.object(Key{env, txnId, term});
+    if (!cached) {
+        m_misses++;
+        return false;
+    }
+
+    m_hits++;
+    *list = *cached;
+    return true;
+}
+
+void PostingCache::put(MDB_env* env, quint64 txnId, const QByteArray& term, const PostingList& list)
+{
+    const int cost = list.size() * sizeof(quint64) + term.size() + s_entryOverhead;
+
+    QMutexLocker locker(&m_mutex);
+    if (cost > m_cache.maxCost() || !advance(env, txnId)) {
+        return;
+    }
+    m_cache.insert(Key{env, txnId, term}, new PostingList(list), cost);
+}
+
+bool PostingCache::advance(MDB_env* env, quint64 txnId)
+{
+    auto it = m_txnIds.find(env);
+    if (it == m_txnIds.end()) {
+        m_txnIds.insert(env, txnId);
+        return true;
+    }
+    if (txnId < it.value()) {
+        return false;
+    }
+    if (txnId == it.value()) {
+        return true;
+    }
+
+    it.value() = txnId;
+    const QList<Key> keys = m_cache.keys();
+    for (const Key& key : keys) {
+        if (key.env == env && key.txnId < txnId) {
+            m_cache.remove(key);
+        }
+    }
+    return true;
+}
+
+void PostingCache::remove(MDB_env* env)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_txnIds.remove(env)) {
+        return;
+    }
+
+    const QList<Key> keys = m_cache.keys();
+    for (const Key& key : keys) {
+        if (key.env == env) {
+            m_cache.remove(key);
+        }
+    }
+}
+
+int PostingCache::maxBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.maxCost();
+}
+
+void PostingCache::setMaxBytes(int bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.setMaxCost(bytes);
+}
+
+int PostingCache::bytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.totalCost();
+}
+
+quint64 PostingCache::hits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hits;
+}
+
+quint64 PostingCache::misses() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_misses;
+}
@@ -0,0 +1,110 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_POSTINGCACHE_H
+#define BALOO_POSTINGCACHE_H
+
+#include "engine_export.h"
+#include "postingdb.h"
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+
+#include <lmdb.h>
+
+namespace Baloo {
+
+/**
+ * A process wide cache of decoded posting lists, so that the hot terms of
+ * interactive queries such as the file types and mimetypes are not decoded
+ * again for every keystroke.
+ *
+ * The lists are those of one snapshot: they are keyed by the environment,
+ * the id of the read transaction and the term. Once a newer snapshot of an
+ * environment is seen, the lists of the older ones are dropped, so readers
+ * still on them just miss. Write transactions must not use the cache, as
+ * their view changes with every put.
+ *
+ * The cache is bounded by the size of the lists and evicts the least
+ * recently used ones. All methods are thread safe.
+ */
+class BALOO_ENGINE_EXPORT PostingCache
+{
+public:
+    PostingCache();
+
+    /**
+     * The cache which the Transaction hands to the PostingDB of read
+     * transactions
+     */
+    static PostingCache* instance();
+
+    /**
+     * Looks up the list of \p term in the snapshot \p txnId of \p env
+     */
+    bool get(MDB_env* env, quint64 txnId, const QByteArray& term, PostingList* list);
+    void put(MDB_env* env, quint64 txnId, const QByteArray& term, const PostingList& list);
+
+    /**
+     * Drops all lists of \p env, which must be called before the
+     * environment is closed since its transaction ids may start over.
+     */
+    void remove(MDB_env* env);
+
+    /**
+     * The budget and the current size in bytes
+     */
+    int maxBytes() const;
+    void setMaxBytes(int bytes);
+    int bytes() const;
+
+    quint64 hits() const;
+    quint64 misses() const;
+
+private:
+    struct Key {
+        MDB_env* env;
+        quint64 txnId;
+        QByteArray term;
+
+        bool operator==(const Key& other) const {
+            return env == other.env && txnId == other.txnId && term == other.term;
+        }
+    };
+    friend uint qHash(const Key& key, uint seed);
+
+    /**
+     * Makes \p txnId the snapshot of \p env, returns false if it is older
+     */
+    bool advance(MDB_env* env, quint64 txnId);
+
+    mutable QMutex m_mutex;
+    QCache<Key, PostingList> m_cache;
+    QHash<MDB_env*, quint64> m_txnIds;
+    quint64 m_hits;
+    quint64 m_misses;
+};
+
+}
+
+#endif // BALOO_POSTINGCACHE_H
@@ -20,15 +20,21 @@
 
 #include "postingdb.h"
 #include "orpostingiterator.h"
+#include "postingcache.h"
 #include "postingcodec.h"
+#include "queryprofile.h"
 
 #include <QDebug>
 
+#include <algorithm>
+
 using namespace Baloo;
 
 PostingDB::PostingDB(MDB_dbi dbi, MDB_txn* txn)
     : m_txn(txn)
     , m_dbi(dbi)
+    , m_counters(nullptr)
+    , m_cache(nullptr)
 {
     Q_ASSERT(txn != nullptr);
     Q_ASSERT(dbi != 0);
@@ -59,7 +65,7 @@ MDB_dbi PostingDB::open(MDB_txn* txn)
     return dbi;
 }
 
-void PostingDB::put(const QByteArray& term, const PostingList& list)
+uint PostingDB::put(const QByteArray& term, const PostingList& list)
 {
     Q_ASSERT(!term.isEmpty());
     Q_ASSERT(!list.isEmpty());
@@ -77,6 +83,8 @@ void PostingDB::put(const QByteArray& term, const PostingList& list)
 
     int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
     Q_ASSERT_X(rc == 0, "PostingDB::put", mdb_strerror(rc));
+
+    return val.mv_size;
 }
 
 PostingList PostingDB::get(const QByteArray& term)
@@ -144,9 +152,11 @@ QVector< QByteArray > PostingDB::fetchTermsStartingWith(const QByteArray& term)
 
 class DBPostingIterator : public PostingIterator {
 public:
-    DBPostingIterator(void* data, uint size);
+    explicit DBPostingIterator(const PostingList& list);
     quint64 docId() const Q_DECL_OVERRIDE;
     quint64 next() Q_DECL_OVERRIDE;
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE;
+    uint estimatedSize() const Q_DECL_OVERRIDE;
 
 private:
     const QVector<quint64> m_vec;
@@ -155,25 +165,57 @@ private:
 
 PostingIterator* PostingDB::iter(const QByteArray& term)
 {
+    MDB_env* env = nullptr;
+    quint64 txnId = 0;
+    if (m_cache) {
+        env = mdb_txn_env(m_txn);
+        txnId = mdb_txn_id(m_txn);
+
+        PostingList list;
+        if (m_cache->get(env, txnId, term, &list)) {
+            if (m_counters) {
+                m_counters->terms++;
+                m_counters->cached++;
+            }
+            return new DBPostingIterator(list);
+        }
+    }
+
     MDB_val key;
     key.mv_size = term.size();
     key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (m_counters) {
+        m_counters->gets++;
+    }
     if (rc == MDB_NOTFOUND) {
         return nullptr;
     }
     Q_ASSERT_X(rc == 0, "PostingDB::iter", mdb_strerror(rc));
 
-    return new DBPostingIterator(val.mv_data, val.mv_size);
+    const PostingList list = decode(val);
+    if (m_cache) {
+        m_cache->put(env, txnId, term, list);
+    }
+    return new DBPostingIterator(list);
+}
+
+PostingList PostingDB::decode(const MDB_val& val)
+{
+    if (m_counters) {
+        m_counters->terms++;
+        m_counters->bytesDecoded += val.mv_size;
+    }
+    return PostingCodec().decode(QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size));
 }
 
 //
 // Posting Iterator
 //
-DBPostingIterator::DBPostingIterator(void* data, uint size)
-    : m_vec(PostingCodec().decode(QByteArray(static_cast<char*>(data), size)))
+DBPostingIterator::DBPostingIterator(const PostingList& list)
+    : m_vec(list)
     , m_pos(-1)
 {
 }
@@ -198,6 +240,25 @@ quint64 DBPostingIterator::next()
     return m_vec[m_pos];
 }
 
+quint64 DBPostingIterator::skipTo(quint64 id)
+{
+    if (m_pos >= m_vec.size()) {
+        return 0;
+    }
+    if (m_pos >= 0 && m_vec[m_pos] >= id) {
+        return m_vec[m_pos];
+    }
+
+    auto it = std::lower_bound(m_vec.constBegin() + qMax(m_pos, 0), m_vec.constEnd(), id);
+    m_pos = it - m_vec.constBegin();
+    return docId();
+}
+
+uint DBPostingIterator::estimatedSize() const
+{
+    return m_vec.size();
+}
+
 template <typename Validator>
 PostingIterator* PostingDB::iter(const QByteArray& prefix, Validator validate)
 {
@@ -216,13 +277,16 @@ PostingIterator* PostingDB::iter(const QByteArray& prefix, Validator validate)
     int rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
     while (rc != MDB_NOTFOUND) {
         Q_ASSERT_X(rc == 0, "PostingDB::regexpIter", mdb_strerror(rc));
+        if (m_counters) {
+            m_counters->gets++;
+        }
 
         const QByteArray arr(static_cast<char*>(key.mv_data), key.mv_size);
         if (!arr.startsWith(prefix)) {
             break;
         }
         if (validate(arr)) {
-            termIterators << new DBPostingIterator(val.mv_data, val.mv_size);
+            termIterators << new DBPostingIterator(decode(val));
         }
         rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
     }
@@ -31,6 +31,9 @@
 
 namespace Baloo {
 
+struct DBCounters;
+class PostingCache;
+
 typedef QVector<quint64> PostingList;
 
 /**
@@ -46,7 +49,10 @@ public:
     static MDB_dbi create(MDB_txn* txn);
     static MDB_dbi open(MDB_txn* txn);
 
-    void put(const QByteArray& term, const PostingList& list);
+    /**
+     * Returns the number of bytes stored for \p list
+     */
+    uint put(const QByteArray& term, const PostingList& list);
     PostingList get(const QByteArray& term);
     void del(const QByteArray& term);
 
@@ -63,12 +69,35 @@ public:
     QVector<QByteArray> fetchTermsStartingWith(const QByteArray& term);
 
     QMap<QByteArray, PostingList> toTestMap() const;
+
+    /**
+     * Count the lookups done by the iterator methods in \p counters, used for
+     * explaining queries.
+     */
+    void setCounters(DBCounters* counters) {
+        m_counters = counters;
+    }
+
+    /**
+     * Look the decoded lists of iter() up in \p cache before reading them.
+     * The iterators over a range of terms bypass it, so that expanding a
+     * prefix does not push the hot terms out. Only for read transactions,
+     * the view of a write transaction changes with every put.
+     */
+    void setCache(PostingCache* cache) {
+        m_cache = cache;
+    }
+
 private:
     template <typename Validator>
     PostingIterator* iter(const QByteArray& prefix, Validator validate);
 
+    PostingList decode(const MDB_val& val);
+
     MDB_txn* m_txn;
     MDB_dbi m_dbi;
+    DBCounters* m_counters;
+    PostingCache* m_cache;
 };
 
 
@@ -22,18 +22,30 @@
 
 using namespace Baloo;
 
+const uint PostingIterator::UnknownSize;
+
 PostingIterator::~PostingIterator()
 {
 }
 
 quint64 PostingIterator::skipTo(quint64 id)
 {
+    // Calling next() on an exhausted iterator is harmless, it keeps returning 0
+    if (docId() == 0) {
+        next();
+    }
+
     while (docId() && docId() < id) {
         next();
     }
     return docId();
 }
 
+uint PostingIterator::estimatedSize() const
+{
+    return UnknownSize;
+}
+
 QVector<uint> PostingIterator::positions()
 {
     return QVector<uint>();
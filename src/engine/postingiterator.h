@@ -39,8 +39,27 @@ public:
 
     virtual quint64 next() = 0;
     virtual quint64 docId() const = 0;
+
+    /**
+     * Advances the iterator to the first document id which is greater than
+     * or equal to \p docId and returns it. The iterator is not moved if it
+     * already points to such an id. An iterator which has not been started
+     * yet is started first.
+     *
+     * Returns 0 when there are no more ids.
+     */
     virtual quint64 skipTo(quint64 docId);
 
+    /**
+     * Returns an upper bound on the number of ids this iterator yields. It
+     * is used to order the children of an AND so that the rarest one drives
+     * the intersection. Iterators which cannot cheaply estimate their size
+     * return UnknownSize.
+     */
+    virtual uint estimatedSize() const;
+
+    static const uint UnknownSize = 0xffffffff;
+
     virtual QVector<uint> positions();
 };
 }
@@ -0,0 +1,167 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "queryprofile.h"
+#include "postingiterator.h"
+
+#include <QElapsedTimer>
+
+namespace Baloo {
+
+class ProfilingPostingIterator : public PostingIterator
+{
+public:
+    ProfilingPostingIterator(PostingIterator* it, QueryProfile* profile, int node)
+        : m_it(it)
+        , m_profile(profile)
+        , m_node(node)
+    {
+    }
+
+    ~ProfilingPostingIterator()
+    {
+        delete m_it;
+    }
+
+    quint64 next() Q_DECL_OVERRIDE {
+        QElapsedTimer timer;
+        timer.start();
+
+        const quint64 id = m_it->next();
+
+        QueryProfile::Node& node = m_profile->m_nodes[m_node];
+        node.nsecs += timer.nsecsElapsed();
+        node.nextCalls++;
+        if (id) {
+            node.ids++;
+        }
+        return id;
+    }
+
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE {
+        QElapsedTimer timer;
+        timer.start();
+
+        const quint64 prevId = m_it->docId();
+        const quint64 id = m_it->skipTo(docId);
+
+        QueryProfile::Node& node = m_profile->m_nodes[m_node];
+        node.nsecs += timer.nsecsElapsed();
+        node.skipToCalls++;
+        if (id && id != prevId) {
+            node.ids++;
+        }
+        return id;
+    }
+
+    quint64 docId() const Q_DECL_OVERRIDE {
+        return m_it->docId();
+    }
+
+    uint estimatedSize() const Q_DECL_OVERRIDE {
+        return m_it->estimatedSize();
+    }
+
+    QVector<uint> positions() Q_DECL_OVERRIDE {
+        return m_it->positions();
+    }
+
+    int node() const {
+        return m_node;
+    }
+
+private:
+    PostingIterator* m_it;
+    QueryProfile* m_profile;
+    int m_node;
+};
+
+}
+
+using namespace Baloo;
+
+QVector<int> QueryProfile::nodeIds(const QVector<PostingIterator*>& iterators) const
+{
+    QVector<int> ids;
+    for (PostingIterator* it : iterators) {
+        auto pit = dynamic_cast<ProfilingPostingIterator*>(it);
+        if (pit) {
+            ids << pit->node();
+        }
+    }
+    return ids;
+}
+
+PostingIterator* QueryProfile::wrap(PostingIterator* it, const QByteArray& name, const QVector<PostingIterator*>& children)
+{
+    return wrapNode(it, name, nodeIds(children));
+}
+
+PostingIterator* QueryProfile::wrapNode(PostingIterator* it, const QByteArray& name, const QVector<int>& children)
+{
+    Node node;
+    node.name = it ? name : name + " (no match)";
+    node.db = m_pending;
+    node.children = children;
+    m_pending = DBCounters();
+
+    for (int child : children) {
+        m_nodes[child].hasParent = true;
+    }
+    m_nodes << node;
+
+    if (!it) {
+        return nullptr;
+    }
+    return new ProfilingPostingIterator(it, this, m_nodes.size() - 1);
+}
+
+void QueryProfile::print(QString& str, int id, int depth) const
+{
+    const Node& node = m_nodes[id];
+
+    str += QString(depth * 2, QLatin1Char(' ')) + QString::fromUtf8(node.name);
+    if (node.db.terms || node.db.gets) {
+        str += QStringLiteral("  terms: %1  gets: %2  bytes: %3")
+                   .arg(node.db.terms).arg(node.db.gets).arg(node.db.bytesDecoded);
+        if (node.db.cached) {
+            str += QStringLiteral("  cached: %1").arg(node.db.cached);
+        }
+    }
+    str += QStringLiteral("  next: %1  skipTo: %2  ids: %3  time: %4 ms\n")
+               .arg(node.nextCalls).arg(node.skipToCalls).arg(node.ids)
+               .arg(node.nsecs / 1000000.0, 0, 'f', 3);
+
+    for (int child : node.children) {
+        print(str, child, depth + 1);
+    }
+}
+
+QString QueryProfile::toString() const
+{
+    QString str;
+    for (int i = 0; i < m_nodes.size(); i++) {
+        if (!m_nodes[i].hasParent) {
+            print(str, i, 0);
+        }
+    }
+    return str;
+}
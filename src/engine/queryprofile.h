@@ -0,0 +1,119 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_QUERYPROFILE_H
+#define BALOO_QUERYPROFILE_H
+
+#include "engine_export.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+namespace Baloo {
+
+class PostingIterator;
+
+/**
+ * The database work done while building an iterator
+ */
+struct DBCounters {
+    uint terms = 0;
+    uint cached = 0;
+    quint64 gets = 0;
+    quint64 bytesDecoded = 0;
+};
+
+/**
+ * Records the iterator tree of a query along with how much work every node
+ * did, in order to explain why a query is slow.
+ *
+ * Profiling is opt-in: iterators are only wrapped and databases only count
+ * their accesses when a QueryProfile has been set on the Transaction, so
+ * queries without one do not pay for it.
+ */
+class BALOO_ENGINE_EXPORT QueryProfile
+{
+public:
+    struct Node {
+        QByteArray name;
+        DBCounters db;
+
+        quint64 nextCalls = 0;
+        quint64 skipToCalls = 0;
+        quint64 ids = 0;
+        qint64 nsecs = 0;
+
+        QVector<int> children;
+        bool hasParent = false;
+    };
+
+    /**
+     * The counters the databases add to while an iterator is being built.
+     * They are attributed to the next node passed to wrap().
+     */
+    DBCounters* dbCounters() {
+        return &m_pending;
+    }
+
+    /**
+     * Returns a profiling iterator forwarding to \p it, which becomes a node
+     * called \p name. \p children are the iterators \p it was built from and
+     * must have been returned by wrap() as well.
+     *
+     * Takes ownership of \p it. Returns nullptr if \p it is null.
+     */
+    PostingIterator* wrap(PostingIterator* it, const QByteArray& name,
+                          const QVector<PostingIterator*>& children = QVector<PostingIterator*>());
+
+    /**
+     * Convenience method for composite iterators which take ownership of
+     * their children and may delete them in their constructor.
+     */
+    template <typename Iterator>
+    PostingIterator* create(const QByteArray& name, const QVector<PostingIterator*>& children) {
+        const QVector<int> nodes = nodeIds(children);
+        return wrapNode(new Iterator(children), name, nodes);
+    }
+
+    QVector<Node> nodes() const {
+        return m_nodes;
+    }
+
+    /**
+     * Renders the iterator tree, one node per line
+     */
+    QString toString() const;
+
+private:
+    QVector<int> nodeIds(const QVector<PostingIterator*>& iterators) const;
+    PostingIterator* wrapNode(PostingIterator* it, const QByteArray& name, const QVector<int>& children);
+    void print(QString& str, int node, int depth) const;
+
+    QVector<Node> m_nodes;
+    DBCounters m_pending;
+
+    friend class ProfilingPostingIterator;
+};
+
+}
+
+#endif // BALOO_QUERYPROFILE_H
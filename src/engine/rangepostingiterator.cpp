@@ -0,0 +1,90 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "rangepostingiterator.h"
+
+using namespace Baloo;
+
+RangePostingIterator::RangePostingIterator(PostingIterator* it, quint64 firstId, quint64 lastId)
+    : m_it(it)
+    , m_firstId(firstId)
+    , m_lastId(lastId)
+    , m_docId(0)
+    , m_done(false)
+{
+    Q_ASSERT(m_it);
+    Q_ASSERT(firstId <= lastId);
+}
+
+RangePostingIterator::~RangePostingIterator()
+{
+    delete m_it;
+}
+
+quint64 RangePostingIterator::docId() const
+{
+    return m_docId;
+}
+
+quint64 RangePostingIterator::next()
+{
+    if (m_done) {
+        return 0;
+    }
+
+    if (!m_docId) {
+        return check(m_it->skipTo(m_firstId));
+    }
+    return check(m_it->next());
+}
+
+quint64 RangePostingIterator::skipTo(quint64 id)
+{
+    if (m_done) {
+        return 0;
+    }
+    if (m_docId && m_docId >= id) {
+        return m_docId;
+    }
+
+    return check(m_it->skipTo(qMax(id, m_firstId)));
+}
+
+quint64 RangePostingIterator::check(quint64 id)
+{
+    if (!id || id > m_lastId) {
+        m_done = true;
+        id = 0;
+    }
+
+    m_docId = id;
+    return m_docId;
+}
+
+uint RangePostingIterator::estimatedSize() const
+{
+    return m_it->estimatedSize();
+}
+
+QVector<uint> RangePostingIterator::positions()
+{
+    return m_it->positions();
+}
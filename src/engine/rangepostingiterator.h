@@ -0,0 +1,61 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_RANGEPOSTINGITERATOR_H
+#define BALOO_RANGEPOSTINGITERATOR_H
+
+#include "postingiterator.h"
+
+namespace Baloo {
+
+/**
+ * Yields the ids of another iterator which lie within [firstId, lastId]. The
+ * wrapped iterator is started with a skipTo, and is not advanced any further
+ * once it passes \p lastId. This is used to evaluate a query in parallel over
+ * disjoint id ranges.
+ *
+ * Takes ownership of the wrapped iterator.
+ */
+class BALOO_ENGINE_EXPORT RangePostingIterator : public PostingIterator
+{
+public:
+    RangePostingIterator(PostingIterator* it, quint64 firstId, quint64 lastId);
+    ~RangePostingIterator();
+
+    quint64 next() Q_DECL_OVERRIDE;
+    quint64 docId() const Q_DECL_OVERRIDE;
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE;
+    uint estimatedSize() const Q_DECL_OVERRIDE;
+    QVector<uint> positions() Q_DECL_OVERRIDE;
+
+private:
+    quint64 check(quint64 id);
+
+    PostingIterator* m_it;
+    quint64 m_firstId;
+    quint64 m_lastId;
+    quint64 m_docId;
+    bool m_done;
+};
+
+}
+
+#endif // BALOO_RANGEPOSTINGITERATOR_H
@@ -0,0 +1,336 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "residentidsets.h"
+#include "idutils.h"
+
+#include <QSaveFile>
+
+#include <algorithm>
+#include <limits>
+
+using namespace Baloo;
+
+namespace {
+
+struct FileHeader {
+    quint32 magic;
+    quint32 version;
+    quint64 indexId;
+    quint64 txnId;
+    quint64 sizes[ResidentIdSets::SetCount];
+};
+
+const quint32 fileMagic = 0x53444942;
+const quint32 fileVersion = 2;
+
+}
+
+ResidentIdSets::ResidentIdSets(const QString& filePath, const QString& indexPath)
+    : m_filePath(filePath)
+    , m_indexPath(indexPath)
+    , m_txnId(0)
+    , m_map(nullptr)
+    , m_misses(0)
+{
+    for (int set = 0; set < SetCount; set++) {
+        m_data[set] = nullptr;
+        m_size[set] = 0;
+    }
+}
+
+ResidentIdSets::~ResidentIdSets()
+{
+    unmap();
+}
+
+bool ResidentIdSets::lookup(Set set, quint64 id, quint64 txnId, bool* contains) const
+{
+    Q_ASSERT(contains);
+
+    QReadLocker locker(&m_lock);
+    if (!m_txnId || m_txnId != txnId) {
+        m_misses.ref();
+        return false;
+    }
+
+    const quint64* begin = m_data[set];
+    *contains = std::binary_search(begin, begin + m_size[set], id);
+    return true;
+}
+
+bool ResidentIdSets::shouldBuild(quint64 documentCount)
+{
+    // Building reads all the ids once, which has to pay off in lookups
+    const int threshold = qMin<quint64>(qMax<quint64>(1024, documentCount / 16), std::numeric_limits<int>::max());
+
+    const int misses = m_misses.load();
+    return misses >= threshold && m_misses.testAndSetOrdered(misses, 0);
+}
+
+void ResidentIdSets::build(MDB_txn* txn, const DatabaseDbis& dbis)
+{
+    const MDB_dbi setDbis[SetCount] = { dbis.idFilenameDbi, dbis.contentIndexingDbi, dbis.failedIdDbi };
+
+    QVector<quint64> sets[SetCount];
+    for (int set = 0; set < SetCount; set++) {
+        MDB_stat stat;
+        int rc = mdb_stat(txn, setDbis[set], &stat);
+        Q_ASSERT_X(rc == 0, "ResidentIdSets::build", mdb_strerror(rc));
+        if (rc) {
+            return;
+        }
+        sets[set].reserve(stat.ms_entries);
+
+        MDB_cursor* cursor;
+        rc = mdb_cursor_open(txn, setDbis[set], &cursor);
+        Q_ASSERT_X(rc == 0, "ResidentIdSets::build", mdb_strerror(rc));
+        if (rc) {
+            return;
+        }
+
+        // The keys are integers, so they come sorted
+        MDB_val key = {0, nullptr};
+        MDB_val val;
+        while ((rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT)) == 0) {
+            sets[set] << *static_cast<quint64*>(key.mv_data);
+        }
+        Q_ASSERT_X(rc == MDB_NOTFOUND, "ResidentIdSets::build", mdb_strerror(rc));
+        mdb_cursor_close(cursor);
+    }
+
+    QWriteLocker locker(&m_lock);
+
+    // A commit may have moved the sets past this snapshot in the meantime
+    const quint64 txnId = mdb_txn_id(txn);
+    if (txnId > m_txnId) {
+        setSets(txnId, sets);
+    }
+}
+
+void ResidentIdSets::update(quint64 txnId, const Changes& changes)
+{
+    QWriteLocker locker(&m_lock);
+    if (!m_txnId || m_txnId + 1 != txnId) {
+        return;
+    }
+
+    QVector<quint64> ids;
+    ids.reserve(changes.size());
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        ids << it.key();
+    }
+    std::sort(ids.begin(), ids.end());
+
+    bool changed[SetCount];
+    bool anyChanged = false;
+    for (int set = 0; set < SetCount; set++) {
+        const quint64* begin = m_data[set];
+        const quint64* end = begin + m_size[set];
+        const uint mask = 1u << set;
+
+        changed[set] = false;
+        for (quint64 id : ids) {
+            if (std::binary_search(begin, end, id) != bool(changes.value(id) & mask)) {
+                changed[set] = true;
+                anyChanged = true;
+                break;
+            }
+        }
+    }
+
+    // Such as commits which only touched the posting lists, the mapped
+    // file can be kept then
+    if (!anyChanged) {
+        m_txnId = txnId;
+        return;
+    }
+
+    // The changes are merged into copies, the mapped file is left for good
+    QVector<quint64> sets[SetCount];
+    for (int set = 0; set < SetCount; set++) {
+        const quint64* it = m_data[set];
+        const quint64* end = it + m_size[set];
+        const uint mask = 1u << set;
+
+        if (!changed[set] && !m_map) {
+            sets[set] = m_sets[set];
+            continue;
+        }
+
+        QVector<quint64>& result = sets[set];
+        result.reserve(m_size[set] + ids.size());
+        for (quint64 id : ids) {
+            const quint64* pos = std::lower_bound(it, end, id);
+            while (it != pos) {
+                result << *it++;
+            }
+            if (it != end && *it == id) {
+                ++it;
+            }
+            if (changes.value(id) & mask) {
+                result << id;
+            }
+        }
+        while (it != end) {
+            result << *it++;
+        }
+    }
+
+    setSets(txnId, sets);
+}
+
+quint64 ResidentIdSets::txnId() const
+{
+    QReadLocker locker(&m_lock);
+    return m_txnId;
+}
+
+bool ResidentIdSets::load(quint64 txnId)
+{
+    QWriteLocker locker(&m_lock);
+    unmap();
+
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // A compacted or new data file is another file, and its transaction
+    // ids may well have caught up with those of the saved sets
+    const quint64 indexId = filePathToId(QFile::encodeName(m_indexPath));
+
+    const qint64 fileSize = m_file.size();
+    FileHeader header;
+    if (fileSize < qint64(sizeof(header)) || m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header)
+        || header.magic != fileMagic || header.version != fileVersion
+        || !indexId || header.indexId != indexId || header.txnId != txnId) {
+        m_file.close();
+        return false;
+    }
+
+    quint64 count = 0;
+    for (int set = 0; set < SetCount; set++) {
+        if (header.sizes[set] > quint64(std::numeric_limits<int>::max())) {
+            m_file.close();
+            return false;
+        }
+        count += header.sizes[set];
+    }
+    if (quint64(fileSize) != sizeof(header) + count * sizeof(quint64)) {
+        m_file.close();
+        return false;
+    }
+
+    m_map = m_file.map(0, fileSize);
+    if (!m_map) {
+        m_file.close();
+        return false;
+    }
+
+    // The header keeps the arrays aligned
+    const quint64* data = reinterpret_cast<const quint64*>(m_map + sizeof(header));
+    for (int set = 0; set < SetCount; set++) {
+        m_sets[set].clear();
+        m_data[set] = data;
+        m_size[set] = header.sizes[set];
+        data += header.sizes[set];
+    }
+    m_txnId = txnId;
+    m_misses.store(0);
+
+    return true;
+}
+
+bool ResidentIdSets::save() const
+{
+    QReadLocker locker(&m_lock);
+    if (!m_txnId) {
+        return false;
+    }
+
+    FileHeader header;
+    header.magic = fileMagic;
+    header.version = fileVersion;
+    header.indexId = filePathToId(QFile::encodeName(m_indexPath));
+    header.txnId = m_txnId;
+    if (!header.indexId) {
+        return false;
+    }
+    for (int set = 0; set < SetCount; set++) {
+        header.sizes[set] = m_size[set];
+    }
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int set = 0; set < SetCount; set++) {
+        file.write(reinterpret_cast<const char*>(m_data[set]), m_size[set] * sizeof(quint64));
+    }
+
+    return file.commit();
+}
+
+void ResidentIdSets::clear()
+{
+    QWriteLocker locker(&m_lock);
+
+    QVector<quint64> sets[SetCount];
+    setSets(0, sets);
+    QFile::remove(m_filePath);
+}
+
+QVector<quint64> ResidentIdSets::toTestVector(Set set) const
+{
+    QReadLocker locker(&m_lock);
+
+    QVector<quint64> vec;
+    for (int i = 0; i < m_size[set]; i++) {
+        vec << m_data[set][i];
+    }
+    return vec;
+}
+
+void ResidentIdSets::setSets(quint64 txnId, QVector<quint64>* sets)
+{
+    for (int set = 0; set < SetCount; set++) {
+        m_sets[set].swap(sets[set]);
+        m_data[set] = m_sets[set].constData();
+        m_size[set] = m_sets[set].size();
+    }
+    unmap();
+
+    m_txnId = txnId;
+    m_misses.store(0);
+}
+
+void ResidentIdSets::unmap()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
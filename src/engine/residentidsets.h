@@ -0,0 +1,134 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_RESIDENTIDSETS_H
+#define BALOO_RESIDENTIDSETS_H
+
+#include "engine_export.h"
+#include "databasedbis.h"
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * Keeps the ids of the documents, of those waiting for content indexing and
+ * of those whose indexing failed in memory, as sorted arrays, so that
+ * Transaction::hasDocument(), inPhaseOne() and hasFailed() are answered
+ * without walking the B-trees of the index.
+ *
+ * The sets belong to one snapshot of the index. The transactions reading
+ * that snapshot use them, and the commits of this process move them on to
+ * the next one. A commit of another process leaves them behind, they are
+ * built again once enough lookups missed them.
+ *
+ * The Database saves them next to the index when it is closed, and the next
+ * process opening the index maps the file into memory as long as nothing
+ * was committed in between. The transaction ids start over once the index
+ * is compacted or created anew, so the file also records which data file
+ * \p indexPath it was saved for.
+ */
+class BALOO_ENGINE_EXPORT ResidentIdSets
+{
+public:
+    enum Set {
+        Documents = 0,
+        PhaseOne,
+        Failed,
+        SetCount
+    };
+
+    /**
+     * The sets which contain the ids changed by a commit, as masks of 1 << Set
+     */
+    typedef QHash<quint64, uint> Changes;
+
+    ResidentIdSets(const QString& filePath, const QString& indexPath);
+    ~ResidentIdSets();
+
+    /**
+     * Returns false if the sets are not those of the snapshot \p txnId,
+     * otherwise sets \p contains to whether \p set contains \p id
+     */
+    bool lookup(Set set, quint64 id, quint64 txnId, bool* contains) const;
+
+    /**
+     * Returns true once the lookups missed often enough to make building
+     * the sets of an index with \p documentCount documents worth it
+     */
+    bool shouldBuild(quint64 documentCount);
+
+    /**
+     * Reads the sets from the snapshot of \p txn
+     */
+    void build(MDB_txn* txn, const DatabaseDbis& dbis);
+
+    /**
+     * Moves the sets from the snapshot \p txnId - 1 to \p txnId, which
+     * changed the ids of \p changes. Does nothing if the sets are not those
+     * of the snapshot \p txnId - 1.
+     */
+    void update(quint64 txnId, const Changes& changes);
+
+    /**
+     * The snapshot of the sets, 0 if there are none
+     */
+    quint64 txnId() const;
+
+    /**
+     * Maps the saved sets into memory if they are those of \p txnId of the
+     * current data file
+     */
+    bool load(quint64 txnId);
+    bool save() const;
+
+    /**
+     * Drops the sets and the saved file
+     */
+    void clear();
+
+    QVector<quint64> toTestVector(Set set) const;
+
+private:
+    void setSets(quint64 txnId, QVector<quint64>* sets);
+    void unmap();
+
+    const QString m_filePath;
+    const QString m_indexPath;
+
+    mutable QReadWriteLock m_lock;
+    quint64 m_txnId;
+    const quint64* m_data[SetCount];
+    int m_size[SetCount];
+    QVector<quint64> m_sets[SetCount];
+    QFile m_file;
+    uchar* m_map;
+
+    mutable QAtomicInt m_misses;
+};
+
+}
+
+#endif // BALOO_RESIDENTIDSETS_H
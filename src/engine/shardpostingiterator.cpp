@@ -0,0 +1,93 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "shardpostingiterator.h"
+
+using namespace Baloo;
+
+ShardPostingIterator::ShardPostingIterator(PostingIterator* it, quint32 deviceId)
+    : m_it(it)
+    , m_deviceId(deviceId)
+    , m_docId(0)
+    , m_done(false)
+{
+    Q_ASSERT(m_it);
+}
+
+ShardPostingIterator::~ShardPostingIterator()
+{
+    delete m_it;
+}
+
+quint64 ShardPostingIterator::docId() const
+{
+    return m_docId;
+}
+
+quint64 ShardPostingIterator::next()
+{
+    if (m_done) {
+        return 0;
+    }
+    return check(m_it->next());
+}
+
+quint64 ShardPostingIterator::skipTo(quint64 id)
+{
+    if (m_done) {
+        return 0;
+    }
+    if (m_docId && m_docId >= id) {
+        return m_docId;
+    }
+
+    const quint32 deviceId = id >> 32;
+    if (deviceId > m_deviceId) {
+        return check(0);
+    }
+
+    // Anything before this shard starts it at its first ordinal
+    const quint64 ordinal = deviceId < m_deviceId ? 1 : qMax<quint64>(id & 0xffffffff, 1);
+    return check(m_it->skipTo(ordinal));
+}
+
+quint64 ShardPostingIterator::check(quint64 ordinal)
+{
+    if (!ordinal) {
+        m_done = true;
+        m_docId = 0;
+        return 0;
+    }
+
+    Q_ASSERT(ordinal <= 0xffffffff);
+    m_docId = (static_cast<quint64>(m_deviceId) << 32) | ordinal;
+    return m_docId;
+}
+
+uint ShardPostingIterator::estimatedSize() const
+{
+    return m_it->estimatedSize();
+}
+
+QVector<uint> ShardPostingIterator::positions()
+{
+    return m_it->positions();
+}
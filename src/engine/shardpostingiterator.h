@@ -0,0 +1,59 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_SHARDPOSTINGITERATOR_H
+#define BALOO_SHARDPOSTINGITERATOR_H
+
+#include "postingiterator.h"
+
+namespace Baloo {
+
+/**
+ * Yields the ordinals of an iterator over the shard of \p deviceId with the
+ * device id in the high word. The ordinals of every shard start at 1, this
+ * keeps them apart and sorted once the shards are merged.
+ *
+ * Takes ownership of the wrapped iterator.
+ */
+class BALOO_ENGINE_EXPORT ShardPostingIterator : public PostingIterator
+{
+public:
+    ShardPostingIterator(PostingIterator* it, quint32 deviceId);
+    ~ShardPostingIterator();
+
+    quint64 next() Q_DECL_OVERRIDE;
+    quint64 docId() const Q_DECL_OVERRIDE;
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE;
+    uint estimatedSize() const Q_DECL_OVERRIDE;
+    QVector<uint> positions() Q_DECL_OVERRIDE;
+
+private:
+    quint64 check(quint64 ordinal);
+
+    PostingIterator* m_it;
+    quint32 m_deviceId;
+    quint64 m_docId;
+    bool m_done;
+};
+
+}
+
+#endif // BALOO_SHARDPOSTINGITERATOR_H
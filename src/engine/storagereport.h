@@ -0,0 +1,88 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_STORAGEREPORT_H
+#define BALOO_STORAGEREPORT_H
+
+#include <QByteArray>
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * A page level view of the index, as shown by "balooctl storage". It is
+ * meant for finding the terms which bloat the index and churn overflow
+ * pages, so it comes at the cost of reading every value once.
+ */
+class StorageReport {
+public:
+    class Value {
+    public:
+        /// The term, or the document id for the integer keyed databases
+        QByteArray key;
+        size_t size;
+
+        /// Estimated number of overflow pages, 0 if the value fits on a leaf page
+        size_t overflowPages;
+
+        Value() : size(0), overflowPages(0) {}
+    };
+
+    class Dbi {
+    public:
+        QByteArray name;
+
+        size_t entries;
+        size_t depth;
+        size_t branchPages;
+        size_t leafPages;
+        size_t overflowPages;
+
+        /// The number of values which are too large for a leaf page
+        size_t overflowValues;
+
+        /// The largest values, largest first
+        QVector<Value> largestValues;
+
+        Dbi() : entries(0), depth(0), branchPages(0), leafPages(0), overflowPages(0), overflowValues(0) {}
+
+        size_t pages() const {
+            return branchPages + leafPages + overflowPages;
+        }
+    };
+
+    size_t pageSize;
+    size_t mapSize;
+
+    /// The number of pages in use by the file, including the free ones
+    size_t usedPages;
+
+    /// The number of pages on the freelist, which are reused by later commits
+    size_t freePages;
+
+    QVector<Dbi> dbis;
+
+    StorageReport() : pageSize(0), mapSize(0), usedPages(0), freePages(0) {}
+};
+
+}
+
+#endif // BALOO_STORAGEREPORT_H
@@ -0,0 +1,279 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "tagdb.h"
+
+#include <cstring>
+
+using namespace Baloo;
+
+TagDB::TagDB(MDB_dbi dbi, MDB_txn* txn)
+    : m_txn(txn)
+    , m_dbi(dbi)
+{
+    Q_ASSERT(txn != nullptr);
+    Q_ASSERT(dbi != 0);
+}
+
+TagDB::~TagDB()
+{
+}
+
+MDB_dbi TagDB::create(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "tagdb", MDB_CREATE, &dbi);
+    Q_ASSERT_X(rc == 0, "TagDB::create", mdb_strerror(rc));
+
+    return dbi;
+}
+
+MDB_dbi TagDB::open(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "tagdb", 0, &dbi);
+    if (rc == MDB_NOTFOUND) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "TagDB::open", mdb_strerror(rc));
+
+    return dbi;
+}
+
+// Not splitting at leading, trailing or repeated slashes gives every tag exactly one key
+static int splitPosition(const QByteArray& tag)
+{
+    const int pos = tag.lastIndexOf('/');
+    if (pos <= 0 || pos == tag.size() - 1) {
+        return -1;
+    }
+    return pos;
+}
+
+QByteArray TagDB::parentTag(const QByteArray& tag)
+{
+    const int pos = splitPosition(tag);
+    return pos < 0 ? QByteArray() : tag.left(pos);
+}
+
+static QByteArray tagKey(const QByteArray& tag)
+{
+    const int pos = splitPosition(tag);
+
+    QByteArray key;
+    key.reserve(tag.size() + 1);
+    if (pos >= 0) {
+        key.append(tag.constData(), pos);
+    }
+    key.append('\0');
+    key.append(tag.constData() + pos + 1, tag.size() - pos - 1);
+    return key;
+}
+
+bool TagDB::fetch(const QByteArray& tag, TagInfo* info)
+{
+    const QByteArray k = tagKey(tag);
+
+    MDB_val key;
+    key.mv_size = k.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(k.constData()));
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND) {
+        return false;
+    }
+    Q_ASSERT_X(rc == 0, "TagDB::fetch", mdb_strerror(rc));
+    if (rc) {
+        return false;
+    }
+
+    // Values of non integer keys are not guaranteed to be aligned
+    memcpy(info, val.mv_data, qMin(sizeof(TagInfo), val.mv_size));
+    return true;
+}
+
+void TagDB::put(const QByteArray& tag, const TagInfo& info)
+{
+    const QByteArray k = tagKey(tag);
+
+    MDB_val key;
+    key.mv_size = k.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(k.constData()));
+
+    MDB_val val;
+    val.mv_size = sizeof(TagInfo);
+    val.mv_data = static_cast<void*>(const_cast<TagInfo*>(&info));
+
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    Q_ASSERT_X(rc == 0, "TagDB::put", mdb_strerror(rc));
+}
+
+void TagDB::del(const QByteArray& tag)
+{
+    const QByteArray k = tagKey(tag);
+
+    MDB_val key;
+    key.mv_size = k.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(k.constData()));
+
+    int rc = mdb_del(m_txn, m_dbi, &key, nullptr);
+    if (rc == MDB_NOTFOUND) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "TagDB::del", mdb_strerror(rc));
+}
+
+void TagDB::setDocumentCount(const QByteArray& tag, quint32 count)
+{
+    Q_ASSERT(!tag.isEmpty());
+
+    TagInfo info;
+    const bool exists = fetch(tag, &info);
+    if (info.documentCount == count) {
+        return;
+    }
+
+    info.documentCount = count;
+    if (!info.documentCount && !info.childCount) {
+        del(tag);
+        removeChild(parentTag(tag));
+        return;
+    }
+
+    put(tag, info);
+    if (!exists) {
+        addChild(parentTag(tag));
+    }
+}
+
+void TagDB::addChild(const QByteArray& parent)
+{
+    if (parent.isEmpty()) {
+        return;
+    }
+
+    TagInfo info;
+    const bool exists = fetch(parent, &info);
+    info.childCount++;
+    put(parent, info);
+
+    if (!exists) {
+        addChild(parentTag(parent));
+    }
+}
+
+void TagDB::removeChild(const QByteArray& parent)
+{
+    if (parent.isEmpty()) {
+        return;
+    }
+
+    TagInfo info;
+    if (!fetch(parent, &info) || !info.childCount) {
+        Q_ASSERT_X(false, "TagDB::removeChild", "The parent does not have any children");
+        return;
+    }
+
+    info.childCount--;
+    if (!info.documentCount && !info.childCount) {
+        del(parent);
+        removeChild(parentTag(parent));
+        return;
+    }
+    put(parent, info);
+}
+
+TagDB::TagInfo TagDB::get(const QByteArray& tag)
+{
+    Q_ASSERT(!tag.isEmpty());
+
+    TagInfo info;
+    fetch(tag, &info);
+    return info;
+}
+
+QMap<QByteArray, TagDB::TagInfo> TagDB::children(const QByteArray& parent)
+{
+    QByteArray prefix = parent;
+    prefix.append('\0');
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(prefix.data());
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    QMap<QByteArray, TagInfo> map;
+
+    MDB_val val;
+    int rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+    while (rc == 0) {
+        const QByteArray k = QByteArray::fromRawData(static_cast<char*>(key.mv_data), key.mv_size);
+        if (!k.startsWith(prefix)) {
+            break;
+        }
+
+        TagInfo info;
+        memcpy(&info, val.mv_data, qMin(sizeof(TagInfo), val.mv_size));
+        map.insert(k.mid(prefix.size()), info);
+
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+    }
+    Q_ASSERT_X(rc == 0 || rc == MDB_NOTFOUND, "TagDB::children", mdb_strerror(rc));
+
+    mdb_cursor_close(cursor);
+    return map;
+}
+
+QMap<QByteArray, TagDB::TagInfo> TagDB::toTestMap() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    QMap<QByteArray, TagInfo> map;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc == MDB_NOTFOUND) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "TagDB::toTestMap", mdb_strerror(rc));
+
+        const QByteArray k(static_cast<char*>(key.mv_data), key.mv_size);
+        const int pos = k.indexOf('\0');
+        QByteArray tag = k.left(pos);
+        if (!tag.isEmpty()) {
+            tag.append('/');
+        }
+        tag.append(k.mid(pos + 1));
+
+        TagInfo info;
+        memcpy(&info, val.mv_data, qMin(sizeof(TagInfo), val.mv_size));
+        map.insert(tag, info);
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_TAGDB_H
+#define BALOO_TAGDB_H
+
+#include "engine_export.h"
+
+#include <QByteArray>
+#include <QMap>
+#include <lmdb.h>
+
+namespace Baloo {
+
+/**
+ * Keeps the tree of all tags with the number of documents carrying each of
+ * them, so that a level of the tag hierarchy can be listed with a single
+ * cursor range. Tags are split at '/', "a/b" is the child "b" of "a".
+ * Intermediate tags which are not set on any document are kept as long as
+ * they have children.
+ *
+ * parent '\0' name -> TagInfo
+ */
+class BALOO_ENGINE_EXPORT TagDB
+{
+public:
+    TagDB(MDB_dbi dbi, MDB_txn* txn);
+    ~TagDB();
+
+    static MDB_dbi create(MDB_txn* txn);
+    static MDB_dbi open(MDB_txn* txn);
+
+    struct TagInfo {
+        /// The number of documents tagged with exactly this tag
+        quint32 documentCount;
+        /// The number of tags directly below this one
+        quint32 childCount;
+
+        TagInfo() : documentCount(0), childCount(0) {}
+
+        bool operator == (const TagInfo& rhs) const {
+            return documentCount == rhs.documentCount && childCount == rhs.childCount;
+        }
+    };
+
+    /**
+     * Sets the number of documents tagged with \p tag, adding or removing
+     * the tag and the parents which only exist because of it
+     */
+    void setDocumentCount(const QByteArray& tag, quint32 count);
+
+    TagInfo get(const QByteArray& tag);
+
+    /**
+     * Returns the tags directly below \p parent by their last component. An
+     * empty \p parent returns the top level tags.
+     */
+    QMap<QByteArray, TagInfo> children(const QByteArray& parent);
+
+    /**
+     * Returns the tag \p tag is listed under, or an empty array for a top
+     * level tag. Tags are only split at a '/' with a non empty component on
+     * both sides, "/a" and "a/" are top level tags.
+     */
+    static QByteArray parentTag(const QByteArray& tag);
+
+    /**
+     * Returns every tag by its full name
+     */
+    QMap<QByteArray, TagInfo> toTestMap() const;
+
+private:
+    bool fetch(const QByteArray& tag, TagInfo* info);
+    void put(const QByteArray& tag, const TagInfo& info);
+    void del(const QByteArray& tag);
+
+    void addChild(const QByteArray& parent);
+    void removeChild(const QByteArray& parent);
+
+    MDB_txn* m_txn;
+    MDB_dbi m_dbi;
+};
+
+}
+
+#endif // BALOO_TAGDB_H
@@ -0,0 +1,141 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "termstatsdb.h"
+
+#include <cstring>
+
+using namespace Baloo;
+
+TermStatsDB::TermStatsDB(MDB_dbi dbi, MDB_txn* txn)
+    : m_txn(txn)
+    , m_dbi(dbi)
+{
+    Q_ASSERT(txn != nullptr);
+    Q_ASSERT(dbi != 0);
+}
+
+TermStatsDB::~TermStatsDB()
+{
+}
+
+MDB_dbi TermStatsDB::create(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "termstatsdb", MDB_CREATE, &dbi);
+    Q_ASSERT_X(rc == 0, "TermStatsDB::create", mdb_strerror(rc));
+
+    return dbi;
+}
+
+MDB_dbi TermStatsDB::open(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "termstatsdb", 0, &dbi);
+    if (rc == MDB_NOTFOUND) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "TermStatsDB::open", mdb_strerror(rc));
+
+    return dbi;
+}
+
+void TermStatsDB::put(const QByteArray& term, const TermStats& stats)
+{
+    Q_ASSERT(!term.isEmpty());
+    Q_ASSERT(stats.documentCount > 0);
+
+    MDB_val key;
+    key.mv_size = term.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
+
+    MDB_val val;
+    val.mv_size = sizeof(TermStats);
+    val.mv_data = static_cast<void*>(const_cast<TermStats*>(&stats));
+
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    Q_ASSERT_X(rc == 0, "TermStatsDB::put", mdb_strerror(rc));
+}
+
+TermStatsDB::TermStats TermStatsDB::get(const QByteArray& term)
+{
+    Q_ASSERT(!term.isEmpty());
+
+    MDB_val key;
+    key.mv_size = term.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
+
+    TermStats stats;
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND) {
+        return stats;
+    }
+    Q_ASSERT_X(rc == 0, "TermStatsDB::get", mdb_strerror(rc));
+
+    // Values of non integer keys are not guaranteed to be aligned
+    if (val.mv_size == sizeof(TermStats)) {
+        memcpy(&stats, val.mv_data, sizeof(TermStats));
+    }
+    return stats;
+}
+
+void TermStatsDB::del(const QByteArray& term)
+{
+    Q_ASSERT(!term.isEmpty());
+
+    MDB_val key;
+    key.mv_size = term.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
+
+    int rc = mdb_del(m_txn, m_dbi, &key, nullptr);
+    if (rc == MDB_NOTFOUND) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "TermStatsDB::del", mdb_strerror(rc));
+}
+
+QMap<QByteArray, TermStatsDB::TermStats> TermStatsDB::toTestMap() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    QMap<QByteArray, TermStats> map;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc == MDB_NOTFOUND) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "TermStatsDB::toTestMap", mdb_strerror(rc));
+
+        const QByteArray term(static_cast<char*>(key.mv_data), key.mv_size);
+        TermStats stats;
+        memcpy(&stats, val.mv_data, qMin(sizeof(TermStats), val.mv_size));
+        map.insert(term, stats);
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_TERMSTATSDB_H
+#define BALOO_TERMSTATSDB_H
+
+#include "engine_export.h"
+
+#include <QByteArray>
+#include <QMap>
+#include <lmdb.h>
+
+namespace Baloo {
+
+/**
+ * Keeps the statistics of every term in the PostingDB, so that the document
+ * frequency of a term can be known without decoding its posting list.
+ *
+ * term -> TermStats
+ */
+class BALOO_ENGINE_EXPORT TermStatsDB
+{
+public:
+    TermStatsDB(MDB_dbi dbi, MDB_txn* txn);
+    ~TermStatsDB();
+
+    static MDB_dbi create(MDB_txn* txn);
+    static MDB_dbi open(MDB_txn* txn);
+
+    struct TermStats {
+        quint32 documentCount;
+        quint32 reserved;
+        /// The first and the last document ordinal in the posting list
+        quint64 minId;
+        quint64 maxId;
+        quint64 positionCount;
+
+        TermStats() : documentCount(0), reserved(0), minId(0), maxId(0), positionCount(0) {}
+
+        bool operator == (const TermStats& rhs) const {
+            return documentCount == rhs.documentCount && minId == rhs.minId
+                && maxId == rhs.maxId && positionCount == rhs.positionCount;
+        }
+    };
+
+    void put(const QByteArray& term, const TermStats& stats);
+    TermStats get(const QByteArray& term);
+    void del(const QByteArray& term);
+
+    QMap<QByteArray, TermStats> toTestMap() const;
+private:
+    MDB_txn* m_txn;
+    MDB_dbi m_dbi;
+};
+
+}
+
+#endif // BALOO_TERMSTATSDB_H
@@ -26,6 +26,9 @@
 #include "positiondb.h"
 #include "documentdatadb.h"
 #include "mtimedb.h"
+#include "idfilenamedb.h"
+#include "metadatadb.h"
+#include "ordinaldb.h"
 
 #include "document.h"
 #include "enginequery.h"
@@ -33,29 +36,70 @@
 #include "andpostingiterator.h"
 #include "orpostingiterator.h"
 #include "phraseanditerator.h"
+#include "filterpostingiterator.h"
+#include "shardpostingiterator.h"
+#include "vectorpostingiterator.h"
+#include "queryprofile.h"
+#include "enginemetrics.h"
 
 #include "writetransaction.h"
 #include "idutils.h"
 #include "database.h"
 #include "databasesize.h"
+#include "postingcache.h"
+#include "residentidsets.h"
+#include "storagereport.h"
 
 #include <QFile>
 #include <QFileInfo>
+#include <QElapsedTimer>
+#include <QScopedPointer>
+
+#include <algorithm>
+#include <functional>
 
 using namespace Baloo;
 
 Transaction::Transaction(const Database& db, Transaction::TransactionType type)
     : m_dbis(db.m_dbis)
-    , m_env(db.m_env)
+    , m_db(db)
+    , m_txn(nullptr)
+    , m_env(nullptr)
     , m_writeTrans(nullptr)
+    , m_profile(nullptr)
+    , m_type(type)
+    , m_sharded(db.isSharded())
+    , m_shardsSnapshotBase(0)
+    , m_writersFd(-1)
 {
-    uint flags = type == ReadOnly ? MDB_RDONLY : 0;
-    int rc = mdb_txn_begin(db.m_env, nullptr, flags, &m_txn);
-    Q_ASSERT_X(rc == 0, "Transaction", mdb_strerror(rc));
+    // Database::compact() must not swap the environment under us
+    db.m_envLock.lockForRead();
+    m_env = db.m_env;
+
+    if (m_sharded) {
+        if (type == ReadOnly) {
+            const QMap<quint32, Database*> shards = db.openShards(&m_shardsSnapshotBase);
+            for (auto it = shards.constBegin(); it != shards.constEnd(); ++it) {
+                startShard(it.key(), it.value(), ReadOnly);
+            }
+        }
+        return;
+    }
+
+    // The environment of a removed shard is closed
+    if (!m_env) {
+        return;
+    }
 
-    if (type == ReadWrite) {
-        m_writeTrans = new WriteTransaction(m_dbis, m_txn);
+    if (type == ReadOnly) {
+        m_txn = db.acquireReadTransaction();
+        return;
     }
+
+    int rc = mdb_txn_begin(db.m_env, nullptr, 0, &m_txn);
+    Q_ASSERT_X(rc == 0, "Transaction", mdb_strerror(rc));
+
+    m_writeTrans = new WriteTransaction(m_dbis, m_txn);
 }
 
 Transaction::Transaction(Database* db, Transaction::TransactionType type)
@@ -65,38 +109,205 @@ Transaction::Transaction(Database* db, Transaction::TransactionType type)
 
 Transaction::~Transaction()
 {
-    if (m_writeTrans)
+    if (m_writeTrans || (m_type == ReadWrite && !m_shards.isEmpty()))
         qWarning() << "Closing an active WriteTransaction without calling abort/commit";
 
-    if (m_txn) {
+    if (m_txn || !m_shards.isEmpty() || !m_readShards.isEmpty()) {
         abort();
     }
+
+    m_db.m_envLock.unlock();
+}
+
+Transaction* Transaction::startShard(quint32 deviceId, Database* shard, TransactionType type) const
+{
+    Transaction* tr = new Transaction(*shard, type);
+    if (!tr->m_txn) {
+        delete tr;
+        return nullptr;
+    }
+
+    tr->setQueryProfile(m_profile);
+    if (type == m_type) {
+        m_shards.insert(deviceId, tr);
+    } else {
+        m_readShards.insert(deviceId, tr);
+    }
+    return tr;
+}
+
+Transaction* Transaction::shardTransaction(quint64 id) const
+{
+    return deviceTransaction(idToDeviceId(id));
+}
+
+Transaction* Transaction::deviceTransaction(quint32 deviceId) const
+{
+    Q_ASSERT(m_sharded);
+
+    if (Transaction* tr = m_shards.value(deviceId)) {
+        return tr;
+    }
+
+    // A read only transaction sticks to the shards it started with
+    if (m_type == ReadOnly) {
+        return nullptr;
+    }
+    if (Transaction* tr = m_readShards.value(deviceId)) {
+        return tr;
+    }
+
+    Database* shard = m_db.openShard(deviceId, false);
+    return shard ? startShard(deviceId, shard, ReadOnly) : nullptr;
+}
+
+QMap<quint32, Transaction*> Transaction::shardTransactions() const
+{
+    Q_ASSERT(m_sharded);
+
+    if (m_type == ReadOnly) {
+        return m_shards;
+    }
+
+    QMap<quint32, Transaction*> shards;
+    const QMap<quint32, Database*> openShards = m_db.openShards();
+    for (auto it = openShards.constBegin(); it != openShards.constEnd(); ++it) {
+        if (Transaction* tr = deviceTransaction(it.key())) {
+            shards.insert(it.key(), tr);
+        }
+    }
+    return shards;
+}
+
+Transaction* Transaction::writeShard(quint32 deviceId, bool create)
+{
+    Q_ASSERT(m_sharded);
+    Q_ASSERT(m_type == ReadWrite);
+
+    if (Transaction* tr = m_shards.value(deviceId)) {
+        return tr;
+    }
+
+    Database* shard = m_db.openShard(deviceId, create);
+    if (!shard) {
+        return nullptr;
+    }
+
+    // The shards are started in whatever order they are written to, which
+    // only cannot deadlock as long as one transaction at a time writes
+    if (m_writersFd < 0) {
+        m_writersFd = m_db.lockWriters();
+    }
+    return startShard(deviceId, shard, ReadWrite);
+}
+
+QVector<Transaction*> Transaction::writeShards(quint64 id)
+{
+    QVector<Transaction*> shards;
+    const QMap<quint32, Transaction*> readers = shardTransactions();
+    for (auto it = readers.constBegin(); it != readers.constEnd(); ++it) {
+        Transaction* tr = it.value();
+        if (id && !tr->hasDocument(id) && tr->documentChildren(id).isEmpty()) {
+            continue;
+        }
+        if ((tr = writeShard(it.key()))) {
+            shards << tr;
+        }
+    }
+    return shards;
 }
 
 bool Transaction::hasDocument(quint64 id) const
 {
+    if (m_sharded) {
+        Transaction* tr = shardTransaction(id);
+        return tr && tr->hasDocument(id);
+    }
+
     Q_ASSERT(id > 0);
 
+    bool contains;
+    if (residentLookup(ResidentIdSets::Documents, id, &contains)) {
+        return contains;
+    }
+
     IdFilenameDB idFilenameDb(m_dbis.idFilenameDbi, m_txn);
     return idFilenameDb.contains(id);
 }
 
+bool Transaction::residentLookup(int set, quint64 id, bool* contains) const
+{
+    ResidentIdSets* idSets = m_db.m_idSets;
+    if (!idSets || !m_txn) {
+        return false;
+    }
+
+    // A write transaction builds on the previous snapshot, and its own
+    // changes are only found in the databases
+    quint64 txnId = mdb_txn_id(m_txn);
+    if (m_writeTrans) {
+        if (m_writeTrans->isTouched(id)) {
+            return false;
+        }
+        txnId--;
+    }
+
+    const ResidentIdSets::Set idSet = static_cast<ResidentIdSets::Set>(set);
+    if (idSets->lookup(idSet, id, txnId, contains)) {
+        return true;
+    }
+
+    MDB_stat stat;
+    if (mdb_stat(m_txn, m_dbis.idFilenameDbi, &stat) == 0 && idSets->shouldBuild(stat.ms_entries)) {
+        m_db.buildResidentIdSets();
+        return idSets->lookup(idSet, id, txnId, contains);
+    }
+    return false;
+}
+
 bool Transaction::inPhaseOne(quint64 id) const
 {
+    if (m_sharded) {
+        Transaction* tr = shardTransaction(id);
+        return tr && tr->inPhaseOne(id);
+    }
+
     Q_ASSERT(id > 0);
+
+    bool contains;
+    if (residentLookup(ResidentIdSets::PhaseOne, id, &contains)) {
+        return contains;
+    }
+
     DocumentIdDB contentIndexingDb(m_dbis.contentIndexingDbi, m_txn);
     return contentIndexingDb.contains(id);
 }
 
 bool Transaction::hasFailed(quint64 id) const
 {
+    if (m_sharded) {
+        Transaction* tr = shardTransaction(id);
+        return tr && tr->hasFailed(id);
+    }
+
     Q_ASSERT(id > 0);
+
+    bool contains;
+    if (residentLookup(ResidentIdSets::Failed, id, &contains)) {
+        return contains;
+    }
+
     DocumentIdDB failedIdDb(m_dbis.failedIdDbi, m_txn);
     return failedIdDb.contains(id);
 }
 
 QByteArray Transaction::documentUrl(quint64 id) const
 {
+    if (m_sharded) {
+        Transaction* tr = shardTransaction(id);
+        return tr ? tr->documentUrl(id) : QByteArray();
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(id > 0);
 
@@ -104,8 +315,37 @@ QByteArray Transaction::documentUrl(quint64 id) const
     return docUrlDb.get(id);
 }
 
+QVector<quint64> Transaction::documentChildren(quint64 id) const
+{
+    // The folders are stored in the shards of all devices below them
+    if (m_sharded) {
+        QVector<quint64> children;
+        for (Transaction* tr : shardTransactions()) {
+            for (quint64 child : tr->documentChildren(id)) {
+                sortedIdInsert(children, child);
+            }
+        }
+        return children;
+    }
+
+    Q_ASSERT(m_txn);
+    Q_ASSERT(id > 0);
+
+    DocumentUrlDB docUrlDb(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
+    return docUrlDb.getChildren(id);
+}
+
 quint64 Transaction::documentId(const QByteArray& path) const
 {
+    if (m_sharded) {
+        for (Transaction* tr : shardTransactions()) {
+            if (const quint64 id = tr->documentId(path)) {
+                return id;
+            }
+        }
+        return 0;
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(!path.isEmpty());
 
@@ -129,14 +369,106 @@ quint64 Transaction::documentId(const QByteArray& path) const
 
 DocumentTimeDB::TimeInfo Transaction::documentTimeInfo(quint64 id) const
 {
+    if (m_sharded) {
+        Transaction* tr = shardTransaction(id);
+        return tr ? tr->documentTimeInfo(id) : DocumentTimeDB::TimeInfo();
+    }
+
     Q_ASSERT(m_txn);
 
     DocumentTimeDB docTimeDb(m_dbis.docTimeDbi, m_txn);
     return docTimeDb.get(id);
 }
 
+bool Transaction::documentIdRange(quint64* firstId, quint64* lastId) const
+{
+    if (m_sharded) {
+        bool found = false;
+        for (Transaction* tr : shardTransactions()) {
+            quint64 first;
+            quint64 last;
+            if (tr->documentIdRange(&first, &last)) {
+                *firstId = found ? qMin(*firstId, first) : first;
+                *lastId = found ? qMax(*lastId, last) : last;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    Q_ASSERT(m_txn);
+
+    DocumentTimeDB docTimeDb(m_dbis.docTimeDbi, m_txn);
+    return docTimeDb.idRange(firstId, lastId);
+}
+
+bool Transaction::ordinalRange(quint64* first, quint64* last) const
+{
+    if (m_sharded) {
+        bool found = false;
+        const QMap<quint32, Transaction*> shards = shardTransactions();
+        for (auto it = shards.constBegin(); it != shards.constEnd(); ++it) {
+            quint64 shardFirst;
+            quint64 shardLast;
+            if (it.value()->ordinalRange(&shardFirst, &shardLast)) {
+                const quint64 base = static_cast<quint64>(it.key()) << 32;
+                *first = found ? qMin(*first, base | shardFirst) : base | shardFirst;
+                *last = found ? qMax(*last, base | shardLast) : base | shardLast;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    Q_ASSERT(m_txn);
+
+    OrdinalDB ordinalDb(m_dbis.idOrdinalDbi, m_dbis.ordinalIdDbi, m_dbis.freeOrdinalDbi, m_txn);
+    quint32 firstOrdinal;
+    quint32 lastOrdinal;
+    if (!ordinalDb.range(&firstOrdinal, &lastOrdinal)) {
+        return false;
+    }
+    *first = firstOrdinal;
+    *last = lastOrdinal;
+    return true;
+}
+
+quint64 Transaction::ordinalToId(quint64 ordinal) const
+{
+    if (m_sharded) {
+        Transaction* tr = deviceTransaction(ordinal >> 32);
+        return tr ? tr->ordinalToId(ordinal & 0xffffffff) : 0;
+    }
+
+    Q_ASSERT(m_txn);
+    Q_ASSERT(ordinal > 0 && ordinal <= 0xffffffff);
+
+    OrdinalDB ordinalDb(m_dbis.idOrdinalDbi, m_dbis.ordinalIdDbi, m_dbis.freeOrdinalDbi, m_txn);
+    return ordinalDb.id(ordinal);
+}
+
+quint64 Transaction::idToOrdinal(quint64 id) const
+{
+    if (m_sharded) {
+        Transaction* tr = shardTransaction(id);
+        const quint64 ordinal = tr ? tr->idToOrdinal(id) : 0;
+        return ordinal ? (static_cast<quint64>(idToDeviceId(id)) << 32) | ordinal : 0;
+    }
+
+    Q_ASSERT(m_txn);
+    Q_ASSERT(id > 0);
+
+    OrdinalDB ordinalDb(m_dbis.idOrdinalDbi, m_dbis.ordinalIdDbi, m_dbis.freeOrdinalDbi, m_txn);
+    return ordinalDb.ordinal(id);
+}
+
 QByteArray Transaction::documentData(quint64 id) const
 {
+    if (m_sharded) {
+        Transaction* tr = shardTransaction(id);
+        return tr ? tr->documentData(id) : QByteArray();
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(id > 0);
 
@@ -146,6 +478,15 @@ QByteArray Transaction::documentData(quint64 id) const
 
 bool Transaction::hasChanges() const
 {
+    if (m_sharded) {
+        for (Transaction* tr : m_shards) {
+            if (tr->hasChanges()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(m_writeTrans);
     return m_writeTrans->hasChanges();
@@ -153,6 +494,18 @@ bool Transaction::hasChanges() const
 
 QVector<quint64> Transaction::fetchPhaseOneIds(int size) const
 {
+    // Taking them shard by shard keeps the batches of the extractor on one device
+    if (m_sharded) {
+        QVector<quint64> ids;
+        for (Transaction* tr : shardTransactions()) {
+            if (ids.size() == size) {
+                break;
+            }
+            ids += tr->fetchPhaseOneIds(size - ids.size());
+        }
+        return ids;
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(size > 0);
 
@@ -162,63 +515,246 @@ QVector<quint64> Transaction::fetchPhaseOneIds(int size) const
 
 QVector<QByteArray> Transaction::fetchTermsStartingWith(const QByteArray& term) const
 {
+    if (m_sharded) {
+        QVector<QByteArray> terms;
+        for (Transaction* tr : shardTransactions()) {
+            terms += tr->fetchTermsStartingWith(term);
+        }
+        std::sort(terms.begin(), terms.end());
+        terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+        return terms;
+    }
+
     Q_ASSERT(term.size() > 0);
 
     PostingDB postingDb(m_dbis.postingDbi, m_txn);
     return postingDb.fetchTermsStartingWith(term);
 }
 
+QMap<QByteArray, TagDB::TagInfo> Transaction::tagChildren(const QByteArray& parent) const
+{
+    if (m_sharded) {
+        QMap<QByteArray, TagDB::TagInfo> map;
+        for (Transaction* tr : shardTransactions()) {
+            const QMap<QByteArray, TagDB::TagInfo> children = tr->tagChildren(parent);
+            for (auto it = children.constBegin(); it != children.constEnd(); ++it) {
+                TagDB::TagInfo& info = map[it.key()];
+                info.documentCount += it.value().documentCount;
+                // The shards may share child tags, so this is a lower bound
+                info.childCount = qMax(info.childCount, it.value().childCount);
+            }
+        }
+        return map;
+    }
+
+    Q_ASSERT(m_txn);
+
+    if (m_dbis.tagDbi) {
+        TagDB tagDb(m_dbis.tagDbi, m_txn);
+        return tagDb.children(parent);
+    }
+
+    // Databases created by older versions which have only been opened read only
+    PostingDB postingDb(m_dbis.postingDbi, m_txn);
+    const QByteArray prefix = parent.isEmpty() ? QByteArray("TAG-") : "TAG-" + parent + '/';
+
+    QMap<QByteArray, TagDB::TagInfo> map;
+    QMap<QByteArray, QSet<QByteArray>> grandChildren;
+    for (const QByteArray& term : postingDb.fetchTermsStartingWith(prefix)) {
+        QByteArray child = term.mid(4);
+        QByteArray grandChild;
+        while (!child.isEmpty() && TagDB::parentTag(child) != parent) {
+            grandChild = child;
+            child = TagDB::parentTag(child);
+        }
+        if (child.isEmpty()) {
+            continue;
+        }
+
+        TagDB::TagInfo& info = map[child.mid(parent.isEmpty() ? 0 : parent.size() + 1)];
+        if (grandChild.isEmpty()) {
+            info.documentCount = postingDb.get(term).size();
+        } else {
+            QSet<QByteArray>& names = grandChildren[child];
+            names << grandChild;
+            info.childCount = names.size();
+        }
+    }
+
+    return map;
+}
+
+quint64 Transaction::snapshotId() const
+{
+    // Grows with the snapshot of any shard. Dropped shards are made up for
+    // by the base, see Database::retireShard()
+    if (m_sharded) {
+        quint64 id = m_shardsSnapshotBase;
+        for (Transaction* tr : m_shards) {
+            id += tr->snapshotId();
+        }
+        return id;
+    }
+
+    Q_ASSERT(m_txn);
+
+    return m_db.m_snapshotBase.load() + mdb_txn_id(m_txn);
+}
+
 uint Transaction::phaseOneSize() const
 {
+    if (m_sharded) {
+        uint count = 0;
+        for (Transaction* tr : shardTransactions()) {
+            count += tr->phaseOneSize();
+        }
+        return count;
+    }
+
     Q_ASSERT(m_txn);
 
+    if (m_dbis.metaDataDbi) {
+        MetaDataDB metaDataDb(m_dbis.metaDataDbi, m_txn);
+        return metaDataDb.count(phaseOneCountName);
+    }
+
     DocumentIdDB contentIndexingDb(m_dbis.contentIndexingDbi, m_txn);
     return contentIndexingDb.size();
 }
 
 uint Transaction::size() const
 {
+    if (m_sharded) {
+        uint count = 0;
+        for (Transaction* tr : shardTransactions()) {
+            count += tr->size();
+        }
+        return count;
+    }
+
     Q_ASSERT(m_txn);
 
+    if (m_dbis.metaDataDbi) {
+        MetaDataDB metaDataDb(m_dbis.metaDataDbi, m_txn);
+        return metaDataDb.count(documentCountName);
+    }
+
     DocumentDB docTermsDb(m_dbis.docTermsDbi, m_txn);
     return docTermsDb.size();
 }
 
+uint Transaction::failedSize() const
+{
+    if (m_sharded) {
+        uint count = 0;
+        for (Transaction* tr : shardTransactions()) {
+            count += tr->failedSize();
+        }
+        return count;
+    }
+
+    Q_ASSERT(m_txn);
+
+    if (m_dbis.metaDataDbi) {
+        MetaDataDB metaDataDb(m_dbis.metaDataDbi, m_txn);
+        return metaDataDb.count(failedCountName);
+    }
+
+    DocumentIdDB failedIdDb(m_dbis.failedIdDbi, m_txn);
+    return failedIdDb.size();
+}
+
+TermStatsDB::TermStats Transaction::termStats(const QByteArray& term) const
+{
+    if (m_sharded) {
+        TermStatsDB::TermStats stats;
+        const QMap<quint32, Transaction*> shards = shardTransactions();
+        for (auto it = shards.constBegin(); it != shards.constEnd(); ++it) {
+            const TermStatsDB::TermStats shardStats = it.value()->termStats(term);
+            if (!shardStats.documentCount) {
+                continue;
+            }
+            // In terms of the ordinals of the merged iterators
+            const quint64 base = static_cast<quint64>(it.key()) << 32;
+            stats.minId = stats.documentCount ? qMin(stats.minId, base | shardStats.minId) : base | shardStats.minId;
+            stats.maxId = qMax(stats.maxId, base | shardStats.maxId);
+            stats.documentCount += shardStats.documentCount;
+            stats.positionCount += shardStats.positionCount;
+        }
+        return stats;
+    }
+
+    Q_ASSERT(m_txn);
+    Q_ASSERT(!term.isEmpty());
+
+    if (!m_dbis.termStatsDbi) {
+        return TermStatsDB::TermStats();
+    }
+
+    TermStatsDB termStatsDb(m_dbis.termStatsDbi, m_txn);
+    return termStatsDb.get(term);
+}
+
 //
 // Write Operations
 //
 void Transaction::setPhaseOne(quint64 id)
 {
+    if (m_sharded) {
+        if (Transaction* tr = writeShard(idToDeviceId(id), true)) {
+            tr->setPhaseOne(id);
+        }
+        return;
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(id > 0);
     Q_ASSERT(m_writeTrans);
 
-    DocumentIdDB contentIndexingDb(m_dbis.contentIndexingDbi, m_txn);
-    contentIndexingDb.put(id);
+    m_writeTrans->setPhaseOne(id);
 }
 
 void Transaction::removePhaseOne(quint64 id)
 {
+    if (m_sharded) {
+        if (Transaction* tr = writeShard(idToDeviceId(id))) {
+            tr->removePhaseOne(id);
+        }
+        return;
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(id > 0);
     Q_ASSERT(m_writeTrans);
 
-    DocumentIdDB contentIndexingDb(m_dbis.contentIndexingDbi, m_txn);
-    contentIndexingDb.del(id);
+    m_writeTrans->removePhaseOne(id);
 }
 
 void Transaction::addFailed(quint64 id)
 {
+    if (m_sharded) {
+        if (Transaction* tr = writeShard(idToDeviceId(id), true)) {
+            tr->addFailed(id);
+        }
+        return;
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(id > 0);
     Q_ASSERT(m_writeTrans);
 
-    DocumentIdDB failedIdDb(m_dbis.failedIdDbi, m_txn);
-    failedIdDb.put(id);
+    m_writeTrans->addFailed(id);
 }
 
 void Transaction::addDocument(const Document& doc)
 {
+    if (m_sharded) {
+        if (Transaction* tr = writeShard(idToDeviceId(doc.id()), true)) {
+            tr->addDocument(doc);
+        }
+        return;
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(doc.id() > 0);
     Q_ASSERT(m_writeTrans);
@@ -228,6 +764,13 @@ void Transaction::addDocument(const Document& doc)
 
 void Transaction::removeDocument(quint64 id)
 {
+    if (m_sharded) {
+        if (Transaction* tr = writeShard(idToDeviceId(id))) {
+            tr->removeDocument(id);
+        }
+        return;
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(id > 0);
     Q_ASSERT(m_writeTrans);
@@ -237,6 +780,14 @@ void Transaction::removeDocument(quint64 id)
 
 void Transaction::removeRecursively(quint64 id)
 {
+    // The folders are stored in the shards of all devices below them
+    if (m_sharded) {
+        for (Transaction* tr : writeShards(id)) {
+            tr->removeRecursively(id);
+        }
+        return;
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(id > 0);
     Q_ASSERT(m_writeTrans);
@@ -244,8 +795,31 @@ void Transaction::removeRecursively(quint64 id)
     m_writeTrans->removeRecursively(id);
 }
 
+bool Transaction::reorderDocuments()
+{
+    if (m_sharded) {
+        bool reordered = false;
+        for (Transaction* tr : writeShards()) {
+            reordered = tr->reorderDocuments() || reordered;
+        }
+        return reordered;
+    }
+
+    Q_ASSERT(m_txn);
+    Q_ASSERT(m_writeTrans);
+
+    return m_writeTrans->reorderDocuments();
+}
+
 void Transaction::replaceDocument(const Document& doc, DocumentOperations operations)
 {
+    if (m_sharded) {
+        if (Transaction* tr = writeShard(idToDeviceId(doc.id()))) {
+            tr->replaceDocument(doc, operations);
+        }
+        return;
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(doc.id() > 0);
     Q_ASSERT(m_writeTrans);
@@ -256,10 +830,45 @@ void Transaction::replaceDocument(const Document& doc, DocumentOperations operat
 
 void Transaction::commit()
 {
+    if (m_sharded) {
+        for (Transaction* tr : m_shards) {
+            tr->commit();
+        }
+        qDeleteAll(m_shards);
+        m_shards.clear();
+        for (Transaction* tr : m_readShards) {
+            tr->abort();
+        }
+        qDeleteAll(m_readShards);
+        m_readShards.clear();
+
+        Database::unlockWriters(m_writersFd);
+        m_writersFd = -1;
+        return;
+    }
+
     Q_ASSERT(m_txn);
     Q_ASSERT(m_writeTrans);
 
-    m_writeTrans->commit();
+    QElapsedTimer timer;
+    timer.start();
+
+    MDB_envinfo info;
+    mdb_env_info(m_env, &info);
+    const size_t lastPage = info.me_last_pgno;
+
+    // The resident id sets follow the commit if they are those of the
+    // snapshot it builds on
+    const quint64 txnId = mdb_txn_id(m_txn);
+    ResidentIdSets* idSets = m_db.m_idSets;
+    const bool updateIdSets = idSets && idSets->txnId() == txnId - 1;
+    ResidentIdSets::Changes idChanges;
+    if (updateIdSets) {
+        idChanges = m_writeTrans->residentIdChanges();
+    }
+
+    EngineMetrics::CommitStats stats;
+    m_writeTrans->commit(&stats);
     delete m_writeTrans;
     m_writeTrans = nullptr;
 
@@ -267,13 +876,44 @@ void Transaction::commit()
     Q_ASSERT_X(rc == 0, "Transaction::commit", mdb_strerror(rc));
 
     m_txn = nullptr;
+
+    // A commit without changes does not get a transaction id
+    mdb_env_info(m_env, &info);
+    if (updateIdSets && rc == 0 && info.me_last_txnid >= txnId) {
+        idSets->update(txnId, idChanges);
+    }
+
+    stats.pages = info.me_last_pgno > lastPage ? info.me_last_pgno - lastPage : 0;
+    stats.usecs = timer.nsecsElapsed() / 1000;
+    EngineMetrics::instance()->recordCommit(stats);
 }
 
 void Transaction::abort()
 {
+    if (m_sharded) {
+        for (Transaction* tr : m_shards) {
+            tr->abort();
+        }
+        qDeleteAll(m_shards);
+        m_shards.clear();
+        for (Transaction* tr : m_readShards) {
+            tr->abort();
+        }
+        qDeleteAll(m_readShards);
+        m_readShards.clear();
+
+        Database::unlockWriters(m_writersFd);
+        m_writersFd = -1;
+        return;
+    }
+
     Q_ASSERT(m_txn);
 
-    mdb_txn_abort(m_txn);
+    if (m_writeTrans) {
+        mdb_txn_abort(m_txn);
+    } else {
+        m_db.releaseReadTransaction(m_txn);
+    }
     m_txn = nullptr;
 
     delete m_writeTrans;
@@ -284,16 +924,94 @@ void Transaction::abort()
 // Queries
 //
 
+/**
+ * Returns the sub queries of the And/Or \p query with nested queries of the
+ * same kind pulled up and duplicates removed, so that each term is only
+ * fetched once and the AndPostingIterator can order all of them by size.
+ */
+static QVector<EngineQuery> flattenedSubQueries(const EngineQuery& query)
+{
+    auto isDuplicate = [](const QVector<EngineQuery>& queries, const EngineQuery& q) {
+        for (const EngineQuery& existing : queries) {
+            if (existing.term() == q.term() && existing.op() == q.op() && existing.subQueries() == q.subQueries()) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    QVector<EngineQuery> result;
+    QVector<EngineQuery> pending = query.subQueries();
+    while (!pending.isEmpty()) {
+        const EngineQuery q = pending.takeFirst();
+        if (!q.leaf() && q.op() == query.op()) {
+            pending = q.subQueries() + pending;
+            continue;
+        }
+        if (!isDuplicate(result, q)) {
+            result << q;
+        }
+    }
+
+    return result;
+}
+
+PostingIterator* Transaction::profiled(PostingIterator* it, const QByteArray& name,
+                                       const QVector<PostingIterator*>& children) const
+{
+    Q_ASSERT(m_profile);
+    return m_profile->wrap(it, name, children);
+}
+
+/**
+ * Merges the iterators returned by \p iter for every shard. Each document
+ * is stored in one shard only, so once the ordinals are tagged with their
+ * device this is a plain union.
+ */
+static PostingIterator* mergeShards(const QMap<quint32, Transaction*>& shards, QueryProfile* profile,
+                                    const std::function<PostingIterator* (Transaction*)>& iter)
+{
+    QVector<PostingIterator*> vec;
+    for (auto shard = shards.constBegin(); shard != shards.constEnd(); ++shard) {
+        if (PostingIterator* it = iter(shard.value())) {
+            vec << new ShardPostingIterator(it, shard.key());
+        }
+    }
+
+    if (vec.size() < 2) {
+        return vec.value(0);
+    }
+    if (profile) {
+        return profile->create<OrPostingIterator>("SHARDS", vec);
+    }
+    return new OrPostingIterator(vec);
+}
+
 PostingIterator* Transaction::postingIterator(const EngineQuery& query) const
 {
+    if (m_sharded) {
+        return mergeShards(shardTransactions(), m_profile, [&query](Transaction* tr) {
+            return tr->postingIterator(query);
+        });
+    }
+
     PostingDB postingDb(m_dbis.postingDbi, m_txn);
     PositionDB positionDb(m_dbis.positionDBi, m_txn);
+    if (!m_writeTrans) {
+        postingDb.setCache(PostingCache::instance());
+    }
+    if (m_profile) {
+        postingDb.setCounters(m_profile->dbCounters());
+        positionDb.setCounters(m_profile->dbCounters());
+    }
 
     if (query.leaf()) {
         if (query.op() == EngineQuery::Equal) {
-            return postingDb.iter(query.term());
+            PostingIterator* it = postingDb.iter(query.term());
+            return m_profile ? profiled(it, "TERM " + query.term()) : it;
         } else if (query.op() == EngineQuery::StartsWith) {
-            return postingDb.prefixIter(query.term());
+            PostingIterator* it = postingDb.prefixIter(query.term());
+            return m_profile ? profiled(it, "PREFIX " + query.term()) : it;
         } else {
             Q_ASSERT(0);
         }
@@ -309,19 +1027,29 @@ PostingIterator* Transaction::postingIterator(const EngineQuery& query) const
     if (query.op() == EngineQuery::Phrase) {
         for (const EngineQuery& q : query.subQueries()) {
             Q_ASSERT_X(q.leaf(), "Transaction::toPostingIterator", "Phrase queries must contain leaf queries");
-            vec << positionDb.iter(q.term());
+            PostingIterator* it = positionDb.iter(q.term());
+            vec << (m_profile ? profiled(it, "POSITIONS " + q.term()) : it);
         }
 
+        if (m_profile) {
+            return m_profile->create<PhraseAndIterator>("PHRASE", vec);
+        }
         return new PhraseAndIterator(vec);
     }
 
-    for (const EngineQuery& q : query.subQueries()) {
+    for (const EngineQuery& q : flattenedSubQueries(query)) {
         vec << postingIterator(q);
     }
 
     if (query.op() == EngineQuery::And) {
+        if (m_profile) {
+            return m_profile->create<AndPostingIterator>("AND", vec);
+        }
         return new AndPostingIterator(vec);
     } else if (query.op() == EngineQuery::Or) {
+        if (m_profile) {
+            return m_profile->create<OrPostingIterator>("OR", vec);
+        }
         return new OrPostingIterator(vec);
     }
 
@@ -331,31 +1059,214 @@ PostingIterator* Transaction::postingIterator(const EngineQuery& query) const
 
 PostingIterator* Transaction::postingCompIterator(const QByteArray& prefix, const QByteArray& value, PostingDB::Comparator com) const
 {
+    if (m_sharded) {
+        return mergeShards(shardTransactions(), m_profile, [&](Transaction* tr) {
+            return tr->postingCompIterator(prefix, value, com);
+        });
+    }
+
     PostingDB postingDb(m_dbis.postingDbi, m_txn);
-    return postingDb.compIter(prefix, value, com);
+    if (!m_writeTrans) {
+        postingDb.setCache(PostingCache::instance());
+    }
+    if (m_profile) {
+        postingDb.setCounters(m_profile->dbCounters());
+    }
+
+    PostingIterator* it = postingDb.compIter(prefix, value, com);
+    if (m_profile) {
+        const QByteArray op = com == PostingDB::LessEqual ? " <= " : " >= ";
+        return profiled(it, "COMPARE " + prefix + op + value);
+    }
+    return it;
 }
 
 PostingIterator* Transaction::mTimeIter(quint32 mtime, MTimeDB::Comparator com) const
 {
+    if (m_sharded) {
+        return mergeShards(shardTransactions(), m_profile, [=](Transaction* tr) {
+            return tr->mTimeIter(mtime, com);
+        });
+    }
+
     MTimeDB mTimeDb(m_dbis.mtimeDbi, m_txn);
-    return mTimeDb.iter(mtime, com);
+    PostingIterator* it = mTimeDb.iter(mtime, com);
+    return m_profile ? profiled(it, "MTIME " + QByteArray::number(mtime)) : it;
 }
 
 PostingIterator* Transaction::mTimeRangeIter(quint32 beginTime, quint32 endTime) const
 {
+    if (m_sharded) {
+        return mergeShards(shardTransactions(), m_profile, [=](Transaction* tr) {
+            return tr->mTimeRangeIter(beginTime, endTime);
+        });
+    }
+
+    MTimeDB mTimeDb(m_dbis.mtimeDbi, m_txn);
+    PostingIterator* it = mTimeDb.iterRange(beginTime, endTime);
+    if (m_profile) {
+        return profiled(it, "MTIME " + QByteArray::number(beginTime) + ".." + QByteArray::number(endTime));
+    }
+    return it;
+}
+
+QMap<QDate, uint> Transaction::mTimeHistogram(quint32 beginTime, quint32 endTime, MTimeDB::Granularity granularity,
+                                              const QVector<quint64>* ids) const
+{
+    Q_ASSERT(m_txn || m_sharded);
+    Q_ASSERT(beginTime <= endTime);
+
+    if (m_sharded) {
+        QMap<QDate, uint> histogram;
+        const QMap<quint32, Transaction*> shards = shardTransactions();
+        for (auto shard = shards.constBegin(); shard != shards.constEnd(); ++shard) {
+            // The ordinals of a shard share the device id in the high word
+            QVector<quint64> shardIds;
+            if (ids) {
+                const quint64 base = static_cast<quint64>(shard.key()) << 32;
+                auto it = std::lower_bound(ids->constBegin(), ids->constEnd(), base);
+                for (; it != ids->constEnd() && (*it >> 32) == shard.key(); ++it) {
+                    shardIds << (*it & 0xffffffff);
+                }
+            }
+
+            Transaction* tr = shard.value();
+            const QMap<QDate, uint> shardHistogram = tr->mTimeHistogram(beginTime, endTime, granularity,
+                                                                        ids ? &shardIds : nullptr);
+            for (auto it = shardHistogram.constBegin(); it != shardHistogram.constEnd(); ++it) {
+                histogram[it.key()] += it.value();
+            }
+        }
+        return histogram;
+    }
+
     MTimeDB mTimeDb(m_dbis.mtimeDbi, m_txn);
-    return mTimeDb.iterRange(beginTime, endTime);
+    return mTimeDb.histogram(beginTime, endTime, granularity, ids);
 }
 
 PostingIterator* Transaction::docUrlIter(quint64 id) const
 {
+    // The folders are stored in the shards of all devices below them
+    if (m_sharded) {
+        return mergeShards(shardTransactions(), m_profile, [id](Transaction* tr) {
+            return tr->docUrlIter(id);
+        });
+    }
+
     DocumentUrlDB docUrlDb(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
-    return docUrlDb.iter(id);
+    QScopedPointer<PostingIterator> idIt(docUrlDb.iter(id));
+    if (!idIt) {
+        return nullptr;
+    }
+
+    // The folder tree is kept by id, the folders which are only known as
+    // parents have no ordinal and are not documents of their own
+    OrdinalDB ordinalDb(m_dbis.idOrdinalDbi, m_dbis.ordinalIdDbi, m_dbis.freeOrdinalDbi, m_txn);
+    QVector<quint64> ordinals;
+    while (const quint64 docId = idIt->next()) {
+        if (const quint32 ordinal = ordinalDb.ordinal(docId)) {
+            ordinals << ordinal;
+        }
+    }
+    std::sort(ordinals.begin(), ordinals.end());
+
+    PostingIterator* it = new VectorPostingIterator(ordinals);
+    return m_profile ? profiled(it, "FOLDER " + docUrlDb.get(id)) : it;
+}
+
+PostingIterator* Transaction::docUrlFilterIter(PostingIterator* it, quint64 id, bool exclude) const
+{
+    if (!it) {
+        return nullptr;
+    }
+
+    auto isInside = [id, exclude](IdFilenameDB& idFilenameDb, quint64 docId) {
+        while (docId) {
+            if (docId == id) {
+                return !exclude;
+            }
+            docId = idFilenameDb.get(docId).parentId;
+        }
+        return exclude;
+    };
+
+    FilterPostingIterator::Filter filter;
+    if (m_sharded) {
+        // The parents of a document are stored in its own shard
+        filter = [this, isInside, exclude](quint64 ordinal) {
+            Transaction* tr = deviceTransaction(ordinal >> 32);
+            if (!tr) {
+                return exclude;
+            }
+            IdFilenameDB idFilenameDb(tr->m_dbis.idFilenameDbi, tr->m_txn);
+            return isInside(idFilenameDb, tr->ordinalToId(ordinal & 0xffffffff));
+        };
+    } else {
+        IdFilenameDB idFilenameDb(m_dbis.idFilenameDbi, m_txn);
+        OrdinalDB ordinalDb(m_dbis.idOrdinalDbi, m_dbis.ordinalIdDbi, m_dbis.freeOrdinalDbi, m_txn);
+        filter = [idFilenameDb, ordinalDb, isInside](quint64 ordinal) mutable {
+            return isInside(idFilenameDb, ordinalDb.id(ordinal));
+        };
+    }
+
+    if (m_profile) {
+        const QByteArray name = (exclude ? "NOT FOLDER FILTER " : "FOLDER FILTER ") + documentUrl(id);
+        return m_profile->wrap(new FilterPostingIterator(it, filter), name, {it});
+    }
+    return new FilterPostingIterator(it, filter);
+}
+
+PostingIterator* Transaction::mTimeRangeFilterIter(PostingIterator* it, quint32 beginTime, quint32 endTime,
+                                                   bool exclude) const
+{
+    if (!it) {
+        return nullptr;
+    }
+
+    FilterPostingIterator::Filter filter;
+    if (m_sharded) {
+        filter = [this, beginTime, endTime, exclude](quint64 ordinal) {
+            const quint64 docId = ordinalToId(ordinal);
+            const quint32 mTime = docId ? documentTimeInfo(docId).mTime : 0;
+            return (mTime >= beginTime && mTime <= endTime) != exclude;
+        };
+    } else {
+        DocumentTimeDB docTimeDb(m_dbis.docTimeDbi, m_txn);
+        OrdinalDB ordinalDb(m_dbis.idOrdinalDbi, m_dbis.ordinalIdDbi, m_dbis.freeOrdinalDbi, m_txn);
+        filter = [docTimeDb, ordinalDb, beginTime, endTime, exclude](quint64 ordinal) mutable {
+            const quint64 docId = ordinalDb.id(ordinal);
+            const quint32 mTime = docId ? docTimeDb.get(docId).mTime : 0;
+            return (mTime >= beginTime && mTime <= endTime) != exclude;
+        };
+    }
+
+    if (m_profile) {
+        const QByteArray name = (exclude ? "NOT MTIME FILTER " : "MTIME FILTER ")
+            + QByteArray::number(beginTime) + ".." + QByteArray::number(endTime);
+        return m_profile->wrap(new FilterPostingIterator(it, filter), name, {it});
+    }
+    return new FilterPostingIterator(it, filter);
+}
+
+void Transaction::setQueryProfile(QueryProfile* profile)
+{
+    m_profile = profile;
+    for (Transaction* tr : m_shards) {
+        tr->setQueryProfile(profile);
+    }
+    for (Transaction* tr : m_readShards) {
+        tr->setQueryProfile(profile);
+    }
+}
+
+QueryProfile* Transaction::queryProfile() const
+{
+    return m_profile;
 }
 
 QVector<quint64> Transaction::exec(const EngineQuery& query, int limit) const
 {
-    Q_ASSERT(m_txn);
+    Q_ASSERT(m_txn || m_sharded);
 
     QVector<quint64> results;
     PostingIterator* it = postingIterator(query);
@@ -364,10 +1275,14 @@ QVector<quint64> Transaction::exec(const EngineQuery& query, int limit) const
     }
 
     while (it->next() && limit) {
-        results << it->docId();
+        if (const quint64 id = ordinalToId(it->docId())) {
+            results << id;
+        }
         limit--;
     }
+    delete it;
 
+    std::sort(results.begin(), results.end());
     return results;
 }
 
@@ -377,6 +1292,11 @@ QVector<quint64> Transaction::exec(const EngineQuery& query, int limit) const
 
 QVector<QByteArray> Transaction::documentTerms(quint64 docId) const
 {
+    if (m_sharded) {
+        Transaction* tr = shardTransaction(docId);
+        return tr ? tr->documentTerms(docId) : QVector<QByteArray>();
+    }
+
     Q_ASSERT(docId);
 
     DocumentDB documentTermsDB(m_dbis.docTermsDbi, m_txn);
@@ -385,6 +1305,11 @@ QVector<QByteArray> Transaction::documentTerms(quint64 docId) const
 
 QVector<QByteArray> Transaction::documentFileNameTerms(quint64 docId) const
 {
+    if (m_sharded) {
+        Transaction* tr = shardTransaction(docId);
+        return tr ? tr->documentFileNameTerms(docId) : QVector<QByteArray>();
+    }
+
     Q_ASSERT(docId);
 
     DocumentDB documentFileNameTermsDB(m_dbis.docFilenameTermsDbi, m_txn);
@@ -393,6 +1318,11 @@ QVector<QByteArray> Transaction::documentFileNameTerms(quint64 docId) const
 
 QVector<QByteArray> Transaction::documentXattrTerms(quint64 docId) const
 {
+    if (m_sharded) {
+        Transaction* tr = shardTransaction(docId);
+        return tr ? tr->documentXattrTerms(docId) : QVector<QByteArray>();
+    }
+
     Q_ASSERT(docId);
 
     DocumentDB documentXattrTermsDB(m_dbis.docXattrTermsDbi, m_txn);
@@ -404,6 +1334,11 @@ QVector<QByteArray> Transaction::documentXattrTerms(quint64 docId) const
 //
 static size_t dbiSize(MDB_txn* txn, MDB_dbi dbi)
 {
+    // The optional databases are 0 when missing, which is the free list
+    if (!dbi) {
+        return 0;
+    }
+
     MDB_stat stat;
     mdb_stat(txn, dbi, &stat);
 
@@ -412,6 +1347,32 @@ static size_t dbiSize(MDB_txn* txn, MDB_dbi dbi)
 
 DatabaseSize Transaction::dbSize()
 {
+    if (m_sharded) {
+        DatabaseSize dbSize = DatabaseSize();
+        for (Transaction* tr : shardTransactions()) {
+            const DatabaseSize shardSize = tr->dbSize();
+            dbSize.expectedSize += shardSize.expectedSize;
+            dbSize.actualSize += shardSize.actualSize;
+            dbSize.postingDb += shardSize.postingDb;
+            dbSize.positionDb += shardSize.positionDb;
+            dbSize.docTerms += shardSize.docTerms;
+            dbSize.docFilenameTerms += shardSize.docFilenameTerms;
+            dbSize.docXattrTerms += shardSize.docXattrTerms;
+            dbSize.idTree += shardSize.idTree;
+            dbSize.idFilename += shardSize.idFilename;
+            dbSize.docTime += shardSize.docTime;
+            dbSize.docData += shardSize.docData;
+            dbSize.contentIndexingIds += shardSize.contentIndexingIds;
+            dbSize.failedIds += shardSize.failedIds;
+            dbSize.mtimeDb += shardSize.mtimeDb;
+            dbSize.ordinalDb += shardSize.ordinalDb;
+            dbSize.termStatsDb += shardSize.termStatsDb;
+            dbSize.metaDataDb += shardSize.metaDataDb;
+            dbSize.tagDb += shardSize.tagDb;
+        }
+        return dbSize;
+    }
+
     DatabaseSize dbSize;
     dbSize.postingDb = dbiSize(m_txn, m_dbis.postingDbi);
     dbSize.positionDb = dbiSize(m_txn, m_dbis.positionDBi);
@@ -429,155 +1390,234 @@ DatabaseSize Transaction::dbSize()
     dbSize.failedIds = dbiSize(m_txn, m_dbis.failedIdDbi);
 
     dbSize.mtimeDb = dbiSize(m_txn, m_dbis.mtimeDbi);
+    dbSize.ordinalDb = dbiSize(m_txn, m_dbis.idOrdinalDbi) + dbiSize(m_txn, m_dbis.ordinalIdDbi)
+                     + dbiSize(m_txn, m_dbis.freeOrdinalDbi);
+
+    dbSize.termStatsDb = dbiSize(m_txn, m_dbis.termStatsDbi);
+    dbSize.metaDataDb = dbiSize(m_txn, m_dbis.metaDataDbi);
+    dbSize.tagDb = dbiSize(m_txn, m_dbis.tagDbi);
 
-    dbSize.expectedSize = dbSize.positionDb + dbSize.positionDb + dbSize.docTerms + dbSize.docFilenameTerms
+    dbSize.expectedSize = dbSize.postingDb + dbSize.positionDb + dbSize.docTerms + dbSize.docFilenameTerms
                   + dbSize.docXattrTerms + dbSize.idTree + dbSize.idFilename + dbSize.docTime
-                  + dbSize.docData + dbSize.contentIndexingIds + dbSize.failedIds + dbSize.mtimeDb;
+                  + dbSize.docData + dbSize.contentIndexingIds + dbSize.failedIds + dbSize.mtimeDb
+                  + dbSize.ordinalDb + dbSize.termStatsDb + dbSize.metaDataDb + dbSize.tagDb;
 
+    MDB_stat stat;
+    mdb_env_stat(m_env, &stat);
+
+    // Page numbers start at 0
     MDB_envinfo info;
     mdb_env_info(m_env, &info);
-    dbSize.actualSize = info.me_last_pgno * 4096; // TODO: separate page size
+    dbSize.actualSize = (info.me_last_pgno + 1) * stat.ms_psize;
 
     return dbSize;
 }
 
 //
-// Debugging
+// Storage Report
 //
-void Transaction::checkFsTree()
-{
-    DocumentDB documentTermsDB(m_dbis.docTermsDbi, m_txn);
-    DocumentDB documentXattrTermsDB(m_dbis.docXattrTermsDbi, m_txn);
-    DocumentDB documentFileNameTermsDB(m_dbis.docFilenameTermsDbi, m_txn);
-    DocumentUrlDB docUrlDb(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
-    PostingDB postingDb(m_dbis.postingDbi, m_txn);
 
-    auto map = postingDb.toTestMap();
+// Mirrors the node layout of LMDB, which does not export it: a value goes
+// to overflow pages when its node does not fit into half a page
+static const size_t s_pageHeaderSize = 16;
+static const size_t s_nodeHeaderSize = 8;
 
-    QSet<quint64> allIds;
-    Q_FOREACH (const auto& list, map) {
-        for (quint64 id : list) {
-            allIds << id;
-        }
+static size_t overflowPageCount(size_t pageSize, size_t keySize, size_t valueSize)
+{
+    const size_t nodeMax = (((pageSize - s_pageHeaderSize) / 2) & ~size_t(1)) - sizeof(quint16);
+    if (s_nodeHeaderSize + keySize + valueSize <= nodeMax) {
+        return 0;
     }
+    return (s_pageHeaderSize + valueSize + pageSize - 1) / pageSize;
+}
 
-    QTextStream out(stdout);
-    out << "Total Document IDs: " << allIds.size() << endl;
+static StorageReport::Dbi dbiReport(MDB_txn* txn, MDB_dbi dbi, const char* name, int largestValueCount)
+{
+    StorageReport::Dbi report;
+    report.name = name;
 
-    int count = 0;
-    for (quint64 id: allIds) {
-        QByteArray url = docUrlDb.get(id);
-        if (url.isEmpty()) {
-            auto terms = documentTermsDB.get(id);
-            auto fileNameTerms = documentFileNameTermsDB.get(id);
-            auto xAttrTerms = documentXattrTermsDB.get(id);
+    MDB_stat stat;
+    int rc = mdb_stat(txn, dbi, &stat);
+    Q_ASSERT_X(rc == 0, "Transaction::storageReport", mdb_strerror(rc));
+
+    report.entries = stat.ms_entries;
+    report.depth = stat.ms_depth;
+    report.branchPages = stat.ms_branch_pages;
+    report.leafPages = stat.ms_leaf_pages;
+    report.overflowPages = stat.ms_overflow_pages;
+
+    // The duplicates of a DUPSORT database are stored in sub pages, never on overflow pages
+    unsigned int flags = 0;
+    mdb_dbi_flags(txn, dbi, &flags);
+    if (flags & MDB_DUPSORT) {
+        return report;
+    }
 
-            // Lets reverse enginer the terms
-            QList<QByteArray> newTerms;
-            QMapIterator<QByteArray, PostingList> it(map);
-            while (it.hasNext()) {
-                it.next();
-                if (it.value().contains(id)) {
-                    newTerms << it.key();
-                }
-            }
+    const auto largerThan = [](const StorageReport::Value& value, size_t size) {
+        return value.size > size;
+    };
 
-            out << "Missing filePath for " << id << endl;
-            out << "\tPostingDB Terms: ";
-            for (const QByteArray& term : newTerms) {
-                out << term << " ";
-            }
-            out << endl;
+    MDB_cursor* cursor;
+    rc = mdb_cursor_open(txn, dbi, &cursor);
+    Q_ASSERT_X(rc == 0, "Transaction::storageReport", mdb_strerror(rc));
 
-            out << "\tDocumentTermsDB: ";
-            for (const QByteArray& term : terms) {
-                out << term << " ";
-            }
-            out << endl;
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        const size_t overflowPages = overflowPageCount(stat.ms_psize, key.mv_size, val.mv_size);
+        if (overflowPages) {
+            report.overflowValues++;
+        }
 
-            out << "\tFileNameTermsDB: ";
-            for (const QByteArray& term : terms) {
-                out << term << " ";
-            }
-            out << endl;
+        QVector<StorageReport::Value>& largest = report.largestValues;
+        if (largest.size() == largestValueCount && (largest.isEmpty() || largest.last().size >= val.mv_size)) {
+            continue;
+        }
 
-            out << "\tXAttrTermsDB: ";
-            for (const QByteArray& term : terms) {
-                out << term << " ";
-            }
-            out << endl;
+        StorageReport::Value value;
+        if ((flags & MDB_INTEGERKEY) && key.mv_size == sizeof(quint64)) {
+            value.key = QByteArray::number(*static_cast<quint64*>(key.mv_data));
+        } else if ((flags & MDB_INTEGERKEY) && key.mv_size == sizeof(quint32)) {
+            value.key = QByteArray::number(*static_cast<quint32*>(key.mv_data));
+        } else {
+            value.key = QByteArray(static_cast<char*>(key.mv_data), key.mv_size);
+        }
+        value.size = val.mv_size;
+        value.overflowPages = overflowPages;
 
-            count++;
+        largest.insert(std::lower_bound(largest.begin(), largest.end(), value.size, largerThan), value);
+        if (largest.size() > largestValueCount) {
+            largest.removeLast();
         }
     }
+    mdb_cursor_close(cursor);
 
-    out << "Invalid Entries: " << count << " (" << count * 100.0 / allIds.size() << "%)" << endl;
+    return report;
 }
 
-void Transaction::checkTermsDbinPostingDb()
+size_t Transaction::freePageCount(size_t* usedPages) const
 {
-    DocumentDB documentTermsDB(m_dbis.docTermsDbi, m_txn);
-    DocumentDB documentXattrTermsDB(m_dbis.docXattrTermsDbi, m_txn);
-    DocumentDB documentFileNameTermsDB(m_dbis.docFilenameTermsDbi, m_txn);
-    PostingDB postingDb(m_dbis.postingDbi, m_txn);
-
-    // Iterate over each document, and fetch all terms
-    // check if each term maps to its own id in the posting db
+    if (m_sharded) {
+        size_t freePages = 0;
+        if (usedPages) {
+            *usedPages = 0;
+        }
+        for (Transaction* tr : shardTransactions()) {
+            size_t shardPages = 0;
+            freePages += tr->freePageCount(&shardPages);
+            if (usedPages) {
+                *usedPages += shardPages;
+            }
+        }
+        return freePages;
+    }
 
-    auto map = postingDb.toTestMap();
+    Q_ASSERT(m_txn);
 
-    QSet<quint64> allIds;
-    Q_FOREACH (const auto& list, map) {
-        for (quint64 id : list) {
-            allIds << id;
-        }
+    if (usedPages) {
+        MDB_envinfo info;
+        mdb_env_info(m_env, &info);
+        *usedPages = info.me_last_pgno + 1;
     }
 
-    QTextStream out(stdout);
-    out << "PostingDB check .." << endl;
-    for (quint64 id : allIds) {
-        QVector<QByteArray> terms = documentTermsDB.get(id);
-        terms += documentXattrTermsDB.get(id);
-        terms += documentFileNameTermsDB.get(id);
+    // The free list is the database 0, each value is a list of page
+    // numbers prefixed with its length
+    MDB_cursor* cursor;
+    int rc = mdb_cursor_open(m_txn, 0, &cursor);
+    Q_ASSERT_X(rc == 0, "Transaction::freePageCount", mdb_strerror(rc));
+    if (rc) {
+        return 0;
+    }
 
-        for (const QByteArray& term : terms) {
-            PostingList plist = postingDb.get(term);
-            if (!plist.contains(id)) {
-                out << id << " is missing term " << term << endl;
-            }
-        }
+    size_t freePages = 0;
+    MDB_val key;
+    MDB_val val;
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        freePages += *static_cast<size_t*>(val.mv_data);
     }
+    mdb_cursor_close(cursor);
+
+    return freePages;
 }
 
-void Transaction::checkPostingDbinTermsDb()
+StorageReport Transaction::storageReport(int largestValueCount) const
 {
-    DocumentDB documentTermsDB(m_dbis.docTermsDbi, m_txn);
-    DocumentDB documentXattrTermsDB(m_dbis.docXattrTermsDbi, m_txn);
-    DocumentDB documentFileNameTermsDB(m_dbis.docFilenameTermsDbi, m_txn);
-    PostingDB postingDb(m_dbis.postingDbi, m_txn);
-
-    QMap<QByteArray, PostingList> map = postingDb.toTestMap();
-    QMapIterator<QByteArray, PostingList> it(map);
+    Q_ASSERT(largestValueCount >= 0);
+
+    StorageReport report;
+
+    // The databases of the shards are reported as one
+    if (m_sharded) {
+        const auto largerThan = [](const StorageReport::Value& lhs, const StorageReport::Value& rhs) {
+            return lhs.size > rhs.size;
+        };
+
+        for (Transaction* tr : shardTransactions()) {
+            const StorageReport shardReport = tr->storageReport(largestValueCount);
+            report.pageSize = shardReport.pageSize;
+            report.mapSize += shardReport.mapSize;
+            report.usedPages += shardReport.usedPages;
+            report.freePages += shardReport.freePages;
+
+            for (const StorageReport::Dbi& shardDbi : shardReport.dbis) {
+                auto dbi = std::find_if(report.dbis.begin(), report.dbis.end(), [&shardDbi](const StorageReport::Dbi& d) {
+                    return d.name == shardDbi.name;
+                });
+                if (dbi == report.dbis.end()) {
+                    report.dbis << shardDbi;
+                    continue;
+                }
 
-    QTextStream out(stdout);
-    out << "DocumentTermsDB check .." << endl;
-    while (it.hasNext()) {
-        it.next();
+                dbi->entries += shardDbi.entries;
+                dbi->depth = qMax(dbi->depth, shardDbi.depth);
+                dbi->branchPages += shardDbi.branchPages;
+                dbi->leafPages += shardDbi.leafPages;
+                dbi->overflowPages += shardDbi.overflowPages;
+                dbi->overflowValues += shardDbi.overflowValues;
 
-        const QByteArray term = it.key();
-        const PostingList list = it.value();
-        for (quint64 id : list) {
-            if (documentTermsDB.get(id).contains(term)) {
-                continue;
+                dbi->largestValues += shardDbi.largestValues;
+                std::stable_sort(dbi->largestValues.begin(), dbi->largestValues.end(), largerThan);
+                dbi->largestValues.resize(qMin(dbi->largestValues.size(), largestValueCount));
             }
-            if (documentFileNameTermsDB.get(id).contains(term)) {
-                continue;
-            }
-            if (documentXattrTermsDB.get(id).contains(term)) {
-                continue;
-            }
-            out << id << " is missing " << QString::fromUtf8(term) << " from document terms db" << endl;
         }
+        return report;
     }
-}
 
+    MDB_stat stat;
+    mdb_env_stat(m_env, &stat);
+    report.pageSize = stat.ms_psize;
+
+    MDB_envinfo info;
+    mdb_env_info(m_env, &info);
+    report.mapSize = info.me_mapsize;
+    report.freePages = freePageCount(&report.usedPages);
+
+    const QVector<QPair<MDB_dbi, const char*>> dbis = {
+        {m_dbis.postingDbi, "postingdb"},
+        {m_dbis.positionDBi, "positiondb"},
+        {m_dbis.docTermsDbi, "docterms"},
+        {m_dbis.docFilenameTermsDbi, "docfilenameterms"},
+        {m_dbis.docXattrTermsDbi, "docxatrrterms"},
+        {m_dbis.idTreeDbi, "idtree"},
+        {m_dbis.idFilenameDbi, "idfilename"},
+        {m_dbis.docTimeDbi, "documenttimedb"},
+        {m_dbis.docDataDbi, "documentdatadb"},
+        {m_dbis.contentIndexingDbi, "indexingleveldb"},
+        {m_dbis.failedIdDbi, "failediddb"},
+        {m_dbis.mtimeDbi, "mtimedb"},
+        {m_dbis.idOrdinalDbi, "idordinaldb"},
+        {m_dbis.ordinalIdDbi, "ordinaliddb"},
+        {m_dbis.freeOrdinalDbi, "freeordinaldb"},
+        {m_dbis.termStatsDbi, "termstatsdb"},
+        {m_dbis.metaDataDbi, "metadatadb"},
+        {m_dbis.tagDbi, "tagdb"},
+    };
+
+    for (const auto& dbi : dbis) {
+        if (dbi.first) {
+            report.dbis << dbiReport(m_txn, dbi.first, dbi.second, largestValueCount);
+        }
+    }
+
+    return report;
+}
@@ -26,7 +26,10 @@
 #include "postingdb.h"
 #include "writetransaction.h"
 #include "documenttimedb.h"
+#include "termstatsdb.h"
+#include "tagdb.h"
 
+#include <QMap>
 #include <QString>
 #include <lmdb.h>
 
@@ -37,8 +40,23 @@ class Document;
 class PostingIterator;
 class EngineQuery;
 class DatabaseSize;
+class StorageReport;
 class DBState;
+class QueryProfile;
 
+/**
+ * The posting iterators yield the dense ordinals the documents are stored
+ * under rather than their ids, see OrdinalDB. ordinalToId() turns them into
+ * ids, exec() does so for its results.
+ *
+ * On a sharded Database every call is routed to the shard of the device of
+ * the document id, or made on all shards and merged. The ordinals of the
+ * merged iterators carry the device id in the high word. Read only transactions
+ * start on all shards at once. Write transactions only start writing on the
+ * shards they change, and look the others up in read only transactions of
+ * their own. Writing to shards is serialized across processes, see
+ * Database::lockWriters(). Committing is not atomic across shards.
+ */
 class BALOO_ENGINE_EXPORT Transaction
 {
 public:
@@ -65,8 +83,16 @@ public:
     quint64 documentId(const QByteArray& path) const;
     QByteArray documentData(quint64 id) const;
 
+    /**
+     * The ids of the documents directly inside the folder \p id
+     */
+    QVector<quint64> documentChildren(quint64 id) const;
+
     DocumentTimeDB::TimeInfo documentTimeInfo(quint64 id) const;
 
+    /**
+     * Returns the sorted ids of the first \p limit documents matching \p query
+     */
     QVector<quint64> exec(const EngineQuery& query, int limit = -1) const;
 
     PostingIterator* postingIterator(const EngineQuery& query) const;
@@ -75,12 +101,91 @@ public:
     PostingIterator* mTimeRangeIter(quint32 beginTime, quint32 endTime) const;
     PostingIterator* docUrlIter(quint64 id) const;
 
+    /**
+     * Counts the documents modified within [\p beginTime, \p endTime] per day,
+     * month or year in a single pass over the mtime index, optionally only
+     * those with the sorted ordinals \p ids. \sa MTimeDB::histogram
+     */
+    QMap<QDate, uint> mTimeHistogram(quint32 beginTime, quint32 endTime, MTimeDB::Granularity granularity,
+                                     const QVector<quint64>* ids = nullptr) const;
+
+    /**
+     * Restricts \p it to the documents within the folder \p id, or outside
+     * of it if \p exclude is set, checking the parents of each document
+     * instead of enumerating the folder. Preferable to docUrlIter when \p it
+     * is small. Takes ownership of \p it.
+     */
+    PostingIterator* docUrlFilterIter(PostingIterator* it, quint64 id, bool exclude = false) const;
+
+    /**
+     * Restricts \p it to the documents whose mtime lies within [\p beginTime, \p endTime],
+     * or outside of it if \p exclude is set, looking up the time of each document
+     * instead of scanning the mtime index. Takes ownership of \p it.
+     */
+    PostingIterator* mTimeRangeFilterIter(PostingIterator* it, quint32 beginTime, quint32 endTime,
+                                          bool exclude = false) const;
+
+    /**
+     * While \p profile is set, the iterators returned by this transaction record
+     * their work in it. Pass nullptr to stop profiling. The profile is not owned
+     * and must outlive the iterators.
+     */
+    void setQueryProfile(QueryProfile* profile);
+    QueryProfile* queryProfile() const;
+
     QVector<quint64> fetchPhaseOneIds(int size) const;
+
+    /**
+     * The number of documents, and of those which are still waiting for or
+     * have failed content indexing. These are read from counters maintained
+     * on commit and are cheap to call.
+     */
     uint phaseOneSize() const;
     uint size() const;
+    uint failedSize() const;
+
+    /**
+     * Returns the document frequency, the ordinal range and the number of positions
+     * of \p term without reading its posting list. The statistics are empty if
+     * the term does not exist.
+     */
+    TermStatsDB::TermStats termStats(const QByteArray& term) const;
 
     QVector<QByteArray> fetchTermsStartingWith(const QByteArray& term) const;
 
+    /**
+     * Returns the tags directly below \p parent by their last component, along
+     * with the number of documents tagged with each of them. An empty \p parent
+     * returns the top level tags.
+     */
+    QMap<QByteArray, TagDB::TagInfo> tagChildren(const QByteArray& parent) const;
+
+    /**
+     * Returns the smallest and the largest id of all indexed documents, or
+     * false if the index is empty.
+     */
+    bool documentIdRange(quint64* firstId, quint64* lastId) const;
+
+    /**
+     * Returns the smallest and the largest ordinal in use, or false if the
+     * index is empty. Used to partition queries by ordinal range.
+     */
+    bool ordinalRange(quint64* first, quint64* last) const;
+
+    /**
+     * Convert between the ids of the documents and the ordinals yielded by
+     * the posting iterators. Both return 0 for unknown documents.
+     */
+    quint64 ordinalToId(quint64 ordinal) const;
+    quint64 idToOrdinal(quint64 id) const;
+
+    /**
+     * Returns the id of the database snapshot this transaction operates on. Two
+     * read only transactions with the same id see exactly the same data. The
+     * ids of later snapshots are larger, also after Database::compact().
+     */
+    quint64 snapshotId() const;
+
     //
     // Introspecing document data
     //
@@ -90,6 +195,18 @@ public:
 
     DatabaseSize dbSize();
 
+    /**
+     * Returns the page usage of every database along with its
+     * \p largestValueCount largest values. This reads the whole index.
+     */
+    StorageReport storageReport(int largestValueCount) const;
+
+    /**
+     * The number of pages which are part of the index file but unused,
+     * along with the total number of pages. Cheap compared to storageReport()
+     */
+    size_t freePageCount(size_t* usedPages = nullptr) const;
+
     //
     // Transaction handling
     //
@@ -107,6 +224,14 @@ public:
 
     template <typename Functor>
     void removeRecursively(quint64 id, Functor shouldDelete) {
+        // The folders are stored in the shards of all devices below them
+        if (m_sharded) {
+            for (Transaction* tr : writeShards(id)) {
+                tr->removeRecursively(id, shouldDelete);
+            }
+            return;
+        }
+
         Q_ASSERT(m_txn);
         Q_ASSERT(m_writeTrans);
 
@@ -117,20 +242,65 @@ public:
     void setPhaseOne(quint64 id);
     void removePhaseOne(quint64 id);
 
-    // Debugging
-    void checkFsTree();
-    void checkTermsDbinPostingDb();
-    void checkPostingDbinTermsDb();
+    /**
+     * Renumbers the documents in path order, see WriteTransaction::reorderDocuments.
+     * Has to be the only change of the transaction.
+     */
+    bool reorderDocuments();
 
 private:
     Transaction(const Transaction& rhs) = delete;
 
+    PostingIterator* profiled(PostingIterator* it, const QByteArray& name,
+                              const QVector<PostingIterator*>& children = QVector<PostingIterator*>()) const;
+
+    /**
+     * Returns the transaction to look the document \p id up in, started if
+     * needed, or nullptr if its device has no shard. That is the write
+     * transaction of the shard once something was written to it, and a
+     * read only one before.
+     */
+    Transaction* shardTransaction(quint64 id) const;
+    Transaction* deviceTransaction(quint32 deviceId) const;
+
+    /**
+     * Returns the transactions to look things up in of all shards by
+     * device id, starting the missing ones
+     */
+    QMap<quint32, Transaction*> shardTransactions() const;
+
+    /**
+     * Returns the write transaction of the shard of \p deviceId, started
+     * if needed, or nullptr if the device has no shard and \p create is
+     * not set. writeShards() returns those of the shards storing the
+     * document \p id, of all shards if it is 0.
+     */
+    Transaction* writeShard(quint32 deviceId, bool create = false);
+    QVector<Transaction*> writeShards(quint64 id = 0);
+    Transaction* startShard(quint32 deviceId, Database* shard, TransactionType type) const;
+
+    /**
+     * Looks \p id up in the ResidentIdSets::Set \p set of the database.
+     * Returns false if the sets cannot answer for this transaction.
+     */
+    bool residentLookup(int set, quint64 id, bool* contains) const;
+
     const DatabaseDbis& m_dbis;
+    const Database& m_db;
     MDB_txn* m_txn;
     MDB_env* m_env;
     WriteTransaction* m_writeTrans;
+    QueryProfile* m_profile;
+
+    const TransactionType m_type;
+    bool m_sharded;
+    mutable QMap<quint32, Transaction*> m_shards;
+    mutable QMap<quint32, Transaction*> m_readShards;
+    quint64 m_shardsSnapshotBase;
+    int m_writersFd;
 
     friend class DBState; // for testing
+    friend class IndexChecker;
 };
 }
 
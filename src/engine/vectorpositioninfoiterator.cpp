@@ -21,6 +21,8 @@
 #include "vectorpositioninfoiterator.h"
 #include "positioninfo.h"
 
+#include <algorithm>
+
 using namespace Baloo;
 
 VectorPositionInfoIterator::VectorPositionInfoIterator(const QVector<PositionInfo>& vector)
@@ -59,5 +61,22 @@ QVector<uint> VectorPositionInfoIterator::positions()
     return m_vector[m_pos].positions;
 }
 
+quint64 VectorPositionInfoIterator::skipTo(quint64 id)
+{
+    if (m_pos >= m_vector.size()) {
+        return 0;
+    }
+    if (m_pos >= 0 && m_vector[m_pos].docId >= id) {
+        return m_vector[m_pos].docId;
+    }
 
+    auto it = std::lower_bound(m_vector.constBegin() + qMax(m_pos, 0), m_vector.constEnd(), id,
+                               [](const PositionInfo& info, quint64 docId) { return info.docId < docId; });
+    m_pos = it - m_vector.constBegin();
+    return docId();
+}
 
+uint VectorPositionInfoIterator::estimatedSize() const
+{
+    return m_vector.size();
+}
@@ -33,6 +33,8 @@ public:
 
     quint64 docId() const Q_DECL_OVERRIDE;
     quint64 next() Q_DECL_OVERRIDE;
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE;
+    uint estimatedSize() const Q_DECL_OVERRIDE;
     QVector<uint> positions() Q_DECL_OVERRIDE;
 
 private:
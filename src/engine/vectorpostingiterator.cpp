@@ -20,6 +20,8 @@
 
 #include "vectorpostingiterator.h"
 
+#include <algorithm>
+
 using namespace Baloo;
 
 VectorPostingIterator::VectorPostingIterator(const QVector<quint64>& values)
@@ -48,3 +50,22 @@ quint64 VectorPostingIterator::next()
     m_pos++;
     return m_values[m_pos];
 }
+
+quint64 VectorPostingIterator::skipTo(quint64 id)
+{
+    if (m_pos >= m_values.size()) {
+        return 0;
+    }
+    if (m_pos >= 0 && m_values[m_pos] >= id) {
+        return m_values[m_pos];
+    }
+
+    auto it = std::lower_bound(m_values.constBegin() + qMax(m_pos, 0), m_values.constEnd(), id);
+    m_pos = it - m_values.constBegin();
+    return docId();
+}
+
+uint VectorPostingIterator::estimatedSize() const
+{
+    return m_values.size();
+}
@@ -30,10 +30,32 @@
 #include "documenttimedb.h"
 #include "documentdatadb.h"
 #include "mtimedb.h"
+#include "termstatsdb.h"
+#include "metadatadb.h"
+#include "tagdb.h"
+#include "ordinaldb.h"
 #include "idutils.h"
+#include "postingcodec.h"
+#include "positioncodec.h"
+
+#include <algorithm>
 
 using namespace Baloo;
 
+/**
+ * Returns whether \p id is \p folderId or somewhere below it
+ */
+static bool isInFolder(IdFilenameDB& idFilenameDB, quint64 id, quint64 folderId)
+{
+    while (id) {
+        if (id == folderId) {
+            return true;
+        }
+        id = idFilenameDB.get(id).parentId;
+    }
+    return false;
+}
+
 void WriteTransaction::addDocument(const Document& doc)
 {
     quint64 id = doc.id();
@@ -46,6 +68,7 @@ void WriteTransaction::addDocument(const Document& doc)
     DocumentIdDB contentIndexingDB(m_dbis.contentIndexingDbi, m_txn);
     MTimeDB mtimeDB(m_dbis.mtimeDbi, m_txn);
     DocumentUrlDB docUrlDB(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
+    OrdinalDB ordinalDB(m_dbis.idOrdinalDbi, m_dbis.ordinalIdDbi, m_dbis.freeOrdinalDbi, m_txn);
 
     Q_ASSERT(!documentTermsDB.contains(id));
     Q_ASSERT(!documentXattrTermsDB.contains(id));
@@ -54,24 +77,42 @@ void WriteTransaction::addDocument(const Document& doc)
     Q_ASSERT(!docDataDB.contains(id));
     Q_ASSERT(!contentIndexingDB.contains(id));
 
+    m_touchedIds.insert(id);
+    docUrlDB.setChangeLog(&m_touchedIds);
     if (!docUrlDB.put(id, doc.url())) {
         return;
     }
+    m_documentCountDelta++;
+
+    // Close to its folder if one of the spare ordinals reorderDocuments()
+    // left after its documents is still free. Those of the next folder
+    // follow the documents of that one instead.
+    IdFilenameDB idFilenameDB(m_dbis.idFilenameDbi, m_txn);
+    const quint64 parentId = idFilenameDB.get(id).parentId;
+    quint32 hint = 0;
+    if (const quint32 folderOrdinal = parentId ? ordinalDB.ordinal(parentId) : 0) {
+        quint64 previousId = 0;
+        const quint32 free = ordinalDB.nextFree(folderOrdinal, &previousId);
+        if (free && isInFolder(idFilenameDB, previousId, parentId)) {
+            hint = free;
+        }
+    }
+    const quint32 ordinal = ordinalDB.assign(id, hint);
 
-    QVector<QByteArray> docTerms = addTerms(id, doc.m_terms);
+    QVector<QByteArray> docTerms = addTerms(ordinal, doc.m_terms);
     documentTermsDB.put(id, docTerms);
 
-    QVector<QByteArray> docXattrTerms = addTerms(id, doc.m_xattrTerms);
+    QVector<QByteArray> docXattrTerms = addTerms(ordinal, doc.m_xattrTerms);
     if (!docXattrTerms.isEmpty())
         documentXattrTermsDB.put(id, docXattrTerms);
 
-    QVector<QByteArray> docFileNameTerms = addTerms(id, doc.m_fileNameTerms);
+    QVector<QByteArray> docFileNameTerms = addTerms(ordinal, doc.m_fileNameTerms);
     if (!docFileNameTerms.isEmpty())
         documentFileNameTermsDB.put(id, docFileNameTerms);
 
 
-    if (doc.contentIndexing()) {
-        contentIndexingDB.put(doc.id());
+    if (doc.contentIndexing() && contentIndexingDB.put(doc.id())) {
+        m_phaseOneCountDelta++;
     }
 
     DocumentTimeDB::TimeInfo info;
@@ -79,14 +120,14 @@ void WriteTransaction::addDocument(const Document& doc)
     info.cTime = doc.m_cTime;
 
     docTimeDB.put(id, info);
-    mtimeDB.put(doc.m_mTime, id);
+    mtimeDB.put(doc.m_mTime, ordinal);
 
     if (!doc.m_data.isEmpty()) {
         docDataDB.put(id, doc.m_data);
     }
 }
 
-QVector<QByteArray> WriteTransaction::addTerms(quint64 id, const QMap<QByteArray, Document::TermData>& terms)
+QVector<QByteArray> WriteTransaction::addTerms(quint32 ordinal, const QMap<QByteArray, Document::TermData>& terms)
 {
     QVector<QByteArray> termList;
     termList.reserve(terms.size());
@@ -98,7 +139,7 @@ QVector<QByteArray> WriteTransaction::addTerms(quint64 id, const QMap<QByteArray
 
         Operation op;
         op.type = AddId;
-        op.data.docId = id;
+        op.data.docId = ordinal;
         op.data.positions = it.value().positions;
 
         m_pendingOperations[term].append(op);
@@ -119,42 +160,70 @@ void WriteTransaction::removeDocument(quint64 id)
     DocumentIdDB failedIndexingDB(m_dbis.failedIdDbi, m_txn);
     MTimeDB mtimeDB(m_dbis.mtimeDbi, m_txn);
     DocumentUrlDB docUrlDB(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
-
-    removeTerms(id, documentTermsDB.get(id));
-    removeTerms(id, documentXattrTermsDB.get(id));
-    removeTerms(id, documentFileNameTermsDB.get(id));
+    OrdinalDB ordinalDB(m_dbis.idOrdinalDbi, m_dbis.ordinalIdDbi, m_dbis.freeOrdinalDbi, m_txn);
+
+    // Folders which are only known as parents have no ordinal, nor terms
+    const quint32 ordinal = ordinalDB.del(id);
+    if (ordinal) {
+        removeTerms(ordinal, documentTermsDB.get(id));
+        removeTerms(ordinal, documentXattrTermsDB.get(id));
+        removeTerms(ordinal, documentFileNameTermsDB.get(id));
+    }
 
     documentTermsDB.del(id);
     documentXattrTermsDB.del(id);
     documentFileNameTermsDB.del(id);
 
+    m_touchedIds.insert(id);
+    docUrlDB.setChangeLog(&m_touchedIds);
     docUrlDB.del(id, [&docTimeDB](quint64 id) {
         return !docTimeDB.contains(id);
     });
 
-    contentIndexingDB.del(id);
-    failedIndexingDB.del(id);
+    if (contentIndexingDB.del(id)) {
+        m_phaseOneCountDelta--;
+    }
+    if (failedIndexingDB.del(id)) {
+        m_failedCountDelta--;
+    }
+
+    if (docTimeDB.contains(id)) {
+        m_documentCountDelta--;
+    }
 
     DocumentTimeDB::TimeInfo info = docTimeDB.get(id);
     if (info.mTime) {
         docTimeDB.del(id);
-        mtimeDB.del(info.mTime, id);
+        if (ordinal) {
+            mtimeDB.del(info.mTime, ordinal);
+        }
     }
 
     docDataDB.del(id);
 }
 
-void WriteTransaction::removeTerms(quint64 id, const QVector<QByteArray>& terms)
+void WriteTransaction::removeTerms(quint32 ordinal, const QVector<QByteArray>& terms)
 {
     for (const QByteArray& term : terms) {
         Operation op;
         op.type = RemoveId;
-        op.data.docId = id;
+        op.data.docId = ordinal;
 
         m_pendingOperations[term].append(op);
     }
 }
 
+void WriteTransaction::repairPosting(const QByteArray& term, quint32 ordinal, OperationType type)
+{
+    Q_ASSERT(ordinal > 0);
+
+    Operation op;
+    op.type = type;
+    op.data.docId = ordinal;
+
+    m_pendingOperations[term].append(op);
+}
+
 void WriteTransaction::removeRecursively(quint64 parentId)
 {
     DocumentUrlDB docUrlDB(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
@@ -175,20 +244,24 @@ void WriteTransaction::replaceDocument(const Document& doc, DocumentOperations o
     DocumentDataDB docDataDB(m_dbis.docDataDbi, m_txn);
     MTimeDB mtimeDB(m_dbis.mtimeDbi, m_txn);
     DocumentUrlDB docUrlDB(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
+    OrdinalDB ordinalDB(m_dbis.idOrdinalDbi, m_dbis.ordinalIdDbi, m_dbis.freeOrdinalDbi, m_txn);
 
     const quint64 id = doc.id();
+    const quint32 ordinal = ordinalDB.assign(id);
+    m_touchedIds.insert(id);
+    docUrlDB.setChangeLog(&m_touchedIds);
 
     if (operations & DocumentTerms) {
         Q_ASSERT(!doc.m_terms.isEmpty());
         QVector<QByteArray> prevTerms = documentTermsDB.get(id);
-        QVector<QByteArray> docTerms = replaceTerms(id, prevTerms, doc.m_terms);
+        QVector<QByteArray> docTerms = replaceTerms(ordinal, prevTerms, doc.m_terms);
 
         documentTermsDB.put(id, docTerms);
     }
 
     if (operations & XAttrTerms) {
         QVector<QByteArray> prevTerms = documentXattrTermsDB.get(id);
-        QVector<QByteArray> docXattrTerms = replaceTerms(id, prevTerms, doc.m_xattrTerms);
+        QVector<QByteArray> docXattrTerms = replaceTerms(ordinal, prevTerms, doc.m_xattrTerms);
 
         if (!docXattrTerms.isEmpty())
             documentXattrTermsDB.put(id, docXattrTerms);
@@ -198,7 +271,7 @@ void WriteTransaction::replaceDocument(const Document& doc, DocumentOperations o
 
     if (operations & FileNameTerms) {
         QVector<QByteArray> prevTerms = documentFileNameTermsDB.get(id);
-        QVector<QByteArray> docFileNameTerms = replaceTerms(id, prevTerms, doc.m_fileNameTerms);
+        QVector<QByteArray> docFileNameTerms = replaceTerms(ordinal, prevTerms, doc.m_fileNameTerms);
 
         if (!docFileNameTerms.isEmpty())
             documentFileNameTermsDB.put(id, docFileNameTerms);
@@ -207,12 +280,18 @@ void WriteTransaction::replaceDocument(const Document& doc, DocumentOperations o
     }
 
     if (operations & DocumentTime) {
+        // Otherwise the document would still be found under its previous mtime
+        const DocumentTimeDB::TimeInfo prevInfo = docTimeDB.get(id);
+        if (prevInfo.mTime && prevInfo.mTime != doc.m_mTime) {
+            mtimeDB.del(prevInfo.mTime, ordinal);
+        }
+
         DocumentTimeDB::TimeInfo info;
         info.mTime = doc.m_mTime;
         info.cTime = doc.m_cTime;
 
         docTimeDB.put(id, info);
-        mtimeDB.put(doc.m_mTime, id);
+        mtimeDB.put(doc.m_mTime, ordinal);
     }
 
     if (operations & DocumentData) {
@@ -230,42 +309,264 @@ void WriteTransaction::replaceDocument(const Document& doc, DocumentOperations o
     }
 }
 
-QVector< QByteArray > WriteTransaction::replaceTerms(quint64 id, const QVector<QByteArray>& prevTerms,
+QVector< QByteArray > WriteTransaction::replaceTerms(quint32 ordinal, const QVector<QByteArray>& prevTerms,
                                                      const QMap<QByteArray, Document::TermData>& terms)
 {
     for (const QByteArray& term : prevTerms) {
         Operation op;
         op.type = RemoveId;
-        op.data.docId = id;
+        op.data.docId = ordinal;
 
         m_pendingOperations[term].append(op);
     }
 
-    return addTerms(id, terms);
+    return addTerms(ordinal, terms);
+}
+
+void WriteTransaction::setPhaseOne(quint64 id)
+{
+    m_touchedIds.insert(id);
+    DocumentIdDB contentIndexingDB(m_dbis.contentIndexingDbi, m_txn);
+    if (contentIndexingDB.put(id)) {
+        m_phaseOneCountDelta++;
+    }
+}
+
+void WriteTransaction::removePhaseOne(quint64 id)
+{
+    m_touchedIds.insert(id);
+    DocumentIdDB contentIndexingDB(m_dbis.contentIndexingDbi, m_txn);
+    if (contentIndexingDB.del(id)) {
+        m_phaseOneCountDelta--;
+    }
+}
+
+void WriteTransaction::addFailed(quint64 id)
+{
+    m_touchedIds.insert(id);
+    DocumentIdDB failedIdDB(m_dbis.failedIdDbi, m_txn);
+    if (failedIdDB.put(id)) {
+        m_failedCountDelta++;
+    }
+}
+
+ResidentIdSets::Changes WriteTransaction::residentIdChanges() const
+{
+    IdFilenameDB idFilenameDB(m_dbis.idFilenameDbi, m_txn);
+    DocumentIdDB contentIndexingDB(m_dbis.contentIndexingDbi, m_txn);
+    DocumentIdDB failedIdDB(m_dbis.failedIdDbi, m_txn);
+
+    // Only the last state counts, which the pages just written still hold
+    ResidentIdSets::Changes changes;
+    changes.reserve(m_touchedIds.size());
+    for (quint64 id : m_touchedIds) {
+        uint sets = 0;
+        if (idFilenameDB.contains(id)) {
+            sets |= 1u << ResidentIdSets::Documents;
+        }
+        if (contentIndexingDB.contains(id)) {
+            sets |= 1u << ResidentIdSets::PhaseOne;
+        }
+        if (failedIdDB.contains(id)) {
+            sets |= 1u << ResidentIdSets::Failed;
+        }
+        changes.insert(id, sets);
+    }
+    return changes;
+}
+
+/*
+ * Replaces the value under the cursor with \p data, or deletes it if empty.
+ * The key is copied out of the page first, as the value may change size.
+ */
+static void replaceValue(MDB_cursor* cursor, const MDB_val& key, const QByteArray& data)
+{
+    QByteArray keyData(static_cast<char*>(key.mv_data), key.mv_size);
+    MDB_val newKey = {static_cast<size_t>(keyData.size()), keyData.data()};
+
+    int rc;
+    if (data.isEmpty()) {
+        rc = mdb_cursor_del(cursor, 0);
+    } else {
+        MDB_val newVal = {static_cast<size_t>(data.size()), const_cast<char*>(data.constData())};
+        rc = mdb_cursor_put(cursor, &newKey, &newVal, MDB_CURRENT);
+    }
+    Q_ASSERT_X(rc == 0, "WriteTransaction::reorderDocuments", mdb_strerror(rc));
+    Q_UNUSED(rc);
+}
+
+bool WriteTransaction::reorderDocuments()
+{
+    Q_ASSERT(m_pendingOperations.isEmpty());
+
+    OrdinalDB ordinalDB(m_dbis.idOrdinalDbi, m_dbis.ordinalIdDbi, m_dbis.freeOrdinalDbi, m_txn);
+    DocumentUrlDB docUrlDB(m_dbis.idTreeDbi, m_dbis.idFilenameDbi, m_txn);
+
+    const QVector<quint64> oldIds = ordinalDB.idsByOrdinal();
+    if (oldIds.isEmpty()) {
+        return false;
+    }
+
+    // With '/' sorting before every other byte, the order of the paths is
+    // the depth first order of the tree. Documents without a path go last.
+    struct Entry {
+        QByteArray key;
+        quint32 ordinal;
+
+        bool operator<(const Entry& other) const {
+            if (key.isEmpty() != other.key.isEmpty()) {
+                return other.key.isEmpty();
+            }
+            return key < other.key;
+        }
+    };
+    QVector<Entry> entries;
+    for (int ordinal = 1; ordinal < oldIds.size(); ordinal++) {
+        if (oldIds[ordinal]) {
+            QByteArray key = docUrlDB.get(oldIds[ordinal]);
+            key.replace('/', '\0');
+            entries.append({key, quint32(ordinal)});
+        }
+    }
+    std::stable_sort(entries.begin(), entries.end());
+
+    // Every folder is followed by a few free ordinals for the documents
+    // added to it later, one per 16 documents below it
+    QVector<quint64> newIds;
+    newIds.reserve(entries.size() + entries.size() / 8);
+    QVector<quint32> newOrdinals(oldIds.size(), 0);
+
+    QVector<QPair<QByteArray, int>> folders;
+    for (int i = 0; i < entries.size(); i++) {
+        const Entry& entry = entries[i];
+        while (!folders.isEmpty() && (entry.key.isEmpty() || !entry.key.startsWith(folders.last().first))) {
+            const int documents = i - folders.last().second;
+            for (int spare = 0; spare < documents / 16 + 1; spare++) {
+                newIds << 0;
+            }
+            folders.removeLast();
+        }
+
+        newIds << oldIds[entry.ordinal];
+        newOrdinals[entry.ordinal] = newIds.size();
+
+        if (!entry.key.isEmpty() && i + 1 < entries.size()) {
+            const QByteArray prefix = entry.key + '\0';
+            if (entries[i + 1].key.startsWith(prefix)) {
+                folders.append(qMakePair(prefix, i + 1));
+            }
+        }
+    }
+
+    if (newIds == oldIds.mid(1)) {
+        return false;
+    }
+    ordinalDB.reset(newIds);
+
+    TermStatsDB termStatsDB(m_dbis.termStatsDbi, m_txn);
+    MDB_cursor* cursor;
+    MDB_val key = {0, nullptr};
+    MDB_val val;
+
+    mdb_cursor_open(m_txn, m_dbis.postingDbi, &cursor);
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        const QByteArray term(static_cast<char*>(key.mv_data), key.mv_size);
+        const QVector<quint64> list = PostingCodec().decode(QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size));
+
+        QVector<quint64> mapped;
+        mapped.reserve(list.size());
+        for (quint64 ordinal : list) {
+            if (ordinal < quint64(newOrdinals.size()) && newOrdinals[ordinal]) {
+                mapped << newOrdinals[ordinal];
+            }
+        }
+        std::sort(mapped.begin(), mapped.end());
+        replaceValue(cursor, key, mapped.isEmpty() ? QByteArray() : PostingCodec().encode(mapped));
+
+        // Postings of unknown ordinals are dropped on the way
+        TermStatsDB::TermStats stats = termStatsDB.get(term);
+        if (mapped.isEmpty()) {
+            termStatsDB.del(term);
+        } else {
+            stats.documentCount = mapped.size();
+            stats.minId = mapped.first();
+            stats.maxId = mapped.last();
+            termStatsDB.put(term, stats);
+        }
+    }
+    mdb_cursor_close(cursor);
+
+    key = {0, nullptr};
+    mdb_cursor_open(m_txn, m_dbis.positionDBi, &cursor);
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        const QVector<PositionInfo> list = PositionCodec().decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+
+        QVector<PositionInfo> mapped;
+        mapped.reserve(list.size());
+        for (const PositionInfo& info : list) {
+            if (info.docId < quint64(newOrdinals.size()) && newOrdinals[info.docId]) {
+                mapped << info;
+                mapped.last().docId = newOrdinals[info.docId];
+            }
+        }
+        std::sort(mapped.begin(), mapped.end(), [](const PositionInfo& lhs, const PositionInfo& rhs) {
+            return lhs.docId < rhs.docId;
+        });
+        replaceValue(cursor, key, mapped.isEmpty() ? QByteArray() : PositionCodec().encode(mapped));
+    }
+    mdb_cursor_close(cursor);
+
+    // The mtime db holds sorted duplicates, which have to be written anew
+    QVector<QPair<quint32, quint32>> times;
+    key = {0, nullptr};
+    mdb_cursor_open(m_txn, m_dbis.mtimeDbi, &cursor);
+    while (mdb_cursor_get(cursor, &key, &val, MDB_NEXT) == 0) {
+        const quint32 ordinal = *static_cast<quint32*>(val.mv_data);
+        if (ordinal < quint32(newOrdinals.size()) && newOrdinals[ordinal]) {
+            times << qMakePair(*static_cast<quint32*>(key.mv_data), newOrdinals[ordinal]);
+        }
+    }
+    mdb_cursor_close(cursor);
+
+    int rc = mdb_drop(m_txn, m_dbis.mtimeDbi, 0);
+    Q_ASSERT_X(rc == 0, "WriteTransaction::reorderDocuments", mdb_strerror(rc));
+    Q_UNUSED(rc);
+
+    MTimeDB mtimeDB(m_dbis.mtimeDbi, m_txn);
+    for (const auto& time : times) {
+        mtimeDB.put(time.first, time.second);
+    }
+
+    return true;
 }
 
-void WriteTransaction::commit()
+void WriteTransaction::commit(EngineMetrics::CommitStats* commitStats)
 {
     PostingDB postingDB(m_dbis.postingDbi, m_txn);
     PositionDB positionDB(m_dbis.positionDBi, m_txn);
 
+    quint64 operationCount = 0;
+    quint64 bytes = 0;
+
     QHashIterator<QByteArray, QVector<Operation> > iter(m_pendingOperations);
     while (iter.hasNext()) {
         iter.next();
 
         const QByteArray& term = iter.key();
         const QVector<Operation> operations = iter.value();
+        operationCount += operations.size();
 
         PostingList list = postingDB.get(term);
+        const int previousCount = list.size();
 
         bool fetchedPositionList = false;
         QVector<PositionInfo> positionList;
 
         for (const Operation& op : operations) {
-            quint64 id = op.data.docId;
+            quint64 ordinal = op.data.docId;
 
             if (op.type == AddId) {
-                sortedIdInsert(list, id);
+                sortedIdInsert(list, ordinal);
 
                 if (!op.data.positions.isEmpty()) {
                     if (!fetchedPositionList) {
@@ -276,29 +577,86 @@ void WriteTransaction::commit()
                 }
             }
             else {
-                sortedIdRemove(list, id);
+                sortedIdRemove(list, ordinal);
                 if (!fetchedPositionList) {
                     positionList = positionDB.get(term);
                     fetchedPositionList = true;
                 }
-                sortedIdRemove(positionList, PositionInfo(id));
+                sortedIdRemove(positionList, PositionInfo(ordinal));
             }
         }
 
         if (!list.isEmpty()) {
-            postingDB.put(term, list);
+            bytes += postingDB.put(term, list);
         } else {
             postingDB.del(term);
         }
 
         if (fetchedPositionList) {
             if (!positionList.isEmpty()) {
-                positionDB.put(term, positionList);
+                bytes += positionDB.put(term, positionList);
             } else {
                 positionDB.del(term);
             }
         }
+
+        if (m_dbis.tagDbi && list.size() != previousCount && term.startsWith("TAG-") && term.size() > 4) {
+            TagDB tagDB(m_dbis.tagDbi, m_txn);
+            tagDB.setDocumentCount(term.mid(4), list.size());
+        }
+
+        if (!m_dbis.termStatsDbi) {
+            continue;
+        }
+
+        TermStatsDB termStatsDB(m_dbis.termStatsDbi, m_txn);
+        if (list.isEmpty()) {
+            termStatsDB.del(term);
+            continue;
+        }
+
+        TermStatsDB::TermStats stats = fetchedPositionList ? TermStatsDB::TermStats() : termStatsDB.get(term);
+        stats.documentCount = list.size();
+        stats.minId = list.first();
+        stats.maxId = list.last();
+        if (fetchedPositionList) {
+            for (const PositionInfo& info : positionList) {
+                stats.positionCount += info.positions.size();
+            }
+        }
+        termStatsDB.put(term, stats);
+    }
+
+    if (commitStats) {
+        commitStats->terms += m_pendingOperations.size();
+        commitStats->operations += operationCount;
+        commitStats->bytes += bytes;
     }
 
     m_pendingOperations.clear();
+
+    commitCounters();
+}
+
+void WriteTransaction::commitCounters()
+{
+    if (!m_dbis.metaDataDbi) {
+        return;
+    }
+
+    MetaDataDB metaDataDB(m_dbis.metaDataDbi, m_txn);
+    auto apply = [&metaDataDB](const char* name, qint64& delta) {
+        if (!delta) {
+            return;
+        }
+
+        const qint64 count = static_cast<qint64>(metaDataDB.count(name)) + delta;
+        Q_ASSERT_X(count >= 0, "WriteTransaction::commit", name);
+        metaDataDB.putCount(name, qMax<qint64>(count, 0));
+        delta = 0;
+    };
+
+    apply(documentCountName, m_documentCountDelta);
+    apply(phaseOneCountName, m_phaseOneCountDelta);
+    apply(failedCountName, m_failedCountDelta);
 }
@@ -26,6 +26,10 @@
 #include "documentoperations.h"
 #include "databasedbis.h"
 #include "documenturldb.h"
+#include "enginemetrics.h"
+#include "residentidsets.h"
+
+#include <QSet>
 
 namespace Baloo {
 
@@ -35,6 +39,9 @@ public:
     WriteTransaction(DatabaseDbis dbis, MDB_txn* txn)
         : m_txn(txn)
         , m_dbis(dbis)
+        , m_documentCountDelta(0)
+        , m_phaseOneCountDelta(0)
+        , m_failedCountDelta(0)
     {}
 
     void addDocument(const Document& doc);
@@ -71,11 +78,35 @@ public:
     }
 
     void replaceDocument(const Document& doc, DocumentOperations operations);
-    void commit();
+
+    void setPhaseOne(quint64 id);
+    void removePhaseOne(quint64 id);
+    void addFailed(quint64 id);
+
+    /**
+     * Writes the pending posting list changes along with the term statistics,
+     * tag counts and index wide counters affected by them. The amount of work
+     * done is added to \p commitStats if given.
+     */
+    void commit(EngineMetrics::CommitStats* commitStats = nullptr);
 
     bool hasChanges() const {
         return !m_pendingOperations.isEmpty();
     }
+
+    /**
+     * Whether this transaction may have added \p id to, or removed it from,
+     * the documents, the documents waiting for content indexing or the
+     * failed ones
+     */
+    bool isTouched(quint64 id) const {
+        return m_touchedIds.contains(id);
+    }
+
+    /**
+     * The sets of ResidentIdSets which the touched ids are in now
+     */
+    ResidentIdSets::Changes residentIdChanges() const;
     enum OperationType {
         AddId,
         RemoveId
@@ -85,20 +116,45 @@ public:
         PositionInfo data;
     };
 
+    /**
+     * Adds the document ordinal \p ordinal to, or removes it from, the posting
+     * list of \p term, leaving the terms of the document alone. Only meant for
+     * repairing an index whose posting lists disagree with the document terms.
+     */
+    void repairPosting(const QByteArray& term, quint32 ordinal, OperationType type);
+
+    /**
+     * Renumbers the documents in the depth first order of their paths, so
+     * that the documents of a folder have adjacent ordinals, and rewrites the
+     * posting, position and mtime dbs to match. Every folder gets some free
+     * ordinals after its documents for those added to it later.
+     *
+     * Rewrites most of the index, so it is meant for idle time, followed by
+     * Database::compact(). There must be no pending changes. Returns false
+     * if the order did not change.
+     */
+    bool reorderDocuments();
+
 private:
     /*
-     * Adds an 'addId' operation to the pending queue for each term.
-     * Returns the list of all the terms.
+     * Adds an 'addId' operation for the document \p ordinal to the pending
+     * queue for each term. Returns the list of all the terms.
      */
-    QVector<QByteArray> addTerms(quint64 id, const QMap<QByteArray, Document::TermData>& terms);
-    QVector<QByteArray> replaceTerms(quint64 id, const QVector<QByteArray>& prevTerms,
+    QVector<QByteArray> addTerms(quint32 ordinal, const QMap<QByteArray, Document::TermData>& terms);
+    QVector<QByteArray> replaceTerms(quint32 ordinal, const QVector<QByteArray>& prevTerms,
                                      const QMap<QByteArray, Document::TermData>& terms);
-    void removeTerms(quint64 id, const QVector<QByteArray>& terms);
+    void removeTerms(quint32 ordinal, const QVector<QByteArray>& terms);
+    void commitCounters();
 
     QHash<QByteArray, QVector<Operation> > m_pendingOperations;
+    QSet<quint64> m_touchedIds;
 
     MDB_txn* m_txn;
     DatabaseDbis m_dbis;
+
+    qint64 m_documentCountDelta;
+    qint64 m_phaseOneCountDelta;
+    qint64 m_failedCountDelta;
 };
 }
 
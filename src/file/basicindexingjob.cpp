@@ -65,6 +65,8 @@ bool BasicIndexingJob::index()
     tg.indexFileNameText(fileName, 1000);
     tg.indexFileNameText(fileName, QByteArray("F"));
     tg.indexText(m_mimetype, QByteArray("M"));
+    // The whole mimetype, for counting the results per mimetype
+    doc.addBoolTerm(QByteArray("MIME-") + m_mimetype.toUtf8());
 
     // Time
     doc.setMTime(statBuf.st_mtime);
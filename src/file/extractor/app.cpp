@@ -55,6 +55,10 @@ App::App(QObject* parent)
 void App::slotNewInput()
 {
     Database *db = globalDatabaseInstance();
+    if (!db->isOpen() && m_config.syncInterval()) {
+        // baloo_file flushes our commits along with its own
+        db->setDurability(Database::DeferredSync);
+    }
     if (!db->open(Database::ReadWriteDatabase)) {
         qCritical() << "Failed to open the database";
         exit(1);
@@ -101,6 +105,8 @@ void App::processNextFile()
         delete m_tr;
         m_tr = nullptr;
 
+        m_io.writeCommitStats(EngineMetrics::instance()->lastCommit());
+
         /*
         * TODO we're already sending out each file as we start we can simply send out a done
         * signal isntead of sending out the list of files, that will need changes in whatever
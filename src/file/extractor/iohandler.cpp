@@ -73,3 +73,9 @@ void IOHandler::writeFinishedIndexingUrl(const QString& url)
 {
     m_stdout << "F " << url << endl;
 }
+
+void IOHandler::writeCommitStats(const EngineMetrics::CommitStats& stats)
+{
+    m_stdout << "C " << stats.usecs << ' ' << stats.terms << ' ' << stats.operations << ' '
+             << stats.bytes << ' ' << stats.pages << endl;
+}
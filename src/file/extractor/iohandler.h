@@ -26,6 +26,8 @@
 #include <QObject>
 #include <QTextStream>
 
+#include "enginemetrics.h"
+
 namespace Baloo {
 
 class IOHandler
@@ -40,6 +42,9 @@ public:
     void writeStartedIndexingUrl(const QString& url);
     void writeFinishedIndexingUrl(const QString& url);
 
+    // forwards the metrics of the batch's commit to baloo_file
+    void writeCommitStats(const EngineMetrics::CommitStats& stats);
+
     // always call this after a batch has been indexed
     void writeBatchIndexed();
 
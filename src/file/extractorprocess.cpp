@@ -19,6 +19,7 @@
  */
 
 #include "extractorprocess.h"
+#include "enginemetrics.h"
 
 #include <QStandardPaths>
 #include <QDebug>
@@ -85,6 +86,21 @@ void ExtractorProcess::slotIndexingFile()
             m_extractorIdle = true;
             break;
 
+        case 'C': {
+            // The extractor commits in its own process, its metrics are added to ours
+            const QStringList values = arg.split(QLatin1Char(' '));
+            if (values.size() == 5) {
+                EngineMetrics::CommitStats stats;
+                stats.usecs = values[0].toULongLong();
+                stats.terms = values[1].toULongLong();
+                stats.operations = values[2].toULongLong();
+                stats.bytes = values[3].toULongLong();
+                stats.pages = values[4].toULongLong();
+                EngineMetrics::instance()->recordCommit(stats);
+            }
+            break;
+        }
+
         default:
             qCritical() << "Got unknown result from extractor" << command << arg;
         }
@@ -34,6 +34,11 @@ FileContentIndexer::FileContentIndexer(FileIndexerConfig* config, FileContentInd
     , m_batchSize(config->maxUncomittedFiles())
     , m_provider(provider)
     , m_stop(0)
+    , m_extractedFiles(0)
+    , m_extractorBatches(0)
+    , m_extractorMsecs(0)
+    , m_lastBatchFiles(0)
+    , m_lastBatchMsecs(0)
 {
     Q_ASSERT(provider);
 
@@ -72,6 +77,13 @@ void FileContentIndexer::run()
         process.index(idList);
         loop.exec();
 
+        const quint64 elapsed = timer.elapsed();
+        m_extractedFiles.fetchAndAddRelaxed(idList.size());
+        m_extractorBatches.fetchAndAddRelaxed(1);
+        m_extractorMsecs.fetchAndAddRelaxed(elapsed);
+        m_lastBatchFiles.store(idList.size());
+        m_lastBatchMsecs.store(elapsed);
+
         // QDbus requires us to be in object creation thread (thread affinity)
         // This signal is not even exported, and yet QDbus complains. QDbus bug?
         QMetaObject::invokeMethod(this, "newBatchTime", Qt::QueuedConnection, Q_ARG(uint, timer.elapsed()));
@@ -79,6 +91,22 @@ void FileContentIndexer::run()
     QMetaObject::invokeMethod(this, "done", Qt::QueuedConnection);
 }
 
+QVariantMap FileContentIndexer::metrics() const
+{
+    const quint64 files = m_extractedFiles.load();
+    const quint64 msecs = m_extractorMsecs.load();
+    const quint64 lastFiles = m_lastBatchFiles.load();
+    const quint64 lastMsecs = m_lastBatchMsecs.load();
+
+    QVariantMap map;
+    map.insert(QStringLiteral("extractedFiles"), files);
+    map.insert(QStringLiteral("extractorBatches"), m_extractorBatches.load());
+    map.insert(QStringLiteral("extractorTimeMsecs"), msecs);
+    map.insert(QStringLiteral("extractorFilesPerSecond"), msecs ? files * 1000.0 / msecs : 0.0);
+    map.insert(QStringLiteral("lastBatchFilesPerSecond"), lastMsecs ? lastFiles * 1000.0 / lastMsecs : 0.0);
+    return map;
+}
+
 void FileContentIndexer::slotStartedIndexingFile(const QString& filePath)
 {
     m_currentFile = filePath;
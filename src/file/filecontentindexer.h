@@ -23,7 +23,9 @@
 #include <QRunnable>
 #include <QObject>
 #include <QAtomicInt>
+#include <QAtomicInteger>
 #include <QStringList>
+#include <QVariantMap>
 
 #include <QDBusServiceWatcher>
 #include <QDBusMessage>
@@ -50,6 +52,12 @@ public:
         m_stop.store(true);
     }
 
+    /**
+     * The extractor throughput, as exported on /metrics. The counters
+     * are updated by the indexing thread after each batch.
+     */
+    QVariantMap metrics() const;
+
 public Q_SLOTS:
     Q_SCRIPTABLE void registerMonitor(const QDBusMessage& message);
     Q_SCRIPTABLE void unregisterMonitor(const QDBusMessage& message);
@@ -73,6 +81,12 @@ private:
 
     QAtomicInt m_stop;
 
+    QAtomicInteger<quint64> m_extractedFiles;
+    QAtomicInteger<quint64> m_extractorBatches;
+    QAtomicInteger<quint64> m_extractorMsecs;
+    QAtomicInteger<quint64> m_lastBatchFiles;
+    QAtomicInteger<quint64> m_lastBatchMsecs;
+
     QString m_currentFile;
 
     QStringList m_registeredMonitors;
@@ -358,3 +358,18 @@ uint FileIndexerConfig::maxUncomittedFiles()
     return m_maxUncomittedFiles;
 }
 
+uint FileIndexerConfig::syncInterval() const
+{
+    return m_config.group("General").readEntry("sync interval", 0);
+}
+
+uint FileIndexerConfig::compactionThreshold() const
+{
+    return m_config.group("General").readEntry("compaction threshold", 50);
+}
+
+bool FileIndexerConfig::shardedIndex() const
+{
+    return m_config.group("General").readEntry("sharded index", false);
+}
+
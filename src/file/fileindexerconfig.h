@@ -151,6 +151,32 @@ public:
       */
     uint maxUncomittedFiles();
 
+    /**
+     * A "hidden" config option which defers flushing the index to disk to
+     * every \c syncInterval seconds, instead of once per commit. A crash may
+     * then lose the commits of the interval, which are found again by
+     * checking all files changed since the last flush.
+     *
+     * \return 0 if every commit is flushed
+     */
+    uint syncInterval() const;
+
+    /**
+     * A "hidden" config option, the percentage of free pages in the index
+     * at which it is compacted once the indexer is idle.
+     *
+     * \return 0 if the index is only compacted on request
+     */
+    uint compactionThreshold() const;
+
+    /**
+     * A "hidden" config option which splits a new index into one shard per
+     * device, so that the devices are indexed in parallel and a removed
+     * device is dropped along with its shard. An existing index is kept as
+     * it is until it is rebuilt.
+     */
+    bool shardedIndex() const;
+
 public Q_SLOTS:
     /**
      * Reread the config from disk and update the configuration cache.
@@ -26,8 +26,13 @@
 #include "filecontentindexer.h"
 #include "filecontentindexerprovider.h"
 #include "unindexedfileindexer.h"
+#include "reconcileindexer.h"
+#include "indexcompactor.h"
+#include "indexcleaner.h"
 
 #include "fileindexerconfig.h"
+#include "database.h"
+#include "transaction.h"
 
 #include <QTimer>
 #include <QDebug>
@@ -35,18 +40,23 @@
 
 using namespace Baloo;
 
-FileIndexScheduler::FileIndexScheduler(Database* db, FileIndexerConfig* config, QObject* parent)
+FileIndexScheduler::FileIndexScheduler(Database* db, FileIndexerConfig* config, WriteCoordinator* coordinator, QObject* parent)
     : QObject(parent)
     , m_db(db)
     , m_config(config)
+    , m_coordinator(coordinator)
     , m_provider(db)
     , m_contentIndexer(nullptr)
     , m_indexerState(Idle)
     , m_timeEstimator(config, this)
     , m_checkUnindexedFiles(false)
+    , m_reconcileSince(0)
+    , m_compact(false)
+    , m_reorder(false)
 {
     Q_ASSERT(db);
     Q_ASSERT(config);
+    Q_ASSERT(coordinator);
 
     m_threadPool.setMaxThreadCount(1);
 
@@ -76,7 +86,7 @@ void FileIndexScheduler::scheduleIndexing()
     }
 
     if (m_config->isInitialRun()) {
-        auto runnable = new FirstRunIndexer(m_db, m_config, m_config->includeFolders());
+        auto runnable = new FirstRunIndexer(m_coordinator, m_config, m_config->includeFolders());
         connect(runnable, &FirstRunIndexer::done, this, &FileIndexScheduler::scheduleIndexing);
 
         m_threadPool.start(runnable);
@@ -85,8 +95,19 @@ void FileIndexScheduler::scheduleIndexing()
         return;
     }
 
+    if (m_reconcileSince) {
+        auto runnable = new ReconcileIndexer(m_coordinator, m_config, m_reconcileSince);
+        connect(runnable, &ReconcileIndexer::done, this, &FileIndexScheduler::scheduleIndexing);
+
+        m_threadPool.start(runnable);
+        m_reconcileSince = 0;
+        m_indexerState = UnindexedFileCheck;
+        Q_EMIT stateChanged(m_indexerState);
+        return;
+    }
+
     if (!m_newFiles.isEmpty()) {
-        auto runnable = new NewFileIndexer(m_db, m_config, m_newFiles);
+        auto runnable = new NewFileIndexer(m_coordinator, m_config, m_newFiles);
         connect(runnable, &NewFileIndexer::done, this, &FileIndexScheduler::scheduleIndexing);
 
         m_threadPool.start(runnable);
@@ -97,7 +118,7 @@ void FileIndexScheduler::scheduleIndexing()
     }
 
     if (!m_modifiedFiles.isEmpty()) {
-        auto runnable = new ModifiedFileIndexer(m_db, m_config, m_modifiedFiles);
+        auto runnable = new ModifiedFileIndexer(m_coordinator, m_config, m_modifiedFiles);
         connect(runnable, &ModifiedFileIndexer::done, this, &FileIndexScheduler::scheduleIndexing);
 
         m_threadPool.start(runnable);
@@ -108,7 +129,7 @@ void FileIndexScheduler::scheduleIndexing()
     }
 
     if (!m_xattrFiles.isEmpty()) {
-        auto runnable = new XAttrIndexer(m_db, m_config, m_xattrFiles);
+        auto runnable = new XAttrIndexer(m_coordinator, m_config, m_xattrFiles);
         connect(runnable, &XAttrIndexer::done, this, &FileIndexScheduler::scheduleIndexing);
 
         m_threadPool.start(runnable);
@@ -126,7 +147,7 @@ void FileIndexScheduler::scheduleIndexing()
     }
 
     if (m_checkUnindexedFiles) {
-        auto runnable = new UnindexedFileIndexer(m_db, m_config);
+        auto runnable = new UnindexedFileIndexer(m_coordinator, m_config);
         connect(runnable, &UnindexedFileIndexer::done, this, &FileIndexScheduler::scheduleIndexing);
 
         m_threadPool.start(runnable);
@@ -135,6 +156,35 @@ void FileIndexScheduler::scheduleIndexing()
         Q_EMIT stateChanged(m_indexerState);
         return;
     }
+
+    // Dropping the shard of a removed device is cheap, but like compacting
+    // needs the extractor process to be done with it
+    if (shouldRemoveStaleShards()) {
+        auto runnable = new IndexCleaner(m_coordinator, m_config);
+        runnable->setRemoveExcluded(false);
+        connect(runnable, &IndexCleaner::done, this, &FileIndexScheduler::scheduleIndexing);
+
+        m_threadPool.start(runnable);
+        m_lastShardCheck.start();
+        m_indexerState = Cleaning;
+        Q_EMIT stateChanged(m_indexerState);
+        return;
+    }
+
+    // Nothing else may run, the extractor process in particular would keep writing to the old index
+    if (m_compact || m_reorder || (!m_powerMonitor.isOnBattery() && shouldCompact())) {
+        auto runnable = new IndexCompactor(m_coordinator);
+        runnable->setReorder(m_reorder);
+        connect(runnable, &IndexCompactor::done, this, &FileIndexScheduler::scheduleIndexing);
+
+        m_threadPool.start(runnable);
+        m_compact = false;
+        m_reorder = false;
+        m_lastCompaction.start();
+        m_indexerState = Compacting;
+        Q_EMIT stateChanged(m_indexerState);
+        return;
+    }
     m_indexerState = Idle;
     Q_EMIT stateChanged(m_indexerState);
 }
@@ -209,6 +259,71 @@ void FileIndexScheduler::checkUnindexedFiles()
     scheduleIndexing();
 }
 
+void FileIndexScheduler::reconcile(quint32 since)
+{
+    m_reconcileSince = since;
+    scheduleIndexing();
+}
+
+QVariantMap FileIndexScheduler::metrics()
+{
+    QVariantMap map = m_contentIndexer->metrics();
+    map.insert(QStringLiteral("state"), static_cast<int>(m_indexerState));
+    map.insert(QStringLiteral("newFiles"), m_newFiles.size());
+    map.insert(QStringLiteral("modifiedFiles"), m_modifiedFiles.size());
+    map.insert(QStringLiteral("xattrFiles"), m_xattrFiles.size());
+    map.insert(QStringLiteral("contentIndexingFiles"), m_provider.size());
+    return map;
+}
+
+void FileIndexScheduler::compact()
+{
+    m_compact = true;
+    scheduleIndexing();
+}
+
+void FileIndexScheduler::reorder()
+{
+    m_reorder = true;
+    scheduleIndexing();
+}
+
+bool FileIndexScheduler::shouldCompact()
+{
+    const uint threshold = m_config->compactionThreshold();
+    if (!threshold) {
+        return false;
+    }
+
+    // Compacting needs a writer pause, do not retry it on every idle moment
+    if (m_lastCompaction.isValid() && m_lastCompaction.elapsed() < 60 * 60 * 1000) {
+        return false;
+    }
+
+    size_t usedPages = 0;
+    size_t freePages = 0;
+    {
+        Transaction tr(m_db, Transaction::ReadOnly);
+        freePages = tr.freePageCount(&usedPages);
+    }
+
+    // Not worth it for small amounts of free pages, such as on small indexes
+    if (freePages < 8192) {
+        return false;
+    }
+    return freePages * 100 >= usedPages * threshold;
+}
+
+bool FileIndexScheduler::shouldRemoveStaleShards()
+{
+    if (!m_db->isSharded()) {
+        return false;
+    }
+
+    // Once after starting, and then every hour the indexer runs out of work
+    return !m_lastShardCheck.isValid() || m_lastShardCheck.elapsed() >= 60 * 60 * 1000;
+}
+
 uint FileIndexScheduler::getBatchSize()
 {
     return m_config->maxUncomittedFiles();
@@ -24,6 +24,8 @@
 #include <QStringList>
 #include <QThreadPool>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QVariantMap>
 
 #include "filecontentindexerprovider.h"
 #include "powerstatemonitor.h"
@@ -35,6 +37,7 @@ namespace Baloo {
 class Database;
 class FileIndexerConfig;
 class FileContentIndexer;
+class WriteCoordinator;
 
 class FileIndexScheduler : public QObject
 {
@@ -43,10 +46,21 @@ class FileIndexScheduler : public QObject
 
     Q_PROPERTY(int state READ state NOTIFY stateChanged)
 public:
-    FileIndexScheduler(Database* db, FileIndexerConfig* config, QObject* parent = nullptr);
+    FileIndexScheduler(Database* db, FileIndexerConfig* config, WriteCoordinator* coordinator, QObject* parent = nullptr);
     ~FileIndexScheduler() Q_DECL_OVERRIDE;
     int state() const { return m_indexerState; }
 
+    /**
+     * The number of files waiting in each stage, and the extractor
+     * throughput, as exported on /metrics
+     */
+    QVariantMap metrics();
+
+    /**
+     * Schedules a ReconcileIndexer for the changes made after \p since
+     */
+    void reconcile(quint32 since);
+
 Q_SIGNALS:
     Q_SCRIPTABLE void stateChanged(int state);
 
@@ -82,14 +96,28 @@ public Q_SLOTS:
     Q_SCRIPTABLE void checkUnindexedFiles();
     Q_SCRIPTABLE uint getBatchSize();
 
+    /**
+     * Compacts the index once the indexer is idle
+     */
+    Q_SCRIPTABLE void compact();
+
+    /**
+     * Renumbers the documents in path order and compacts the index once
+     * the indexer is idle
+     */
+    Q_SCRIPTABLE void reorder();
+
 private Q_SLOTS:
     void powerManagementStatusChanged(bool isOnBattery);
 
 private:
     void setSuspend(bool suspend);
+    bool shouldCompact();
+    bool shouldRemoveStaleShards();
 
     Database* m_db;
     FileIndexerConfig* m_config;
+    WriteCoordinator* m_coordinator;
 
     QStringList m_newFiles;
     QStringList m_modifiedFiles;
@@ -106,6 +134,12 @@ private:
     TimeEstimator m_timeEstimator;
 
     bool m_checkUnindexedFiles;
+    quint32 m_reconcileSince;
+
+    bool m_compact;
+    bool m_reorder;
+    QElapsedTimer m_lastCompaction;
+    QElapsedTimer m_lastShardCheck;
 };
 
 }
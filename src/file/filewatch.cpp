@@ -37,6 +37,11 @@
 using namespace Baloo;
 
 FileWatch::FileWatch(Database* db, FileIndexerConfig* config, QObject* parent)
+    : FileWatch(db, config, nullptr, parent)
+{
+}
+
+FileWatch::FileWatch(Database* db, FileIndexerConfig* config, WriteCoordinator* coordinator, QObject* parent)
     : QObject(parent)
     , m_db(db)
     , m_config(config)
@@ -45,7 +50,7 @@ FileWatch::FileWatch(Database* db, FileIndexerConfig* config, QObject* parent)
     Q_ASSERT(db);
     Q_ASSERT(config);
 
-    m_metadataMover = new MetadataMover(m_db, this);
+    m_metadataMover = new MetadataMover(m_db, coordinator, this);
     connect(m_metadataMover, &MetadataMover::movedWithoutData, this, &FileWatch::indexNewFile);
     connect(m_metadataMover, &MetadataMover::fileRemoved, this, &FileWatch::fileRemoved);
 
@@ -73,6 +78,14 @@ FileWatch::~FileWatch()
 {
 }
 
+QVariantMap FileWatch::metrics() const
+{
+    QVariantMap map;
+    map.insert(QStringLiteral("inotifyEvents"), m_dirWatch->eventCount());
+    map.insert(QStringLiteral("inotifyEventsPerSecond"), m_dirWatch->eventsPerSecond());
+    return map;
+}
+
 void FileWatch::watchIndexedFolders()
 {
     // Watch all indexed folders
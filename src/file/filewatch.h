@@ -20,6 +20,7 @@
 #define BALOO_FILE_WATCH_H_
 
 #include <QObject>
+#include <QVariantMap>
 #include "pendingfile.h"
 
 class KInotify;
@@ -30,6 +31,7 @@ class Database;
 class MetadataMover;
 class FileIndexerConfig;
 class PendingFileQueue;
+class WriteCoordinator;
 class FileWatchTest;
 
 class FileWatch : public QObject
@@ -38,8 +40,18 @@ class FileWatch : public QObject
 
 public:
     FileWatch(Database* db, FileIndexerConfig* config, QObject* parent = nullptr);
+
+    /**
+     * Moves and deletes are queued with \p coordinator, which commits them in batches
+     */
+    FileWatch(Database* db, FileIndexerConfig* config, WriteCoordinator* coordinator, QObject* parent = nullptr);
     ~FileWatch();
 
+    /**
+     * The inotify event counters, as exported on /metrics
+     */
+    QVariantMap metrics() const;
+
 public Q_SLOTS:
     /**
      * To be called whenever the list of indexed folders changes. This is done because
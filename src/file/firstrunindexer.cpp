@@ -24,17 +24,21 @@
 
 #include "database.h"
 #include "transaction.h"
+#include "writecoordinator.h"
 
 #include <QMimeDatabase>
 
 using namespace Baloo;
 
-FirstRunIndexer::FirstRunIndexer(Database* db, FileIndexerConfig* config, const QStringList& folders)
-    : m_db(db)
+// The number of documents handed to the WriteCoordinator at once
+static const int s_batchSize = 500;
+
+FirstRunIndexer::FirstRunIndexer(WriteCoordinator* coordinator, FileIndexerConfig* config, const QStringList& folders)
+    : m_coordinator(coordinator)
     , m_config(config)
     , m_folders(folders)
 {
-    Q_ASSERT(m_db);
+    Q_ASSERT(m_coordinator);
     Q_ASSERT(m_config);
     Q_ASSERT(!m_folders.isEmpty());
 }
@@ -43,15 +47,33 @@ void FirstRunIndexer::run()
 {
     Q_ASSERT(m_config->isInitialRun());
     {
-        Transaction tr(m_db, Transaction::ReadOnly);
+        Transaction tr(m_coordinator->database(), Transaction::ReadOnly);
         Q_ASSERT_X(tr.size() == 0, "FirstRunIndexer", "The database is not empty on first run");
     }
 
     QMimeDatabase mimeDb;
 
-    for (const QString& folder : m_folders) {
-        Transaction tr(m_db, Transaction::ReadWrite);
+    QVector<Document> documents;
+    auto enqueue = [&]() {
+        // Waiting for the previous batch keeps at most two of them in memory,
+        // and the writer busy while the next one is collected
+        m_coordinator->flush();
+        m_coordinator->enqueue([documents](Transaction* tr) {
+            for (const Document& doc : documents) {
+                // Even though this is the first run, because 2 hard links will resolve to the same id,
+                // we land up crashing (due to the asserts in addDocument).
+                // Hence we are checking before.
+                // FIXME: Silently ignore hard links!
+                //
+                if (!tr->hasDocument(doc.id())) {
+                    tr->addDocument(doc);
+                }
+            }
+        });
+        documents.clear();
+    };
 
+    for (const QString& folder : m_folders) {
         FilteredDirIterator it(m_config, folder);
         while (!it.next().isEmpty()) {
             QString mimetype = mimeDb.mimeTypeForFile(it.filePath(), QMimeDatabase::MatchExtension).name();
@@ -65,22 +87,18 @@ void FirstRunIndexer::run()
                 continue;
             }
 
-            // Even though this is the first run, because 2 hard links will resolve to the same id,
-            // we land up crashing (due to the asserts in addDocument).
-            // Hence we are checking before.
-            // FIXME: Silently ignore hard links!
-            //
-            if (tr.hasDocument(job.document().id())) {
-                continue;
+            documents << job.document();
+            if (documents.size() == s_batchSize) {
+                enqueue();
             }
-            tr.addDocument(job.document());
         }
-
-        // FIXME: This would consume too much memory. We should make some more commits
-        //        based on how much memory we consume
-        tr.commit();
+    }
+    if (!documents.isEmpty()) {
+        enqueue();
     }
 
+    // The content indexer must find the files once we are done
+    m_coordinator->flush();
     m_config->setInitialRun(false);
 
     Q_EMIT done();
@@ -26,14 +26,18 @@
 
 namespace Baloo {
 
-class Database;
 class FileIndexerConfig;
+class WriteCoordinator;
 
+/**
+ * Indexes the include folders of an empty index, writing the documents in
+ * batches through the WriteCoordinator
+ */
 class FirstRunIndexer : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    FirstRunIndexer(Database* db, FileIndexerConfig* config, const QStringList& folders);
+    FirstRunIndexer(WriteCoordinator* coordinator, FileIndexerConfig* config, const QStringList& folders);
 
     void run() Q_DECL_OVERRIDE;
 
@@ -41,7 +45,7 @@ Q_SIGNALS:
     void done();
 
 private:
-    Database* m_db;
+    WriteCoordinator* m_coordinator;
     FileIndexerConfig* m_config;
 
     QStringList m_folders;
@@ -22,34 +22,96 @@
 
 #include "database.h"
 #include "transaction.h"
+#include "writecoordinator.h"
 #include "idutils.h"
 
 #include <QDebug>
 #include <QFile>
 #include <QMimeDatabase>
+#include <QScopedPointer>
+
+#include <functional>
 
 using namespace Baloo;
 
-IndexCleaner::IndexCleaner(Database* db, FileIndexerConfig* config)
-    : m_db(db)
+// The number of removed folders and files handed to the WriteCoordinator at once
+static const int s_batchSize = 500;
+
+IndexCleaner::IndexCleaner(WriteCoordinator* coordinator, FileIndexerConfig* config)
+    : m_coordinator(coordinator)
+    , m_db(coordinator->database())
     , m_config(config)
+    , m_removeExcluded(true)
 {
-    Q_ASSERT(db);
+    Q_ASSERT(coordinator);
     Q_ASSERT(config);
 }
 
+void IndexCleaner::setRemoveExcluded(bool remove)
+{
+    m_removeExcluded = remove;
+}
+
+void IndexCleaner::removeStaleShards()
+{
+    for (quint32 deviceId : m_db->shardDevices()) {
+        QByteArray top;
+        quint64 topId = 0;
+        {
+            Database* shard = m_db->shard(deviceId);
+            if (!shard) {
+                continue;
+            }
+
+            Transaction tr(shard, Transaction::ReadOnly);
+            quint64 firstId;
+            quint64 lastId;
+            if (!tr.documentIdRange(&firstId, &lastId)) {
+                continue;
+            }
+
+            // The topmost folder of the device, usually where it is mounted
+            const QByteArray url = tr.documentUrl(firstId);
+            if (url.isEmpty()) {
+                continue;
+            }
+            int pos = 0;
+            while (!topId && pos != -1) {
+                pos = url.indexOf('/', pos + 1);
+                top = pos == -1 ? url : url.left(pos);
+                const quint64 id = tr.documentId(top);
+                if (id && idToDeviceId(id) == deviceId) {
+                    topId = id;
+                }
+            }
+        }
+
+        if (topId && filePathToId(top) != topId) {
+            qDebug() << "device is gone: " << top;
+            m_db->removeShard(deviceId);
+        }
+    }
+}
+
 void IndexCleaner::run()
 {
-    QMimeDatabase mimeDb;
+    if (m_db->isSharded()) {
+        removeStaleShards();
+    }
+    if (!m_removeExcluded) {
+        Q_EMIT done();
+        return;
+    }
 
-    Transaction tr(m_db, Transaction::ReadWrite);
+    QMimeDatabase mimeDb;
+    QScopedPointer<Transaction> tr(new Transaction(m_db, Transaction::ReadOnly));
 
     auto shouldDelete = [&](quint64 id) {
         if (!id) {
             return false;
         }
 
-        QString url = tr.documentUrl(id);
+        QString url = tr->documentUrl(id);
 
         if (!QFile::exists(url)) {
             qDebug() << "not exists: " << url;
@@ -71,11 +133,44 @@ void IndexCleaner::run()
         return false;
     };
 
+    QVector<quint64> removedIds;
+    auto enqueue = [&]() {
+        m_coordinator->enqueue([removedIds](Transaction* tr) {
+            for (quint64 id : removedIds) {
+                if (tr->hasDocument(id)) {
+                    tr->removeRecursively(id);
+                }
+            }
+        });
+        removedIds.clear();
+
+        // Do not keep the pages of old snapshots from being reused
+        tr.reset(new Transaction(m_db, Transaction::ReadOnly));
+    };
+
+    // The children of a removed folder are removed along with it
+    std::function<void(quint64)> collect = [&](quint64 id) {
+        if (shouldDelete(id)) {
+            removedIds << id;
+            if (removedIds.size() == s_batchSize) {
+                enqueue();
+            }
+            return;
+        }
+        for (quint64 child : tr->documentChildren(id)) {
+            collect(child);
+        }
+    };
+
     for (const QString& folder : m_config->includeFolders()) {
         quint64 id = filePathToId(QFile::encodeName(folder));
-        tr.removeRecursively(id, shouldDelete);
+        collect(id);
+    }
+    if (!removedIds.isEmpty()) {
+        enqueue();
     }
-    tr.commit();
+    tr.reset();
+    m_coordinator->flush();
 
     Q_EMIT done();
 }
@@ -27,20 +27,39 @@ namespace Baloo {
 
 class Database;
 class FileIndexerConfig;
+class WriteCoordinator;
 
+/**
+ * Removes the documents which should no longer be indexed, and on a sharded
+ * index the shards of removed devices. The index is only read while looking
+ * for them, the documents are removed in batches through the WriteCoordinator.
+ */
 class IndexCleaner : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    IndexCleaner(Database* db, FileIndexerConfig* config);
+    IndexCleaner(WriteCoordinator* coordinator, FileIndexerConfig* config);
     void run() Q_DECL_OVERRIDE;
 
+    /**
+     * Whether to also remove the documents which should no longer be
+     * indexed, which walks all of them. Defaults to true.
+     */
+    void setRemoveExcluded(bool remove);
+
 Q_SIGNALS:
     void done();
 
 private:
+    /**
+     * Drops the shards of devices which are gone, or have been reformatted
+     */
+    void removeStaleShards();
+
+    WriteCoordinator* m_coordinator;
     Database* m_db;
     FileIndexerConfig* m_config;
+    bool m_removeExcluded;
 };
 }
 
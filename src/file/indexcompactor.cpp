@@ -0,0 +1,67 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "indexcompactor.h"
+#include "database.h"
+#include "transaction.h"
+#include "writecoordinator.h"
+
+#include <QDebug>
+
+using namespace Baloo;
+
+IndexCompactor::IndexCompactor(WriteCoordinator* coordinator)
+    : m_coordinator(coordinator)
+    , m_reorder(false)
+{
+    Q_ASSERT(m_coordinator);
+}
+
+void IndexCompactor::setReorder(bool reorder)
+{
+    m_reorder = reorder;
+}
+
+void IndexCompactor::run()
+{
+    if (m_reorder) {
+        bool reordered = false;
+        m_coordinator->enqueueAlone([&reordered](Transaction* tr) {
+            reordered = tr->reorderDocuments();
+        });
+        m_coordinator->flush();
+        if (reordered) {
+            qDebug() << "Reordered the documents of the index";
+        }
+    }
+
+    Database* db = m_coordinator->database();
+    const qint64 size = db->fileSize();
+
+    if (db->compact()) {
+        qDebug() << "Compacted the index from" << size << "to" << db->fileSize() << "bytes";
+    } else {
+        // Usually because other processes have the index open
+        qDebug() << "Could not compact the index";
+    }
+
+    Q_EMIT done();
+}
@@ -0,0 +1,58 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "indexermetrics.h"
+#include "filewatch.h"
+#include "fileindexscheduler.h"
+#include "enginemetrics.h"
+
+#include <QDBusConnection>
+
+using namespace Baloo;
+
+IndexerMetrics::IndexerMetrics(FileWatch* fileWatch, FileIndexScheduler* scheduler, QObject* parent)
+    : QObject(parent)
+    , m_fileWatch(fileWatch)
+    , m_scheduler(scheduler)
+{
+    Q_ASSERT(fileWatch);
+    Q_ASSERT(scheduler);
+
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/metrics"),
+                                                 this, QDBusConnection::ExportScriptableContents);
+}
+
+QVariantMap IndexerMetrics::metrics() const
+{
+    QVariantMap map = EngineMetrics::instance()->snapshot();
+
+    const QVariantMap scheduler = m_scheduler->metrics();
+    for (auto it = scheduler.constBegin(); it != scheduler.constEnd(); ++it) {
+        map.insert(it.key(), it.value());
+    }
+
+    const QVariantMap fileWatch = m_fileWatch->metrics();
+    for (auto it = fileWatch.constBegin(); it != fileWatch.constEnd(); ++it) {
+        map.insert(it.key(), it.value());
+    }
+
+    return map;
+}
@@ -0,0 +1,54 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_INDEXERMETRICS_H
+#define BALOO_INDEXERMETRICS_H
+
+#include <QObject>
+#include <QVariantMap>
+
+namespace Baloo {
+
+class FileWatch;
+class FileIndexScheduler;
+
+/**
+ * Exports the engine, scheduler and file watcher counters on /metrics.
+ * Nothing is computed until metrics() is called.
+ */
+class IndexerMetrics : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.baloo.metrics")
+public:
+    IndexerMetrics(FileWatch* fileWatch, FileIndexScheduler* scheduler, QObject* parent = nullptr);
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QVariantMap metrics() const;
+
+private:
+    FileWatch* m_fileWatch;
+    FileIndexScheduler* m_scheduler;
+};
+
+}
+
+#endif // BALOO_INDEXERMETRICS_H
@@ -34,7 +34,9 @@ enum IndexerState {
         ModifiedFiles,
         XAttrFiles,
         ContentIndexing,
-        UnindexedFileCheck
+        UnindexedFileCheck,
+        Compacting,
+        Cleaning
 };
 
 inline QString stateString(IndexerState state)
@@ -64,6 +66,12 @@ inline QString stateString(IndexerState state)
         break;
     case UnindexedFileCheck:
         status = i18n("Checking for unindexed files");
+        break;
+    case Compacting:
+        status = i18n("Compacting the index");
+        break;
+    case Cleaning:
+        status = i18n("Removing the documents of removed devices");
     }
     return status;
 }
@@ -25,6 +25,7 @@
 #include "baloodebug.h"
 
 #include <QSocketNotifier>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QDirIterator>
 #include <QFile>
@@ -67,6 +68,9 @@ class KInotify::Private
 public:
     Private(KInotify* parent)
         : userLimitReachedSignaled(false)
+        , eventCount(0)
+        , secondEvents(0)
+        , lastSecondEvents(0)
         , config(nullptr)
         , m_dirIter(nullptr)
         , m_inotifyFd(-1)
@@ -84,6 +88,32 @@ public:
     // This variable is set to true if the watch limit is reached, and reset when it is raised
     bool userLimitReachedSignaled;
 
+    // The events are counted per second, the rate is that of the last full second
+    quint64 eventCount;
+    QElapsedTimer secondTimer;
+    quint64 secondEvents;
+    quint64 lastSecondEvents;
+
+    void countEvents(quint64 count) {
+        rollSecond();
+        eventCount += count;
+        secondEvents += count;
+    }
+
+    void rollSecond() {
+        if (!secondTimer.isValid()) {
+            secondTimer.start();
+            return;
+        }
+        const qint64 elapsed = secondTimer.elapsed();
+        if (elapsed >= 1000) {
+            // Nothing happened in the last second if more than one has passed
+            lastSecondEvents = elapsed < 2000 ? secondEvents : 0;
+            secondEvents = 0;
+            secondTimer.restart();
+        }
+    }
+
     // url <-> wd mappings
     // Read the documentation fo OptimizedByteArray to understand why have a cache
     QHash<int, OptimizedByteArray> watchPathHash;
@@ -324,14 +354,17 @@ void KInotify::slotEvent(int socket)
     Q_ASSERT(len == avail);
 
     int i = 0;
+    quint64 events = 0;
     while (i < len) {
         const struct inotify_event* event = (struct inotify_event*)&buffer[i];
+        ++events;
 
         QByteArray path;
 
         // Overflow happens sometimes if we process the events too slowly
         if (event->wd < 0 && (event->mask & EventQueueOverflow)) {
             qWarning() << "Inotify - too many event - Overflowed";
+            d->countEvents(events);
             free(buffer);
             return;
         }
@@ -455,9 +488,21 @@ void KInotify::slotEvent(int socket)
         qCDebug(BALOO) << "Failed to read event.";
     }
 
+    d->countEvents(events);
     free(buffer);
 }
 
+quint64 KInotify::eventCount() const
+{
+    return d->eventCount;
+}
+
+quint64 KInotify::eventsPerSecond() const
+{
+    d->rollSecond();
+    return d->lastSecondEvents;
+}
+
 void KInotify::slotClearCookies()
 {
     QHashIterator<int, QPair<QByteArray, WatchFlags> > it(d->cookies);
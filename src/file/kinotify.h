@@ -104,6 +104,16 @@ public:
      */
     void resetUserLimit();
 
+    /**
+     * \return The number of inotify events received so far.
+     */
+    quint64 eventCount() const;
+
+    /**
+     * \return The number of inotify events received in the last second.
+     */
+    quint64 eventsPerSecond() const;
+
 public Q_SLOTS:
     bool addWatch(const QString& path, WatchEvents modes, WatchFlags flags = WatchFlags());
     bool removeWatch(const QString& path);
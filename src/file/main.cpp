@@ -26,6 +26,7 @@
 
 #include <QDebug>
 #include <QFileInfo>
+#include <QDir>
 #include <iostream>
 
 #include "global.h"
@@ -73,15 +74,23 @@ int main(int argc, char** argv)
         migrator.migrate();
     }
 
-    if (!QFile::exists(path + "/index")) {
+    if (!QFile::exists(path + "/index") && !QFile::exists(path + "/shards")) {
         indexerConfig.setInitialRun(true);
     }
 
     // HACK: Untill we start using lmdb with robust mutex support. We're just going to remove
     //       the lock manually in the baloo_file process.
     QFile::remove(path + "/index-lock");
+    const QStringList shards = QDir(path + "/shards").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& shard : shards) {
+        QFile::remove(path + "/shards/" + shard + "/index-lock");
+    }
 
     Baloo::Database *db = Baloo::globalDatabaseInstance();
+    if (indexerConfig.syncInterval()) {
+        db->setDurability(Baloo::Database::DeferredSync);
+    }
+    db->setSharded(indexerConfig.shardedIndex());
 
     /**
      * try to open, if that fails, try to unlink the index db and retry
@@ -91,6 +100,7 @@ int main(int argc, char** argv)
         qWarning() << "Failed to create database, removing corrupted database.";
         QFile::remove(path + "/index");
         QFile::remove(path + "/index-lock");
+        QDir(path + "/shards").removeRecursively();
         indexerConfig.setInitialRun(true);
 
         // try to create now after cleanup, if still no works => fail
@@ -100,6 +110,26 @@ int main(int argc, char** argv)
         }
     }
 
-    Baloo::MainHub hub(db, &indexerConfig);
-    return app.exec();
+    // A checkpoint left behind means the last run crashed, and whatever it
+    // committed after its last sync may have been lost. It stays until the
+    // ReconcileIndexer has repaired that, should we crash again.
+    quint32 checkpointTime = 0;
+    const bool reconcile = db->hasCheckpoint(&checkpointTime);
+    if (reconcile) {
+        db->holdCheckpoint(checkpointTime);
+    }
+    db->sync();
+
+    int ret;
+    {
+        Baloo::MainHub hub(db, &indexerConfig);
+        if (reconcile) {
+            hub.reconcile(checkpointTime);
+        }
+        ret = app.exec();
+    }
+
+    // All writers, including the extractor, are gone now
+    db->sync(true);
+    return ret;
 }
@@ -19,6 +19,7 @@
 
 #include "mainhub.h"
 #include "fileindexerconfig.h"
+#include "database.h"
 #include "mainadaptor.h"
 
 #include <QDBusConnection>
@@ -30,8 +31,10 @@ using namespace Baloo;
 MainHub::MainHub(Database* db, FileIndexerConfig* config)
     : m_db(db)
     , m_config(config)
-    , m_fileWatcher(db, config, this)
-    , m_fileIndexScheduler(db, config, this)
+    , m_writeCoordinator(db, this)
+    , m_fileWatcher(db, config, &m_writeCoordinator, this)
+    , m_fileIndexScheduler(db, config, &m_writeCoordinator, this)
+    , m_metrics(&m_fileWatcher, &m_fileIndexScheduler, this)
 {
     Q_ASSERT(db);
     Q_ASSERT(config);
@@ -43,6 +46,11 @@ MainHub::MainHub(Database* db, FileIndexerConfig* config)
 
     connect(&m_fileWatcher, &FileWatch::installedWatches, &m_fileIndexScheduler, &FileIndexScheduler::scheduleIndexing);
 
+    // The commits of both baloo_file and the extractor only reach the disk on sync
+    if (db->durability() == Database::DeferredSync) {
+        m_writeCoordinator.setSyncInterval(config->syncInterval() * 1000);
+    }
+
     MainAdaptor* main = new MainAdaptor(this);
     Q_UNUSED(main)
 
@@ -53,6 +61,11 @@ MainHub::MainHub(Database* db, FileIndexerConfig* config)
     QTimer::singleShot(0, &m_fileWatcher, &FileWatch::watchIndexedFolders);
 }
 
+void MainHub::reconcile(quint32 time)
+{
+    m_fileIndexScheduler.reconcile(time);
+}
+
 void MainHub::quit() const
 {
     QCoreApplication::instance()->quit();
@@ -24,6 +24,8 @@
 
 #include "filewatch.h"
 #include "fileindexscheduler.h"
+#include "indexermetrics.h"
+#include "writecoordinator.h"
 
 namespace Baloo {
 
@@ -37,6 +39,12 @@ class MainHub : public QObject
 public:
     MainHub(Database* db, FileIndexerConfig* config);
 
+    /**
+     * Checks all files changed since \p time, as their changes may
+     * have been lost by the crash of an earlier run
+     */
+    void reconcile(quint32 time);
+
 public Q_SLOTS:
     Q_SCRIPTABLE void quit() const;
     Q_SCRIPTABLE void updateConfig();
@@ -45,8 +53,12 @@ private:
     Database* m_db;
     FileIndexerConfig* m_config;
 
+    // Declared first so that it outlives everyone queueing writes with it
+    WriteCoordinator m_writeCoordinator;
+
     FileWatch m_fileWatcher;
     FileIndexScheduler m_fileIndexScheduler;
+    IndexerMetrics m_metrics;
 };
 }
 
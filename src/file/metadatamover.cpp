@@ -20,6 +20,7 @@
 #include "metadatamover.h"
 #include "database.h"
 #include "transaction.h"
+#include "writecoordinator.h"
 #include "basicindexingjob.h"
 #include "idutils.h"
 #include "baloodebug.h"
@@ -29,14 +30,24 @@
 using namespace Baloo;
 
 MetadataMover::MetadataMover(Database* db, QObject* parent)
+    : MetadataMover(db, nullptr, parent)
+{
+}
+
+MetadataMover::MetadataMover(Database* db, WriteCoordinator* coordinator, QObject* parent)
     : QObject(parent)
     , m_db(db)
+    , m_coordinator(coordinator)
 {
 }
 
 
 MetadataMover::~MetadataMover()
 {
+    // The queued mutations refer to us
+    if (m_coordinator) {
+        m_coordinator->flush();
+    }
 }
 
 
@@ -46,15 +57,22 @@ void MetadataMover::moveFileMetadata(const QString& from, const QString& to)
     Q_ASSERT(!from.isEmpty() && from != QLatin1String("/"));
     Q_ASSERT(!to.isEmpty() && to != QLatin1String("/"));
 
-    Transaction tr(m_db, Transaction::ReadWrite);
+    const auto mutation = [this, from, to](Transaction* tr) {
+        // We do NOT get deleted messages for overwritten files! Thus, we
+        // have to remove all metadata for overwritten files first.
+        removeMetadata(tr, to);
 
-    // We do NOT get deleted messages for overwritten files! Thus, we
-    // have to remove all metadata for overwritten files first.
-    removeMetadata(&tr, to);
+        // and finally update the old statements
+        updateMetadata(tr, from, to);
+    };
 
-    // and finally update the old statements
-    updateMetadata(&tr, from, to);
+    if (m_coordinator) {
+        m_coordinator->enqueue(mutation);
+        return;
+    }
 
+    Transaction tr(m_db, Transaction::ReadWrite);
+    mutation(&tr);
     tr.commit();
 }
 
@@ -62,6 +80,13 @@ void MetadataMover::removeFileMetadata(const QString& file)
 {
     Q_ASSERT(!file.isEmpty() && file != QLatin1String("/"));
 
+    if (m_coordinator) {
+        m_coordinator->enqueue([this, file](Transaction* tr) {
+            removeMetadata(tr, file);
+        });
+        return;
+    }
+
     Transaction tr(m_db, Transaction::ReadWrite);
     removeMetadata(&tr, file);
     tr.commit();
@@ -27,6 +27,7 @@ namespace Baloo
 
 class Database;
 class Transaction;
+class WriteCoordinator;
 
 class MetadataMover : public QObject
 {
@@ -34,6 +35,16 @@ class MetadataMover : public QObject
 
 public:
     MetadataMover(Database* db, QObject* parent = nullptr);
+
+    /**
+     * Queues the changes with \p coordinator instead of committing each
+     * of them on its own, the signals are then emitted from its thread.
+     */
+    MetadataMover(Database* db, WriteCoordinator* coordinator, QObject* parent = nullptr);
+
+    /**
+     * Waits for the queued changes to be committed
+     */
     ~MetadataMover();
 
 public Q_SLOTS:
@@ -65,6 +76,7 @@ private:
     void updateMetadata(Transaction* tr, const QString& from, const QString& to);
 
     Database* m_db;
+    WriteCoordinator* m_coordinator;
 };
 }
 
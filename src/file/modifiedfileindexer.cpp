@@ -22,8 +22,8 @@
 #include "fileindexerconfig.h"
 #include "idutils.h"
 
-#include "database.h"
 #include "transaction.h"
+#include "writecoordinator.h"
 
 #include <QMimeDatabase>
 #include <QFile>
@@ -32,12 +32,12 @@
 
 using namespace Baloo;
 
-ModifiedFileIndexer::ModifiedFileIndexer(Database* db, FileIndexerConfig* config, const QStringList& files)
-    : m_db(db)
+ModifiedFileIndexer::ModifiedFileIndexer(WriteCoordinator* coordinator, FileIndexerConfig* config, const QStringList& files)
+    : m_coordinator(coordinator)
     , m_config(config)
     , m_files(files)
 {
-    Q_ASSERT(m_db);
+    Q_ASSERT(m_coordinator);
     Q_ASSERT(m_config);
     Q_ASSERT(!m_files.isEmpty());
 }
@@ -46,60 +46,70 @@ void ModifiedFileIndexer::run()
 {
     QMimeDatabase mimeDb;
 
-    Transaction tr(m_db, Transaction::ReadWrite);
-
-    for (const QString& filePath : m_files) {
-        Q_ASSERT(!filePath.endsWith('/'));
-
-        QString fileName = filePath.mid(filePath.lastIndexOf('/') + 1);
-        if (!m_config->shouldFileBeIndexed(fileName)) {
-            continue;
-        }
-
-        QString mimetype = mimeDb.mimeTypeForFile(filePath, QMimeDatabase::MatchExtension).name();
-        if (!m_config->shouldMimeTypeBeIndexed(mimetype)) {
-            continue;
-        }
-
-        quint64 fileId = filePathToId(QFile::encodeName(filePath));
-        if (!fileId) {
-            continue;
-        }
-
-        quint32 mTime = tr.documentTimeInfo(fileId).mTime;
-
-        // A folders mtime is updated when a new file is added / removed / renamed
-        // we don't really need to reindex a folder when that happens
-        // In fact, we never need to reindex a folder
-        if (mTime && mimetype == QLatin1String("inode/directory")) {
-            continue;
-        }
-
-        // FIXME: Using QFileInfo over here is quite expensive!
-        QFileInfo fileInfo(filePath);
-        if (mTime == fileInfo.lastModified().toTime_t()) {
-            continue;
-        }
-
-        // FIXME: The BasicIndexingJob extracts too much info. We only need the time
-        BasicIndexingJob::IndexingLevel level =
-            m_config->onlyBasicIndexing() ? BasicIndexingJob::NoLevel : BasicIndexingJob::MarkForContentIndexing;
-        BasicIndexingJob job(filePath, mimetype, level);
-        if (!job.index()) {
-            continue;
+    QVector<Document> documents;
+    {
+        Transaction tr(m_coordinator->database(), Transaction::ReadOnly);
+
+        for (const QString& filePath : m_files) {
+            Q_ASSERT(!filePath.endsWith('/'));
+
+            QString fileName = filePath.mid(filePath.lastIndexOf('/') + 1);
+            if (!m_config->shouldFileBeIndexed(fileName)) {
+                continue;
+            }
+
+            QString mimetype = mimeDb.mimeTypeForFile(filePath, QMimeDatabase::MatchExtension).name();
+            if (!m_config->shouldMimeTypeBeIndexed(mimetype)) {
+                continue;
+            }
+
+            quint64 fileId = filePathToId(QFile::encodeName(filePath));
+            if (!fileId) {
+                continue;
+            }
+
+            quint32 mTime = tr.documentTimeInfo(fileId).mTime;
+
+            // A folders mtime is updated when a new file is added / removed / renamed
+            // we don't really need to reindex a folder when that happens
+            // In fact, we never need to reindex a folder
+            if (mTime && mimetype == QLatin1String("inode/directory")) {
+                continue;
+            }
+
+            // FIXME: Using QFileInfo over here is quite expensive!
+            QFileInfo fileInfo(filePath);
+            if (mTime == fileInfo.lastModified().toTime_t()) {
+                continue;
+            }
+
+            // FIXME: The BasicIndexingJob extracts too much info. We only need the time
+            BasicIndexingJob::IndexingLevel level =
+                m_config->onlyBasicIndexing() ? BasicIndexingJob::NoLevel : BasicIndexingJob::MarkForContentIndexing;
+            BasicIndexingJob job(filePath, mimetype, level);
+            if (!job.index()) {
+                continue;
+            }
+
+            documents << job.document();
         }
+    }
 
-        // we can get modified events for files which do not exist
-        // cause Baloo was not running and missed those events
-        if (tr.hasDocument(job.document().id())) {
-            tr.replaceDocument(job.document(), DocumentTime);
-            tr.setPhaseOne(job.document().id());
+    m_coordinator->enqueue([documents](Transaction* tr) {
+        for (const Document& doc : documents) {
+            // we can get modified events for files which do not exist
+            // cause Baloo was not running and missed those events
+            if (tr->hasDocument(doc.id())) {
+                tr->replaceDocument(doc, DocumentTime);
+                tr->setPhaseOne(doc.id());
+            }
+            else {
+                tr->addDocument(doc);
+            }
         }
-        else {
-            tr.addDocument(job.document());
-        }
-    }
+    });
 
-    tr.commit();
+    // The content indexer must find the modified files once we are done
+    m_coordinator->flush();
     Q_EMIT done();
 }
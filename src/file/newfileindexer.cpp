@@ -21,19 +21,19 @@
 #include "basicindexingjob.h"
 #include "fileindexerconfig.h"
 
-#include "database.h"
 #include "transaction.h"
+#include "writecoordinator.h"
 
 #include <QMimeDatabase>
 
 using namespace Baloo;
 
-NewFileIndexer::NewFileIndexer(Database* db, FileIndexerConfig* config, const QStringList& newFiles)
-    : m_db(db)
+NewFileIndexer::NewFileIndexer(WriteCoordinator* coordinator, FileIndexerConfig* config, const QStringList& newFiles)
+    : m_coordinator(coordinator)
     , m_config(config)
     , m_files(newFiles)
 {
-    Q_ASSERT(m_db);
+    Q_ASSERT(m_coordinator);
     Q_ASSERT(m_config);
     Q_ASSERT(!m_files.isEmpty());
 }
@@ -42,8 +42,7 @@ void NewFileIndexer::run()
 {
     QMimeDatabase mimeDb;
 
-    Transaction tr(m_db, Transaction::ReadWrite);
-
+    QVector<Document> documents;
     for (const QString& filePath : m_files) {
         Q_ASSERT(!filePath.endsWith('/'));
 
@@ -64,14 +63,21 @@ void NewFileIndexer::run()
             continue;
         }
 
-        // The same file can be sent twice though it shouldn't be.
-        // Lets just silently ignore it instead of crashing
-        if (tr.hasDocument(job.document().id())) {
-            continue;
-        }
-        tr.addDocument(job.document());
+        documents << job.document();
     }
 
-    tr.commit();
+    m_coordinator->enqueue([documents](Transaction* tr) {
+        for (const Document& doc : documents) {
+            // The same file can be sent twice though it shouldn't be.
+            // Lets just silently ignore it instead of crashing
+            if (tr->hasDocument(doc.id())) {
+                continue;
+            }
+            tr->addDocument(doc);
+        }
+    });
+
+    // The content indexer must find the new files once we are done
+    m_coordinator->flush();
     Q_EMIT done();
 }
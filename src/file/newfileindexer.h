@@ -26,8 +26,8 @@
 
 namespace Baloo {
 
-class Database;
 class FileIndexerConfig;
+class WriteCoordinator;
 
 /**
  * Does not check the folder path or the mtime of the file
@@ -36,7 +36,7 @@ class NewFileIndexer : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    NewFileIndexer(Database* db, FileIndexerConfig* config, const QStringList& newFiles);
+    NewFileIndexer(WriteCoordinator* coordinator, FileIndexerConfig* config, const QStringList& newFiles);
 
     void run() Q_DECL_OVERRIDE;
 
@@ -44,7 +44,7 @@ Q_SIGNALS:
     void done();
 
 private:
-    Database* m_db;
+    WriteCoordinator* m_coordinator;
     FileIndexerConfig* m_config;
     QStringList m_files;
 };
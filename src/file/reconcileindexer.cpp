@@ -0,0 +1,97 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "reconcileindexer.h"
+
+#include "filtereddiriterator.h"
+#include "database.h"
+#include "transaction.h"
+#include "fileindexerconfig.h"
+#include "writecoordinator.h"
+#include "idutils.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDebug>
+
+using namespace Baloo;
+
+ReconcileIndexer::ReconcileIndexer(WriteCoordinator* coordinator, FileIndexerConfig* config, quint32 since)
+    : UnindexedFileIndexer(coordinator, config, since)
+{
+}
+
+void ReconcileIndexer::run()
+{
+    const QStringList includeFolders = m_config->includeFolders();
+    qDebug() << "Reconciling changes since" << QDateTime::fromTime_t(m_changedSince);
+
+    for (const QString& includeFolder : includeFolders) {
+        QVector<quint64> removedIds;
+        {
+            Transaction tr(m_coordinator->database(), Transaction::ReadOnly);
+
+            // Removing or renaming a file updates the mtime of its folder, so only
+            // those folders can contain documents which no longer exist
+            FilteredDirIterator dirIt(m_config, includeFolder, FilteredDirIterator::DirsOnly);
+            while (!dirIt.next().isEmpty()) {
+                const QString folder = dirIt.filePath();
+                if (QFileInfo(folder).lastModified().toTime_t() < m_changedSince) {
+                    continue;
+                }
+
+                const quint64 folderId = filePathToId(QFile::encodeName(folder));
+                if (!folderId || !tr.hasDocument(folderId)) {
+                    continue;
+                }
+
+                const QVector<quint64> children = tr.documentChildren(folderId);
+                for (quint64 id : children) {
+                    const QByteArray url = tr.documentUrl(id);
+                    if (url.isEmpty() || !QFile::exists(QFile::decodeName(url))) {
+                        removedIds << id;
+                    }
+                }
+            }
+        }
+
+        if (!removedIds.isEmpty()) {
+            m_coordinator->enqueue([removedIds](Transaction* tr) {
+                for (quint64 id : removedIds) {
+                    if (tr->hasDocument(id)) {
+                        tr->removeRecursively(id);
+                    }
+                }
+            });
+        }
+    }
+
+    // Everything else which was lost shows up as a changed mtime or ctime
+    indexFiles();
+
+    // Only now that the repairs are committed may the checkpoint move on
+    Database* db = m_coordinator->database();
+    db->holdCheckpoint(0);
+    db->sync();
+
+    Q_EMIT done();
+}
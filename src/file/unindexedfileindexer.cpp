@@ -26,26 +26,79 @@
 #include "transaction.h"
 #include "fileindexerconfig.h"
 #include "basicindexingjob.h"
+#include "writecoordinator.h"
 
 #include <QMimeDatabase>
+#include <QScopedPointer>
 #include <QDebug>
 
 using namespace Baloo;
 
-UnindexedFileIndexer::UnindexedFileIndexer(Database* db, FileIndexerConfig* config)
-    : m_db(db)
+// The number of files handed to the WriteCoordinator at once
+static const int s_batchSize = 500;
+
+namespace {
+struct IndexedFile {
+    Document document;
+    bool mTimeChanged;
+    bool cTimeChanged;
+};
+}
+
+UnindexedFileIndexer::UnindexedFileIndexer(WriteCoordinator* coordinator, FileIndexerConfig* config, quint32 changedSince)
+    : m_coordinator(coordinator)
     , m_config(config)
+    , m_changedSince(changedSince)
 {
+    Q_ASSERT(m_coordinator);
+    Q_ASSERT(m_config);
 }
 
 void UnindexedFileIndexer::run()
+{
+    indexFiles();
+    Q_EMIT done();
+}
+
+void UnindexedFileIndexer::indexFiles()
 {
     QMimeDatabase m_mimeDb;
     QStringList includeFolders = m_config->includeFolders();
+    Database* db = m_coordinator->database();
+
+    QVector<IndexedFile> files;
+    auto enqueue = [&]() {
+        m_coordinator->enqueue([files](Transaction* tr) {
+            for (const IndexedFile& file : files) {
+                const Document& doc = file.document;
+
+                // We handle modified files by simply updating the mTime and filename in the Db and marking them for ContentIndexing
+                const quint64 id = doc.id();
+                if (tr->hasDocument(id)) {
+                    DocumentOperations ops = DocumentTime;
+                    if (file.cTimeChanged) {
+                        ops |= XAttrTerms;
+                        if (tr->documentUrl(id) != doc.url()) {
+                            ops |= (FileNameTerms | DocumentUrl);
+                        }
+                    }
+                    tr->replaceDocument(doc, ops);
+
+                    if (file.mTimeChanged) {
+                        tr->setPhaseOne(id);
+                    }
+                } else { // New file
+                    tr->addDocument(doc);
+                }
+            }
+        });
+        files.clear();
+    };
 
     for (const QString& includeFolder : includeFolders) {
-        Transaction tr(m_db, Transaction::ReadWrite);
-        UnIndexedFileIterator it(m_config, &tr, includeFolder);
+        QScopedPointer<Transaction> tr(new Transaction(db, Transaction::ReadOnly));
+        UnIndexedFileIterator it(m_config, tr.data(), includeFolder);
+        it.setChangedSince(m_changedSince);
 
         while (!it.next().isEmpty()) {
             QString mime = m_mimeDb.mimeTypeForFile(it.filePath(), QMimeDatabase::MatchExtension).name();
@@ -54,29 +107,20 @@ void UnindexedFileIndexer::run()
             BasicIndexingJob job(it.filePath(), mime, level);
             job.index();
 
-            // We handle modified files by simply updating the mTime and filename in the Db and marking them for ContentIndexing
-            const quint64 id = job.document().id();
-            if (tr.hasDocument(id)) {
-
-                DocumentOperations ops = DocumentTime;
-                if (it.cTimeChanged()) {
-                    ops |= XAttrTerms;
-                    if (tr.documentUrl(id) != it.filePath()) {
-                        ops |= (FileNameTerms | DocumentUrl);
-                    }
-                }
-                tr.replaceDocument(job.document(), ops);
-
-                if (it.mTimeChanged()) {
-                    tr.setPhaseOne(id);
-                }
+            files << IndexedFile{job.document(), it.mTimeChanged(), it.cTimeChanged()};
+            if (files.size() == s_batchSize) {
+                enqueue();
 
-            } else { // New file
-                tr.addDocument(job.document());
+                // Do not keep the pages of old snapshots from being reused
+                tr.reset(new Transaction(db, Transaction::ReadOnly));
+                it.setTransaction(tr.data());
             }
         }
-        tr.commit();
+    }
+    if (!files.isEmpty()) {
+        enqueue();
     }
 
-    Q_EMIT done();
+    // The content indexer must find the files once we are done
+    m_coordinator->flush();
 }
@@ -28,23 +28,38 @@
 
 namespace Baloo {
 
-class Database;
 class FileIndexerConfig;
+class WriteCoordinator;
 
+/**
+ * Indexes the files which are new or were modified while baloo_file was
+ * not running. The index is only read while walking the include folders,
+ * the changes are written in batches through the WriteCoordinator.
+ */
 class UnindexedFileIndexer : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    UnindexedFileIndexer(Database* db, FileIndexerConfig* config);
+    /**
+     * Only files whose mtime or ctime is at least \p changedSince are
+     * looked at, if it is set.
+     */
+    UnindexedFileIndexer(WriteCoordinator* coordinator, FileIndexerConfig* config, quint32 changedSince = 0);
 
     void run() Q_DECL_OVERRIDE;
 
 Q_SIGNALS:
     void done();
 
-private:
-    Database* m_db;
+protected:
+    /**
+     * Indexes the files and waits until the changes have been committed
+     */
+    void indexFiles();
+
+    WriteCoordinator* m_coordinator;
     FileIndexerConfig* m_config;
+    quint32 m_changedSince;
 };
 }
 
@@ -34,6 +34,7 @@ UnIndexedFileIterator::UnIndexedFileIterator(FileIndexerConfig* config, Transact
     , m_iter(config, folder, FilteredDirIterator::FilesAndDirs)
     , m_mTimeChanged(false)
     , m_cTimeChanged(false)
+    , m_changedSince(0)
 {
 }
 
@@ -41,6 +42,16 @@ UnIndexedFileIterator::~UnIndexedFileIterator()
 {
 }
 
+void UnIndexedFileIterator::setTransaction(Transaction* transaction)
+{
+    m_transaction = transaction;
+}
+
+void UnIndexedFileIterator::setChangedSince(quint32 time)
+{
+    m_changedSince = time;
+}
+
 QString UnIndexedFileIterator::filePath() const
 {
     return m_iter.filePath();
@@ -73,6 +84,13 @@ QString UnIndexedFileIterator::next()
             return QString();
         }
 
+        if (m_changedSince) {
+            const QFileInfo fileInfo(filePath);
+            if (fileInfo.lastModified().toTime_t() < m_changedSince && fileInfo.created().toTime_t() < m_changedSince) {
+                continue;
+            }
+        }
+
         // This mimetype may not be completely accurate, but that's okay. This is
         // just the initial phase of indexing. The second phase can try to find
         // a more accurate mimetype.
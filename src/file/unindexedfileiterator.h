@@ -44,6 +44,19 @@ public:
     ~UnIndexedFileIterator();
 
     QString next();
+
+    /**
+     * Compares the following files with \p transaction, which lets long
+     * walks move on to newer snapshots of the index.
+     */
+    void setTransaction(Transaction* transaction);
+
+    /**
+     * Skips the files whose mtime and ctime are both older than \p time
+     * without looking them up in the index
+     */
+    void setChangedSince(quint32 time);
+
     QString filePath() const;
     QString mimetype() const;
     bool mTimeChanged() const;
@@ -61,6 +74,7 @@ private:
 
     bool m_mTimeChanged;
     bool m_cTimeChanged;
+    quint32 m_changedSince;
 };
 
 }
@@ -0,0 +1,190 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "writecoordinator.h"
+#include "database.h"
+#include "transaction.h"
+
+using namespace Baloo;
+
+WriteCoordinator::WriteCoordinator(Database* db, QObject* parent)
+    : QThread(parent)
+    , m_db(db)
+    , m_queuedCount(0)
+    , m_committedCount(0)
+    , m_commitCount(0)
+    , m_flushWaiters(0)
+    , m_maxLatency(500)
+    , m_maxBatchSize(4096)
+    , m_syncInterval(0)
+    , m_stop(false)
+{
+    Q_ASSERT(db);
+    m_syncTimer.start();
+    start();
+}
+
+WriteCoordinator::~WriteCoordinator()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stop = true;
+        m_queueCondition.wakeAll();
+    }
+    wait();
+}
+
+void WriteCoordinator::enqueue(const Mutation& mutation)
+{
+    enqueue(mutation, false);
+}
+
+void WriteCoordinator::enqueueAlone(const Mutation& mutation)
+{
+    enqueue(mutation, true);
+}
+
+void WriteCoordinator::enqueue(const Mutation& mutation, bool alone)
+{
+    QMutexLocker locker(&m_mutex);
+    Q_ASSERT_X(!m_stop, "WriteCoordinator::enqueue", "The coordinator is being destroyed");
+
+    if (m_queue.isEmpty()) {
+        m_queueAge.start();
+    }
+    m_queue << QueuedMutation{mutation, alone};
+    m_queuedCount++;
+
+    // The writer only needs to wake up early for a new or a full window
+    if (m_queue.size() == 1 || m_queue.size() >= m_maxBatchSize || alone) {
+        m_queueCondition.wakeAll();
+    }
+}
+
+void WriteCoordinator::flush()
+{
+    Q_ASSERT_X(QThread::currentThread() != this, "WriteCoordinator::flush", "Called from a mutation");
+
+    QMutexLocker locker(&m_mutex);
+    const quint64 sequence = m_queuedCount;
+    if (m_committedCount >= sequence) {
+        return;
+    }
+
+    m_flushWaiters++;
+    m_queueCondition.wakeAll();
+    while (m_committedCount < sequence) {
+        m_commitCondition.wait(&m_mutex);
+    }
+    m_flushWaiters--;
+}
+
+void WriteCoordinator::setMaximumLatency(int msecs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxLatency = msecs;
+    m_queueCondition.wakeAll();
+}
+
+void WriteCoordinator::setMaximumBatchSize(int size)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxBatchSize = size;
+    m_queueCondition.wakeAll();
+}
+
+void WriteCoordinator::setSyncInterval(int msecs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_syncInterval = msecs;
+    m_queueCondition.wakeAll();
+}
+
+quint64 WriteCoordinator::commitCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_commitCount;
+}
+
+void WriteCoordinator::run()
+{
+    QMutexLocker locker(&m_mutex);
+    while (true) {
+        while (m_queue.isEmpty() && !m_stop) {
+            if (!m_syncInterval) {
+                m_queueCondition.wait(&m_mutex);
+                continue;
+            }
+
+            const qint64 remaining = m_syncInterval - m_syncTimer.elapsed();
+            if (remaining <= 0) {
+                locker.unlock();
+                m_db->sync();
+                locker.relock();
+                m_syncTimer.restart();
+                continue;
+            }
+            m_queueCondition.wait(&m_mutex, remaining);
+        }
+        if (m_queue.isEmpty()) {
+            break;
+        }
+
+        // Let the window fill up
+        while (!m_stop && !m_flushWaiters && m_queue.size() < m_maxBatchSize && !m_queue.last().alone) {
+            const qint64 remaining = m_maxLatency - m_queueAge.elapsed();
+            if (remaining <= 0) {
+                break;
+            }
+            m_queueCondition.wait(&m_mutex, remaining);
+        }
+
+        // A mutation which has to be alone ends the window before it
+        int count = 1;
+        if (!m_queue.first().alone) {
+            while (count < m_queue.size() && !m_queue.at(count).alone) {
+                count++;
+            }
+        }
+        const QVector<QueuedMutation> batch = m_queue.mid(0, count);
+        m_queue.remove(0, count);
+        const quint64 sequence = m_committedCount + count;
+        const int syncInterval = m_syncInterval;
+
+        locker.unlock();
+        {
+            Transaction tr(m_db, Transaction::ReadWrite);
+            for (const QueuedMutation& queued : batch) {
+                queued.mutation(&tr);
+            }
+            tr.commit();
+        }
+        if (syncInterval && m_syncTimer.elapsed() >= syncInterval) {
+            m_db->sync();
+            m_syncTimer.restart();
+        }
+        locker.relock();
+
+        m_committedCount = sequence;
+        m_commitCount++;
+        m_commitCondition.wakeAll();
+    }
+}
@@ -0,0 +1,134 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_WRITECOORDINATOR_H
+#define BALOO_WRITECOORDINATOR_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <functional>
+
+namespace Baloo {
+
+class Database;
+class Transaction;
+
+/**
+ * Serializes all of baloo_file's writes to the index through a single
+ * thread, which applies the queued mutations in one transaction per window.
+ *
+ * A window is committed once its oldest mutation has waited for the
+ * maximum latency, once it holds the maximum batch size, or as soon as
+ * someone is blocked in flush(). This way a storm of inotify events, such
+ * as renaming a large folder, costs a single commit instead of one per
+ * event.
+ *
+ * The mutations are run in the writer thread, so signals emitted by them
+ * are delivered queued.
+ */
+class WriteCoordinator : public QThread
+{
+    Q_OBJECT
+public:
+    typedef std::function<void(Transaction* tr)> Mutation;
+
+    explicit WriteCoordinator(Database* db, QObject* parent = nullptr);
+
+    /**
+     * Commits whatever is still queued before returning
+     */
+    ~WriteCoordinator() Q_DECL_OVERRIDE;
+
+    Database* database() const { return m_db; }
+
+    /**
+     * Queues \p mutation to be applied with the next commit. This never blocks
+     * on the database.
+     */
+    void enqueue(const Mutation& mutation);
+
+    /**
+     * Queues \p mutation to be applied in a transaction of its own, for
+     * those which have to be the only change, such as
+     * Transaction::reorderDocuments()
+     */
+    void enqueueAlone(const Mutation& mutation);
+
+    /**
+     * Blocks until all mutations which were queued before the call have
+     * been committed. Must not be called from a mutation.
+     */
+    void flush();
+
+    void setMaximumLatency(int msecs);
+    void setMaximumBatchSize(int size);
+
+    /**
+     * Calls Database::sync() every \p msecs, which flushes the commits of
+     * all processes writing to a database opened with DeferredSync.
+     * 0, the default, disables it.
+     */
+    void setSyncInterval(int msecs);
+
+    /**
+     * The number of transactions committed so far
+     */
+    quint64 commitCount() const;
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    Database* m_db;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_queueCondition;
+    QWaitCondition m_commitCondition;
+
+    struct QueuedMutation {
+        Mutation mutation;
+        bool alone;
+    };
+    void enqueue(const Mutation& mutation, bool alone);
+
+    QVector<QueuedMutation> m_queue;
+    QElapsedTimer m_queueAge;
+
+    // Sequence numbers of the last queued and the last committed mutation
+    quint64 m_queuedCount;
+    quint64 m_committedCount;
+    quint64 m_commitCount;
+
+    int m_flushWaiters;
+    int m_maxLatency;
+    int m_maxBatchSize;
+    int m_syncInterval;
+    QElapsedTimer m_syncTimer;
+    bool m_stop;
+};
+
+}
+
+#endif // BALOO_WRITECOORDINATOR_H
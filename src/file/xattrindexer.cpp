@@ -21,19 +21,19 @@
 #include "basicindexingjob.h"
 #include "fileindexerconfig.h"
 
-#include "database.h"
 #include "transaction.h"
+#include "writecoordinator.h"
 
 #include <QMimeDatabase>
 
 using namespace Baloo;
 
-XAttrIndexer::XAttrIndexer(Database* db, FileIndexerConfig* config, const QStringList& files)
-    : m_db(db)
+XAttrIndexer::XAttrIndexer(WriteCoordinator* coordinator, FileIndexerConfig* config, const QStringList& files)
+    : m_coordinator(coordinator)
     , m_config(config)
     , m_files(files)
 {
-    Q_ASSERT(m_db);
+    Q_ASSERT(m_coordinator);
     Q_ASSERT(m_config);
     Q_ASSERT(!m_files.isEmpty());
 }
@@ -42,8 +42,7 @@ void XAttrIndexer::run()
 {
     QMimeDatabase mimeDb;
 
-    Transaction tr(m_db, Transaction::ReadWrite);
-
+    QVector<Document> documents;
     for (const QString& filePath : m_files) {
         Q_ASSERT(!filePath.endsWith('/'));
 
@@ -65,18 +64,24 @@ void XAttrIndexer::run()
             continue;
         }
 
-        // FIXME: This slightly defeats the point of having separate indexers
-        //        But we can get xattr changes of a file, even when it doesn't exist
-        //        cause we missed its creation somehow
-        if (!tr.hasDocument(job.document().id())) {
-            tr.addDocument(job.document());
-            continue;
-        }
-
-        // FIXME: Do we also need to update the ctime of the file?
-        tr.replaceDocument(job.document(), XAttrTerms);
+        documents << job.document();
     }
 
-    tr.commit();
+    m_coordinator->enqueue([documents](Transaction* tr) {
+        for (const Document& doc : documents) {
+            // FIXME: This slightly defeats the point of having separate indexers
+            //        But we can get xattr changes of a file, even when it doesn't exist
+            //        cause we missed its creation somehow
+            if (!tr->hasDocument(doc.id())) {
+                tr->addDocument(doc);
+                continue;
+            }
+
+            // FIXME: Do we also need to update the ctime of the file?
+            tr->replaceDocument(doc, XAttrTerms);
+        }
+    });
+
+    m_coordinator->flush();
     Q_EMIT done();
 }
@@ -26,14 +26,14 @@
 
 namespace Baloo {
 
-class Database;
 class FileIndexerConfig;
+class WriteCoordinator;
 
 class XAttrIndexer : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    XAttrIndexer(Database* db, FileIndexerConfig* config, const QStringList& files);
+    XAttrIndexer(WriteCoordinator* coordinator, FileIndexerConfig* config, const QStringList& files);
 
     void run() Q_DECL_OVERRIDE;
 
@@ -41,7 +41,7 @@ Q_SIGNALS:
     void done();
 
 private:
-    Database* m_db;
+    WriteCoordinator* m_coordinator;
     FileIndexerConfig* m_config;
     QStringList m_files;
 };
@@ -53,7 +53,7 @@ TagsProtocol::~TagsProtocol()
 
 namespace
 {
-KIO::UDSEntry createUDSEntryForTag(const QString& tag)
+KIO::UDSEntry createUDSEntryForTag(const QString& tag, int fileCount = -1)
 {
     KIO::UDSEntry uds;
     uds.insert(KIO::UDSEntry::UDS_NAME, tag);
@@ -64,6 +64,9 @@ KIO::UDSEntry createUDSEntryForTag(const QString& tag)
     uds.insert(KIO::UDSEntry::UDS_ACCESS, 0700);
     uds.insert(KIO::UDSEntry::UDS_USER, KUser().loginName());
     uds.insert(KIO::UDSEntry::UDS_ICON_NAME, QStringLiteral("tag"));
+    if (fileCount >= 0) {
+        uds.insert(KIO::UDSEntry::UDS_COMMENT, i18np("1 file", "%1 files", fileCount));
+    }
 
     return uds;
 }
@@ -79,49 +82,43 @@ void TagsProtocol::listDir(const QUrl& url)
 
     ParseResult result = parseUrl(url, tag, fileUrl);
 
-    TagListJob* job = new TagListJob();
-    job->exec();
-
     switch (result) {
     case InvalidUrl:
         return;
 
-    case RootUrl: {
-        qDebug() << "Root Url";
+    case RootUrl:
+    case TagUrl: {
+        // Only the current level of the tag hierarchy is read
+        TagListJob* job = new TagListJob();
+        job->setParentTag(tag);
+        job->exec();
 
-        for (QString resultTag : job->tags()) {
-            if (resultTag.contains(QLatin1Char('/'))) {
-                resultTag = resultTag.section(QLatin1Char('/'), 0, 0, QString::SectionSkipEmpty);
-            }
-            if (paths.contains(resultTag, Qt::CaseInsensitive)) {
+        for (const QString& resultTag : job->tags()) {
+            if (resultTag.isEmpty() || paths.contains(resultTag, Qt::CaseInsensitive)) {
                 continue;
-            } else {
-                paths.insert(0, resultTag);
             }
-            listEntry(createUDSEntryForTag(resultTag));
+            paths << resultTag;
+            listEntry(createUDSEntryForTag(resultTag, job->fileCount(resultTag)));
         }
 
-        finished();
-        return;
-    }
-
-    case TagUrl: {
-        for (QString resultTag : job->tags()) {
-            if (resultTag.startsWith(tag, Qt::CaseInsensitive) && resultTag.contains(QLatin1Char('/'))) {
-                resultTag.remove(0, (tag.size() + 1));
-                resultTag = resultTag.section(QLatin1Char('/'), 0, 0, QString::SectionSkipEmpty);
-                if (paths.contains(resultTag, Qt::CaseInsensitive)) {
-                    continue;
-                } else {
-                    paths.insert(0, resultTag);
-                }
-                listEntry(createUDSEntryForTag(resultTag));
-            }
+        if (result == RootUrl) {
+            finished();
+            return;
         }
 
         Query q;
         q.setSortingOption(Query::SortNone);
-        q.setSearchString(QStringLiteral("tag=\"%1\"").arg(tag));
+
+        // Every spelling of the tag has its own files
+        QStringList tagTerms;
+        for (const QString& parentTag : job->parentTags()) {
+            tagTerms << QStringLiteral("tag=\"%1\"").arg(parentTag);
+        }
+        if (tagTerms.isEmpty()) {
+            finished();
+            return;
+        }
+        q.setSearchString(tagTerms.join(QStringLiteral(" OR ")));
 
         ResultIterator it = q.exec();
         while (it.next()) {
@@ -65,6 +65,11 @@ KIO::UDSEntry createMonthUDSEntry(int month, int year)
                                 QDate(year, month, 1));
 }
 
+KIO::UDSEntry createYearUDSEntry(int year)
+{
+    return createFolderUDSEntry(QString::number(year), QString::number(year), QDate(year, 1, 1));
+}
+
 KIO::UDSEntry createDayUDSEntry(const QDate& date)
 {
     KIO::UDSEntry uds = createFolderUDSEntry(date.toString(QStringLiteral("yyyy-MM-dd")),
@@ -123,8 +128,13 @@ void TimelineProtocol::listDir(const QUrl& url)
         break;
 
     case CalendarFolder:
-        listThisYearsMonths();
-        // TODO: add entry for previous years
+        listMonths(QDate::currentDate().year());
+        listPreviousYears();
+        finished();
+        break;
+
+    case YearFolder:
+        listMonths(m_date.year());
         finished();
         break;
 
@@ -160,6 +170,7 @@ void TimelineProtocol::mimetype(const QUrl& url)
     switch (parseTimelineUrl(url, &m_date, &m_filename)) {
     case RootFolder:
     case CalendarFolder:
+    case YearFolder:
     case MonthFolder:
     case DayFolder:
         mimetype(QUrl(QLatin1String("inode/directory")));
@@ -191,6 +202,11 @@ void TimelineProtocol::stat(const QUrl& url)
         finished();
         break;
 
+    case YearFolder:
+        statEntry(createYearUDSEntry(m_date.year()));
+        finished();
+        break;
+
     case MonthFolder:
         statEntry(createMonthUDSEntry(m_date.month(), m_date.year()));
         finished();
@@ -212,41 +228,41 @@ void TimelineProtocol::stat(const QUrl& url)
 
 void TimelineProtocol::listDays(int month, int year)
 {
-    const int days = QDate(year, month, 1).daysInMonth();
-    for (int day = 1; day <= days; ++day) {
-        QDate date(year, month, day);
+    Query query;
+    query.setDateFilter(year, month);
 
-        if (date <= QDate::currentDate() && filesInDate(date)) {
-            listEntry(createDayUDSEntry(date));
+    const QMap<QDate, uint> days = query.dateHistogram(Query::Day);
+    for (auto it = days.constBegin(); it != days.constEnd(); ++it) {
+        if (it.key() <= QDate::currentDate()) {
+            listEntry(createDayUDSEntry(it.key()));
         }
     }
 }
 
-bool TimelineProtocol::filesInDate(const QDate& date)
+
+void TimelineProtocol::listMonths(int year)
 {
     Query query;
-    query.setLimit(1);
-    query.setDateFilter(date.year(), date.month(), date.day());
-    query.setSortingOption(Query::SortNone);
+    query.setDateFilter(year);
 
-    ResultIterator it = query.exec();
-    return it.next();
+    const QMap<QDate, uint> months = query.dateHistogram(Query::Month);
+    for (auto it = months.constBegin(); it != months.constEnd(); ++it) {
+        if (it.key() <= QDate::currentDate()) {
+            listEntry(createMonthUDSEntry(it.key().month(), it.key().year()));
+        }
+    }
 }
 
 
-void TimelineProtocol::listThisYearsMonths()
+void TimelineProtocol::listPreviousYears()
 {
     Query query;
-    query.setLimit(1);
-    query.setSortingOption(Query::SortNone);
 
-    int year = QDate::currentDate().year();
-    int currentMonth = QDate::currentDate().month();
-    for (int month = 1; month <= currentMonth; ++month) {
-        query.setDateFilter(year, month);
-        ResultIterator it = query.exec();
-        if (it.next()) {
-            listEntry(createMonthUDSEntry(month, year));
+    const int currentYear = QDate::currentDate().year();
+    const QMap<QDate, uint> years = query.dateHistogram(Query::Year);
+    for (auto it = years.constBegin(); it != years.constEnd(); ++it) {
+        if (it.key().year() < currentYear) {
+            listEntry(createYearUDSEntry(it.key().year()));
         }
     }
 }
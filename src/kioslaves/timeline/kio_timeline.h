@@ -55,8 +55,8 @@ public:
 
 private:
     void listDays(int month, int year);
-    void listThisYearsMonths();
-    bool filesInDate(const QDate& date);
+    void listMonths(int year);
+    void listPreviousYears();
 
     /// temp vars for the currently handled URL
     QDate m_date;
@@ -74,6 +74,7 @@ Baloo::TimelineFolderType Baloo::parseTimelineUrl(const QUrl& url, QDate* date,
     qDebug() << url;
 
     static QRegExp s_dateRegexp(QStringLiteral("\\d{4}-\\d{2}(?:-(\\d{2}))?"));
+    static QRegExp s_yearRegexp(QStringLiteral("\\d{4}"));
 
     // reset
     *date = QDate();
@@ -103,6 +104,11 @@ Baloo::TimelineFolderType Baloo::parseTimelineUrl(const QUrl& url, QDate* date,
             dateString = sections[sections.count() - 2];
             if (filename)
                 *filename = sections.last();
+        } else if (sections.count() == 2 && sections.first() == QLatin1String("calendar")
+                   && s_yearRegexp.exactMatch(sections.last())) {
+            *date = QDate(sections.last().toInt(), 1, 1);
+            qDebug() << url << "is year folder:" << date->year();
+            return date->isValid() ? YearFolder : NoFolder;
         } else {
             qDebug() << url << "COULD NOT PARSE";
             return NoFolder;
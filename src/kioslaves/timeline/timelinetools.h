@@ -48,7 +48,8 @@ namespace Baloo
 enum TimelineFolderType {
     NoFolder = 0,    /// nothing
     RootFolder,      /// the root folder
-    CalendarFolder,  /// the calendar folder listing all months
+    CalendarFolder,  /// the calendar folder listing this year's months and the previous years
+    YearFolder,      /// a folder listing a previous year's months (m_date contains the year)
     MonthFolder,     /// a folder listing a month's days (m_date contains the month)
     DayFolder        /// a folder listing a day (m_date); optionally m_filename is set
 };
@@ -137,12 +137,15 @@ Term AdvancedQueryParser::parse(const QString& text)
     // The parser does not do any look-ahead but has to store some state
     QStack<Term> stack;
     QStack<Term::Operation> ops;
+    QStack<bool> negations;
     Term termInConstruction;
     bool valueExpected = false;
+    bool negateNext = false;
     Term::Operation nextOp = Term::And;
 
     stack.push(Term());
     ops.push(Term::And);
+    negations.push(false);
 
     // Lex the input string
     QStringList tokens = lex(text);
@@ -177,6 +180,10 @@ Term AdvancedQueryParser::parse(const QString& text)
         } else if (token == QStringLiteral("OR")) {
             nextOp = Term::Or;
             continue;
+        } else if (token == QStringLiteral("NOT") || token == QStringLiteral("-")) {
+            // Negates the following term or group
+            negateNext = !negateNext;
+            continue;
         }
 
         // Handle the different comparators (and braces)
@@ -213,7 +220,9 @@ Term AdvancedQueryParser::parse(const QString& text)
 
                 stack.push(Term());
                 ops.push(Term::And);
+                negations.push(negateNext);
                 nextOp = Term::And;
+                negateNext = false;
                 termInConstruction = Term();
 
                 continue;
@@ -228,7 +237,11 @@ Term AdvancedQueryParser::parse(const QString& text)
                     // stack.pop() is the term that has just been closed. Append
                     // it to the term just above it.
                     ops.pop();
-                    addTermToStack(stack, stack.pop(), ops.top());
+                    Term closedTerm = stack.pop();
+                    if (negations.pop()) {
+                        closedTerm.setNegation(!closedTerm.isNegated());
+                    }
+                    addTermToStack(stack, closedTerm, ops.top());
                     nextOp = Term::And;
                     termInConstruction = Term();
                 }
@@ -251,7 +264,18 @@ Term AdvancedQueryParser::parse(const QString& text)
                 nextOp = Term::And;
             }
 
-            termInConstruction = Term(QString(), token);
+            // A leading minus negates a term, unless it is a negative number
+            QString word = token;
+            bool isNumber = false;
+            word.toInt(&isNumber);
+            if (word.size() > 1 && word.startsWith(QLatin1Char('-')) && !isNumber) {
+                word = word.mid(1);
+                negateNext = !negateNext;
+            }
+
+            termInConstruction = Term(QString(), word);
+            termInConstruction.setNegation(negateNext);
+            negateNext = false;
         }
     }
 
@@ -24,6 +24,8 @@
 #include "term.h"
 #include "advancedqueryparser.h"
 #include "searchstore.h"
+#include "queryjob.h"
+#include "queryclient.h"
 
 #include <QString>
 #include <QStringList>
@@ -61,6 +63,13 @@ public:
 
     SortingOption m_sortingOption;
     QString m_includeFolder;
+
+    /**
+     * The term which is actually searched for, combining m_term with the
+     * type, folder and, if \p withDateFilter is set, date filters
+     */
+    Term buildTerm(bool withDateFilter = true) const;
+    Term dateTerm() const;
 };
 
 Query::Query()
@@ -181,36 +190,92 @@ void Query::setIncludeFolder(const QString& folder)
     d->m_includeFolder = folder;
 }
 
-ResultIterator Query::exec()
+Term Query::Private::buildTerm(bool withDateFilter) const
 {
-    Term term(d->m_term);
-    if (!d->m_types.isEmpty()) {
-        for (const QString& type : d->m_types) {
+    Term term(m_term);
+    if (!m_types.isEmpty()) {
+        for (const QString& type : m_types) {
             term = term && Term(QStringLiteral("type"), type);
         }
     }
 
-    if (!d->m_includeFolder.isEmpty()) {
-        term = term && Term(QStringLiteral("includefolder"), d->m_includeFolder);
+    if (!m_includeFolder.isEmpty()) {
+        term = term && Term(QStringLiteral("includefolder"), m_includeFolder);
+    }
+
+    if (withDateFilter && (m_yearFilter || m_monthFilter || m_dayFilter)) {
+        term = term && dateTerm();
     }
 
-    if (d->m_yearFilter || d->m_monthFilter || d->m_dayFilter) {
-        QByteArray ba = QByteArray::number(d->m_yearFilter);
-        if (d->m_monthFilter < 10)
-            ba += '0';
-        ba += QByteArray::number(d->m_monthFilter);
-        if (d->m_dayFilter < 10)
-            ba += '0';
-        ba += QByteArray::number(d->m_dayFilter);
+    return term;
+}
 
-        term = term && Term(QStringLiteral("modified"), ba, Term::Equal);
+Term Query::Private::dateTerm() const
+{
+    if (!m_yearFilter && !m_monthFilter && !m_dayFilter) {
+        return Term();
+    }
+
+    QByteArray ba = QByteArray::number(m_yearFilter);
+    if (m_monthFilter < 10)
+        ba += '0';
+    ba += QByteArray::number(m_monthFilter);
+    if (m_dayFilter < 10)
+        ba += '0';
+    ba += QByteArray::number(m_dayFilter);
+
+    return Term(QStringLiteral("modified"), ba, Term::Equal);
+}
+
+ResultIterator Query::exec()
+{
+    // Prefer baloo_queryd, which keeps the index open and its caches warm
+    QStringList result;
+    if (QueryClient::exec(toJSON(), &result)) {
+        return ResultIterator(result);
     }
 
     SearchStore searchStore;
-    QStringList result = searchStore.exec(term, d->m_offset, d->m_limit, d->m_sortingOption == SortAuto);
+    result = searchStore.exec(d->buildTerm(), d->m_offset, d->m_limit, d->m_sortingOption == SortAuto);
     return ResultIterator(result);
 }
 
+QueryJob* Query::execAsync(QObject* parent)
+{
+    return new QueryJob(d->buildTerm(), d->m_offset, d->m_limit, d->m_sortingOption == SortAuto, parent);
+}
+
+QString Query::explain()
+{
+    SearchStore searchStore;
+    return searchStore.explain(d->buildTerm(), d->m_offset, d->m_limit, d->m_sortingOption == SortAuto);
+}
+
+QMap<QString, QMap<QString, int>> Query::facets(const QStringList& properties)
+{
+    SearchStore searchStore;
+    return searchStore.facets(d->buildTerm(), properties);
+}
+
+QMap<QDate, uint> Query::dateHistogram(DatePeriod period)
+{
+    MTimeDB::Granularity granularity = MTimeDB::Day;
+    switch (period) {
+    case Day:
+        granularity = MTimeDB::Day;
+        break;
+    case Month:
+        granularity = MTimeDB::Month;
+        break;
+    case Year:
+        granularity = MTimeDB::Year;
+        break;
+    }
+
+    SearchStore searchStore;
+    return searchStore.dateHistogram(d->buildTerm(false), d->dateTerm(), granularity);
+}
+
 QByteArray Query::toJSON()
 {
     QVariantMap map;
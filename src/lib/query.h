@@ -27,9 +27,13 @@
 #include "resultiterator.h"
 
 #include <QVariant>
+#include <QMap>
+#include <QDate>
 
 namespace Baloo {
 
+class QueryJob;
+
 /**
  * The Query class is the central class to query to search for files from the Index.
  *
@@ -57,6 +61,11 @@ namespace Baloo {
  * @example -
  * "type:Audio title:Fix" -> Look for Audio files which contains the title "Fix" in its title.
  *
+ * @example -
+ * "report -draft" or "report NOT draft" -> Look for files which contain the word "report" but
+ * not the word "draft". Negated terms and groups only exclude files, they have to be combined
+ * with a term which is not negated.
+ *
  * The Query Parser recognizes a large number of properties. These property names can be looked
  * up in KFileMetaData::Property::Property. The type of the file can mentioned with the property
  * 'type' or 'kind'.
@@ -140,6 +149,53 @@ public:
 
     ResultIterator exec();
 
+    /**
+     * Creates a job which runs the query in a worker thread and delivers
+     * the results in batches through QueryJob::resultsReady. The job has
+     * to be started with KJob::start().
+     *
+     * This should be preferred over exec() when the results are shown in
+     * a user interface, as it does not block.
+     */
+    QueryJob* execAsync(QObject* parent = nullptr);
+
+    /**
+     * Runs the query and returns a human readable report of how it was
+     * evaluated: the iterator tree after prefix expansion, and for every
+     * node the number of terms, database lookups, bytes decoded, next and
+     * skipTo calls, ids produced and the time spent.
+     *
+     * This is meant for diagnosing slow queries and is slower than exec().
+     */
+    QString explain();
+
+    /**
+     * Runs the query once and counts the matching files per value of each
+     * of the \p properties, which may be "type", "mimetype", "rating", "tag",
+     * and "year" or "month" for buckets of the modification time. Months
+     * are formatted as "yyyy-MM". Values without matches are left out.
+     *
+     * The limit and offset of the query are ignored.
+     */
+    QMap<QString, QMap<QString, int>> facets(const QStringList& properties);
+
+    enum DatePeriod {
+        Day,
+        Month,
+        Year
+    };
+
+    /**
+     * Counts the matching files per day, month or year of their modification
+     * time, keyed by the first day of each period. Only periods with matches
+     * are included. The date filter restricts the range which is counted.
+     *
+     * The modification time index is read in a single pass, which is a lot
+     * cheaper than running a query per period. A query without any search
+     * string, type or folder counts every indexed file.
+     */
+    QMap<QDate, uint> dateHistogram(DatePeriod period);
+
     QByteArray toJSON();
     static Query fromJSON(const QByteArray& arr);
 
@@ -0,0 +1,117 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "queryclient.h"
+#include "global.h"
+
+#include <QDataStream>
+#include <QLocalSocket>
+#include <QStandardPaths>
+#include <QtEndian>
+
+using namespace Baloo;
+
+// The daemon gets this long to answer before the query is run locally
+static const int s_timeout = 30000;
+
+QString QueryClient::socketPath()
+{
+    const QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    return runtimeDir + QStringLiteral("/baloo-query-%1").arg(qHash(fileIndexDbPath()), 0, 16);
+}
+
+QByteArray QueryClient::frame(const QByteArray& payload)
+{
+    QByteArray arr(sizeof(quint32), Qt::Uninitialized);
+    qToBigEndian<quint32>(payload.size(), reinterpret_cast<uchar*>(arr.data()));
+
+    return arr + payload;
+}
+
+bool QueryClient::takeFrame(QByteArray* buffer, QByteArray* payload)
+{
+    if (static_cast<uint>(buffer->size()) < sizeof(quint32)) {
+        return false;
+    }
+
+    const quint32 size = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(buffer->constData()));
+    if (static_cast<quint64>(buffer->size()) < sizeof(quint32) + static_cast<quint64>(size)) {
+        return false;
+    }
+
+    *payload = buffer->mid(sizeof(quint32), size);
+    buffer->remove(0, sizeof(quint32) + size);
+    return true;
+}
+
+QByteArray QueryClient::serializeResults(const QStringList& results)
+{
+    QByteArray arr;
+    QDataStream stream(&arr, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << results;
+
+    return arr;
+}
+
+QStringList QueryClient::deserializeResults(const QByteArray& payload)
+{
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    QStringList results;
+    stream >> results;
+    return results;
+}
+
+bool QueryClient::exec(const QByteArray& json, QStringList* results)
+{
+    Q_ASSERT(results);
+
+    QLocalSocket socket;
+    socket.connectToServer(socketPath());
+    if (!socket.waitForConnected(100)) {
+        return false;
+    }
+
+    socket.write(frame(json));
+
+    QStringList received;
+    QByteArray buffer;
+    QByteArray payload;
+    while (true) {
+        while (!takeFrame(&buffer, &payload)) {
+            if (!socket.waitForReadyRead(s_timeout)) {
+                return false;
+            }
+            buffer += socket.readAll();
+        }
+
+        const QStringList batch = deserializeResults(payload);
+        if (batch.isEmpty()) {
+            break;
+        }
+        received << batch;
+    }
+
+    *results << received;
+    return true;
+}
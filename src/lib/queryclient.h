@@ -0,0 +1,69 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_QUERYCLIENT_H
+#define BALOO_QUERYCLIENT_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+namespace Baloo {
+
+/**
+ * baloo_queryd runs queries on behalf of other processes, which then do not
+ * have to open the index themselves and benefit from its warm caches.
+ *
+ * Messages are framed with a big endian quint32 length. The client sends
+ * one frame with Query::toJSON(), and the daemon replies with frames which
+ * contain a QDataStream serialized QStringList of results each. An empty
+ * list ends the reply.
+ */
+namespace QueryClient {
+
+/**
+ * The socket lives in the user's runtime directory and is specific to the
+ * index, so that a daemon never answers queries for another database.
+ */
+QString socketPath();
+
+QByteArray frame(const QByteArray& payload);
+
+/**
+ * Removes the first complete frame from \p buffer and stores its payload
+ * in \p payload. Returns false if \p buffer does not contain one yet.
+ */
+bool takeFrame(QByteArray* buffer, QByteArray* payload);
+
+QByteArray serializeResults(const QStringList& results);
+QStringList deserializeResults(const QByteArray& payload);
+
+/**
+ * Runs \p json in baloo_queryd and appends the results to \p results.
+ * Returns false if the daemon is not running or went away, in which case
+ * the query has to be run locally.
+ */
+bool exec(const QByteArray& json, QStringList* results);
+
+}
+}
+
+#endif // BALOO_QUERYCLIENT_H
@@ -0,0 +1,204 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "queryjob.h"
+#include "searchstore.h"
+#include "term.h"
+
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QAtomicInt>
+
+using namespace Baloo;
+
+/**
+ * Batches start with this many results and double up to s_maxBatchSize.
+ */
+static const int s_firstBatchSize = 32;
+static const int s_maxBatchSize = 4096;
+
+namespace Baloo {
+
+/**
+ * Shared between the job and its worker, which may outlive the job
+ */
+struct QueryJobState
+{
+    QAtomicInt stop;
+    QSemaphore credits;
+};
+
+class QueryJobWorker : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    QueryJobWorker(const Term& term, uint offset, int limit, bool sortResults,
+                   const QSharedPointer<QueryJobState>& state)
+        : m_term(term)
+        , m_offset(offset)
+        , m_limit(limit)
+        , m_sortResults(sortResults)
+        , m_state(state)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void resultsReady(const QStringList& filePaths, int total);
+    void finished();
+
+private:
+    bool waitForCredit();
+
+    Term m_term;
+    uint m_offset;
+    int m_limit;
+    bool m_sortResults;
+    QSharedPointer<QueryJobState> m_state;
+};
+
+}
+
+void QueryJobWorker::run()
+{
+    // The ids are collected first, so that no transaction is held while
+    // waiting for the receiver. It would keep the snapshot alive, and with
+    // it the pages which later commits could reuse.
+    SearchStore searchStore;
+    const QVector<quint64> ids = searchStore.resultIds(m_term, m_offset, m_limit, m_sortResults);
+
+    int pos = 0;
+    int batchSize = s_firstBatchSize;
+    while (pos < ids.size() && waitForCredit()) {
+        // Each batch resolves its urls in a short transaction of its own
+        const QStringList batch = searchStore.filePaths(ids.mid(pos, batchSize));
+        if (batch.isEmpty()) {
+            m_state->credits.release();
+        } else {
+            Q_EMIT resultsReady(batch, ids.size());
+        }
+
+        pos += batchSize;
+        batchSize = qMin(batchSize * 2, s_maxBatchSize);
+    }
+
+    Q_EMIT finished();
+}
+
+bool QueryJobWorker::waitForCredit()
+{
+    // Wait for the receiver to catch up
+    while (!m_state->credits.tryAcquire(1, 100)) {
+        if (m_state->stop.load()) {
+            return false;
+        }
+    }
+    return !m_state->stop.load();
+}
+
+class QueryJob::Private {
+public:
+    Term term;
+    uint offset;
+    int limit;
+    bool sortResults;
+
+    int maxPendingBatches;
+    qulonglong processed;
+    QSharedPointer<QueryJobState> state;
+};
+
+QueryJob::QueryJob(const Term& term, uint offset, int limit, bool sortResults, QObject* parent)
+    : KJob(parent)
+    , d(new Private)
+{
+    d->term = term;
+    d->offset = offset;
+    d->limit = limit;
+    d->sortResults = sortResults;
+    d->maxPendingBatches = 2;
+    d->processed = 0;
+}
+
+QueryJob::~QueryJob()
+{
+    doKill();
+    delete d;
+}
+
+void QueryJob::setMaxPendingBatches(int count)
+{
+    Q_ASSERT(count > 0);
+    Q_ASSERT_X(!d->state, "QueryJob::setMaxPendingBatches", "The job has already been started");
+
+    d->maxPendingBatches = count;
+}
+
+int QueryJob::maxPendingBatches() const
+{
+    return d->maxPendingBatches;
+}
+
+void QueryJob::start()
+{
+    Q_ASSERT_X(!d->state, "QueryJob::start", "The job has already been started");
+
+    d->state.reset(new QueryJobState);
+    d->state->credits.release(d->maxPendingBatches);
+
+    QueryJobWorker* worker = new QueryJobWorker(d->term, d->offset, d->limit, d->sortResults, d->state);
+    connect(worker, &QueryJobWorker::resultsReady, this, [this](const QStringList& filePaths, int total) {
+        if (d->state->stop.load()) {
+            return;
+        }
+
+        setTotalAmount(KJob::Files, total);
+        d->processed += filePaths.size();
+        Q_EMIT resultsReady(this, filePaths);
+        setProcessedAmount(KJob::Files, d->processed);
+
+        d->state->credits.release();
+    });
+    connect(worker, &QueryJobWorker::finished, this, [this]() {
+        if (d->state->stop.load()) {
+            return;
+        }
+
+        setTotalAmount(KJob::Files, d->processed);
+        emitResult();
+    });
+
+    QThreadPool::globalInstance()->start(worker);
+}
+
+bool QueryJob::doKill()
+{
+    if (d->state) {
+        d->state->stop.store(1);
+        d->state->credits.release(d->maxPendingBatches);
+    }
+    return true;
+}
+
+#include "queryjob.moc"
@@ -0,0 +1,80 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_QUERYJOB_H
+#define BALOO_QUERYJOB_H
+
+#include <KJob>
+#include <QStringList>
+#include "core_export.h"
+
+namespace Baloo {
+
+class Query;
+class Term;
+
+/**
+ * Runs a Query in a worker thread and delivers the results in batches.
+ *
+ * The batches start small, so that the first results show up quickly, and
+ * grow while the results keep coming. The number of results is reported as
+ * the total amount of KJob::Files, and the processed amount is updated with
+ * every batch.
+ *
+ * The worker never runs more than maxPendingBatches() batches ahead of the
+ * receiver, so a slow receiver slows the query down instead of piling up
+ * events. Killing the job stops the query.
+ *
+ * \sa Query::execAsync
+ */
+class BALOO_CORE_EXPORT QueryJob : public KJob
+{
+    Q_OBJECT
+public:
+    ~QueryJob() Q_DECL_OVERRIDE;
+
+    /**
+     * The number of batches which may be delivered but not yet processed
+     * by the receiver. Has to be set before start(). Defaults to 2.
+     */
+    void setMaxPendingBatches(int count);
+    int maxPendingBatches() const;
+
+    void start() Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void resultsReady(Baloo::QueryJob* job, const QStringList& filePaths);
+
+protected:
+    bool doKill() Q_DECL_OVERRIDE;
+
+private:
+    QueryJob(const Term& term, uint offset, int limit, bool sortResults, QObject* parent);
+
+    class Private;
+    Private* d;
+
+    friend class Query;
+};
+
+}
+
+#endif // BALOO_QUERYJOB_H
@@ -0,0 +1,156 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "queryresultcache.h"
+#include "term.h"
+
+#include <QDateTime>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+using namespace Baloo;
+
+QueryResultCache::QueryResultCache(int maxCost)
+    : m_cache(maxCost)
+    , m_snapshotId(0)
+{
+}
+
+void QueryResultCache::setSnapshot(quint64 snapshotId)
+{
+    if (snapshotId > m_snapshotId) {
+        m_cache.clear();
+        m_snapshotId = snapshotId;
+    }
+}
+
+bool QueryResultCache::lookup(const QByteArray& key, quint64 snapshotId, QVector<quint64>* ids)
+{
+    Q_ASSERT(ids);
+
+    QMutexLocker locker(&m_mutex);
+    setSnapshot(snapshotId);
+    if (snapshotId != m_snapshotId) {
+        return false;
+    }
+
+    const QVector<quint64>* cached = m_cache.object(key);
+    if (!cached) {
+        return false;
+    }
+
+    *ids = *cached;
+    return true;
+}
+
+void QueryResultCache::insert(const QByteArray& key, quint64 snapshotId, const QVector<quint64>& ids)
+{
+    QMutexLocker locker(&m_mutex);
+    setSnapshot(snapshotId);
+    if (snapshotId != m_snapshotId) {
+        return;
+    }
+
+    const int cost = qMax(1, ids.size() * static_cast<int>(sizeof(quint64)));
+    m_cache.insert(key, new QVector<quint64>(ids), cost);
+}
+
+void QueryResultCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+}
+
+static void serializeValue(const QVariant& value, QByteArray& out)
+{
+    QByteArray val;
+    switch (value.type()) {
+    case QVariant::Date:
+        val = value.toDate().toString(Qt::ISODate).toUtf8();
+        break;
+    case QVariant::DateTime:
+        val = value.toDateTime().toString(Qt::ISODate).toUtf8();
+        break;
+    case QVariant::ByteArray:
+        val = value.toByteArray();
+        break;
+    default:
+        val = value.toString().toUtf8();
+        break;
+    }
+
+    out += QByteArray::number(value.userType());
+    out += ':';
+    out += QByteArray::number(val.size());
+    out += ':';
+    out += val;
+}
+
+static void serializeTerm(const Term& term, QByteArray& out)
+{
+    if (term.isNegated()) {
+        out += '!';
+    }
+
+    if (term.operation() == Term::And || term.operation() == Term::Or) {
+        QVector<QByteArray> subTerms;
+        for (const Term& t : term.subTerms()) {
+            QByteArray arr;
+            serializeTerm(t, arr);
+            subTerms << arr;
+        }
+        std::sort(subTerms.begin(), subTerms.end());
+
+        out += term.operation() == Term::And ? "(&" : "(|";
+        for (const QByteArray& arr : subTerms) {
+            out += arr;
+        }
+        out += ')';
+        return;
+    }
+
+    const QByteArray property = term.property().toLower().toUtf8();
+
+    out += '(';
+    out += QByteArray::number(property.size());
+    out += ':';
+    out += property;
+    out += QByteArray::number(static_cast<int>(term.comparator()));
+    out += ':';
+    serializeValue(term.value(), out);
+    out += ')';
+}
+
+QByteArray QueryResultCache::key(const Term& term, uint offset, int limit, bool sortResults)
+{
+    QByteArray key;
+    serializeTerm(term, key);
+
+    key += '#';
+    key += QByteArray::number(offset);
+    key += ',';
+    key += QByteArray::number(limit);
+    key += ',';
+    key += sortResults ? '1' : '0';
+
+    return key;
+}
@@ -0,0 +1,74 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_QUERYRESULTCACHE_H
+#define BALOO_QUERYRESULTCACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QVector>
+
+namespace Baloo {
+
+class Term;
+
+/**
+ * A process wide cache of query results, stored as the document ids which were
+ * returned for a given query.
+ *
+ * Each entry is only valid for the LMDB snapshot it was computed on. As soon as a
+ * newer snapshot is seen, all the entries are dropped. Lookups from an older
+ * snapshot never hit the cache.
+ *
+ * This class is thread safe.
+ */
+class QueryResultCache
+{
+public:
+    explicit QueryResultCache(int maxCost = 4 * 1024 * 1024);
+
+    /**
+     * Fills \p ids with the cached results for \p key if they were computed
+     * on the snapshot \p snapshotId. Returns false otherwise.
+     */
+    bool lookup(const QByteArray& key, quint64 snapshotId, QVector<quint64>* ids);
+    void insert(const QByteArray& key, quint64 snapshotId, const QVector<quint64>& ids);
+
+    void clear();
+
+    /**
+     * Builds a normalized key for the given query. Terms which only differ in the
+     * order of their sub terms result in the same key.
+     */
+    static QByteArray key(const Term& term, uint offset, int limit, bool sortResults);
+
+private:
+    void setSnapshot(quint64 snapshotId);
+
+    QMutex m_mutex;
+    QCache<QByteArray, QVector<quint64>> m_cache;
+    quint64 m_snapshotId;
+};
+
+}
+
+#endif // BALOO_QUERYRESULTCACHE_H
@@ -29,6 +29,12 @@
 
 namespace Baloo {
 
+/**
+ * Runs a Query in a QThreadPool and emits every result separately.
+ *
+ * Query::execAsync() should be preferred, as it delivers the results in
+ * batches and does not flood the receiver with one event per result.
+ */
 class BALOO_CORE_EXPORT QueryRunnable : public QObject, public QRunnable
 {
     Q_OBJECT
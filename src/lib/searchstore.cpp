@@ -30,21 +30,60 @@
 #include "queryparser.h"
 #include "termgenerator.h"
 #include "andpostingiterator.h"
+#include "andnotpostingiterator.h"
 #include "orpostingiterator.h"
+#include "rangepostingiterator.h"
+#include "vectorpostingiterator.h"
 #include "idutils.h"
+#include "queryresultcache.h"
+#include "queryprofile.h"
 
 #include <QStandardPaths>
 #include <QFile>
 #include <QFileInfo>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
 
 #include <KFileMetaData/PropertyInfo>
 #include <KFileMetaData/TypeInfo>
 #include <KFileMetaData/Types>
 
 #include <algorithm>
+#include <functional>
+#include <limits>
 
 using namespace Baloo;
 
+Q_GLOBAL_STATIC(QueryResultCache, s_resultCache)
+Q_GLOBAL_STATIC(QThreadPool, s_queryThreadPool)
+
+/**
+ * Queries which have to enumerate all their results are split into id ranges
+ * which are evaluated in parallel, when they are estimated to match at least
+ * this many documents.
+ */
+static const uint s_parallelThreshold = 50000;
+static const int s_maxPartitions = 8;
+
+namespace {
+class FunctionRunnable : public QRunnable
+{
+public:
+    explicit FunctionRunnable(const std::function<void ()>& func)
+        : m_func(func) {}
+
+    void run() Q_DECL_OVERRIDE {
+        m_func();
+    }
+
+private:
+    std::function<void ()> m_func;
+};
+}
+
 SearchStore::SearchStore()
     : m_db(nullptr)
 {
@@ -65,6 +104,32 @@ SearchStore::~SearchStore()
 {
 }
 
+QVector<quint64> SearchStore::cachedExec(Transaction* tr, const Term& term, uint offset, int limit, bool sortResults)
+{
+    const QByteArray cacheKey = QueryResultCache::key(term, offset, limit, sortResults);
+    const quint64 snapshotId = tr->snapshotId();
+
+    QVector<quint64> resultIds;
+    if (!s_resultCache->lookup(cacheKey, snapshotId, &resultIds)) {
+        resultIds = exec(tr, term, offset, limit, sortResults);
+        s_resultCache->insert(cacheKey, snapshotId, resultIds);
+    }
+    return resultIds;
+}
+
+static QStringList documentPaths(Transaction* tr, const QVector<quint64>& ids)
+{
+    QStringList paths;
+    paths.reserve(ids.size());
+    for (quint64 id : ids) {
+        const QByteArray url = tr->documentUrl(id);
+        if (!url.isEmpty()) {
+            paths << QString::fromUtf8(url);
+        }
+    }
+    return paths;
+}
+
 // Return the result with-in [offset, offset + limit)
 QStringList SearchStore::exec(const Term& term, uint offset, int limit, bool sortResults)
 {
@@ -73,27 +138,61 @@ QStringList SearchStore::exec(const Term& term, uint offset, int limit, bool sor
     }
 
     Transaction tr(m_db, Transaction::ReadOnly);
-    QScopedPointer<PostingIterator> it(constructQuery(&tr, term));
-    if (!it) {
+    return documentPaths(&tr, cachedExec(&tr, term, offset, limit, sortResults));
+}
+
+QVector<quint64> SearchStore::resultIds(const Term& term, uint offset, int limit, bool sortResults)
+{
+    if (!m_db || !m_db->isOpen()) {
+        return QVector<quint64>();
+    }
+
+    Transaction tr(m_db, Transaction::ReadOnly);
+    return cachedExec(&tr, term, offset, limit, sortResults);
+}
+
+QStringList SearchStore::filePaths(const QVector<quint64>& ids)
+{
+    if (!m_db || !m_db->isOpen()) {
         return QStringList();
     }
 
-    if (sortResults) {
-        QVector<quint64> resultIds;
-        while (it->next()) {
-            quint64 id = it->docId();
-            resultIds << id;
+    Transaction tr(m_db, Transaction::ReadOnly);
+    return documentPaths(&tr, ids);
+}
 
-            Q_ASSERT(id > 0);
+/**
+ * Returns the ids of the documents with the ordinals \p ordinals
+ */
+static QVector<quint64> documentIds(Transaction* tr, const QVector<quint64>& ordinals)
+{
+    QVector<quint64> ids;
+    ids.reserve(ordinals.size());
+    for (quint64 ordinal : ordinals) {
+        if (const quint64 id = tr->ordinalToId(ordinal)) {
+            ids << id;
         }
+    }
+    return ids;
+}
+
+QVector<quint64> SearchStore::exec(Transaction* tr, const Term& term, uint offset, int limit, bool sortResults)
+{
+    QScopedPointer<PostingIterator> it(constructQuery(tr, term));
+    if (!it) {
+        return QVector<quint64>();
+    }
+
+    if (sortResults) {
+        QVector<quint64> resultIds = documentIds(tr, fetchAll(tr, term, it.data()));
 
         // No enough result within range, no need to sort.
         if (offset >= static_cast<uint>(resultIds.size())) {
-            return QStringList();
+            return QVector<quint64>();
         }
 
-        auto compFunc = [&tr](const quint64 lhs, const quint64 rhs) {
-            return tr.documentTimeInfo(lhs).mTime > tr.documentTimeInfo(rhs).mTime;
+        auto compFunc = [tr](const quint64 lhs, const quint64 rhs) {
+            return tr->documentTimeInfo(lhs).mTime > tr->documentTimeInfo(rhs).mTime;
         };
 
         std::sort(resultIds.begin(), resultIds.end(), compFunc);
@@ -101,29 +200,29 @@ QStringList SearchStore::exec(const Term& term, uint offset, int limit, bool sor
             limit = resultIds.size();
         }
 
-        QStringList results;
         const uint end = qMin(static_cast<uint>(resultIds.size()), offset + static_cast<uint>(limit));
-        for (uint i = offset; i < end; i++) {
-            const quint64 id = resultIds[i];
-            const QString filePath = tr.documentUrl(id);
-
-            results << filePath;
+        return resultIds.mid(offset, end - offset);
+    }
+    else if (limit < 0) {
+        const QVector<quint64> resultIds = documentIds(tr, fetchAll(tr, term, it.data()));
+        if (offset >= static_cast<uint>(resultIds.size())) {
+            return QVector<quint64>();
         }
-
-        return results;
+        return resultIds.mid(offset);
     }
     else {
         uint i = 0;
-        QStringList results;
+        QVector<quint64> results;
         const uint end = offset + static_cast<uint>(limit);
 
-        while (it->next() && (limit < 0 || i < end)) {
-            quint64 id = it->docId();
-            Q_ASSERT(id > 0);
+        while (it->next() && i < end) {
+            quint64 ordinal = it->docId();
+            Q_ASSERT(ordinal > 0);
 
             if (i >= offset) {
-                results << tr.documentUrl(it->docId());
-                Q_ASSERT(!results.last().isEmpty());
+                if (const quint64 id = tr->ordinalToId(ordinal)) {
+                    results << id;
+                }
             }
 
             i++;
@@ -133,6 +232,254 @@ QStringList SearchStore::exec(const Term& term, uint offset, int limit, bool sor
     }
 }
 
+static QVector<quint64> fetchIds(PostingIterator* it)
+{
+    QVector<quint64> ids;
+    while (it->next()) {
+        quint64 id = it->docId();
+        ids << id;
+
+        Q_ASSERT(id > 0);
+    }
+    return ids;
+}
+
+QVector<quint64> SearchStore::fetchAll(Transaction* tr, const Term& term, PostingIterator* it)
+{
+    // Profiles are per transaction, and cannot be shared with the workers
+    int partitions = qBound(1, QThread::idealThreadCount(), s_maxPartitions);
+    if (partitions < 2 || tr->queryProfile()) {
+        return fetchIds(it);
+    }
+    if (it->estimatedSize() < s_parallelThreshold || tr->size() < s_parallelThreshold) {
+        return fetchIds(it);
+    }
+
+    quint64 firstId = 0;
+    quint64 lastId = 0;
+    if (!tr->ordinalRange(&firstId, &lastId)) {
+        return fetchIds(it);
+    }
+
+    // The ordinals are dense, so equal width ranges split the documents evenly
+    const quint64 width = (lastId - firstId) / partitions + 1;
+    QVector<QPair<quint64, quint64>> ranges;
+    for (quint64 begin = firstId; begin <= lastId; begin += width) {
+        const quint64 end = (lastId - begin < width) ? lastId : begin + width - 1;
+        ranges << qMakePair(begin, end);
+        if (end == lastId) {
+            break;
+        }
+    }
+    partitions = ranges.size();
+
+    // The range only guides the split, the partitions cover everything
+    ranges.first().first = 0;
+    ranges.last().second = std::numeric_limits<quint64>::max();
+
+    // Every worker evaluates its own copy of the query in its own transaction.
+    // A result is only used if that transaction sees the same snapshot.
+    QVector<QVector<quint64>> results(partitions);
+    QVector<bool> valid(partitions, false);
+    const quint64 snapshotId = tr->snapshotId();
+    QSemaphore finished;
+
+    for (int i = 1; i < partitions; i++) {
+        const QPair<quint64, quint64> range = ranges[i];
+        QVector<quint64>* result = &results[i];
+        bool* resultValid = &valid[i];
+
+        s_queryThreadPool->start(new FunctionRunnable([this, &term, &finished, range, result, resultValid, snapshotId]() {
+            Transaction workerTr(m_db, Transaction::ReadOnly);
+            if (workerTr.snapshotId() == snapshotId) {
+                if (PostingIterator* workerIt = constructQuery(&workerTr, term)) {
+                    RangePostingIterator rangeIt(workerIt, range.first, range.second);
+                    *result = fetchIds(&rangeIt);
+                }
+                *resultValid = true;
+            }
+            finished.release();
+        }));
+    }
+
+    {
+        // The first range is handled here, with the already constructed iterator
+        quint64 id = it->skipTo(ranges[0].first);
+        while (id && id <= ranges[0].second) {
+            results[0] << id;
+            id = it->next();
+        }
+        valid[0] = true;
+    }
+
+    finished.acquire(partitions - 1);
+
+    QVector<quint64> ids;
+    for (int i = 0; i < partitions; i++) {
+        if (!valid[i]) {
+            // The index changed in between, so redo this range in our snapshot
+            if (PostingIterator* rangeIt = constructQuery(tr, term)) {
+                RangePostingIterator iter(rangeIt, ranges[i].first, ranges[i].second);
+                results[i] = fetchIds(&iter);
+            }
+        }
+        ids += results[i];
+    }
+
+    return ids;
+}
+
+QString SearchStore::explain(const Term& term, uint offset, int limit, bool sortResults)
+{
+    if (!m_db || !m_db->isOpen()) {
+        return QString();
+    }
+
+    Transaction tr(m_db, Transaction::ReadOnly);
+
+    QueryProfile profile;
+    tr.setQueryProfile(&profile);
+
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<quint64> resultIds = exec(&tr, term, offset, limit, sortResults);
+    const qint64 nsecs = timer.nsecsElapsed();
+
+    tr.setQueryProfile(nullptr);
+
+    QString str;
+    QDebug(&str).nospace() << term;
+    str += QLatin1Char('\n') + profile.toString();
+    str += QStringLiteral("Results: %1\n").arg(resultIds.size());
+    str += QStringLiteral("Elapsed: %1 msecs\n").arg(nsecs / 1000000.0, 0, 'f', 3);
+    return str;
+}
+
+/**
+ * Returns the number of the sorted \p ids which \p it yields. Takes
+ * ownership of \p it.
+ */
+static int intersectionSize(const QVector<quint64>& ids, PostingIterator* it)
+{
+    if (!it) {
+        return 0;
+    }
+
+    QVector<PostingIterator*> vec = {new VectorPostingIterator(ids), it};
+    AndPostingIterator andIt(vec);
+
+    int count = 0;
+    while (andIt.next()) {
+        count++;
+    }
+    return count;
+}
+
+QMap<QString, QMap<QString, int>> SearchStore::facets(const Term& term, const QStringList& properties)
+{
+    QMap<QString, QMap<QString, int>> result;
+    if (!m_db || !m_db->isOpen()) {
+        return result;
+    }
+
+    Transaction tr(m_db, Transaction::ReadOnly);
+
+    QVector<quint64> ids;
+    {
+        QScopedPointer<PostingIterator> it(constructQuery(&tr, term));
+        if (it) {
+            ids = fetchAll(&tr, term, it.data());
+        }
+    }
+
+    for (const QString& property : properties) {
+        const QString name = property.toLower();
+        QMap<QString, int>& counts = result[property];
+        if (ids.isEmpty()) {
+            continue;
+        }
+
+        if (name == QLatin1String("year") || name == QLatin1String("month")) {
+            const QString format = name == QLatin1String("year") ? QStringLiteral("yyyy") : QStringLiteral("yyyy-MM");
+            for (quint64 ordinal : ids) {
+                const quint32 mTime = tr.documentTimeInfo(tr.ordinalToId(ordinal)).mTime;
+                counts[QDateTime::fromTime_t(mTime).toString(format)]++;
+            }
+            continue;
+        }
+
+        QByteArray prefix;
+        bool numeric = false;
+        if (name == QLatin1String("type") || name == QLatin1String("kind")) {
+            prefix = "T";
+            numeric = true;
+        } else if (name == QLatin1String("mimetype")) {
+            // "M" only has the words of the mimetypes
+            prefix = "MIME-";
+        } else if (name == QLatin1String("rating")) {
+            prefix = "R";
+            numeric = true;
+        } else if (name == QLatin1String("tag")) {
+            prefix = "TAG-";
+        } else {
+            qDebug() << "Property" << property << "cannot be used as a facet";
+            continue;
+        }
+
+        // Every value has its own posting list, which is intersected with the results
+        for (const QByteArray& t : tr.fetchTermsStartingWith(prefix)) {
+            const QByteArray value = t.mid(prefix.size());
+
+            QString label = QString::fromUtf8(value);
+            if (numeric) {
+                bool okay = false;
+                const int num = value.toInt(&okay);
+                // The type prefix is shared with the tag terms
+                if (!okay) {
+                    continue;
+                }
+                if (prefix == "T") {
+                    label = KFileMetaData::TypeInfo(static_cast<KFileMetaData::Type::Type>(num)).name();
+                }
+            }
+
+            const int count = intersectionSize(ids, tr.postingIterator(EngineQuery(t)));
+            if (count) {
+                counts[label] += count;
+            }
+        }
+    }
+
+    return result;
+}
+
+QMap<QDate, uint> SearchStore::dateHistogram(const Term& term, const Term& dateTerm, MTimeDB::Granularity granularity)
+{
+    QMap<QDate, uint> result;
+    if (!m_db || !m_db->isOpen()) {
+        return result;
+    }
+
+    quint32 beginTime = 0;
+    quint32 endTime = std::numeric_limits<quint32>::max();
+    if (!dateTerm.isEmpty() && !mTimeRange(dateTerm, &beginTime, &endTime)) {
+        return result;
+    }
+
+    Transaction tr(m_db, Transaction::ReadOnly);
+    if (term.isEmpty()) {
+        return tr.mTimeHistogram(beginTime, endTime, granularity);
+    }
+
+    QScopedPointer<PostingIterator> it(constructQuery(&tr, term));
+    if (!it) {
+        return result;
+    }
+
+    const QVector<quint64> ids = fetchAll(&tr, term, it.data());
+    return tr.mTimeHistogram(beginTime, endTime, granularity, &ids);
+}
+
 QByteArray SearchStore::fetchPrefix(const QByteArray& property) const
 {
     auto it = m_prefixes.constFind(property.toLower());
@@ -151,16 +498,68 @@ QByteArray SearchStore::fetchPrefix(const QByteArray& property) const
 
 }
 
+/**
+ * Returns the sub terms of the And/Or \p term with nested terms of the same
+ * kind pulled up and duplicates removed.
+ */
+static QList<Term> flattenedSubTerms(const Term& term)
+{
+    QList<Term> result;
+    QList<Term> pending = term.subTerms();
+    while (!pending.isEmpty()) {
+        const Term t = pending.takeFirst();
+        if (t.operation() == term.operation() && !t.isNegated()) {
+            pending = t.subTerms() + pending;
+            continue;
+        }
+        if (!result.contains(t)) {
+            result << t;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Folder and mtime constraints can either be evaluated by enumerating all the
+ * matching documents, or by checking each candidate of the rest of the query.
+ * The latter is used when the rest of the query is estimated to yield at most
+ * this many documents.
+ */
+static const uint s_postFilterThreshold = 10000;
+
+static bool isFilterTerm(const Term& term)
+{
+    if (term.operation() != Term::None || term.isNegated() || term.value().isNull()) {
+        return false;
+    }
+
+    const QString property = term.property().toLower();
+    return property == QLatin1String("includefolder") || property == QLatin1String("modified")
+        || property == QLatin1String("mtime");
+}
+
 PostingIterator* SearchStore::constructQuery(Transaction* tr, const Term& term)
 {
     Q_ASSERT(tr);
 
-    if (term.operation() == Term::And || term.operation() == Term::Or) {
-        QList<Term> subTerms = term.subTerms();
+    // The complement of a term cannot be enumerated, negated terms only
+    // exclude documents from the other sub terms of an And
+    if (term.isNegated()) {
+        qDebug() << "Negated terms are only supported within an And";
+        return nullptr;
+    }
+
+    if (term.operation() == Term::And) {
+        return constructAndQuery(tr, flattenedSubTerms(term));
+    }
+
+    if (term.operation() == Term::Or) {
+        const QList<Term> subTerms = flattenedSubTerms(term);
         QVector<PostingIterator*> vec;
         vec.reserve(subTerms.size());
 
-        for (const Term& t : term.subTerms()) {
+        for (const Term& t : subTerms) {
             vec << constructQuery(tr, t);
         }
 
@@ -168,11 +567,10 @@ PostingIterator* SearchStore::constructQuery(Transaction* tr, const Term& term)
             return nullptr;
         }
 
-        if (term.operation() == Term::And) {
-            return new AndPostingIterator(vec);
-        } else {
-            return new OrPostingIterator(vec);
+        if (QueryProfile* profile = tr->queryProfile()) {
+            return profile->create<OrPostingIterator>("OR", vec);
         }
+        return new OrPostingIterator(vec);
     }
 
     if (term.value().isNull()) {
@@ -190,52 +588,21 @@ PostingIterator* SearchStore::constructQuery(Transaction* tr, const Term& term)
         return tr->postingIterator(q);
     }
     else if (property == "includefolder") {
-        const QByteArray folder = QFile::encodeName(QFileInfo(value.toString()).canonicalPath());
-
-        Q_ASSERT(!folder.isEmpty());
-        Q_ASSERT(folder.startsWith('/'));
-
-        quint64 id = filePathToId(folder);
+        quint64 id = folderId(term);
         if (!id) {
-            qDebug() << "Folder" << value.toString() << "does not exist";
             return nullptr;
         }
 
         return tr->docUrlIter(id);
     }
     else if (property == "modified" || property == "mtime") {
-        if (value.type() == QVariant::ByteArray) {
-            QByteArray ba = value.toByteArray();
-            Q_ASSERT(ba.size() >= 4);
-
-            int year = ba.mid(0, 4).toInt();
-            int month = ba.mid(4, 2).toInt();
-            int day = ba.mid(6, 2).toInt();
-
-            Q_ASSERT(year);
-
-            // uses 0 to represent whole month or whole year
-            month = month >= 0 && month <= 12 ? month : 0;
-            day = day >= 0 && day <= 31 ? day : 0;
-
-            QDate startDate(year, month ? month : 1, day ? day : 1);
-            QDate endDate(startDate);
-
-            if (month == 0) {
-                endDate.setDate(endDate.year(), 12, 31);
-            } else if (day == 0) {
-                endDate.setDate(endDate.year(), endDate.month(), endDate.daysInMonth());
-            }
-
-            return tr->mTimeRangeIter(QDateTime(startDate).toTime_t(), QDateTime(endDate, QTime(23, 59, 59)).toTime_t());
-        }
-        else if (value.type() == QVariant::Date || value.type() == QVariant::DateTime) {
-            const QDateTime dt = value.toDateTime();
-            return constructMTimeQuery(tr, dt, term.comparator());
-        }
-        else {
-            Q_ASSERT_X(0, "SearchStore::constructQuery", "modified property must contain date/datetime values");
+        quint32 beginTime = 0;
+        quint32 endTime = 0;
+        if (!mTimeRange(term, &beginTime, &endTime)) {
+            return nullptr;
         }
+
+        return tr->mTimeRangeIter(beginTime, endTime);
     }
     else if (property == "rating") {
         bool okay = false;
@@ -371,32 +738,185 @@ EngineQuery SearchStore::constructTypeQuery(const QString& value)
     return EngineQuery('T' + QByteArray::number(num));
 }
 
-PostingIterator* SearchStore::constructMTimeQuery(Transaction* tr, const QDateTime& dt, Term::Comparator com)
+PostingIterator* SearchStore::constructAndQuery(Transaction* tr, const QList<Term>& subTerms)
 {
-    Q_ASSERT(dt.isValid());
-    quint32 timet = dt.toTime_t();
+    QVector<PostingIterator*> vec;
+    vec.reserve(subTerms.size());
+    QList<Term> filterTerms;
+    QList<Term> excludedTerms;
+
+    for (const Term& t : subTerms) {
+        if (t.isNegated()) {
+            excludedTerms << !t;
+        } else if (isFilterTerm(t)) {
+            filterTerms << t;
+        } else {
+            vec << constructQuery(tr, t);
+        }
+    }
 
-    MTimeDB::Comparator mtimeCom;
-    if (com == Term::Equal) {
-        mtimeCom = MTimeDB::Equal;
-        quint32 end = QDateTime(dt.date().addDays(1)).toTime_t() - 1;
-
-        return tr->mTimeRangeIter(timet, end);
-    }
-    else if (com == Term::GreaterEqual) {
-        mtimeCom = MTimeDB::GreaterEqual;
-    } else if (com == Term::Greater) {
-        timet++;
-        mtimeCom = MTimeDB::GreaterEqual;
-    } else if (com == Term::LessEqual) {
-        mtimeCom = MTimeDB::LessEqual;
-    } else if (com == Term::Less) {
-        mtimeCom = MTimeDB::LessEqual;
-        timet--;
-    } else {
-        Q_ASSERT_X(0, "SearchStore::constructQuery", "mtime query must contain a valid comparator");
+    if (vec.contains(nullptr)) {
+        qDeleteAll(vec);
+        return nullptr;
+    }
+
+    uint estimatedSize = PostingIterator::UnknownSize;
+    for (PostingIterator* it : vec) {
+        estimatedSize = qMin(estimatedSize, it->estimatedSize());
+    }
+
+    QList<Term> postFilterTerms;
+    for (const Term& t : filterTerms) {
+        if (estimatedSize <= s_postFilterThreshold) {
+            postFilterTerms << t;
+        } else {
+            vec << constructQuery(tr, t);
+        }
+    }
+
+    if (vec.isEmpty()) {
         return nullptr;
     }
 
-    return tr->mTimeIter(timet, mtimeCom);
+    // Excluded folders and mtime ranges are checked per document as well,
+    // everything else is skipped over on the excluded side
+    QList<Term> postExcludeTerms;
+    QVector<PostingIterator*> excluded;
+    for (const Term& t : excludedTerms) {
+        if (isFilterTerm(t) && estimatedSize <= s_postFilterThreshold) {
+            postExcludeTerms << t;
+        } else if (PostingIterator* excludedIt = constructQuery(tr, t)) {
+            excluded << excludedIt;
+        }
+    }
+
+    QueryProfile* profile = tr->queryProfile();
+    PostingIterator* it = vec.first();
+    if (vec.size() > 1) {
+        it = profile ? profile->create<AndPostingIterator>("AND", vec) : new AndPostingIterator(vec);
+    }
+    if (!excluded.isEmpty()) {
+        PostingIterator* excludedIt = excluded.first();
+        if (excluded.size() > 1) {
+            excludedIt = profile ? profile->create<OrPostingIterator>("OR", excluded) : new OrPostingIterator(excluded);
+        }
+
+        PostingIterator* andNotIt = new AndNotPostingIterator(it, excludedIt);
+        it = profile ? profile->wrap(andNotIt, "AND NOT", {it, excludedIt}) : andNotIt;
+    }
+
+    // Returns false if a filter matches nothing, and so the whole query
+    auto addPostFilter = [&](const Term& t, bool exclude) {
+        const QString property = t.property().toLower();
+        if (property == QLatin1String("includefolder")) {
+            quint64 id = folderId(t);
+            if (!id) {
+                return exclude;
+            }
+            it = tr->docUrlFilterIter(it, id, exclude);
+        } else {
+            quint32 beginTime = 0;
+            quint32 endTime = 0;
+            if (!mTimeRange(t, &beginTime, &endTime)) {
+                return exclude;
+            }
+            it = tr->mTimeRangeFilterIter(it, beginTime, endTime, exclude);
+        }
+        return true;
+    };
+
+    for (const Term& t : postFilterTerms) {
+        if (!addPostFilter(t, false)) {
+            delete it;
+            return nullptr;
+        }
+    }
+    for (const Term& t : postExcludeTerms) {
+        addPostFilter(t, true);
+    }
+
+    return it;
+}
+
+quint64 SearchStore::folderId(const Term& term) const
+{
+    const QByteArray folder = QFile::encodeName(QFileInfo(term.value().toString()).canonicalPath());
+
+    Q_ASSERT(!folder.isEmpty());
+    Q_ASSERT(folder.startsWith('/'));
+
+    quint64 id = filePathToId(folder);
+    if (!id) {
+        qDebug() << "Folder" << term.value().toString() << "does not exist";
+    }
+    return id;
+}
+
+bool SearchStore::mTimeRange(const Term& term, quint32* beginTime, quint32* endTime) const
+{
+    const QVariant value = term.value();
+
+    if (value.type() == QVariant::ByteArray) {
+        QByteArray ba = value.toByteArray();
+        Q_ASSERT(ba.size() >= 4);
+
+        int year = ba.mid(0, 4).toInt();
+        int month = ba.mid(4, 2).toInt();
+        int day = ba.mid(6, 2).toInt();
+
+        Q_ASSERT(year);
+
+        // uses 0 to represent whole month or whole year
+        month = month >= 0 && month <= 12 ? month : 0;
+        day = day >= 0 && day <= 31 ? day : 0;
+
+        QDate startDate(year, month ? month : 1, day ? day : 1);
+        QDate endDate(startDate);
+
+        if (month == 0) {
+            endDate.setDate(endDate.year(), 12, 31);
+        } else if (day == 0) {
+            endDate.setDate(endDate.year(), endDate.month(), endDate.daysInMonth());
+        }
+
+        *beginTime = QDateTime(startDate).toTime_t();
+        *endTime = QDateTime(endDate, QTime(23, 59, 59)).toTime_t();
+        return true;
+    }
+
+    if (value.type() != QVariant::Date && value.type() != QVariant::DateTime) {
+        Q_ASSERT_X(0, "SearchStore::constructQuery", "modified property must contain date/datetime values");
+        return false;
+    }
+
+    const QDateTime dt = value.toDateTime();
+    Q_ASSERT(dt.isValid());
+    const quint32 timet = dt.toTime_t();
+
+    // mtimes are never 0, which is what MTimeDB::iterRange relies on
+    switch (term.comparator()) {
+    case Term::Equal:
+        *beginTime = timet;
+        *endTime = QDateTime(dt.date().addDays(1)).toTime_t() - 1;
+        return true;
+    case Term::GreaterEqual:
+        *beginTime = timet;
+        *endTime = std::numeric_limits<quint32>::max();
+        return true;
+    case Term::Greater:
+        *beginTime = timet + 1;
+        *endTime = std::numeric_limits<quint32>::max();
+        return true;
+    case Term::LessEqual:
+        *beginTime = 1;
+        *endTime = timet;
+        return timet >= 1;
+    case Term::Less:
+        *beginTime = 1;
+        *endTime = timet - 1;
+        return timet >= 2;
+    default:
+        Q_ASSERT_X(0, "SearchStore::constructQuery", "mtime query must contain a valid comparator");
+        return false;
+    }
 }
@@ -26,7 +26,11 @@
 #include <QString>
 #include <QDateTime>
 #include <QHash>
+#include <QMap>
 #include "term.h"
+#include "mtimedb.h"
+
+#include <functional>
 
 namespace Baloo {
 
@@ -44,20 +48,78 @@ public:
 
     QStringList exec(const Term& term, uint offset, int limit, bool sortResults);
 
+    /**
+     * Returns the ids of the results like exec(). The transaction is ended
+     * before returning, so callers may take their time with the results.
+     */
+    QVector<quint64> resultIds(const Term& term, uint offset, int limit, bool sortResults);
+
+    /**
+     * Returns the file paths of \p ids in a transaction of its own. Ids which
+     * have been removed from the index meanwhile are left out.
+     */
+    QStringList filePaths(const QVector<quint64>& ids);
+
+    /**
+     * Runs the query like exec() while profiling it, bypassing the result cache,
+     * and returns the report. \sa Query::explain
+     */
+    QString explain(const Term& term, uint offset, int limit, bool sortResults);
+
+    /**
+     * Evaluates \p term once and counts the matches per value of each of
+     * the \p properties. \sa Query::facets
+     */
+    QMap<QString, QMap<QString, int>> facets(const Term& term, const QStringList& properties);
+
+    /**
+     * Counts the documents matching \p term per day, month or year of their
+     * modification time, restricted to the range of \p dateTerm unless it is
+     * empty. An empty \p term counts every document. \sa Query::dateHistogram
+     */
+    QMap<QDate, uint> dateHistogram(const Term& term, const Term& dateTerm, MTimeDB::Granularity granularity);
+
 private:
     QByteArray fetchPrefix(const QByteArray& property) const;
 
+    /**
+     * Returns the ids of the documents matching \p term with-in [offset, offset + limit)
+     */
+    QVector<quint64> exec(Transaction* tr, const Term& term, uint offset, int limit, bool sortResults);
+
+    /**
+     * Like the above, but looks the ids up in the result cache first
+     */
+    QVector<quint64> cachedExec(Transaction* tr, const Term& term, uint offset, int limit, bool sortResults);
+
+    /**
+     * Returns all the document ordinals yielded by \p it, which has been
+     * constructed for \p term. Large queries are split into ordinal ranges
+     * which are evaluated on a thread pool, each with its own transaction
+     * and copy of the query.
+     */
+    QVector<quint64> fetchAll(Transaction* tr, const Term& term, PostingIterator* it);
+
     Database* m_db;
     QHash<QByteArray, QByteArray> m_prefixes;
 
     PostingIterator* constructQuery(Transaction* tr, const Term& term);
 
+    /**
+     * Builds the intersection of \p subTerms. Folder and mtime constraints are
+     * applied as per document filters instead of being enumerated when the
+     * other terms are selective enough.
+     */
+    PostingIterator* constructAndQuery(Transaction* tr, const QList<Term>& subTerms);
+
     EngineQuery constructContainsQuery(const QByteArray& prefix, const QString& value);
     EngineQuery constructEqualsQuery(const QByteArray& prefix, const QString& value);
     EngineQuery constructTypeQuery(const QString& type);
 
     PostingIterator* constructRatingQuery(Transaction* tr, int rating);
-    PostingIterator* constructMTimeQuery(Transaction* tr, const QDateTime& dt, Term::Comparator com);
+
+    quint64 folderId(const Term& term) const;
+    bool mTimeRange(const Term& term, quint32* beginTime, quint32* endTime) const;
 };
 
 }
@@ -24,12 +24,20 @@
 #include "transaction.h"
 
 #include <QStringList>
+#include <QHash>
 
 using namespace Baloo;
 
 class TagListJob::Private {
 public:
+    Private() : hierarchical(false) {}
+
     QStringList tags;
+
+    bool hierarchical;
+    QString parentTag;
+    QStringList parentTags;
+    QHash<QString, TagDB::TagInfo> tagInfos;
 };
 
 TagListJob::TagListJob(QObject* parent)
@@ -43,6 +51,12 @@ TagListJob::~TagListJob()
     delete d;
 }
 
+void TagListJob::setParentTag(const QString& parentTag)
+{
+    d->hierarchical = true;
+    d->parentTag = parentTag;
+}
+
 void TagListJob::start()
 {
     Database *db = globalDatabaseInstance();
@@ -53,6 +67,55 @@ void TagListJob::start()
         return;
     }
 
+    if (d->hierarchical) {
+        Transaction tr(db, Transaction::ReadOnly);
+
+        // Tags are stored as they were written, but are looked up regardless
+        // of case, so "a/b" may stand for several tags
+        QVector<QByteArray> parents = {QByteArray()};
+        const QStringList components = d->parentTag.split(QLatin1Char('/'), QString::SkipEmptyParts);
+        for (const QString& component : components) {
+            QVector<QByteArray> matches;
+            for (const QByteArray& parent : parents) {
+                const QMap<QByteArray, TagDB::TagInfo> children = tr.tagChildren(parent);
+                for (auto it = children.constBegin(); it != children.constEnd(); ++it) {
+                    if (QString::fromUtf8(it.key()).compare(component, Qt::CaseInsensitive) == 0) {
+                        matches << (parent.isEmpty() ? it.key() : parent + '/' + it.key());
+                    }
+                }
+            }
+            parents = matches;
+        }
+        for (const QByteArray& parent : parents) {
+            d->parentTags << QString::fromUtf8(parent);
+        }
+
+        // Children which only differ in case are listed once
+        QHash<QString, QString> spellings;
+        for (const QByteArray& parent : parents) {
+            const QMap<QByteArray, TagDB::TagInfo> children = tr.tagChildren(parent);
+            for (auto it = children.constBegin(); it != children.constEnd(); ++it) {
+                const QString tag = QString::fromUtf8(it.key());
+                const QString folded = tag.toCaseFolded();
+
+                auto spelling = spellings.constFind(folded);
+                if (spelling == spellings.constEnd()) {
+                    spellings.insert(folded, tag);
+                    d->tags << tag;
+                    d->tagInfos.insert(tag, it.value());
+                    continue;
+                }
+
+                TagDB::TagInfo& info = d->tagInfos[spelling.value()];
+                info.documentCount += it.value().documentCount;
+                info.childCount += it.value().childCount;
+            }
+        }
+
+        emitResult();
+        return;
+    }
+
     QVector<QByteArray> tagList;
     {
         Transaction tr(db, Transaction::ReadOnly);
@@ -70,3 +133,18 @@ QStringList TagListJob::tags()
 {
     return d->tags;
 }
+
+QStringList TagListJob::parentTags() const
+{
+    return d->parentTags;
+}
+
+uint TagListJob::fileCount(const QString& tag) const
+{
+    return d->tagInfos.value(tag).documentCount;
+}
+
+bool TagListJob::hasChildTags(const QString& tag) const
+{
+    return d->tagInfos.value(tag).childCount > 0;
+}
@@ -33,9 +33,37 @@ public:
     explicit TagListJob(QObject* parent = nullptr);
     ~TagListJob() Q_DECL_OVERRIDE;
 
+    /**
+     * Only list the tags directly below \p parentTag by their last component,
+     * "a/b" is listed as "b" below "a". An empty \p parentTag lists the top
+     * level tags. By default every tag is listed by its full name.
+     *
+     * \p parentTag is matched regardless of case. Tags which only differ
+     * in case are listed once, with the counts of all of them.
+     */
+    void setParentTag(const QString& parentTag);
+
     void start() Q_DECL_OVERRIDE;
     QStringList tags();
 
+    /**
+     * Returns the tags the parent tag matched, as they were written. Only
+     * available when a parent tag has been set.
+     */
+    QStringList parentTags() const;
+
+    /**
+     * Returns the number of files tagged with exactly \p tag, one of tags().
+     * Only available when a parent tag has been set.
+     */
+    uint fileCount(const QString& tag) const;
+
+    /**
+     * Returns whether there are tags below \p tag, one of tags(). Only
+     * available when a parent tag has been set.
+     */
+    bool hasChildTags(const QString& tag) const;
+
 private:
     class Private;
     Private* d;
@@ -238,9 +238,38 @@ QVariant Term::userData(const QString& name) const
     return d->m_userData.value(name);
 }
 
+namespace {
+    // JSON only has strings, byte arrays are tagged so that they come back
+    // as such. Terms treat the two differently, e.g. for dates.
+    const QString byteArrayKey = QStringLiteral("$bytes");
+
+    QVariant encodeValue(const QVariant& value) {
+        if (value.type() != QVariant::ByteArray)
+            return value;
+
+        QVariantMap map;
+        map[byteArrayKey] = QString::fromLatin1(value.toByteArray().toBase64());
+        return map;
+    }
+
+    bool isEncodedByteArray(const QVariant& value) {
+        return value.type() == QVariant::Map && value.toMap().size() == 1
+            && value.toMap().contains(byteArrayKey);
+    }
+
+    QByteArray decodeByteArray(const QVariant& value) {
+        return QByteArray::fromBase64(value.toMap().value(byteArrayKey).toString().toLatin1());
+    }
+}
+
 QVariantMap Term::toVariantMap() const
 {
     QVariantMap map;
+    if (d->m_isNegated) {
+        map[QStringLiteral("$not")] = QVariant((!*this).toVariantMap());
+        return map;
+    }
+
     if (d->m_op != None) {
         QVariantList variantList;
         Q_FOREACH (const Term& term, d->m_subTerms) {
@@ -258,7 +287,7 @@ QVariantMap Term::toVariantMap() const
     QString op;
     switch (d->m_comp) {
     case Equal:
-        map[d->m_property] = d->m_value;
+        map[d->m_property] = encodeValue(d->m_value);
         return map;
 
     case Contains:
@@ -286,7 +315,7 @@ QVariantMap Term::toVariantMap() const
     }
 
     QVariantMap m;
-    m[op] = d->m_value;
+    m[op] = encodeValue(d->m_value);
     map[d->m_property] = QVariant(m);
 
     return map;
@@ -315,6 +344,10 @@ Term Term::fromVariantMap(const QVariantMap& map)
     if (map.size() != 1)
         return Term();
 
+    if (map.contains(QStringLiteral("$not"))) {
+        return !Term::fromVariantMap(map.value(QStringLiteral("$not")).toMap());
+    }
+
     Term term;
 
     QString andOrString;
@@ -342,6 +375,12 @@ Term Term::fromVariantMap(const QVariantMap& map)
     term.setProperty(prop);
 
     QVariant value = map.value(prop);
+    if (isEncodedByteArray(value)) {
+        term.setComparator(Equal);
+        term.setValue(decodeByteArray(value));
+        return term;
+    }
+
     if (value.type() == QVariant::Map) {
         QVariantMap mapVal = value.toMap();
         if (mapVal.size() != 1)
@@ -363,7 +402,8 @@ Term Term::fromVariantMap(const QVariantMap& map)
             return term;
 
         term.setComparator(com);
-        term.setValue(tryConvert(mapVal.value(op)));
+        const QVariant opValue = mapVal.value(op);
+        term.setValue(isEncodedByteArray(opValue) ? QVariant(decodeByteArray(opValue)) : tryConvert(opValue));
 
         return term;
     }
@@ -441,6 +481,9 @@ namespace {
 
 QDebug operator <<(QDebug d, const Baloo::Term& t)
 {
+    if (t.isNegated()) {
+        d << "NOT";
+    }
     if (t.subTerms().isEmpty()) {
         d << QStringLiteral("(%1 %2 %3 (%4))").arg(t.property(),
                                                         comparatorToString(t.comparator()),
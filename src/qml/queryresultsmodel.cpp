@@ -19,10 +19,13 @@
 
 #include "queryresultsmodel.h"
 #include "query.h"
+#include "queryjob.h"
 
-#include <QMimeDatabase>
 #include <QUrl>
 
+// The number of rows which are added at a time
+static const int s_pageSize = 100;
+
 Query::Query(QObject *parent)
     : QObject(parent)
     , m_limit(0)
@@ -65,6 +68,8 @@ int Query::limit() const
 
 QueryResultsModel::QueryResultsModel(QObject *parent)
     : QAbstractListModel(parent),
+      m_pendingPos(0),
+      m_fetchRequested(false),
       m_query(new Query(this))
 {
     connect(m_query, &Query::searchStringChanged, this, &QueryResultsModel::populateModel);
@@ -73,12 +78,16 @@ QueryResultsModel::QueryResultsModel(QObject *parent)
 
 QueryResultsModel::~QueryResultsModel()
 {
+    if (m_job) {
+        m_job->kill();
+    }
 }
 
 QHash<int, QByteArray> QueryResultsModel::roleNames() const
 {
     QHash<int, QByteArray> roleNames = QAbstractListModel::roleNames();
     roleNames[UrlRole] = "url";
+    roleNames[MimeTypeRole] = "mimeType";
 
     return roleNames;
 }
@@ -91,20 +100,32 @@ QVariant QueryResultsModel::data(const QModelIndex &index, int role) const
 
     switch (role) {
     case Qt::DisplayRole: {
-        const QUrl url = QUrl::fromLocalFile(m_balooEntryList.at(index.row()));
+        const QUrl url = QUrl::fromLocalFile(m_balooEntryList.at(index.row()).filePath);
         return url.fileName();
     }
-    case Qt::DecorationRole: {
-        QString localUrl = m_balooEntryList.at(index.row());
-        return QMimeDatabase().mimeTypeForFile(localUrl).iconName();
-    }
+    case Qt::DecorationRole:
+        return entry(index.row()).iconName;
     case UrlRole:
-        return m_balooEntryList.at(index.row());
+        return m_balooEntryList.at(index.row()).filePath;
+    case MimeTypeRole:
+        return entry(index.row()).mimeType;
     default:
         return QVariant();
     }
 }
 
+const QueryResultsModel::Entry &QueryResultsModel::entry(int row) const
+{
+    Entry &e = m_balooEntryList[row];
+    if (e.mimeType.isEmpty()) {
+        const QMimeType mimeType = m_mimeDb.mimeTypeForFile(e.filePath);
+        e.mimeType = mimeType.name();
+        e.iconName = mimeType.iconName();
+    }
+
+    return e;
+}
+
 int QueryResultsModel::rowCount(const QModelIndex &parent) const
 {
     if (parent.isValid()) {
@@ -114,6 +135,30 @@ int QueryResultsModel::rowCount(const QModelIndex &parent) const
     return m_balooEntryList.count();
 }
 
+bool QueryResultsModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return false;
+    }
+
+    return m_pendingPos < m_pendingEntries.size() || m_job;
+}
+
+void QueryResultsModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    if (m_pendingPos == m_pendingEntries.size()) {
+        // Add the next results as soon as they arrive
+        m_fetchRequested = true;
+        return;
+    }
+
+    insertPending();
+}
+
 void QueryResultsModel::setQuery(Query *query)
 {
     if (m_query == query) {
@@ -123,7 +168,12 @@ void QueryResultsModel::setQuery(Query *query)
     delete m_query;
     m_query = query;
     m_query->setParent(this);
+
+    connect(m_query, &Query::searchStringChanged, this, &QueryResultsModel::populateModel);
+    connect(m_query, &Query::limitChanged, this, &QueryResultsModel::populateModel);
+
     Q_EMIT queryChanged();
+    populateModel();
 }
 
 Query* QueryResultsModel::query() const
@@ -133,16 +183,56 @@ Query* QueryResultsModel::query() const
 
 void QueryResultsModel::populateModel()
 {
+    // The results of the previous search are of no use anymore
+    if (m_job) {
+        m_job->kill();
+    }
+
+    beginResetModel();
+    m_balooEntryList.clear();
+    m_pendingEntries.clear();
+    m_pendingPos = 0;
+    m_fetchRequested = true;
+    endResetModel();
+
     Baloo::Query query;
     query.setSearchString(m_query->searchString());
     query.setLimit(m_query->limit());
-    Baloo::ResultIterator it = query.exec();
 
-    beginResetModel();
-    m_balooEntryList.clear();
-    while (it.next()) {
-        m_balooEntryList << it.filePath();
+    m_job = query.execAsync(this);
+    connect(m_job.data(), &Baloo::QueryJob::resultsReady, this, [this](Baloo::QueryJob*, const QStringList &filePaths) {
+        appendResults(filePaths);
+    });
+    m_job->start();
+}
+
+void QueryResultsModel::appendResults(const QStringList &filePaths)
+{
+    if (m_pendingPos == m_pendingEntries.size()) {
+        m_pendingEntries.clear();
+        m_pendingPos = 0;
+    }
+    m_pendingEntries << filePaths;
+
+    if (m_fetchRequested) {
+        insertPending();
     }
-    endResetModel();
 }
 
+void QueryResultsModel::insertPending()
+{
+    const int count = qMin(s_pageSize, m_pendingEntries.size() - m_pendingPos);
+    if (!count) {
+        return;
+    }
+
+    const int first = m_balooEntryList.size();
+    beginInsertRows(QModelIndex(), first, first + count - 1);
+    for (int i = 0; i < count; i++) {
+        Entry e;
+        e.filePath = m_pendingEntries.at(m_pendingPos++);
+        m_balooEntryList << e;
+    }
+    m_fetchRequested = false;
+    endInsertRows();
+}
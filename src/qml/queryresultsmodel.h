@@ -21,7 +21,14 @@
 #define BALOODATAMODEL_H
 
 #include <QAbstractListModel>
+#include <QMimeDatabase>
+#include <QPointer>
 #include <QString>
+#include <QVector>
+
+namespace Baloo {
+class QueryJob;
+}
 
 class Query : public QObject
 {
@@ -63,8 +70,16 @@ public:
 
     QHash<int, QByteArray> roleNames() const Q_DECL_OVERRIDE;
 
+    /**
+     * The query runs in the background and its results are buffered. Rows are
+     * made available a page at a time, when the view asks for more.
+     */
+    bool canFetchMore(const QModelIndex &parent) const Q_DECL_OVERRIDE;
+    void fetchMore(const QModelIndex &parent) Q_DECL_OVERRIDE;
+
     enum Roles {
-        UrlRole = Qt::UserRole + 1
+        UrlRole = Qt::UserRole + 1,
+        MimeTypeRole
     };
 
     void setQuery(Query *query);
@@ -77,7 +92,25 @@ private Q_SLOTS:
     void populateModel();
 
 private:
-    QStringList m_balooEntryList;
+    void appendResults(const QStringList &filePaths);
+    void insertPending();
+
+    struct Entry {
+        QString filePath;
+        // Resolved on first use
+        QString mimeType;
+        QString iconName;
+    };
+    const Entry &entry(int row) const;
+
+    mutable QVector<Entry> m_balooEntryList;
+    // Results which have been received, but not added as rows yet
+    QStringList m_pendingEntries;
+    int m_pendingPos;
+    bool m_fetchRequested;
+
+    QPointer<Baloo::QueryJob> m_job;
+    QMimeDatabase m_mimeDb;
     Query *m_query;
 };
 
@@ -0,0 +1,140 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "querydaemon.h"
+#include "queryclient.h"
+#include "queryjob.h"
+#include "query.h"
+#include "global.h"
+#include "database.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTimer>
+#include <QDebug>
+
+using namespace Baloo;
+
+// How long the index stays open after the last query
+static const int s_idleTimeout = 60 * 1000;
+
+QueryDaemon::QueryDaemon(QObject* parent)
+    : QObject(parent)
+    , m_server(new QLocalServer(this))
+    , m_idleTimer(new QTimer(this))
+    , m_runningJobs(0)
+{
+    connect(m_server, &QLocalServer::newConnection, this, &QueryDaemon::slotNewConnection);
+
+    m_idleTimer->setSingleShot(true);
+    m_idleTimer->setInterval(s_idleTimeout);
+    connect(m_idleTimer, &QTimer::timeout, this, &QueryDaemon::slotIdle);
+}
+
+QueryDaemon::~QueryDaemon()
+{
+}
+
+bool QueryDaemon::start()
+{
+    Database* db = globalDatabaseInstance();
+    if (!db->open(Database::ReadOnlyDatabase)) {
+        qWarning() << "Failed to open the index at" << db->path();
+        return false;
+    }
+
+    const QString path = QueryClient::socketPath();
+
+    // A socket we cannot connect to was left behind by a daemon which crashed
+    QLocalSocket socket;
+    socket.connectToServer(path);
+    if (socket.waitForConnected(100)) {
+        qWarning() << "Another query daemon is already running";
+        return false;
+    }
+    QLocalServer::removeServer(path);
+
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    if (!m_server->listen(path)) {
+        qWarning() << "Failed to listen on" << path << m_server->errorString();
+        return false;
+    }
+
+    m_idleTimer->start();
+    return true;
+}
+
+void QueryDaemon::slotIdle()
+{
+    if (m_runningJobs == 0) {
+        globalDatabaseInstance()->close();
+    }
+}
+
+void QueryDaemon::slotNewConnection()
+{
+    while (QLocalSocket* socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            readRequest(socket);
+        });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void QueryDaemon::readRequest(QLocalSocket* socket)
+{
+    QByteArray& buffer = m_buffers[socket];
+    buffer += socket->readAll();
+
+    QByteArray json;
+    if (!QueryClient::takeFrame(&buffer, &json)) {
+        return;
+    }
+    m_buffers.remove(socket);
+
+    // One query per connection
+    disconnect(socket, &QLocalSocket::readyRead, this, nullptr);
+
+    Query query = Query::fromJSON(json);
+    QueryJob* job = query.execAsync(socket);
+
+    // SearchStore opens the index again if it has been closed
+    m_runningJobs++;
+    m_idleTimer->stop();
+    connect(job, &QObject::destroyed, this, [this]() {
+        if (--m_runningJobs == 0) {
+            m_idleTimer->start();
+        }
+    });
+
+    connect(job, &QueryJob::resultsReady, socket, [socket](QueryJob*, const QStringList& filePaths) {
+        socket->write(QueryClient::frame(QueryClient::serializeResults(filePaths)));
+    });
+    connect(job, &KJob::result, socket, [socket]() {
+        socket->write(QueryClient::frame(QueryClient::serializeResults(QStringList())));
+        socket->disconnectFromServer();
+    });
+
+    job->start();
+}
@@ -0,0 +1,78 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_QUERYDAEMON_H
+#define BALOO_QUERYDAEMON_H
+
+#include <QObject>
+#include <QHash>
+
+class QLocalServer;
+class QLocalSocket;
+class QTimer;
+
+namespace Baloo {
+
+class QueryJob;
+
+/**
+ * Answers queries from other processes over a local socket, see
+ * QueryClient for the protocol. The index stays open while queries keep
+ * coming, so the pooled read transactions, the query result cache and
+ * the page cache of the index stay warm between them.
+ *
+ * The index is closed once the daemon has been idle for a while, as
+ * Database::compact() does not run while another process has it open.
+ * The next query opens it again.
+ *
+ * Every query runs as a QueryJob, so several clients are served at once.
+ */
+class QueryDaemon : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QueryDaemon(QObject* parent = nullptr);
+    ~QueryDaemon() Q_DECL_OVERRIDE;
+
+    /**
+     * Starts listening on QueryClient::socketPath(). Fails if the index
+     * cannot be opened, or if another daemon is already serving it.
+     */
+    bool start();
+
+private Q_SLOTS:
+    void slotNewConnection();
+    void slotIdle();
+
+private:
+    void readRequest(QLocalSocket* socket);
+
+    QLocalServer* m_server;
+    QTimer* m_idleTimer;
+    int m_runningJobs;
+
+    // Requests which have only been partially received
+    QHash<QLocalSocket*, QByteArray> m_buffers;
+};
+
+}
+
+#endif // BALOO_QUERYDAEMON_H
@@ -0,0 +1,122 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "checkdbcommand.h"
+
+#include "global.h"
+#include "database.h"
+#include "transaction.h"
+#include "indexchecker.h"
+
+#include <QTextStream>
+
+#include <KLocalizedString>
+
+using namespace Baloo;
+
+QString CheckDbCommand::command()
+{
+    return QStringLiteral("checkDb");
+}
+
+QString CheckDbCommand::description()
+{
+    return i18n("Check database for consistency");
+}
+
+int CheckDbCommand::exec(const QCommandLineParser& parser)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    int threads = 0;
+    if (parser.isSet(QStringLiteral("threads"))) {
+        bool ok = false;
+        threads = parser.value(QStringLiteral("threads")).toInt(&ok);
+        if (!ok || threads < 1) {
+            err << i18n("Invalid count for --threads: %1", parser.value(QStringLiteral("threads"))) << endl;
+            return 1;
+        }
+    }
+
+    const bool repair = parser.isSet(QStringLiteral("repair"));
+
+    Database *db = globalDatabaseInstance();
+    if (!db->open(repair ? Database::ReadWriteDatabase : Database::ReadOnlyDatabase)) {
+        err << i18n("Baloo Index could not be opened") << endl;
+        return 1;
+    }
+
+    IndexChecker checker(db);
+    if (threads) {
+        checker.setThreadCount(threads);
+    }
+
+    // Problems are rare, so keeping those to be repaired in memory is fine
+    QVector<IndexChecker::Problem> problems;
+    quint64 problemCount = 0;
+    const bool checked = checker.check([&](const IndexChecker::Problem& problem) {
+        problemCount++;
+        if (repair) {
+            problems << problem;
+        }
+
+        switch (problem.type) {
+        case IndexChecker::Problem::UnknownPosting:
+            if (!problem.id) {
+                out << "Ordinal " << problem.ordinal << " of " << QString::fromUtf8(problem.term) << " belongs to no document" << endl;
+                break;
+            }
+            out << problem.id << " is missing " << QString::fromUtf8(problem.term) << " from document terms db" << endl;
+            break;
+        case IndexChecker::Problem::MissingPosting:
+            out << problem.id << " is missing from the posting list of " << QString::fromUtf8(problem.term) << endl;
+            break;
+        case IndexChecker::Problem::MissingUrl:
+            out << "Missing filePath for " << problem.id << endl;
+            break;
+        }
+    });
+
+    if (!checked) {
+        err << i18n("The index kept changing while being checked, try again after suspending the indexer") << endl;
+        return 1;
+    }
+
+    out << i18n("Checked %1 documents and %2 postings, found %3 problems",
+                checker.documentCount(), checker.postingCount(), problemCount) << endl;
+
+    if (!repair || problems.isEmpty()) {
+        return problemCount ? 2 : 0;
+    }
+
+    const int batchSize = 10000;
+    for (int i = 0; i < problems.size(); i += batchSize) {
+        Transaction tr(db, Transaction::ReadWrite);
+        for (int j = i; j < qMin(i + batchSize, problems.size()); j++) {
+            IndexChecker::repair(&tr, problems[j]);
+        }
+        tr.commit();
+    }
+    out << i18n("Repaired %1 problems", problems.size()) << endl;
+
+    return 0;
+}
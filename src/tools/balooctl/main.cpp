@@ -32,6 +32,7 @@
 #include <QProcess>
 #include <QTextStream>
 #include <QFileInfo>
+#include <QDir>
 #include <QLocale>
 
 #include <QDBusMessage>
@@ -53,6 +54,9 @@
 #include "indexerstate.h"
 #include "configcommand.h"
 #include "statuscommand.h"
+#include "metricscommand.h"
+#include "storagecommand.h"
+#include "checkdbcommand.h"
 
 using namespace Baloo;
 
@@ -89,6 +93,16 @@ int main(int argc, char* argv[])
     parser.addPositionalArgument(QStringLiteral("config"), i18n("Modify the Baloo configuration"));
     parser.addPositionalArgument(QStringLiteral("monitor"), i18n("Monitor the file indexer"));
     parser.addPositionalArgument(QStringLiteral("indexSize"), i18n("Display the disk space used by index"));
+    parser.addPositionalArgument(QStringLiteral("metrics"), i18n("Print the counters of the indexer"));
+    parser.addPositionalArgument(QStringLiteral("storage"), i18n("Display the page usage and the largest values of the index"));
+    parser.addPositionalArgument(QStringLiteral("compact"), i18n("Remove the free pages from the index"));
+    parser.addPositionalArgument(QStringLiteral("reorder"), i18n("Renumber the indexed files by folder and compact the index"));
+    parser.addOption(QCommandLineOption(QStringLiteral("json"), i18n("Print the metrics as JSON")));
+    parser.addOption(QCommandLineOption(QStringLiteral("top"), i18n("The number of largest values shown per database"),
+                                        QStringLiteral("count"), QStringLiteral("10")));
+    parser.addOption(QCommandLineOption(QStringLiteral("repair"), i18n("Fix the problems found by checkDb")));
+    parser.addOption(QCommandLineOption(QStringLiteral("threads"), i18n("The number of threads used by checkDb"),
+                                        QStringLiteral("count")));
     parser.addVersionOption();
     parser.addHelpOption();
 
@@ -141,8 +155,9 @@ int main(int argc, char* argv[])
             out << "Disabling the File Indexer\n";
 
             mainInterface.quit();
-            const QString path = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/baloo/index");
-            QFile(path).remove();
+            const QString path = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/baloo");
+            QFile(path + QStringLiteral("/index")).remove();
+            QDir(path + QStringLiteral("/shards")).removeRecursively();
         }
 
         return 0;
@@ -276,7 +291,7 @@ int main(int argc, char* argv[])
         }
 
         KFormat format(QLocale::system());
-        auto prFunc = [&](const QString& name, uint size, uint totalSize) {
+        auto prFunc = [&](const QString& name, quint64 size, quint64 totalSize) {
             out.setFieldWidth(20);
             out << name;
             out.setFieldWidth(0);
@@ -289,7 +304,7 @@ int main(int argc, char* argv[])
             out << " %\n";
         };
 
-        uint ts = size.expectedSize;
+        quint64 ts = size.expectedSize;
         out << "Actual Size: " << format.formatByteSize(size.actualSize, 2) << "\n";
         out << "Expected Size: " << format.formatByteSize(size.expectedSize, 2) << "\n\n";
         prFunc(QStringLiteral("PostingDB"), size.postingDb, ts);
@@ -304,30 +319,92 @@ int main(int argc, char* argv[])
         prFunc(QStringLiteral("ContentIndexingDB"), size.contentIndexingIds, ts);
         prFunc(QStringLiteral("FailedIdsDB"), size.failedIds, ts);
         prFunc(QStringLiteral("MTimeDB"), size.mtimeDb, ts);
+        prFunc(QStringLiteral("OrdinalDB"), size.ordinalDb, ts);
+        prFunc(QStringLiteral("TermStatsDB"), size.termStatsDb, ts);
+        prFunc(QStringLiteral("MetaDataDB"), size.metaDataDb, ts);
+        prFunc(QStringLiteral("TagDB"), size.tagDb, ts);
 
         return 0;
     }
 
-    if (command == QStringLiteral("monitor")) {
-        MonitorCommand mon;
-        return mon.exec(parser);
+    if (command == QLatin1String("storage")) {
+        StorageCommand command;
+        return command.exec(parser);
     }
 
-    if (command == QStringLiteral("checkDb")) {
+    if (command == QLatin1String("compact")) {
+        // The running indexer is the only writer, it has to make the swap
+        if (schedulerinterface.isValid()) {
+            schedulerinterface.compact();
+            out << "The index will be compacted once the File Indexer is idle\n";
+            return 0;
+        }
+
         Database *db = globalDatabaseInstance();
-        if (!db->open(Database::ReadOnlyDatabase)) {
+        if (!db->open(Database::ReadWriteDatabase)) {
+            out << "Baloo Index could not be opened\n";
+            return 1;
+        }
+
+        const qint64 size = db->fileSize();
+        if (!db->compact()) {
+            out << "The index could not be compacted, other programs may be using it\n";
+            return 1;
+        }
+
+        KFormat format(QLocale::system());
+        out << "Compacted the index from " << format.formatByteSize(size, 2)
+            << " to " << format.formatByteSize(db->fileSize(), 2) << "\n";
+        return 0;
+    }
+
+    if (command == QLatin1String("reorder")) {
+        if (schedulerinterface.isValid()) {
+            schedulerinterface.reorder();
+            out << "The index will be reordered once the File Indexer is idle\n";
+            return 0;
+        }
+
+        Database *db = globalDatabaseInstance();
+        if (!db->open(Database::ReadWriteDatabase)) {
             out << "Baloo Index could not be opened\n";
             return 1;
         }
 
-        Transaction tr(db, Transaction::ReadOnly);
-        tr.checkPostingDbinTermsDb();
-        tr.checkTermsDbinPostingDb();
-        out << "Checking file paths .. " << endl;
-        tr.checkFsTree();
+        {
+            Transaction tr(db, Transaction::ReadWrite);
+            if (!tr.reorderDocuments()) {
+                tr.abort();
+                out << "The index is already in order\n";
+                return 0;
+            }
+            tr.commit();
+        }
+
+        // The old order is left behind as free pages
+        if (!db->compact()) {
+            out << "The index was reordered but could not be compacted, other programs may be using it\n";
+            return 1;
+        }
+        out << "Reordered the index\n";
         return 0;
     }
 
+    if (command == QLatin1String("metrics")) {
+        MetricsCommand command;
+        return command.exec(parser);
+    }
+
+    if (command == QStringLiteral("monitor")) {
+        MonitorCommand mon;
+        return mon.exec(parser);
+    }
+
+    if (command == QStringLiteral("checkDb")) {
+        CheckDbCommand command;
+        return command.exec(parser);
+    }
+
     parser.showHelp(1);
     return 0;
 }
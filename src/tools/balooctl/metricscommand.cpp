@@ -0,0 +1,115 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "metricscommand.h"
+#include "metricsinterface.h"
+
+#include <QDBusArgument>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include <KLocalizedString>
+
+using namespace Baloo;
+
+QString MetricsCommand::command()
+{
+    return QStringLiteral("metrics");
+}
+
+QString MetricsCommand::description()
+{
+    return i18n("Print the counters of the indexer");
+}
+
+// Nested maps and lists arrive as QDBusArgument inside the variants
+static QVariant demarshall(const QVariant& value)
+{
+    if (value.userType() != qMetaTypeId<QDBusArgument>()) {
+        return value;
+    }
+
+    const QDBusArgument arg = value.value<QDBusArgument>();
+    if (arg.currentType() == QDBusArgument::MapType) {
+        QVariantMap map = qdbus_cast<QVariantMap>(arg);
+        for (auto it = map.begin(); it != map.end(); ++it) {
+            it.value() = demarshall(it.value());
+        }
+        return map;
+    }
+    if (arg.currentType() == QDBusArgument::ArrayType) {
+        QVariantList list = qdbus_cast<QVariantList>(arg);
+        for (QVariant& v : list) {
+            v = demarshall(v);
+        }
+        return list;
+    }
+    return value;
+}
+
+static void printMap(QTextStream& out, const QVariantMap& map, const QString& prefix)
+{
+    for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+        const QString key = prefix + it.key();
+        if (it.value().type() == QVariant::Map) {
+            printMap(out, it.value().toMap(), key + QLatin1Char('.'));
+        } else if (it.value().type() == QVariant::List) {
+            QStringList values;
+            for (const QVariant& v : it.value().toList()) {
+                values << v.toString();
+            }
+            out << key << ": " << values.join(QLatin1Char(' ')) << endl;
+        } else {
+            out << key << ": " << it.value().toString() << endl;
+        }
+    }
+}
+
+int MetricsCommand::exec(const QCommandLineParser& parser)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    org::kde::baloo::metrics metricsInterface(QStringLiteral("org.kde.baloo"),
+                                              QStringLiteral("/metrics"),
+                                              QDBusConnection::sessionBus());
+
+    QDBusPendingReply<QVariantMap> reply = metricsInterface.metrics();
+    reply.waitForFinished();
+    if (reply.isError()) {
+        err << i18n("Baloo File Indexer is not running") << endl;
+        return 1;
+    }
+
+    QVariantMap metrics = reply.value();
+    for (auto it = metrics.begin(); it != metrics.end(); ++it) {
+        it.value() = demarshall(it.value());
+    }
+
+    if (parser.isSet(QStringLiteral("json"))) {
+        out << QJsonDocument(QJsonObject::fromVariantMap(metrics)).toJson();
+    } else {
+        printMap(out, metrics, QString());
+    }
+
+    return 0;
+}
@@ -57,7 +57,11 @@ int StatusCommand::exec(const QCommandLineParser& parser)
 
     Database *db = globalDatabaseInstance();
     if (!db->open(Database::ReadOnlyDatabase)) {
-        out << i18n("Baloo Index could not be opened") << endl;
+        if (db->needsConversion()) {
+            out << i18n("Baloo Index has to be converted by the file indexer first, please run \"balooctl start\"") << endl;
+        } else {
+            out << i18n("Baloo Index could not be opened") << endl;
+        }
         return 1;
     }
 
@@ -90,10 +94,7 @@ int StatusCommand::exec(const QCommandLineParser& parser)
 
         out << i18n("Indexed %1 / %2 files", total - phaseOne, total) << endl;
 
-        const QString path = fileIndexDbPath();
-
-        const QFileInfo indexInfo(path + QLatin1String("/index"));
-        const auto size = indexInfo.size();
+        const auto size = db->fileSize();
         KFormat format(QLocale::system());
         if (size) {
             out << "Current size of index is " << format.formatByteSize(size, 2) << endl;
@@ -0,0 +1,146 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "storagecommand.h"
+#include "metricsinterface.h"
+
+#include "global.h"
+#include "database.h"
+#include "transaction.h"
+#include "storagereport.h"
+
+#include <QTextStream>
+
+#include <KLocalizedString>
+#include <KFormat>
+
+using namespace Baloo;
+
+QString StorageCommand::command()
+{
+    return QStringLiteral("storage");
+}
+
+QString StorageCommand::description()
+{
+    return i18n("Display the page usage and the largest values of the index");
+}
+
+int StorageCommand::exec(const QCommandLineParser& parser)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    bool ok = false;
+    const int top = parser.value(QStringLiteral("top")).toInt(&ok);
+    if (!ok || top < 0) {
+        err << i18n("Invalid count for --top: %1", parser.value(QStringLiteral("top"))) << endl;
+        return 1;
+    }
+
+    Database *db = globalDatabaseInstance();
+    if (!db->open(Database::ReadOnlyDatabase)) {
+        err << i18n("Baloo Index could not be opened") << endl;
+        return 1;
+    }
+
+    StorageReport report;
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        report = tr.storageReport(top);
+    }
+
+    KFormat format(QLocale::system());
+    const auto pageSize = [&](quint64 pages) {
+        return format.formatByteSize(pages * report.pageSize, 2);
+    };
+
+    out << i18n("Page size: %1", format.formatByteSize(report.pageSize)) << endl;
+    out << i18n("Map size: %1", format.formatByteSize(report.mapSize, 2)) << endl;
+    out << i18n("Used pages: %1 (%2)", report.usedPages, pageSize(report.usedPages)) << endl;
+    out << i18n("Free pages: %1 (%2)", report.freePages, pageSize(report.freePages)) << endl;
+    out << endl;
+
+    const auto printRow = [&](const QStringList& columns) {
+        out.setFieldWidth(18);
+        out.setFieldAlignment(QTextStream::AlignLeft);
+        out << columns.first();
+        out.setFieldAlignment(QTextStream::AlignRight);
+        for (int i = 1; i < columns.size(); i++) {
+            out.setFieldWidth(i == columns.size() - 1 ? 14 : 10);
+            out << columns[i];
+        }
+        out.setFieldWidth(0);
+        out << endl;
+    };
+
+    printRow({i18n("Database"), i18n("Entries"), i18n("Depth"), i18n("Branch"), i18n("Leaf"),
+              i18n("Overflow"), i18n("Large"), i18n("Size")});
+    for (const StorageReport::Dbi& dbi : report.dbis) {
+        printRow({QString::fromUtf8(dbi.name), QString::number(dbi.entries), QString::number(dbi.depth),
+                  QString::number(dbi.branchPages), QString::number(dbi.leafPages),
+                  QString::number(dbi.overflowPages), QString::number(dbi.overflowValues),
+                  pageSize(dbi.pages())});
+    }
+    out << endl;
+
+    for (const StorageReport::Dbi& dbi : report.dbis) {
+        if (dbi.largestValues.isEmpty()) {
+            continue;
+        }
+
+        out << i18n("Largest values of %1:", QString::fromUtf8(dbi.name)) << endl;
+        for (const StorageReport::Value& value : dbi.largestValues) {
+            out << "  " << format.formatByteSize(value.size, 2);
+            if (value.overflowPages) {
+                out << " " << i18np("(1 overflow page)", "(%1 overflow pages)", value.overflowPages);
+            }
+            out << " " << value.key << endl;
+        }
+        out << endl;
+    }
+
+    // The write counters live in baloo_file and only cover its lifetime
+    org::kde::baloo::metrics metricsInterface(QStringLiteral("org.kde.baloo"),
+                                              QStringLiteral("/metrics"),
+                                              QDBusConnection::sessionBus());
+
+    QDBusPendingReply<QVariantMap> reply = metricsInterface.metrics();
+    reply.waitForFinished();
+    if (reply.isError()) {
+        out << i18n("Baloo File Indexer is not running, no write statistics available") << endl;
+        return 0;
+    }
+
+    const QVariantMap metrics = reply.value();
+    const quint64 commits = metrics.value(QStringLiteral("commits")).toULongLong();
+    const quint64 bytes = metrics.value(QStringLiteral("bytesWritten")).toULongLong();
+    const quint64 pages = metrics.value(QStringLiteral("pagesGrown")).toULongLong();
+
+    out << i18n("Commits since startup: %1", commits) << endl;
+    out << i18n("Bytes written: %1", format.formatByteSize(bytes, 2)) << endl;
+    if (commits) {
+        out << i18n("Bytes written per commit: %1", format.formatByteSize(bytes / commits, 2)) << endl;
+        out << i18n("Pages grown per commit: %1", QString::number(double(pages) / commits, 'f', 2)) << endl;
+    }
+
+    return 0;
+}
@@ -59,6 +59,8 @@ int main(int argc, char* argv[])
     parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("d") << QStringLiteral("directory"),
                                         i18n("Limit search to specified directory"),
                                         i18n("directory")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("e") << QStringLiteral("explain"),
+                                        i18n("Show how the query is evaluated instead of the results")));
     parser.addPositionalArgument(i18n("query"), i18n("List of words to query for"));
     parser.addHelpOption();
     parser.addVersionOption();
@@ -95,6 +97,11 @@ int main(int argc, char* argv[])
         query.setIncludeFolder(QFileInfo(folderName).canonicalFilePath());
     }
 
+    if (parser.isSet(QStringLiteral("explain"))) {
+        out << query.explain();
+        return 0;
+    }
+
     QElapsedTimer timer;
     timer.start();
 